@@ -0,0 +1,37 @@
+#pragma once
+// libE57Format benchmarks Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// A minimal benchmark runner. Each benchmark is a function registered with E57_BENCHMARK() which
+// times whatever it wants with Benchmark::time() and prints results with Benchmark::report().
+//
+// Run all of them:
+//    benchmarkE57
+// Run the ones with "Writer" in their name:
+//    benchmarkE57 Writer
+
+namespace Benchmark
+{
+   /// Register a benchmark. Returns true so it can be used to initialize a static.
+   bool add( const std::string &inName, const std::function<void()> &inFunc );
+
+   /// Run all benchmarks whose name contains inFilter. Returns the process exit code.
+   int runAll( const std::string &inFilter );
+
+   /// Run inFunc inRepetitions times and return the fastest run in seconds.
+   double time( const std::function<void()> &inFunc, int inRepetitions = 3 );
+
+   /// Print one result line: throughput in items/s and, if inBytes > 0, MB/s.
+   void report( const std::string &inLabel, double inSeconds, uint64_t inItems,
+                uint64_t inBytes = 0 );
+}
+
+#define E57_BENCHMARK( group, name )                                                               \
+   static void group##_##name();                                                                   \
+   static const bool group##_##name##_registered =                                                 \
+      Benchmark::add( #group "." #name, group##_##name );                                          \
+   static void group##_##name()
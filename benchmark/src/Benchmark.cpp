@@ -0,0 +1,108 @@
+// libE57Format benchmarks Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "E57Exception.h"
+
+#include "Benchmark.h"
+
+namespace
+{
+   struct Entry
+   {
+      std::string name;
+      std::function<void()> func;
+   };
+
+   // Function-local static so registration from other translation units is safe during static
+   // initialization.
+   std::vector<Entry> &registry()
+   {
+      static std::vector<Entry> sRegistry;
+      return sRegistry;
+   }
+}
+
+namespace Benchmark
+{
+   bool add( const std::string &inName, const std::function<void()> &inFunc )
+   {
+      registry().push_back( { inName, inFunc } );
+      return true;
+   }
+
+   int runAll( const std::string &inFilter )
+   {
+      auto &entries = registry();
+
+      std::sort( entries.begin(), entries.end(),
+                 []( const Entry &a, const Entry &b ) { return a.name < b.name; } );
+
+      int result = 0;
+
+      for ( const auto &entry : entries )
+      {
+         if ( !inFilter.empty() && entry.name.find( inFilter ) == std::string::npos )
+         {
+            continue;
+         }
+
+         std::printf( "[ %s ]\n", entry.name.c_str() );
+
+         try
+         {
+            entry.func();
+         }
+         catch ( e57::E57Exception &err )
+         {
+            std::printf( "  FAILED: %s: %s\n", err.errorStr().c_str(), err.context().c_str() );
+            result = 1;
+         }
+      }
+
+      return result;
+   }
+
+   double time( const std::function<void()> &inFunc, int inRepetitions )
+   {
+      using Clock = std::chrono::steady_clock;
+
+      double best = 0.0;
+
+      for ( int i = 0; i < inRepetitions; ++i )
+      {
+         const auto start = Clock::now();
+
+         inFunc();
+
+         const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+         if ( i == 0 || elapsed.count() < best )
+         {
+            best = elapsed.count();
+         }
+      }
+
+      return best;
+   }
+
+   void report( const std::string &inLabel, double inSeconds, uint64_t inItems, uint64_t inBytes )
+   {
+      const double seconds = std::max( inSeconds, 1e-9 );
+
+      if ( inBytes > 0 )
+      {
+         std::printf( "  %-28s %10.3f ms %12.2f Mitems/s %10.1f MB/s\n", inLabel.c_str(),
+                      seconds * 1e3, inItems / seconds / 1e6, inBytes / seconds / 1e6 );
+      }
+      else
+      {
+         std::printf( "  %-28s %10.3f ms %12.2f Mitems/s\n", inLabel.c_str(), seconds * 1e3,
+                      inItems / seconds / 1e6 );
+      }
+   }
+}
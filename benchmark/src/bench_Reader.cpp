@@ -0,0 +1,325 @@
+// libE57Format benchmarks Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "E57Format.h"
+#include "E57SimpleReader.h"
+#include "E57SimpleWriter.h"
+
+#include "Benchmark.h"
+
+namespace
+{
+   // Which parser the library was built with (see E57_BUILTIN_XML_PARSER). To compare the two,
+   // run this benchmark from a build with each.
+#ifdef E57_BUILTIN_XML_PARSER
+   const std::string cParserName = "builtin";
+#else
+   const std::string cParserName = "xerces";
+#endif
+
+   constexpr size_t cNumElements = 20000;
+
+   constexpr int64_t cMaxIndex = std::numeric_limits<int32_t>::max();
+
+   const char *cFileName = "benchmark-reader.e57";
+
+   // Write a file whose XML section describes cNumElements structures, each with a few children
+   // of every type, so opening it is dominated by parsing the XML.
+   size_t writeLargeXML()
+   {
+      e57::ImageFile imf( cFileName, "w" );
+
+      e57::VectorNode images( imf, true );
+      imf.root().set( "images", images );
+
+      for ( size_t i = 0; i < cNumElements; ++i )
+      {
+         const auto index = static_cast<int64_t>( i );
+
+         e57::StructureNode image( imf );
+         image.set( "guid", e57::StringNode( imf, "{image-" + std::to_string( i ) + "}" ) );
+         image.set( "name", e57::StringNode( imf, "Image " + std::to_string( i ) ) );
+         image.set( "index", e57::IntegerNode( imf, index, 0, cMaxIndex ) );
+         image.set( "focalLength", e57::FloatNode( imf, 0.035 + i * 1.0e-6 ) );
+         image.set( "offset",
+                    e57::ScaledIntegerNode( imf, index, int64_t( 0 ), cMaxIndex, 0.001 ) );
+
+         e57::StructureNode pose( imf );
+         pose.set( "x", e57::FloatNode( imf, i * 0.5 ) );
+         pose.set( "y", e57::FloatNode( imf, i * -0.5 ) );
+         pose.set( "z", e57::FloatNode( imf, 1.5 ) );
+         image.set( "pose", pose );
+
+         images.append( image );
+      }
+
+      imf.close();
+
+      std::FILE *file = std::fopen( cFileName, "rb" );
+      std::fseek( file, 0, SEEK_END );
+      const long size = std::ftell( file );
+      std::fclose( file );
+
+      return static_cast<size_t>( size );
+   }
+}
+
+// Latency of opening (and closing) a file with a large XML section, with and without having the
+// XML parser validate it. (The built-in parser never validates.)
+E57_BENCHMARK( Reader, OpenLargeXML )
+{
+   const size_t fileSize = writeLargeXML();
+
+   for ( bool validate : { true, false } )
+   {
+      e57::ImageFileReadOptions options;
+      options.validateXml = validate;
+
+      const double seconds = Benchmark::time( [&] {
+         e57::ImageFile imf( cFileName, options );
+         imf.close();
+      } );
+
+      Benchmark::report( cParserName + ( validate ? " validated" : " unvalidated" ), seconds,
+                         cNumElements, fileSize );
+   }
+
+   std::remove( cFileName );
+}
+
+// Latency of opening a file with a large XML section and reading one element from it, with the
+// whole node tree built on open and with it built as it is used (see
+// ImageFileReadOptions::lazyNodeTree).
+E57_BENCHMARK( Reader, OpenLazyNodeTree )
+{
+   const size_t fileSize = writeLargeXML();
+
+   for ( bool lazy : { false, true } )
+   {
+      e57::ImageFileReadOptions options;
+      options.validateXml = false;
+      options.lazyNodeTree = lazy;
+
+      const double seconds = Benchmark::time( [&] {
+         e57::ImageFile imf( cFileName, options );
+         e57::FloatNode( imf.root().get( "/images/0/pose/x" ) ).value();
+         imf.close();
+      } );
+
+      Benchmark::report( cParserName + ( lazy ? " lazy" : " full" ), seconds, cNumElements,
+                         fileSize );
+   }
+
+   std::remove( cFileName );
+}
+
+// Time taken to look up the same path in every element of a large vector, by looking each element
+// up by name in the vector, then the path in it, given as a string and as a CompiledPath.
+E57_BENCHMARK( Reader, LookupPaths )
+{
+   writeLargeXML();
+
+   e57::ImageFile imf( cFileName, "r" );
+   const e57::VectorNode images( imf.root().get( "images" ) );
+   const e57::CompiledPath posePath( imf, "pose/x" );
+
+   for ( bool compiled : { false, true } )
+   {
+      const double seconds = Benchmark::time( [&] {
+         for ( size_t i = 0; i < cNumElements; ++i )
+         {
+            const e57::StructureNode image( images.get( std::to_string( i ) ) );
+            const e57::Node x( compiled ? image.get( posePath ) : image.get( "pose/x" ) );
+
+            e57::FloatNode( x ).value();
+         }
+      } );
+
+      Benchmark::report( compiled ? "compiled path" : "string path", seconds, cNumElements );
+   }
+
+   imf.close();
+
+   std::remove( cFileName );
+}
+
+namespace
+{
+   constexpr size_t cNumOpens = 2000;
+
+   // Write a file like the ones a catalog would read the headers of: one scan with no points.
+   void writeSmallFile()
+   {
+      e57::ImageFile imf( cFileName, "w" );
+
+      imf.root().set( "formatName", e57::StringNode( imf, "ASTM E57 3D Imaging Data File" ) );
+      imf.root().set( "guid", e57::StringNode( imf, "{benchmark-reader}" ) );
+
+      e57::StructureNode scan( imf );
+      scan.set( "guid", e57::StringNode( imf, "{benchmark-reader-scan}" ) );
+      scan.set( "name", e57::StringNode( imf, "Scan" ) );
+
+      e57::StructureNode proto( imf );
+      proto.set( "cartesianX", e57::FloatNode( imf ) );
+      proto.set( "cartesianY", e57::FloatNode( imf ) );
+      proto.set( "cartesianZ", e57::FloatNode( imf ) );
+
+      e57::VectorNode codecs( imf, true );
+      scan.set( "points", e57::CompressedVectorNode( imf, proto, codecs ) );
+
+      e57::VectorNode data3D( imf, true );
+      data3D.append( scan );
+      imf.root().set( "data3D", data3D );
+
+      imf.close();
+   }
+}
+
+// Cost of opening (and closing) a small file over and over, on one thread and on several at
+// once, as a catalog reading the headers of many files would.
+E57_BENCHMARK( Reader, OpenSmallFiles )
+{
+   writeSmallFile();
+
+   for ( unsigned threads : { 1, 4 } )
+   {
+      const double seconds = Benchmark::time( [&] {
+         std::vector<std::thread> workers;
+
+         for ( unsigned t = 0; t < threads; ++t )
+         {
+            workers.emplace_back( [&] {
+               for ( size_t i = 0; i < cNumOpens / threads; ++i )
+               {
+                  e57::ImageFile imf( cFileName, "r" );
+                  imf.close();
+               }
+            } );
+         }
+
+         for ( auto &worker : workers )
+         {
+            worker.join();
+         }
+      } );
+
+      Benchmark::report( cParserName + " threads=" + std::to_string( threads ), seconds,
+                         cNumOpens );
+   }
+
+   std::remove( cFileName );
+}
+
+namespace
+{
+   constexpr int64_t cNumScans = 500;
+   constexpr int64_t cNumImages = 5000;
+
+   // Write a file like a project file: many scans (without points), and many small images taken
+   // from them.
+   void writeProjectFile()
+   {
+      e57::WriterOptions options;
+      options.guid = "{benchmark-reader-project}";
+
+      e57::Writer writer( cFileName, options );
+
+      for ( int64_t i = 0; i < cNumScans; ++i )
+      {
+         e57::Data3D header;
+         header.guid = "{scan-" + std::to_string( i ) + "}";
+         header.name = "Scan " + std::to_string( i );
+         header.sensorModel = "Benchmark";
+         header.pose.translation.x = static_cast<double>( i );
+         header.acquisitionStart.dateTimeValue = 1.0e9 + static_cast<double>( i );
+         header.cartesianBounds.xMinimum = -100.0;
+         header.cartesianBounds.xMaximum = 100.0;
+
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+         header.pointFields.intensityField = true;
+
+         writer.NewData3D( header );
+      }
+
+      std::vector<uint8_t> png( 64 );
+
+      for ( int64_t i = 0; i < cNumImages; ++i )
+      {
+         e57::Image2D header;
+         header.guid = "{image-" + std::to_string( i ) + "}";
+         header.associatedData3DGuid = "{scan-" + std::to_string( i % cNumScans ) + "}";
+         header.pose.translation.y = static_cast<double>( i );
+
+         header.pinholeRepresentation.imageWidth = 8;
+         header.pinholeRepresentation.imageHeight = 8;
+         header.pinholeRepresentation.pngImageSize = static_cast<int64_t>( png.size() );
+         header.pinholeRepresentation.focalLength = 0.035;
+         header.pinholeRepresentation.pixelWidth = 1.0e-5;
+         header.pinholeRepresentation.pixelHeight = 1.0e-5;
+
+         writer.WriteImage2DData( header, e57::ImagePNG, e57::ProjectionPinhole, 0, png.data(),
+                                  static_cast<int64_t>( png.size() ) );
+      }
+
+      writer.Close();
+   }
+}
+
+// Latency of opening a project file and reading all the scan and image headers in it, one at a
+// time and with Reader::ReadHeaders() on one and four threads, with the whole node tree built on
+// open and with it built as it is used.
+E57_BENCHMARK( Reader, ReadHeaders )
+{
+   writeProjectFile();
+
+   for ( bool lazy : { false, true } )
+   {
+      e57::ReaderOptions options;
+      options.validateXml = false;
+      options.lazyNodeTree = lazy;
+
+      for ( unsigned threads : { 0, 1, 4 } )
+      {
+         const double seconds = Benchmark::time( [&] {
+            e57::Reader reader( cFileName, options );
+
+            if ( threads == 0 )
+            {
+               e57::Data3D scanHeader;
+               e57::Image2D imageHeader;
+
+               for ( int64_t i = 0; i < reader.GetData3DCount(); ++i )
+               {
+                  reader.ReadData3D( i, scanHeader );
+               }
+
+               for ( int64_t i = 0; i < reader.GetImage2DCount(); ++i )
+               {
+                  reader.ReadImage2D( i, imageHeader );
+               }
+            }
+            else
+            {
+               e57::E57Headers headers;
+               reader.ReadHeaders( headers, threads );
+            }
+         } );
+
+         const std::string label =
+            threads == 0 ? "one by one" : "threads=" + std::to_string( threads );
+
+         Benchmark::report( cParserName + ( lazy ? " lazy " : " full " ) + label, seconds,
+                            cNumScans + cNumImages );
+      }
+   }
+
+   std::remove( cFileName );
+}
@@ -0,0 +1,358 @@
+// libE57Format benchmarks Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "E57Format.h"
+
+#include "Benchmark.h"
+
+namespace
+{
+   constexpr size_t cNumRecords = 4 * 1024 * 1024;
+   constexpr size_t cChunkSize = 64 * 1024;
+
+   const char *cFileName = "benchmark-writer.e57";
+
+   // Write cNumRecords from inValues into a compressed vector with a single integer field with
+   // the given range.
+   void writeIntegers( const std::vector<int64_t> &inValues, int64_t inMinimum, int64_t inMaximum )
+   {
+      e57::ImageFile imf( cFileName, "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "value", e57::IntegerNode( imf, inMinimum, inMinimum, inMaximum ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode cv( imf, proto, codecs );
+      imf.root().set( "points", cv );
+
+      std::vector<int64_t> chunk( cChunkSize );
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "value", chunk.data(), chunk.size(), true );
+
+      e57::CompressedVectorWriter writer = cv.writer( sbufs );
+
+      for ( size_t start = 0; start < inValues.size(); start += cChunkSize )
+      {
+         const size_t count = std::min( cChunkSize, inValues.size() - start );
+
+         std::copy_n( inValues.begin() + start, count, chunk.begin() );
+
+         writer.write( count );
+      }
+
+      writer.close();
+      imf.close();
+   }
+}
+
+// Throughput of the integer bit packer for a range of field widths.
+E57_BENCHMARK( Writer, IntegerBitWidths )
+{
+   std::mt19937_64 rng( 42 );
+
+   for ( unsigned bits : { 1, 2, 4, 7, 8, 12, 16, 24, 31, 32, 48, 63, 64 } )
+   {
+      int64_t minimum = 0;
+      int64_t maximum = 0;
+
+      if ( bits == 64 )
+      {
+         minimum = std::numeric_limits<int64_t>::min();
+         maximum = std::numeric_limits<int64_t>::max();
+      }
+      else
+      {
+         maximum = static_cast<int64_t>( ( uint64_t( 1 ) << bits ) - 1 );
+      }
+
+      const uint64_t mask = ( bits == 64 ) ? ~uint64_t( 0 ) : ( uint64_t( 1 ) << bits ) - 1;
+
+      std::vector<int64_t> values( cNumRecords );
+
+      for ( auto &value : values )
+      {
+         value = static_cast<int64_t>( static_cast<uint64_t>( minimum ) + ( rng() & mask ) );
+      }
+
+      const double seconds = Benchmark::time( [&] { writeIntegers( values, minimum, maximum ); } );
+
+      Benchmark::report( "bits=" + std::to_string( bits ), seconds, cNumRecords,
+                         cNumRecords * bits / 8 );
+   }
+
+   std::remove( cFileName );
+}
+
+namespace
+{
+   // Random cartesian coordinates within +/- 1km.
+   void makeXYZ( std::vector<double> ( &outXYZ )[3] )
+   {
+      std::mt19937_64 rng( 42 );
+      std::uniform_real_distribution<double> distribution( -999.0, 999.0 );
+
+      for ( auto &axis : outXYZ )
+      {
+         axis.resize( cNumRecords );
+
+         for ( auto &value : axis )
+         {
+            value = distribution( rng );
+         }
+      }
+   }
+
+   // Write the coordinates into ScaledInteger fields (1mm resolution).
+   void writeScaledXYZ( std::vector<double> ( &inXYZ )[3],
+                        const e57::CompressedVectorWriterOptions &inOptions = {},
+                        const char *inFileName = cFileName )
+   {
+      const double cScale = 0.001;
+      const int64_t cRawLimit = 1000000; // +/- 1km
+
+      e57::ImageFile imf( inFileName, "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "cartesianX", e57::ScaledIntegerNode( imf, 0, -cRawLimit, cRawLimit, cScale ) );
+      proto.set( "cartesianY", e57::ScaledIntegerNode( imf, 0, -cRawLimit, cRawLimit, cScale ) );
+      proto.set( "cartesianZ", e57::ScaledIntegerNode( imf, 0, -cRawLimit, cRawLimit, cScale ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode cv( imf, proto, codecs );
+      imf.root().set( "points", cv );
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "cartesianX", inXYZ[0].data(), cNumRecords, true, true );
+      sbufs.emplace_back( imf, "cartesianY", inXYZ[1].data(), cNumRecords, true, true );
+      sbufs.emplace_back( imf, "cartesianZ", inXYZ[2].data(), cNumRecords, true, true );
+
+      e57::CompressedVectorWriter writer = cv.writer( sbufs, inOptions );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+}
+
+// Throughput of writing cartesian coordinates from doubles into ScaledInteger fields, which
+// includes quantizing each value.
+E57_BENCHMARK( Writer, ScaledIntegerXYZ )
+{
+   std::vector<double> xyz[3];
+   makeXYZ( xyz );
+
+   const double seconds = Benchmark::time( [&] { writeScaledXYZ( xyz ); } );
+
+   Benchmark::report( "points", seconds, cNumRecords, cNumRecords * 3 * sizeof( double ) );
+
+   std::remove( cFileName );
+}
+
+// Same as ScaledIntegerXYZ, encoding the bytestreams on multiple threads.
+E57_BENCHMARK( Writer, EncoderThreads )
+{
+   std::vector<double> xyz[3];
+   makeXYZ( xyz );
+
+   for ( unsigned threads : { 1, 2, 3 } )
+   {
+      e57::CompressedVectorWriterOptions options;
+      options.encoderThreadCount = threads;
+
+      const double seconds = Benchmark::time( [&] { writeScaledXYZ( xyz, options ); } );
+
+      Benchmark::report( "threads=" + std::to_string( threads ), seconds, cNumRecords,
+                         cNumRecords * 3 * sizeof( double ) );
+   }
+
+   std::remove( cFileName );
+}
+
+// Same as ScaledIntegerXYZ, with and without writing data packets on a background thread.
+E57_BENCHMARK( Writer, BackgroundWrites )
+{
+   std::vector<double> xyz[3];
+   makeXYZ( xyz );
+
+   for ( bool background : { false, true } )
+   {
+      e57::CompressedVectorWriterOptions options;
+      options.writePacketsInBackground = background;
+
+      const double seconds = Benchmark::time( [&] { writeScaledXYZ( xyz, options ); } );
+
+      Benchmark::report( background ? "background" : "foreground", seconds, cNumRecords,
+                         cNumRecords * 3 * sizeof( double ) );
+   }
+
+   std::remove( cFileName );
+}
+
+// Writes fields of very different widths (1, 12, 21 and 32 bits per record) and reports how full
+// the data packets are.
+E57_BENCHMARK( Writer, PacketFill )
+{
+   std::vector<double> xyz[3];
+   makeXYZ( xyz );
+
+   std::mt19937_64 rng( 42 );
+   std::vector<int64_t> intensity( cNumRecords );
+   std::vector<int64_t> invalid( cNumRecords );
+   std::vector<float> time( cNumRecords );
+
+   for ( size_t i = 0; i < cNumRecords; ++i )
+   {
+      intensity[i] = static_cast<int64_t>( rng() % 4096 );
+      invalid[i] = static_cast<int64_t>( rng() % 2 );
+      time[i] = static_cast<float>( i ) * 0.001F;
+   }
+
+   e57::CompressedVectorWriterStatistics stats;
+
+   const double seconds = Benchmark::time( [&] {
+      e57::ImageFile imf( cFileName, "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "cartesianX", e57::ScaledIntegerNode( imf, 0, -1000000, 1000000, 0.001 ) );
+      proto.set( "cartesianY", e57::ScaledIntegerNode( imf, 0, -1000000, 1000000, 0.001 ) );
+      proto.set( "cartesianZ", e57::ScaledIntegerNode( imf, 0, -1000000, 1000000, 0.001 ) );
+      proto.set( "intensity", e57::IntegerNode( imf, 0, 0, 4095 ) );
+      proto.set( "cartesianInvalidState", e57::IntegerNode( imf, 0, 0, 1 ) );
+      proto.set( "timeStamp", e57::FloatNode( imf, 0.0, e57::PrecisionSingle ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode cv( imf, proto, codecs );
+      imf.root().set( "points", cv );
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "cartesianX", xyz[0].data(), cNumRecords, true, true );
+      sbufs.emplace_back( imf, "cartesianY", xyz[1].data(), cNumRecords, true, true );
+      sbufs.emplace_back( imf, "cartesianZ", xyz[2].data(), cNumRecords, true, true );
+      sbufs.emplace_back( imf, "intensity", intensity.data(), cNumRecords, true );
+      sbufs.emplace_back( imf, "cartesianInvalidState", invalid.data(), cNumRecords, true );
+      sbufs.emplace_back( imf, "timeStamp", time.data(), cNumRecords, true );
+
+      e57::CompressedVectorWriter writer = cv.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      stats = writer.statistics();
+
+      imf.close();
+   } );
+
+   Benchmark::report( "points", seconds, cNumRecords );
+
+   std::printf( "  %-28s %10llu packets %9.2f %% full\n", "data packets",
+                static_cast<unsigned long long>( stats.dataPacketCount ),
+                stats.averageDataPacketFill * 100.0 );
+
+   std::remove( cFileName );
+}
+
+// Latency of closing a file with a large XML section, which is when the XML is written.
+E57_BENCHMARK( Writer, CloseLargeXML )
+{
+   constexpr size_t cNumElements = 20000;
+   constexpr int64_t cMaxIndex = std::numeric_limits<int32_t>::max();
+
+   double seconds = std::numeric_limits<double>::max();
+
+   for ( int run = 0; run < 3; ++run )
+   {
+      e57::ImageFile imf( cFileName, "w" );
+
+      e57::VectorNode images( imf, true );
+      imf.root().set( "images", images );
+
+      for ( size_t i = 0; i < cNumElements; ++i )
+      {
+         const auto index = static_cast<int64_t>( i );
+
+         e57::StructureNode image( imf );
+         image.set( "guid", e57::StringNode( imf, "{image-" + std::to_string( i ) + "}" ) );
+         image.set( "index", e57::IntegerNode( imf, index, 0, cMaxIndex ) );
+         image.set( "focalLength", e57::FloatNode( imf, 0.035 + i * 1.0e-6 ) );
+         image.set( "offset",
+                    e57::ScaledIntegerNode( imf, index, int64_t( 0 ), cMaxIndex, 0.001 ) );
+
+         e57::StructureNode pose( imf );
+         pose.set( "x", e57::FloatNode( imf, i * 0.5 ) );
+         pose.set( "y", e57::FloatNode( imf, i * -0.5, e57::PrecisionSingle ) );
+         image.set( "pose", pose );
+
+         images.append( image );
+      }
+
+      seconds = std::min( seconds, Benchmark::time( [&] { imf.close(); }, 1 ) );
+   }
+
+   std::FILE *file = std::fopen( cFileName, "rb" );
+   std::fseek( file, 0, SEEK_END );
+   const long size = std::ftell( file );
+   std::fclose( file );
+
+   Benchmark::report( "elements", seconds, cNumElements, static_cast<uint64_t>( size ) );
+
+   std::remove( cFileName );
+}
+
+// Copying a scan into another file section by section, compared with decoding its records and
+// encoding them again.
+E57_BENCHMARK( Writer, CopyScan )
+{
+   const char *cCopyFileName = "benchmark-writer-copy.e57";
+
+   std::vector<double> xyz[3];
+   makeXYZ( xyz );
+   writeScaledXYZ( xyz );
+
+   const double copySeconds = Benchmark::time( [&] {
+      e57::ImageFile source( cFileName, "r" );
+      e57::ImageFile dest( cCopyFileName, "w" );
+
+      dest.root().set( "points", dest.copyNode( source.root().get( "points" ) ) );
+
+      dest.close();
+      source.close();
+   } );
+
+   Benchmark::report( "copyNode", copySeconds, cNumRecords, cNumRecords * 3 * sizeof( double ) );
+
+   const double reencodeSeconds = Benchmark::time( [&] {
+      std::vector<double> copied[3];
+
+      e57::ImageFile source( cFileName, "r" );
+      e57::CompressedVectorNode cv( source.root().get( "points" ) );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      const char *cNames[3] = { "cartesianX", "cartesianY", "cartesianZ" };
+
+      for ( int i = 0; i < 3; ++i )
+      {
+         copied[i].resize( cNumRecords );
+         dbufs.emplace_back( source, cNames[i], copied[i].data(), cNumRecords, true, true );
+      }
+
+      e57::CompressedVectorReader reader = cv.reader( dbufs );
+      reader.read();
+      reader.close();
+
+      source.close();
+
+      writeScaledXYZ( copied, {}, cCopyFileName );
+   } );
+
+   Benchmark::report( "read & write", reencodeSeconds, cNumRecords,
+                      cNumRecords * 3 * sizeof( double ) );
+
+   std::remove( cCopyFileName );
+   std::remove( cFileName );
+}
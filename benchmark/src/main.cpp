@@ -0,0 +1,17 @@
+// libE57Format benchmarks Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <iostream>
+
+#include "E57Version.h"
+
+#include "Benchmark.h"
+
+int main( int argc, char **argv )
+{
+   const std::string filter = ( argc > 1 ) ? argv[1] : "";
+
+   std::cout << "e57Format version: " << e57::Version::library() << std::endl;
+
+   return Benchmark::runAll( filter );
+}
@@ -221,6 +221,7 @@ public:
 
    class BlobNode;
    class BlobNodeImpl;
+   class CompiledPath;
    class CompressedVectorNode;
    class CompressedVectorNodeImpl;
    class CompressedVectorReader;
@@ -278,6 +279,30 @@ public:
       /// @endcond
    };
 
+   /// @brief A path name which has been checked and split into its element names once, to look up
+   /// the same path many times without parsing it again.
+   ///
+   /// Use it with StructureNode::isDefined(const CompiledPath &) const,
+   /// StructureNode::get(const CompiledPath &) const, and their VectorNode equivalents, on the
+   /// nodes of the ImageFile it was made for.
+   class E57_DLL CompiledPath
+   {
+   public:
+      CompiledPath() = delete;
+      CompiledPath( const ImageFile &imf, const ustring &pathName );
+
+      ustring pathName() const;
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      friend class StructureNodeImpl;
+
+      ustring pathName_;
+      bool isRelative_;
+      std::vector<ustring> elementNames_;
+      /// @endcond
+   };
+
    class E57_DLL StructureNode
    {
    public:
@@ -286,9 +311,12 @@ public:
 
       int64_t childCount() const;
       bool isDefined( const ustring &pathName ) const;
+      bool isDefined( const CompiledPath &path ) const;
       Node get( int64_t index ) const;
       Node get( const ustring &pathName ) const;
+      Node get( const CompiledPath &path ) const;
       void set( const ustring &pathName, const Node &n );
+      void replace( const ustring &pathName, const Node &n );
 
       // Up/Down cast conversion
       operator Node() const;
@@ -330,8 +358,10 @@ public:
 
       int64_t childCount() const;
       bool isDefined( const ustring &pathName ) const;
+      bool isDefined( const CompiledPath &path ) const;
       Node get( int64_t index ) const;
       Node get( const ustring &pathName ) const;
+      Node get( const CompiledPath &path ) const;
       void append( const Node &n );
 
       // Up/Down cast conversion
@@ -426,7 +456,7 @@ public:
 
       unsigned read();
       unsigned read( std::vector<SourceDestBuffer> &dbufs );
-      void seek( int64_t recordNumber ); // !!! not implemented yet
+      void seek( int64_t recordNumber );
       void close();
       bool isOpen();
       CompressedVectorNode compressedVectorNode() const;
@@ -447,6 +477,49 @@ public:
       /// @endcond
    };
 
+   /// @brief Options for CompressedVectorNode::writer()
+   struct E57_DLL CompressedVectorWriterOptions
+   {
+      /// Write the index packets (setting this to false is not standards compliant)
+      bool writeIndexPackets = true;
+
+      /// Number of data packets between index entries. Each entry lets a reader seek() straight to
+      /// its chunk of records; smaller numbers mean faster seeks and a larger index.
+      /// 0 = a single entry for the whole section.
+      unsigned dataPacketsPerIndexEntry = 16;
+
+      /// Number of threads used to encode the bytestreams (1 = encode on the calling thread,
+      /// 0 = one per hardware thread). The file written is the same for any number of threads.
+      unsigned encoderThreadCount = 1;
+
+      /// Write (and checksum) finished data packets on a background thread while the next ones are
+      /// being encoded. The file written is the same either way.
+      bool writePacketsInBackground = true;
+
+      /// Build the binary section in memory and only write it to the file, in one piece, when the
+      /// writer is closed. Staged writers for different CompressedVectorNodes may be open at the
+      /// same time, and each may be written and closed on its own thread. BlobNodes may be created,
+      /// written, and read on the file's own thread meanwhile.
+      ///
+      /// The whole encoded section is held in memory until then, so each staged writer needs about
+      /// as much memory as its section takes in the file (e.g. around 1.2 GB for 100 million
+      /// points with three 32-bit fields). It can't be written out early: the section has to be
+      /// contiguous, and other writers may be adding to the file in the meantime.
+      bool stageSection = false;
+   };
+
+   /// What a CompressedVectorWriter has written so far
+   struct E57_DLL CompressedVectorWriterStatistics
+   {
+      uint64_t recordCount = 0;      ///< Records written
+      uint64_t dataPacketCount = 0;  ///< Data packets written
+      uint64_t dataPacketBytes = 0;  ///< Total length of the data packets
+      uint64_t indexPacketCount = 0; ///< Index packets written (only known after close())
+
+      /// Average length of the data packets as a fraction of the maximum (0 to 1)
+      double averageDataPacketFill = 0.0;
+   };
+
    class E57_DLL CompressedVectorWriter
    {
    public:
@@ -457,6 +530,8 @@ public:
       void close();
       bool isOpen();
       CompressedVectorNode compressedVectorNode() const;
+      CompressedVectorWriterStatistics statistics() const;
+      bool valueRange( const ustring &pathName, double &minimum, double &maximum ) const;
 
       void dump( int indent = 0, std::ostream &os = std::cout ) const;
       void checkInvariant( bool doRecurse = true );
@@ -486,8 +561,10 @@ public:
       VectorNode codecs() const;
 
       // Iterators
-      CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs, 
+      CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs,
                                      bool writeIndexPackets = true );
+      CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs,
+                                     const CompressedVectorWriterOptions &options );
       CompressedVectorReader reader( const std::vector<SourceDestBuffer> &dbufs );
 
       // Up/Down cast conversion
@@ -728,16 +805,83 @@ public:
       /// @endcond
    };
 
+   /// @brief Where an ImageFile opened with ImageFile( std::shared_ptr<ImageFileSink> ) is written
+   /// to, instead of a file on disk
+   /// @details Offsets are physical byte offsets from the start of the E57 file. The ImageFile
+   /// writes whole pages, may write the same bytes more than once, and reads back bytes it has
+   /// written, so the sink must be seekable. Calls are made one at a time, though not always on
+   /// the same thread. Report a failure by throwing an exception.
+   class E57_DLL ImageFileSink
+   {
+   public:
+      virtual ~ImageFileSink() = default;
+
+      /// @brief Writes @a count bytes at @a offset, making the sink longer if needed
+      virtual void write( uint64_t offset, const char *buffer, size_t count ) = 0;
+
+      /// @brief Reads @a count bytes, which have all been written before, from @a offset
+      virtual void read( uint64_t offset, char *buffer, size_t count ) = 0;
+
+      /// @brief Returns the number of bytes written so far (one past the last byte written)
+      virtual uint64_t length() const = 0;
+   };
+
+   /// @brief An ImageFileSink which keeps the E57 file in memory
+   class E57_DLL MemoryImageFileSink : public ImageFileSink
+   {
+   public:
+      void write( uint64_t offset, const char *buffer, size_t count ) override;
+      void read( uint64_t offset, char *buffer, size_t count ) override;
+      uint64_t length() const override;
+
+      /// @brief Returns the bytes of the file, which is complete once the ImageFile is closed
+      const std::vector<char> &data() const;
+
+      /// @brief Moves the bytes of the file out of the sink, leaving it empty
+      std::vector<char> takeData();
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      std::vector<char> data_;
+      /// @endcond
+   };
+
+   /// @brief Options for opening an ImageFile for reading
+   struct E57_DLL ImageFileReadOptions
+   {
+      /// Set how frequently to verify the checksums (see ReadChecksumPolicy).
+      ReadChecksumPolicy checksumPolicy = ChecksumAll;
+
+      /// Parse the XML section with the XML parser's validation and schema processing turned on.
+      /// With it off, the parser only checks the XML is well formed, which opens files with large
+      /// XML sections much faster. The elements and attributes are checked as the node tree is
+      /// built either way.
+      bool validateXml = true;
+
+      /// Only build the parts of the node tree which are used. When the file is opened, the
+      /// structures & vectors below the root are created without their children, which are built
+      /// from the XML section the first time they are needed. Opening is faster and uses less
+      /// memory when only some of the tree is used (e.g. one scan of many), but the XML section is
+      /// kept in memory until the file is closed. The XML is always parsed by the library's own
+      /// parser in this mode, without validation, and errors in the parts of it which aren't used
+      /// aren't reported.
+      bool lazyNodeTree = false;
+   };
+
    class E57_DLL ImageFile
    {
    public:
       ImageFile() = delete;
       ImageFile( const ustring &fname, const ustring &mode,
                  ReadChecksumPolicy checksumPolicy = ChecksumAll );
+      ImageFile( const ustring &fname, const ImageFileReadOptions &options );
       ImageFile( const char *input, uint64_t size,
                  ReadChecksumPolicy checksumPolicy = ChecksumAll );
+      ImageFile( const char *input, uint64_t size, const ImageFileReadOptions &options );
+      explicit ImageFile( std::shared_ptr<ImageFileSink> sink );
 
       StructureNode root() const;
+      Node copyNode( const Node &source );
       void close();
       void cancel();
       bool isOpen() const;
@@ -40,6 +40,7 @@ namespace e57
    /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
    class ReaderImpl;
    class WriterImpl;
+   class Data3DStreamWriterImpl;
    /// @endcond
 
    /// @brief Defines a rigid body translation in Cartesian coordinates.
@@ -952,6 +953,20 @@ namespace e57
       CylindricalRepresentation cylindricalRepresentation;
    };
 
+   /// @brief Stores the headers of a file and of all its Data3D and Image2D blocks
+   /// @details Filled in by Reader::ReadHeaders().
+   struct E57_DLL E57Headers
+   {
+      /// The file header (see Reader::GetE57Root())
+      E57Root root;
+
+      /// The header of each Data3D block, by index (see Reader::ReadData3D())
+      std::vector<Data3D> data3D;
+
+      /// The header of each Image2D block, by index (see Reader::ReadImage2D())
+      std::vector<Image2D> images2D;
+   };
+
    /// @brief Identifies the format representation for the image data
    enum Image2DType
    {
@@ -44,6 +44,15 @@ namespace e57
    {
       /// Set how frequently to verify the checksums (see ReadChecksumPolicy).
       ReadChecksumPolicy checksumPolicy = ChecksumAll;
+
+      /// Have the XML parser validate the file's XML section (see
+      /// ImageFileReadOptions::validateXml). Turn off to open files with large XML sections faster.
+      bool validateXml = true;
+
+      /// Only build the parts of the file's node tree which are read (see
+      /// ImageFileReadOptions::lazyNodeTree). Turn on to open files with many scans or images
+      /// faster when only some of them are read.
+      bool lazyNodeTree = false;
    };
 
    /// @brief Used for reading an E57 file using E57 Simple API.
@@ -80,6 +89,17 @@ namespace e57
       /// @return Returns true if successful
       bool GetE57Root( E57Root &fileHeader ) const;
 
+      /// @brief Returns the file header and the headers of all Data3D and Image2D blocks
+      /// @details Same as calling GetE57Root(), ReadData3D() for each Data3D block, and
+      /// ReadImage2D() for each Image2D block, but the blocks may be read on several threads at
+      /// once, which is faster when opening files with many of them with
+      /// ReaderOptions::lazyNodeTree.
+      /// @param [out] headers the headers
+      /// @param [in] threadCount number of threads to read the blocks on (1 = on the calling
+      /// thread, 0 = one per hardware thread)
+      /// @return Returns true if successful
+      bool ReadHeaders( E57Headers &headers, unsigned threadCount = 1 ) const;
+
       ///@}
 
       /// @name Image2D
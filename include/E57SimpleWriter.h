@@ -50,6 +50,95 @@ namespace e57
 
       /// Write the index packets (setting this to false is not standards compliant)
       bool writeIndexPackets = true;
+
+      /// Number of data packets between index entries (0 = a single entry for each scan)
+      unsigned dataPacketsPerIndexEntry = 16;
+
+      /// When writing a scan with Writer::WriteData3DData(), narrow the minimum/maximum of each
+      /// Integer and ScaledInteger field to the values actually in the buffers, so each record
+      /// uses as few bits as possible. Fields whose values don't fit their declared range keep it.
+      bool fitIntegerRangesToData = false;
+
+      /// When writing a scan with Writer::WriteData3DData(), store each Integer and ScaledInteger
+      /// field which has the same value for every point (e.g. returnIndex or isColorInvalid) as
+      /// a constant (minimum == maximum), which takes no space in the data packets. Other fields
+      /// keep their declared range. Implied by fitIntegerRangesToData.
+      bool writeConstantFieldsAsConstant = false;
+
+      /// Number of threads used to encode point data (1 = encode on the calling thread,
+      /// 0 = one per hardware thread). The file written is the same for any number of threads.
+      unsigned encoderThreadCount = 1;
+
+      /// Write (and checksum) finished data packets on a background thread while the next ones are
+      /// being encoded. The file written is the same either way.
+      bool writePacketsInBackground = true;
+
+      /// Build each scan's points in memory and only write them to the file, in one piece, when
+      /// their CompressedVectorWriter is closed. The writers set up for several scans with
+      /// SetUpData3DPointsData() may then be open at the same time, and each may be written and
+      /// closed on its own thread, so the scans are encoded in parallel. Other calls to the Writer
+      /// must still be made from one thread. The scans are laid out in the order they are closed.
+      ///
+      /// Each scan's encoded points are held in memory until its writer is closed, so the scans
+      /// being written at the same time need about as much memory as they take in the file (see
+      /// CompressedVectorWriterOptions::stageSection).
+      bool stageData3DSections = false;
+   };
+
+   /// @brief Writes the points of a Data3D scan in chunks, for when the number of points isn't
+   /// known up front.
+   ///
+   /// @details Created by Writer::NewData3DStream(). Each call to Append() encodes the points in
+   /// the buffers passed to it, so the buffers may be refilled and reused for the next chunk and
+   /// only one chunk needs to be held in memory. The chunks may be of any size.
+   ///
+   /// The point count and any cartesian bounds, spherical bounds, index bounds, and (for Float or
+   /// Double intensities) intensity limits which are not set in the header are worked out from the
+   /// points appended, and are written when the stream is closed. Coordinates marked invalid are
+   /// left out: all cartesian coordinates if cartesianInvalidState is 1 or 2, the range if
+   /// sphericalInvalidState is 1, and all spherical coordinates if it is 2. So are intensities
+   /// marked invalid.
+   ///
+   /// Copies of a Data3DStreamWriter refer to the same stream. If it hasn't been closed, the stream
+   /// is closed when the last copy is destroyed, ignoring any errors.
+   class E57_DLL Data3DStreamWriter
+   {
+   public:
+      /// @brief Writes a chunk of points to the scan
+      /// @details The buffers must hold the same fields for every call, using the same type of
+      /// coordinates.
+      /// @param [in] buffers pointers to user-provided buffers containing the points
+      /// @param [in] pointCount number of points in the buffers
+      /// @throw ::ErrorBuffersNotCompatible if the fields don't match the previous calls
+      void Append( const Data3DPointsFloat &buffers, size_t pointCount );
+
+      /// @overload
+      void Append( const Data3DPointsDouble &buffers, size_t pointCount );
+
+      /// @brief Finishes writing the scan's points and writes the bounds and limits worked out from
+      /// them
+      /// @details Closing a closed stream does nothing.
+      /// @return Returns the index of the scan's data3D block.
+      int64_t Close();
+
+      /// @brief Returns true if points may still be appended to the stream
+      bool IsOpen() const;
+
+      /// @brief Returns the number of points appended so far
+      uint64_t PointCount() const;
+
+      /// @brief Returns the scan's header, including the point count and the bounds and limits
+      /// worked out once the stream is closed
+      const Data3D &Header() const;
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      friend class Writer;
+
+      explicit Data3DStreamWriter( std::shared_ptr<Data3DStreamWriterImpl> impl );
+
+      std::shared_ptr<Data3DStreamWriterImpl> impl_;
+      /// @endcond
    };
 
    /// @brief Used for writing an E57 file using the E57 Simple API.
@@ -64,6 +153,13 @@ namespace e57
       /// @param [in] options Options to be used for the file
       Writer( const ustring &filePath, const WriterOptions &options );
 
+      /// @brief Writer constructor for writing to a sink instead of a file on disk
+      /// @details Use a MemoryImageFileSink to build the E57 file in memory. The file is complete
+      /// once the Writer has been closed.
+      /// @param [in] sink Where to write the E57 file (must be empty)
+      /// @param [in] options Options to be used for the file
+      Writer( std::shared_ptr<ImageFileSink> sink, const WriterOptions &options );
+
       /// @brief Writer constructor (deprecated)
       /// @param [in] filePath Path to E57 file
       /// @param [in] coordinateMetadata Information describing the Coordinate Reference System to
@@ -122,8 +218,11 @@ namespace e57
 
       /// @brief This function writes the Data3D data to the file
       /// @details The user needs to config a Data3D structure with all the scanning information
-      /// before making this call.
-      /// @note @p data3DHeader may be modified (adding a guid or adding missing, required fields).
+      /// before making this call. Any cartesian bounds, spherical bounds, index bounds, and (for
+      /// Float or Double intensities) intensity limits which are not set are worked out while the
+      /// points are encoded, leaving out points marked as invalid.
+      /// @note @p data3DHeader may be modified (adding a guid, adding missing, required fields, or
+      /// adding the bounds & limits worked out from the points).
       /// @param [in,out] data3DHeader metadata about what is included in the buffers
       /// @param [in] buffers pointers to user-provided buffers containing the actual data
       /// @return Returns the index of the new scan's data3D block.
@@ -152,6 +251,17 @@ namespace e57
       CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                     const Data3DPointsDouble &buffers );
 
+      /// @brief Starts writing a new scan whose points are appended in chunks
+      /// @details The user needs to config a Data3D structure with all the scanning information
+      /// before making this call, as for NewData3D(). Because the points aren't known yet, any
+      /// ScaledInteger fields must have their minimum & maximum set, as must the intensity limits
+      /// for an Integer or ScaledInteger intensity and the color limits if there are colors.
+      /// @note The stream must be closed before the Writer is.
+      /// @param [in] data3DHeader scan metadata
+      /// @return Returns the stream to append the points to.
+      /// @throw ::ErrorInvalidData3DValue if a range needed to encode the points isn't set
+      Data3DStreamWriter NewData3DStream( const Data3D &data3DHeader );
+
       /// @brief Writes out the group data
       /// @param [in] dataIndex data block index given by the NewData3D
       /// @param [in] groupCount size of each of the buffers given
@@ -30,6 +30,7 @@
 /// @file BlobNode.cpp
 
 #include "BlobNodeImpl.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
 
 using namespace e57;
@@ -123,7 +124,7 @@ is an error to attempt to attach the BlobNode to a different ImageFile.
 
 @pre The @a destImageFile must be open (i.e. destImageFile.isOpen() must be true).
 @pre The @a destImageFile must have been opened in write mode (i.e. destImageFile.isWritable()
-must be true).
+must be true), not to update its metadata ("u" mode).
 @pre byteCount >= 0
 
 @throw ::ErrorBadAPIArgument
@@ -134,7 +135,7 @@ must be true).
 @see Node, BlobNode::read, BlobNode::write
 */
 BlobNode::BlobNode( const ImageFile &destImageFile, int64_t byteCount ) :
-   impl_( new BlobNodeImpl( destImageFile.impl(), byteCount ) )
+   impl_( destImageFile.impl()->makeNode<BlobNodeImpl>( byteCount ) )
 {
 }
 
@@ -357,7 +358,7 @@ BlobNode::BlobNode( const Node &n )
 
 /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
 BlobNode::BlobNode( const ImageFile &destImageFile, int64_t fileOffset, int64_t length ) :
-   impl_( new BlobNodeImpl( destImageFile.impl(), fileOffset, length ) )
+   impl_( destImageFile.impl()->makeNode<BlobNodeImpl>( fileOffset, length ) )
 {
 }
 
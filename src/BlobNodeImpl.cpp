@@ -30,6 +30,7 @@
 #include "ImageFileImpl.h"
 #include "SectionHeaders.h"
 #include "StringFunctions.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -40,6 +41,13 @@ namespace e57
 
       ImageFileImplSharedPtr imf( destImageFile );
 
+      // Its section couldn't be written to a file whose metadata is being updated, so check before
+      // allocating any space for it
+      if ( imf->isUpdater() )
+      {
+         throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + imf->fileName() );
+      }
+
       // This what caller thinks blob length is
       blobLogicalLength_ = byteCount;
 
@@ -51,6 +59,10 @@ namespace e57
          binarySectionLogicalLength_ += 4 - remainder;
       }
 
+      // Staged sections may be placed in the file by writers closing on other threads, so hold
+      // the file while reserving the blob's space and writing its header
+      std::lock_guard<std::mutex> lock( imf->writerMutex_ );
+
       // Reserve space for blob in file, extend with zeros since writes will
       // happen at later time by caller
       binarySectionLogicalStart_ = imf->allocateSpace( binarySectionLogicalLength_, true );
@@ -135,6 +147,10 @@ namespace e57
       }
 
       ImageFileImplSharedPtr imf( destImageFile_ );
+
+      // As when writing, staged sections may be being placed in the file on other threads
+      std::lock_guard<std::mutex> lock( imf->writerMutex_ );
+
       imf->file_->seek( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start );
       imf->file_->read( reinterpret_cast<char *>( buf ),
                         static_cast<size_t>( count ) ); //??? arg1 void* ?
@@ -165,6 +181,11 @@ namespace e57
       }
 
       ImageFileImplSharedPtr imf( destImageFile_ );
+
+      // Staged sections may be placed in the file by writers closing on other threads, and they
+      // share its position
+      std::lock_guard<std::mutex> lock( imf->writerMutex_ );
+
       imf->file_->seek( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start );
       imf->file_->write( reinterpret_cast<char *>( buf ),
                          static_cast<size_t>( count ) ); //??? arg1 void* ?
@@ -182,7 +203,7 @@ namespace e57
       }
    }
 
-   void BlobNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, CheckedFile &cf, int indent,
+   void BlobNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, XmlWriter &xml, int indent,
                                 const char *forcedFieldName )
    {
       // don't checkImageFileOpen
@@ -200,9 +221,60 @@ namespace e57
       //??? need to implement
       //??? Type --> type
       //??? need to have length?, check same as in section header?
-      uint64_t physicalOffset = cf.logicalToPhysical( binarySectionLogicalStart_ );
-      cf << space( indent ) << "<" << fieldName << " type=\"Blob\" fileOffset=\"" << physicalOffset
-         << "\" length=\"" << blobLogicalLength_ << "\"/>\n";
+      uint64_t physicalOffset = CheckedFile::logicalToPhysical( binarySectionLogicalStart_ );
+      xml.indent( indent ) << "<" << fieldName << " type=\"Blob\" fileOffset=\"" << physicalOffset
+                           << "\" length=\"" << blobLogicalLength_ << "\"/>\n";
+   }
+
+   NodeImplSharedPtr BlobNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( !destImageFile->isWriter() )
+      {
+         throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + destImageFile->fileName() );
+      }
+
+      // The copy is appended to the file, where an unstaged writer would be adding its packets
+      if ( destImageFile->unstagedWriterCount() > 0 )
+      {
+         throw E57_EXCEPTION2( ErrorTooManyWriters,
+                               "fileName=" + destImageFile->fileName() +
+                                  " writerCount=" + toString( destImageFile->writerCount() ) +
+                                  " readerCount=" + toString( destImageFile->readerCount() ) );
+      }
+
+      ImageFileImplSharedPtr imf( destImageFile_ );
+
+      // Round section length up to multiple of 4 bytes, as for a new blob
+      BlobSectionHeader header;
+      header.sectionLogicalLength = sizeof( BlobSectionHeader ) + blobLogicalLength_;
+
+      const auto cPadding = static_cast<size_t>( ( 4 - header.sectionLogicalLength % 4 ) % 4 );
+      header.sectionLogicalLength += cPadding;
+
+      // As for a copied CompressedVector section, hold the file against staged sections
+      std::lock_guard<std::mutex> lock( destImageFile->writerMutex_ );
+
+      const uint64_t cSectionStart =
+         destImageFile->allocateSpace( header.sectionLogicalLength, false );
+
+      CheckedFile *destFile = destImageFile->file_;
+
+      destFile->seek( cSectionStart );
+      destFile->write( reinterpret_cast<char *>( &header ), sizeof( header ) );
+      destFile->copy( *imf->file_, binarySectionLogicalStart_ + sizeof( BlobSectionHeader ),
+                      blobLogicalLength_ );
+
+      if ( cPadding > 0 )
+      {
+         const char cZeros[4] = {};
+         destFile->write( cZeros, cPadding );
+      }
+
+      return destImageFile->makeNode<BlobNodeImpl>(
+         static_cast<int64_t>( CheckedFile::logicalToPhysical( cSectionStart ) ),
+         static_cast<int64_t>( blobLogicalLength_ ) );
    }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -94,6 +94,12 @@ constexpr size_t CheckedFile::logicalPageSize;
 
 namespace
 {
+   // Set on the thread doing a file's background writes, so it doesn't wait on itself
+   thread_local bool tIsBackgroundWriter = false;
+
+   // Most pages read() or write() handle with one system call
+   constexpr size_t cRunPages = 64;
+
    inline uint32_t swap_uint32( uint32_t val )
    {
       val = ( ( val << 8 ) & 0xFF00FF00 ) | ( ( val >> 8 ) & 0xFF00FF );
@@ -102,7 +108,7 @@ namespace
    }
 
    /// Calc CRC32C of given data
-   uint32_t checksum( char *buf, size_t size )
+   uint32_t checksum( const char *buf, size_t size )
    {
       static const CRC::Parameters<crcpp_uint32, 32> sCRCParams{ 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF,
                                                                  true, true };
@@ -135,6 +141,20 @@ public:
       return cursorStream_;
    }
 
+   /// Returns a pointer to the given physical page in the buffer, or nullptr if the buffer
+   /// doesn't hold all of it
+   const char *page( uint64_t page ) const
+   {
+      const uint64_t cStart = page * CheckedFile::physicalPageSize;
+
+      if ( ( cStart > streamSize_ ) || ( streamSize_ - cStart < CheckedFile::physicalPageSize ) )
+      {
+         return nullptr;
+      }
+
+      return stream_ + cStart;
+   }
+
    bool seek( uint64_t offset, int whence )
    {
       if ( whence == SEEK_CUR )
@@ -161,12 +181,8 @@ public:
 
    void read( char *buffer, uint64_t count )
    {
-      const uint64_t start = cursorStream_;
-      for ( uint64_t i = 0; i < count; ++i )
-      {
-         buffer[i] = stream_[start + i];
-         ++cursorStream_;
-      }
+      memcpy( buffer, stream_ + cursorStream_, static_cast<size_t>( count ) );
+      cursorStream_ += count;
    }
 
 private:
@@ -214,6 +230,21 @@ CheckedFile::CheckedFile( const ustring &fileName, Mode mode, ReadChecksumPolicy
          fd_ = open64( fileName_, writeFlags, writeMode );
       }
       break;
+
+      case Update:
+      {
+#if defined( _MSC_VER )
+         constexpr int updateFlags = O_RDWR | O_BINARY;
+#else
+         constexpr int updateFlags = O_RDWR;
+#endif
+
+         fd_ = open64( fileName_, updateFlags, 0 );
+
+         logicalLength_ = physicalToLogical( lseek64( 0LL, SEEK_END ) );
+         lseek64( 0, SEEK_SET );
+      }
+      break;
    }
 }
 
@@ -230,6 +261,22 @@ CheckedFile::CheckedFile( const char *input, uint64_t size, ReadChecksumPolicy p
    logicalLength_ = physicalToLogical( physicalLength_ );
 }
 
+CheckedFile::CheckedFile( std::shared_ptr<ImageFileSink> sink ) :
+   fileName_( "<ImageFileSink>" ), sink_( std::move( sink ) )
+{
+   if ( sink_ == nullptr )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "fileName=" + fileName_ );
+   }
+
+   // Start with an empty file, as if it had been truncated
+   if ( sink_->length() != 0 )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                            "fileName=" + fileName_ + " length=" + toString( sink_->length() ) );
+   }
+}
+
 int CheckedFile::open64( const ustring &fileName, int flags, int mode )
 {
 #if defined( _MSC_VER )
@@ -284,6 +331,8 @@ CheckedFile::~CheckedFile()
 
 void CheckedFile::read( char *buf, size_t nRead, size_t /*bufSize*/ )
 {
+   waitForBackgroundWrites();
+
    //??? what if read past logical end?, or physical end?
    //??? need to keep track of logical length?
    //??? check bufSize OK
@@ -304,44 +353,71 @@ void CheckedFile::read( char *buf, size_t nRead, size_t /*bufSize*/ )
 
    size_t n = std::min( nRead, logicalPageSize - pageOffset );
 
-   // Allocate temp page buffer
-   std::vector<char> page_buffer_v( physicalPageSize );
-   char *page_buffer = page_buffer_v.data();
+   // Pages are read a run at a time into a temp buffer. When reading from memory, the pages are
+   // checked and copied from where they are instead.
+   const size_t pageCount = ( pageOffset + nRead + logicalPageSize - 1 ) / logicalPageSize;
+
+   std::vector<char> page_buffer_v(
+      ( bufView_ != nullptr ) ? 0 : std::min( pageCount, cRunPages ) * physicalPageSize );
 
    while ( nRead > 0 )
    {
-      readPhysicalPage( page_buffer, page );
+      size_t runPages = 1;
 
-      switch ( checkSumPolicy_ )
+      if ( bufView_ == nullptr )
       {
-         case ChecksumPolicy::ChecksumNone:
-            break;
+         runPages = std::min( ( pageOffset + nRead + logicalPageSize - 1 ) / logicalPageSize,
+                              cRunPages );
 
-         case ChecksumPolicy::ChecksumAll:
-            verifyChecksum( page_buffer, page );
-            break;
+         readPhysicalPages( page_buffer_v.data(), page, runPages );
+      }
+
+      for ( size_t i = 0; i < runPages; ++i )
+      {
+         const char *page_buffer = page_buffer_v.data() + i * physicalPageSize;
 
-         default:
+         if ( bufView_ != nullptr )
          {
-            const auto checksumMod =
-               static_cast<unsigned int>( std::nearbyint( 100.0 / checkSumPolicy_ ) );
+            page_buffer = bufView_->page( page );
 
-            if ( !( page % checksumMod ) || ( nRead < physicalPageSize ) )
+            if ( page_buffer == nullptr )
             {
+               throw E57_EXCEPTION2( ErrorReadFailed,
+                                     "fileName=" + fileName_ + " page=" + toString( page ) );
+            }
+         }
+
+         switch ( checkSumPolicy_ )
+         {
+            case ChecksumPolicy::ChecksumNone:
+               break;
+
+            case ChecksumPolicy::ChecksumAll:
                verifyChecksum( page_buffer, page );
+               break;
+
+            default:
+            {
+               const auto checksumMod =
+                  static_cast<unsigned int>( std::nearbyint( 100.0 / checkSumPolicy_ ) );
+
+               if ( !( page % checksumMod ) || ( nRead < physicalPageSize ) )
+               {
+                  verifyChecksum( page_buffer, page );
+               }
             }
+            break;
          }
-         break;
-      }
 
-      memcpy( buf, page_buffer + pageOffset, n );
+         memcpy( buf, page_buffer + pageOffset, n );
 
-      buf += n;
-      nRead -= n;
-      pageOffset = 0;
-      ++page;
+         buf += n;
+         nRead -= n;
+         pageOffset = 0;
+         ++page;
 
-      n = std::min( nRead, logicalPageSize );
+         n = std::min( nRead, logicalPageSize );
+      }
    }
 
    // When done, leave cursor just past end of last byte read
@@ -359,6 +435,8 @@ void CheckedFile::write( const char *buf, size_t nWrite )
       throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
    }
 
+   waitForBackgroundWrites();
+
    uint64_t end = position( Logical ) + nWrite;
 
    uint64_t page = 0;
@@ -368,36 +446,50 @@ void CheckedFile::write( const char *buf, size_t nWrite )
 
    size_t n = std::min( nWrite, logicalPageSize - pageOffset );
 
-   // Allocate temp page buffer
-   std::vector<char> page_buffer_v( physicalPageSize );
-   char *page_buffer = page_buffer_v.data();
+   // Pages are filled in a buffer & written a run at a time. Only a page which is partly
+   // overwritten has to be read first.
+   const uint64_t physicalLength = length( Physical );
+   const size_t pageCount = ( pageOffset + nWrite + logicalPageSize - 1 ) / logicalPageSize;
+
+   std::vector<char> page_buffer_v( std::min( pageCount, cRunPages ) * physicalPageSize );
 
    while ( nWrite > 0 )
    {
-      const uint64_t physicalLength = length( Physical );
+      const uint64_t firstPage = page;
+      size_t runPages = 0;
 
-      if ( page * physicalPageSize < physicalLength )
+      while ( ( nWrite > 0 ) && ( runPages < cRunPages ) )
       {
-         readPhysicalPage( page_buffer, page );
-      }
+         char *page_buffer = page_buffer_v.data() + runPages * physicalPageSize;
+
+         if ( n < logicalPageSize )
+         {
+            if ( page * physicalPageSize < physicalLength )
+            {
+               readPhysicalPage( page_buffer, page );
+            }
+            else
+            {
+               memset( page_buffer, 0, physicalPageSize );
+            }
+         }
 
 #ifdef E57_VERBOSE
-      // cout << "  page_buffer[0] read: '" << page_buffer[0] << "'" << std::endl;
-      // cout << "copy " << n << "bytes to page=" << page << " pageOffset=" <<
-      // pageOffset << " buf='"; //??? for (size_t i=0; i < n; i++) cout <<
-      // buf[i]; cout << "'" << std::endl;
-#endif
-      memcpy( page_buffer + pageOffset, buf, n );
-      writePhysicalPage( page_buffer, page );
-#ifdef E57_VERBOSE
-      // cout << "  page_buffer[0] after write: '" << page_buffer[0] << "'" <<
-      // std::endl; //???
+         // cout << "copy " << n << "bytes to page=" << page << " pageOffset=" <<
+         // pageOffset << " buf='"; //??? for (size_t i=0; i < n; i++) cout <<
+         // buf[i]; cout << "'" << std::endl;
 #endif
-      buf += n;
-      nWrite -= n;
-      pageOffset = 0;
-      page++;
-      n = std::min( nWrite, logicalPageSize );
+         memcpy( page_buffer + pageOffset, buf, n );
+
+         buf += n;
+         nWrite -= n;
+         pageOffset = 0;
+         page++;
+         runPages++;
+         n = std::min( nWrite, logicalPageSize );
+      }
+
+      writePhysicalPages( page_buffer_v.data(), firstPage, runPages );
    }
 
    if ( end > logicalLength_ )
@@ -409,52 +501,40 @@ void CheckedFile::write( const char *buf, size_t nWrite )
    seek( end, Logical );
 }
 
-CheckedFile &CheckedFile::operator<<( const ustring &s )
+void CheckedFile::copy( CheckedFile &source, uint64_t sourceOffset, uint64_t nCopy )
 {
-   write( s.c_str(), s.length() ); //??? should be times size of uchar?
-   return ( *this );
-}
+   // Copy a run of pages at a time, like write() writes them
+   std::vector<char> buffer(
+      static_cast<size_t>( std::min<uint64_t>( nCopy, cRunPages * logicalPageSize ) ) );
 
-CheckedFile &CheckedFile::operator<<( int64_t i )
-{
-   std::stringstream ss;
-   ss << i;
-   return ( *this << ss.str() );
-}
+   uint64_t offset = position( Logical );
 
-CheckedFile &CheckedFile::operator<<( uint64_t i )
-{
-   std::stringstream ss;
-   ss << i;
-   return ( *this << ss.str() );
-}
+   while ( nCopy > 0 )
+   {
+      const auto n = static_cast<size_t>( std::min<uint64_t>( nCopy, buffer.size() ) );
 
-CheckedFile &CheckedFile::operator<<( float f )
-{
-   //??? is 7 digits right number?
-   return writeFloatingPoint( f, 7 );
-}
+      source.seek( sourceOffset );
+      source.read( buffer.data(), n );
 
-CheckedFile &CheckedFile::operator<<( double d )
-{
-   //??? is 17 digits right number?
-   return writeFloatingPoint( d, 17 );
+      seek( offset );
+      write( buffer.data(), n );
+
+      sourceOffset += n;
+      offset += n;
+      nCopy -= n;
+   }
 }
 
-template <class FTYPE> CheckedFile &CheckedFile::writeFloatingPoint( FTYPE value, int precision )
+CheckedFile &CheckedFile::operator<<( const ustring &s )
 {
-   static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
-
-#ifdef E57_VERBOSE
-   std::cout << "CheckedFile::writeFloatingPoint, value=" << value << " precision=" << precision
-             << std::endl;
-#endif
-
-   return *this << floatingPointToStr( value, precision );
+   write( s.c_str(), s.length() ); //??? should be times size of uchar?
+   return ( *this );
 }
 
 void CheckedFile::seek( uint64_t offset, OffsetMode omode )
 {
+   waitForBackgroundWrites();
+
    //??? check for seek beyond logicalLength_
    const auto pos =
       static_cast<int64_t>( omode == Physical ? offset : logicalToPhysical( offset ) );
@@ -468,6 +548,31 @@ void CheckedFile::seek( uint64_t offset, OffsetMode omode )
 
 uint64_t CheckedFile::lseek64( int64_t offset, int whence )
 {
+   if ( sink_ != nullptr )
+   {
+      int64_t result = offset;
+
+      if ( whence == SEEK_CUR )
+      {
+         result += static_cast<int64_t>( sinkPosition_ );
+      }
+      else if ( whence == SEEK_END )
+      {
+         result += static_cast<int64_t>( sink_->length() );
+      }
+
+      if ( result < 0 )
+      {
+         throw E57_EXCEPTION2( ErrorSeekFailed, "fileName=" + fileName_ + " offset=" +
+                                                   toString( offset ) + " whence=" +
+                                                   toString( whence ) );
+      }
+
+      sinkPosition_ = static_cast<uint64_t>( result );
+
+      return sinkPosition_;
+   }
+
    if ( ( fd_ < 0 ) && ( bufView_ != nullptr ) )
    {
       const auto uoffset = static_cast<uint64_t>( offset );
@@ -504,6 +609,8 @@ uint64_t CheckedFile::lseek64( int64_t offset, int whence )
 
 uint64_t CheckedFile::position( OffsetMode omode )
 {
+   waitForBackgroundWrites();
+
    // Get current file cursor position
    const uint64_t pos = lseek64( 0LL, SEEK_CUR );
 
@@ -517,6 +624,8 @@ uint64_t CheckedFile::position( OffsetMode omode )
 
 uint64_t CheckedFile::length( OffsetMode omode )
 {
+   waitForBackgroundWrites();
+
    if ( omode == Physical )
    {
       if ( readOnly_ )
@@ -550,6 +659,8 @@ void CheckedFile::extend( uint64_t newLength, OffsetMode omode )
       throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
    }
 
+   waitForBackgroundWrites();
+
    uint64_t newLogicalLength = 0;
 
    if ( omode == Physical )
@@ -637,8 +748,193 @@ void CheckedFile::extend( uint64_t newLength, OffsetMode omode )
    seek( newLogicalLength, Logical );
 }
 
+void CheckedFile::truncate( uint64_t newLength )
+{
+   if ( readOnly_ )
+   {
+      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
+   }
+
+   // Only files can be truncated
+   if ( fd_ < 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ );
+   }
+
+   waitForBackgroundWrites();
+
+   const uint64_t pageCount = ( newLength + logicalPageSize - 1 ) / logicalPageSize;
+   const uint64_t physicalLength = pageCount * physicalPageSize;
+
+#if defined( _MSC_VER )
+   const int result = ( ::_chsize_s( fd_, static_cast<__int64>( physicalLength ) ) == 0 ) ? 0 : -1;
+#elif defined( _WIN32 ) || defined( __linux__ ) || defined( __EMSCRIPTEN__ )
+   const int result = ::ftruncate64( fd_, static_cast<int64_t>( physicalLength ) );
+#elif defined( __APPLE__ ) || defined( __BSD )
+   const int result = ::ftruncate( fd_, static_cast<off_t>( physicalLength ) );
+#else
+#error "no supported OS platform defined"
+#endif
+
+   if ( result < 0 )
+   {
+      throw E57_EXCEPTION2( ErrorWriteFailed, "fileName=" + fileName_ +
+                                                 " length=" + toString( physicalLength ) );
+   }
+
+   logicalLength_ = newLength;
+
+   // When done, leave cursor at end of file
+   seek( newLength, Logical );
+}
+
+uint64_t CheckedFile::writeInBackground( uint64_t logicalOffset, const char *buf, size_t nWrite )
+{
+   if ( readOnly_ )
+   {
+      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
+   }
+
+   // Start the thread on first use
+   if ( !backgroundThread_.joinable() )
+   {
+      backgroundStopping_ = false;
+      backgroundThread_ = std::thread( &CheckedFile::backgroundWriteLoop, this );
+   }
+
+   uint64_t ticket = 0;
+
+   {
+      std::lock_guard<std::mutex> lock( backgroundMutex_ );
+
+      backgroundQueue_.push_back( BackgroundWrite{ logicalOffset, buf, nWrite } );
+      ticket = ++backgroundWritesQueued_;
+   }
+
+   backgroundQueuedCondition_.notify_one();
+
+   return ticket;
+}
+
+// Wait until the write with this ticket (and all the ones queued before it) are complete.
+// If a background write failed, its exception is rethrown here.
+void CheckedFile::waitForBackgroundWrite( uint64_t ticket )
+{
+   if ( tIsBackgroundWriter || !backgroundThread_.joinable() )
+   {
+      return;
+   }
+
+   std::unique_lock<std::mutex> lock( backgroundMutex_ );
+
+   backgroundDoneCondition_.wait( lock, [&] { return backgroundWritesDone_ >= ticket; } );
+
+   if ( backgroundError_ != nullptr )
+   {
+      std::exception_ptr error = backgroundError_;
+      backgroundError_ = nullptr;
+
+      std::rethrow_exception( error );
+   }
+}
+
+void CheckedFile::waitForBackgroundWrites()
+{
+   if ( tIsBackgroundWriter || !backgroundThread_.joinable() )
+   {
+      return;
+   }
+
+   uint64_t ticket = 0;
+
+   {
+      std::lock_guard<std::mutex> lock( backgroundMutex_ );
+      ticket = backgroundWritesQueued_;
+   }
+
+   waitForBackgroundWrite( ticket );
+}
+
+void CheckedFile::backgroundWriteLoop()
+{
+   tIsBackgroundWriter = true;
+
+   std::unique_lock<std::mutex> lock( backgroundMutex_ );
+
+   while ( true )
+   {
+      backgroundQueuedCondition_.wait(
+         lock, [this] { return backgroundStopping_ || !backgroundQueue_.empty(); } );
+
+      if ( backgroundQueue_.empty() )
+      {
+         // Stopping, and everything has been written
+         return;
+      }
+
+      const BackgroundWrite cWrite = backgroundQueue_.front();
+      backgroundQueue_.pop_front();
+
+      // Once a write has failed, drop the rest. The error is reported by the next wait.
+      if ( backgroundError_ == nullptr )
+      {
+         lock.unlock();
+
+         std::exception_ptr error;
+
+         try
+         {
+            seek( cWrite.logicalOffset );
+            write( cWrite.buf, cWrite.nWrite );
+         }
+         catch ( ... )
+         {
+            error = std::current_exception();
+         }
+
+         lock.lock();
+
+         if ( error != nullptr )
+         {
+            backgroundError_ = error;
+         }
+      }
+
+      ++backgroundWritesDone_;
+
+      backgroundDoneCondition_.notify_all();
+   }
+}
+
+// Finish any queued writes and stop the background thread.
+// Returns the error from a failed write (if any) rather than throwing so it can't leave a thread
+// running.
+std::exception_ptr CheckedFile::stopBackgroundWrites()
+{
+   if ( !backgroundThread_.joinable() )
+   {
+      return nullptr;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock( backgroundMutex_ );
+      backgroundStopping_ = true;
+   }
+
+   backgroundQueuedCondition_.notify_one();
+   backgroundThread_.join();
+
+   std::exception_ptr error = backgroundError_;
+   backgroundError_ = nullptr;
+
+   return error;
+}
+
 void CheckedFile::close()
 {
+   // Let any queued writes finish before closing the file
+   const std::exception_ptr cBackgroundError = stopBackgroundWrites();
+
    if ( fd_ >= 0 )
    {
 #if defined( _MSC_VER )
@@ -665,12 +961,23 @@ void CheckedFile::close()
       // WARNING: do NOT delete buffer of bufView_ because
       // pointer is handled by user !!
    }
+
+   if ( cBackgroundError != nullptr )
+   {
+      std::rethrow_exception( cBackgroundError );
+   }
 }
 
 void CheckedFile::unlink()
 {
    close();
 
+   // There's no file to remove. What was written to the sink is left to its owner.
+   if ( sink_ != nullptr )
+   {
+      return;
+   }
+
    // Try to remove the file, don't report a failure
    int result = std::remove( fileName_.c_str() ); //??? unicode support here
 #ifdef E57_VERBOSE
@@ -683,11 +990,13 @@ void CheckedFile::unlink()
 #endif
 }
 
-void CheckedFile::verifyChecksum( char *page_buffer, uint64_t page )
+void CheckedFile::verifyChecksum( const char *page_buffer, uint64_t page )
 {
    const uint32_t check_sum = checksum( page_buffer, logicalPageSize );
-   const uint32_t check_sum_in_page =
-      *reinterpret_cast<uint32_t *>( &page_buffer[logicalPageSize] );
+
+   // The page may be straight from the caller's buffer, which needn't be aligned
+   uint32_t check_sum_in_page = 0;
+   memcpy( &check_sum_in_page, &page_buffer[logicalPageSize], sizeof( check_sum_in_page ) );
 
    if ( check_sum_in_page != check_sum )
    {
@@ -717,35 +1026,49 @@ void CheckedFile::getCurrentPageAndOffset( uint64_t &page, size_t &pageOffset, O
 }
 
 void CheckedFile::readPhysicalPage( char *page_buffer, uint64_t page )
+{
+   readPhysicalPages( page_buffer, page, 1 );
+}
+
+void CheckedFile::readPhysicalPages( char *page_buffer, uint64_t page, size_t pageCount )
 {
 #ifdef E57_VERBOSE
-   // cout << "readPhysicalPage, page:" << page << std::endl;
+   // cout << "readPhysicalPages, page:" << page << " pageCount:" << pageCount << std::endl;
 #endif
 
+   const size_t size = pageCount * physicalPageSize;
+
 #ifdef E57_CHECK_FILE_DEBUG
    const uint64_t physicalLength = length( Physical );
 
-   assert( page * physicalPageSize < physicalLength );
+   assert( page * physicalPageSize + size <= physicalLength );
 #endif
 
-   // Seek to start of physical page
+   // Seek to start of first physical page
    seek( page * physicalPageSize, Physical );
 
    if ( ( fd_ < 0 ) && ( bufView_ != nullptr ) )
    {
-      bufView_->read( page_buffer, physicalPageSize );
+      bufView_->read( page_buffer, size );
+      return;
+   }
+
+   if ( sink_ != nullptr )
+   {
+      sink_->read( sinkPosition_, page_buffer, size );
+      sinkPosition_ += size;
       return;
    }
 
 #if defined( _MSC_VER )
-   int result = ::_read( fd_, page_buffer, physicalPageSize );
+   int result = ::_read( fd_, page_buffer, static_cast<unsigned int>( size ) );
 #elif defined( __GNUC__ )
-   ssize_t result = ::read( fd_, page_buffer, physicalPageSize );
+   ssize_t result = ::read( fd_, page_buffer, size );
 #else
 #error "no supported compiler defined"
 #endif
 
-   if ( result < 0 || static_cast<size_t>( result ) != physicalPageSize )
+   if ( ( result < 0 ) || ( static_cast<size_t>( result ) != size ) )
    {
       throw E57_EXCEPTION2( ErrorReadFailed,
                             "fileName=" + fileName_ + " result=" + toString( result ) );
@@ -753,28 +1076,47 @@ void CheckedFile::readPhysicalPage( char *page_buffer, uint64_t page )
 }
 
 void CheckedFile::writePhysicalPage( char *page_buffer, uint64_t page )
+{
+   writePhysicalPages( page_buffer, page, 1 );
+}
+
+void CheckedFile::writePhysicalPages( char *page_buffer, uint64_t page, size_t pageCount )
 {
 #ifdef E57_VERBOSE
-   // cout << "writePhysicalPage, page:" << page << std::endl;
+   // cout << "writePhysicalPages, page:" << page << " pageCount:" << pageCount << std::endl;
 #endif
 
-   // Append checksum
-   uint32_t check_sum = checksum( page_buffer, logicalPageSize );
-   *reinterpret_cast<uint32_t *>( &page_buffer[logicalPageSize] ) =
-      check_sum; //??? little endian dependency
+   // Append checksums
+   for ( size_t i = 0; i < pageCount; ++i )
+   {
+      char *pageStart = page_buffer + i * physicalPageSize;
 
-   // Seek to start of physical page
+      uint32_t check_sum = checksum( pageStart, logicalPageSize );
+      *reinterpret_cast<uint32_t *>( &pageStart[logicalPageSize] ) =
+         check_sum; //??? little endian dependency
+   }
+
+   // Seek to start of first physical page
    seek( page * physicalPageSize, Physical );
 
+   const size_t size = pageCount * physicalPageSize;
+
+   if ( sink_ != nullptr )
+   {
+      sink_->write( sinkPosition_, page_buffer, size );
+      sinkPosition_ += size;
+      return;
+   }
+
 #if defined( _MSC_VER )
-   int result = ::_write( fd_, page_buffer, physicalPageSize );
+   int result = ::_write( fd_, page_buffer, static_cast<unsigned int>( size ) );
 #elif defined( __GNUC__ )
-   ssize_t result = ::write( fd_, page_buffer, physicalPageSize );
+   ssize_t result = ::write( fd_, page_buffer, size );
 #else
 #error "no supported compiler defined"
 #endif
 
-   if ( result < 0 )
+   if ( ( result < 0 ) || ( static_cast<size_t>( result ) != size ) )
    {
       throw E57_EXCEPTION2( ErrorWriteFailed,
                             "fileName=" + fileName_ + " result=" + toString( result ) );
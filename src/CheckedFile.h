@@ -28,6 +28,11 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #include "Common.h"
 
@@ -53,6 +58,9 @@ namespace e57
       {
          Read,
          Write,
+
+         /// Read & write an existing file
+         Update,
       };
 
       enum OffsetMode
@@ -63,20 +71,32 @@ namespace e57
 
       CheckedFile( const e57::ustring &fileName, Mode mode, ReadChecksumPolicy policy );
       CheckedFile( const char *input, uint64_t size, ReadChecksumPolicy policy );
+      explicit CheckedFile( std::shared_ptr<ImageFileSink> sink );
       ~CheckedFile();
 
       void read( char *buf, size_t nRead, size_t bufSize = 0 );
       void write( const char *buf, size_t nWrite );
+
+      /// Copy @a nCopy bytes at logical offset @a sourceOffset of @a source (which may be this
+      /// file) to the current position. The checksums are verified and recomputed as usual.
+      void copy( CheckedFile &source, uint64_t sourceOffset, uint64_t nCopy );
+
       CheckedFile &operator<<( const e57::ustring &s );
-      CheckedFile &operator<<( int64_t i );
-      CheckedFile &operator<<( uint64_t i );
-      CheckedFile &operator<<( float f );
-      CheckedFile &operator<<( double d );
       void seek( uint64_t offset, OffsetMode omode = Logical );
       uint64_t position( OffsetMode omode = Logical );
       uint64_t length( OffsetMode omode = Logical );
       void extend( uint64_t newLength, OffsetMode omode = Logical );
 
+      /// Cut the file off after the page containing logical offset @a newLength
+      void truncate( uint64_t newLength );
+
+      // Writing on a background thread.
+      // buf must stay valid and unchanged until the write is complete. Every other operation on
+      // the file waits until all background writes are complete first.
+      uint64_t writeInBackground( uint64_t logicalOffset, const char *buf, size_t nWrite );
+      void waitForBackgroundWrite( uint64_t ticket );
+      void waitForBackgroundWrites();
+
       e57::ustring fileName() const
       {
          return fileName_;
@@ -89,17 +109,20 @@ namespace e57
       static inline uint64_t physicalToLogical( uint64_t physicalOffset );
 
    private:
-      void verifyChecksum( char *page_buffer, uint64_t page );
-
-      template <class FTYPE> CheckedFile &writeFloatingPoint( FTYPE value, int precision );
+      void verifyChecksum( const char *page_buffer, uint64_t page );
 
       void getCurrentPageAndOffset( uint64_t &page, size_t &pageOffset,
                                     OffsetMode omode = Logical );
       void readPhysicalPage( char *page_buffer, uint64_t page );
+      void readPhysicalPages( char *page_buffer, uint64_t page, size_t pageCount );
       void writePhysicalPage( char *page_buffer, uint64_t page );
+      void writePhysicalPages( char *page_buffer, uint64_t page, size_t pageCount );
       int open64( const e57::ustring &fileName, int flags, int mode );
       uint64_t lseek64( int64_t offset, int whence );
 
+      void backgroundWriteLoop();
+      std::exception_ptr stopBackgroundWrites();
+
       e57::ustring fileName_;
       uint64_t logicalLength_ = 0;
       uint64_t physicalLength_ = 0;
@@ -109,6 +132,28 @@ namespace e57
       int fd_ = -1;
       BufferView *bufView_ = nullptr;
       bool readOnly_ = false;
+
+      // Writing to a sink instead of a file
+      std::shared_ptr<ImageFileSink> sink_;
+      uint64_t sinkPosition_ = 0;
+
+      // Background writes (see writeInBackground())
+      struct BackgroundWrite
+      {
+         uint64_t logicalOffset;
+         const char *buf;
+         size_t nWrite;
+      };
+
+      std::thread backgroundThread_;
+      std::mutex backgroundMutex_;
+      std::condition_variable backgroundQueuedCondition_;
+      std::condition_variable backgroundDoneCondition_;
+      std::deque<BackgroundWrite> backgroundQueue_;
+      uint64_t backgroundWritesQueued_ = 0;
+      uint64_t backgroundWritesDone_ = 0;
+      std::exception_ptr backgroundError_;
+      bool backgroundStopping_ = false;
    };
 
    inline uint64_t CheckedFile::logicalToPhysical( uint64_t logicalOffset )
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+/// @file CompiledPath.cpp
+
+#include "ImageFileImpl.h"
+
+using namespace e57;
+
+/*!
+@brief Check a path name and split it into its element names.
+
+@param [in] imf The ImageFile whose nodes the path will be looked up in.
+@param [in] pathName The absolute pathname, or pathname relative to the node it will be looked up
+in.
+
+@details
+The element names must be legal, and any extension prefixes they use must be declared in @a imf
+(see ImageFile::extensionsAdd).
+
+@pre The ImageFile must be open (i.e. isOpen()).
+
+@throw ::ErrorBadPathName
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see StructureNode::get(const CompiledPath&) const, VectorNode::get(const CompiledPath&) const
+*/
+CompiledPath::CompiledPath( const ImageFile &imf, const ustring &pathName ) :
+   pathName_( pathName ), isRelative_( false )
+{
+   if ( !imf.isOpen() )
+   {
+      throw E57_EXCEPTION2( ErrorImageFileNotOpen, "fileName=" + imf.fileName() );
+   }
+
+   imf.impl()->pathNameParse( pathName, isRelative_, elementNames_ ); // throws if bad pathName
+}
+
+/*!
+@brief Get the path name the CompiledPath was made from.
+
+@post No visible state is modified.
+
+@return The path name.
+*/
+ustring CompiledPath::pathName() const
+{
+   return pathName_;
+}
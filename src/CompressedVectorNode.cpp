@@ -31,6 +31,7 @@
 /// @file CompressedVectorNode.cpp
 
 #include "CompressedVectorNodeImpl.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
 
 using namespace e57;
@@ -189,7 +190,7 @@ passing an empty VectorNode will specify that all record fields will be encoded
 
 @pre The @a destImageFile must be open (i.e. destImageFile.isOpen() must be true).
 @pre The @a destImageFile must have been opened in write mode (i.e. destImageFile.isWritable() must
-be true).
+be true), not to update its metadata ("u" mode).
 @pre @a prototype must be an unattached root node (i.e. !prototype.isAttached() &&
 prototype.isRoot())
 @pre @a prototype cannot contain BlobNodes or CompressedVectorNodes.
@@ -209,8 +210,14 @@ prototype.isRoot())
 */
 CompressedVectorNode::CompressedVectorNode( const ImageFile &destImageFile, const Node &prototype,
                                             const VectorNode &codecs ) :
-   impl_( new CompressedVectorNodeImpl( destImageFile.impl() ) )
+   impl_( destImageFile.impl()->makeNode<CompressedVectorNodeImpl>() )
 {
+   // Its data couldn't be written to a file whose metadata is being updated
+   if ( destImageFile.impl()->isUpdater() )
+   {
+      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + destImageFile.fileName() );
+   }
+
    // Because of shared_ptr quirks, can't set prototype,codecs in CompressedVectorNodeImpl(), so set
    // it afterwards
    impl_->setPrototype( prototype.impl() );
@@ -441,7 +448,39 @@ CompressedVectorNode::prototype
 CompressedVectorWriter CompressedVectorNode::writer( std::vector<SourceDestBuffer> &sbufs,
                                                      bool writeIndexPackets )
 {
-   return CompressedVectorWriter( impl_->writer( sbufs, writeIndexPackets ) );
+   CompressedVectorWriterOptions options;
+   options.writeIndexPackets = writeIndexPackets;
+
+   return CompressedVectorWriter( impl_->writer( sbufs, options ) );
+}
+
+/*!
+@brief Create an iterator object for writing a series of blocks of data to a CompressedVectorNode.
+
+@param [in] sbufs Vector of memory buffers that will hold data to be written to a
+CompressedVectorNode.
+@param [in] options Options controlling how the binary section is written.
+
+@details
+Same as writer(std::vector<SourceDestBuffer>&, bool), but with all the writer options.
+
+If CompressedVectorWriterOptions::stageSection is set, the writer builds the binary section in
+memory, and the file isn't touched until it is closed. Any number of staged writers (for different
+CompressedVectorNodes) may be open at the same time, and each of them may be written and closed on
+its own thread, so several sections can be encoded in parallel. Each section is written to the file
+in one piece when its writer is closed, so the sections are laid out in the order their writers are
+closed. A writer which isn't staged still can't be created while any other writer is open.
+Everything else done with the ImageFile (such as creating the writers) must still be done from one
+thread, and BlobNodes must not be written while staged writers are being closed.
+
+@return A smart CompressedVectorWriter handle referencing the underlying iterator object.
+
+@see CompressedVectorWriterOptions, CompressedVectorWriter
+*/
+CompressedVectorWriter CompressedVectorNode::writer( std::vector<SourceDestBuffer> &sbufs,
+                                                     const CompressedVectorWriterOptions &options )
+{
+   return CompressedVectorWriter( impl_->writer( sbufs, options ) );
 }
 
 /*!
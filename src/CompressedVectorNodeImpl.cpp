@@ -30,8 +30,11 @@
 #include "CompressedVectorReaderImpl.h"
 #include "CompressedVectorWriterImpl.h"
 #include "ImageFileImpl.h"
+#include "Packet.h"
+#include "SectionHeaders.h"
 #include "StringFunctions.h"
 #include "VectorNodeImpl.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -203,7 +206,7 @@ namespace e57
       throw E57_EXCEPTION2( ErrorInternal, "this->pathName=" + this->pathName() );
    }
 
-   void CompressedVectorNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+   void CompressedVectorNodeImpl::writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                                             const char *forcedFieldName )
    {
       // don't checkImageFileOpen
@@ -218,21 +221,208 @@ namespace e57
          fieldName = elementName_;
       }
 
-      uint64_t physicalStart = cf.logicalToPhysical( binarySectionLogicalStart_ );
+      uint64_t physicalStart = CheckedFile::logicalToPhysical( binarySectionLogicalStart_ );
 
-      cf << space( indent ) << "<" << fieldName << " type=\"CompressedVector\"";
-      cf << " fileOffset=\"" << physicalStart;
-      cf << "\" recordCount=\"" << recordCount_ << "\">\n";
+      xml.indent( indent ) << "<" << fieldName << " type=\"CompressedVector\"";
+      xml << " fileOffset=\"" << physicalStart;
+      xml << "\" recordCount=\"" << recordCount_ << "\">\n";
 
       if ( prototype_ )
       {
-         prototype_->writeXml( imf, cf, indent + 2, "prototype" );
+         prototype_->writeXml( imf, xml, indent + 2, "prototype" );
       }
       if ( codecs_ )
       {
-         codecs_->writeXml( imf, cf, indent + 2, "codecs" );
+         codecs_->writeXml( imf, xml, indent + 2, "codecs" );
       }
-      cf << space( indent ) << "</" << fieldName << ">\n";
+      xml.indent( indent ) << "</" << fieldName << ">\n";
+   }
+
+   NodeImplSharedPtr CompressedVectorNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( !destImageFile->isWriter() )
+      {
+         throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + destImageFile->fileName() );
+      }
+
+      // The section goes at the end of the file, so a writer can't be adding packets there
+      if ( destImageFile->unstagedWriterCount() > 0 )
+      {
+         throw E57_EXCEPTION2( ErrorTooManyWriters,
+                               "fileName=" + destImageFile->fileName() +
+                                  " writerCount=" + toString( destImageFile->writerCount() ) +
+                                  " readerCount=" + toString( destImageFile->readerCount() ) );
+      }
+
+      std::shared_ptr<CompressedVectorNodeImpl> cvi(
+         destImageFile->makeNode<CompressedVectorNodeImpl>() );
+
+      if ( prototype_ )
+      {
+         cvi->setPrototype( prototype_->copy( destImageFile ) );
+      }
+      if ( codecs_ )
+      {
+         cvi->setCodecs(
+            std::static_pointer_cast<VectorNodeImpl>( codecs_->copy( destImageFile ) ) );
+      }
+
+      cvi->setRecordCount( recordCount_ );
+
+      // If the records haven't been written yet, there is no section to copy
+      if ( binarySectionLogicalStart_ != 0 )
+      {
+         cvi->setBinarySectionLogicalStart( copySection( destImageFile ) );
+      }
+
+      return cvi;
+   }
+
+   // Copy the binary section to the end of destImageFile without decoding it, and return where it
+   // starts. The packets are copied as they are, except that the offsets in the section header
+   // and the index packets are moved along with them.
+   uint64_t CompressedVectorNodeImpl::copySection( const ImageFileImplSharedPtr &destImageFile )
+   {
+      ImageFileImplSharedPtr imf( destImageFile_ );
+      CheckedFile *sourceFile = imf->file();
+      CheckedFile *destFile = destImageFile->file();
+
+      CompressedVectorSectionHeader header;
+      sourceFile->seek( binarySectionLogicalStart_ );
+      sourceFile->read( reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+      header.verify( sourceFile->length( CheckedFile::Physical ) );
+
+      const uint64_t cSourceStart = binarySectionLogicalStart_;
+      const uint64_t cSourceEnd = cSourceStart + header.sectionLogicalLength;
+
+      if ( header.sectionLogicalLength < sizeof( header ) ||
+           cSourceEnd > sourceFile->length( CheckedFile::Logical ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVHeader,
+                               "sectionLogicalLength=" + toString( header.sectionLogicalLength ) +
+                                  " fileName=" + imf->fileName() );
+      }
+
+      // Staged sections may be placed by other threads at any time, so hold the file while this
+      // one is put at the end of it.
+      std::lock_guard<std::mutex> lock( destImageFile->writerMutex_ );
+
+      const uint64_t cDestStart =
+         destImageFile->allocateSpace( header.sectionLogicalLength, false );
+
+      destFile->seek( cDestStart );
+      destFile->copy( *sourceFile, cSourceStart, header.sectionLogicalLength );
+
+      // Logical offsets move by the same amount, physical ones don't (the section may start at a
+      // different place in a page).
+      auto relocate = [&]( uint64_t physicalOffset ) {
+         const uint64_t cLogicalOffset = CheckedFile::physicalToLogical( physicalOffset );
+
+         if ( ( cLogicalOffset < cSourceStart + sizeof( header ) ) ||
+              ( cLogicalOffset >= cSourceEnd ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket, "physicalOffset=" + toString( physicalOffset ) +
+                                                       " fileName=" + imf->fileName() );
+         }
+
+         return CheckedFile::logicalToPhysical( cLogicalOffset - cSourceStart + cDestStart );
+      };
+
+      // Walk the index packets down from the top one. Each level's entries point to packets of the
+      // level below, and level 0's to data packets.
+      struct IndexPacketRef
+      {
+         uint64_t physicalOffset;
+         int level; // expected level, or -1 for the top packet
+      };
+
+      std::vector<IndexPacketRef> pending;
+
+      // A packet is at least as long as its header, so a bad file can't make this loop for long
+      uint64_t packetsLeft = header.sectionLogicalLength / sizeof( IndexPacketHeader );
+
+      if ( header.indexPhysicalOffset != 0 )
+      {
+         pending.push_back( { header.indexPhysicalOffset, -1 } );
+
+         header.indexPhysicalOffset = relocate( header.indexPhysicalOffset );
+      }
+
+      if ( header.dataPhysicalOffset != 0 )
+      {
+         header.dataPhysicalOffset = relocate( header.dataPhysicalOffset );
+      }
+
+      // 32k, so keep it off the stack
+      std::unique_ptr<IndexPacket> indexPacket( new IndexPacket );
+      auto *packetBuffer = reinterpret_cast<char *>( indexPacket.get() );
+
+      while ( !pending.empty() )
+      {
+         const IndexPacketRef cRef = pending.back();
+         pending.pop_back();
+
+         if ( packetsLeft-- == 0 )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket, "too many index packets; fileName=" +
+                                                       imf->fileName() );
+         }
+
+         const uint64_t cLogicalOffset = CheckedFile::physicalToLogical( cRef.physicalOffset );
+
+         sourceFile->seek( cLogicalOffset );
+         sourceFile->read( packetBuffer, sizeof( IndexPacketHeader ) );
+
+         const unsigned cPacketLength = indexPacket->header.packetLogicalLengthMinus1 + 1U;
+
+         if ( ( cPacketLength < sizeof( IndexPacketHeader ) ) ||
+              ( cPacketLength > sizeof( IndexPacket ) ) ||
+              ( cLogicalOffset + cPacketLength > cSourceEnd ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( cPacketLength ) +
+                                                       " fileName=" + imf->fileName() );
+         }
+
+         sourceFile->seek( cLogicalOffset );
+         sourceFile->read( packetBuffer, cPacketLength );
+
+         indexPacket->verify( cPacketLength );
+
+         const int cLevel = indexPacket->header.indexLevel;
+
+         if ( ( cRef.level >= 0 ) && ( cLevel != cRef.level ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket, "indexLevel=" + toString( cLevel ) +
+                                                       " expected=" + toString( cRef.level ) );
+         }
+
+         for ( unsigned i = 0; i < indexPacket->header.entryCount; ++i )
+         {
+            IndexPacket::Entry &entry = indexPacket->entries[i];
+
+            if ( cLevel > 0 )
+            {
+               pending.push_back( { entry.chunkPhysicalOffset, cLevel - 1 } );
+            }
+
+            entry.chunkPhysicalOffset = relocate( entry.chunkPhysicalOffset );
+         }
+
+         destFile->seek( cLogicalOffset - cSourceStart + cDestStart );
+         destFile->write( packetBuffer, cPacketLength );
+      }
+
+#if VALIDATE_BASIC
+      header.verify( destFile->length( CheckedFile::Physical ) );
+#endif
+
+      destFile->seek( cDestStart );
+      destFile->write( reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+      return cDestStart;
    }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -266,14 +456,18 @@ namespace e57
 #endif
 
    std::shared_ptr<CompressedVectorWriterImpl> CompressedVectorNodeImpl::writer(
-      std::vector<SourceDestBuffer> sbufs, bool writeIndexPackets )
+      std::vector<SourceDestBuffer> sbufs, const CompressedVectorWriterOptions &options )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
       ImageFileImplSharedPtr destImageFile( destImageFile_ );
 
-      // Check don't have any writers/readers open for this ImageFile
-      if ( destImageFile->writerCount() > 0 )
+      // Check don't have any writers/readers open for this ImageFile. Writers staging their
+      // sections don't touch the file until they are closed, so any number of them may be open at
+      // once.
+      const int cBlockingWriterCount = options.stageSection ? destImageFile->unstagedWriterCount()
+                                                            : destImageFile->writerCount();
+      if ( cBlockingWriterCount > 0 )
       {
          throw E57_EXCEPTION2( ErrorTooManyWriters,
                                "fileName=" + destImageFile->fileName() +
@@ -313,7 +507,7 @@ namespace e57
 
       // Return a shared_ptr to new object
       std::shared_ptr<CompressedVectorWriterImpl> cvwi(
-         new CompressedVectorWriterImpl( cai, sbufs, writeIndexPackets ) );
+         new CompressedVectorWriterImpl( cai, sbufs, options ) );
       return ( cvwi );
    }
 
@@ -54,12 +54,14 @@ namespace e57
 
       void checkLeavesInSet( const StringSet &pathNames, NodeImplSharedPtr origin ) override;
 
-      void writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+      void writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                      const char *forcedFieldName = nullptr ) override;
 
+      NodeImplSharedPtr copy( const ImageFileImplSharedPtr &destImageFile ) override;
+
       /// Iterator constructors
-      std::shared_ptr<CompressedVectorWriterImpl> writer( std::vector<SourceDestBuffer> sbufs, 
-                                                          bool writeIndexPackets = true );
+      std::shared_ptr<CompressedVectorWriterImpl> writer(
+         std::vector<SourceDestBuffer> sbufs, const CompressedVectorWriterOptions &options );
       std::shared_ptr<CompressedVectorReaderImpl> reader( std::vector<SourceDestBuffer> dbufs );
 
       int64_t getRecordCount() const
@@ -89,6 +91,8 @@ namespace e57
    private:
       friend class CompressedVectorReaderImpl;
 
+      uint64_t copySection( const ImageFileImplSharedPtr &destImageFile );
+
       NodeImplSharedPtr prototype_;
       std::shared_ptr<VectorNodeImpl> codecs_;
 
@@ -265,6 +265,10 @@ This function may be called at any time (as long as ImageFile and CompressedVect
 The next read will start at the given recordNumber. It is not an error to seek to recordNumber =
 childCount() (i.e. to one record past end of CompressedVectorNode).
 
+The index packets of the binary section are used to find the chunk of records containing
+recordNumber, so only that chunk is decoded (into the current dbufs) to get there. Sections
+without a useful index are decoded from the beginning.
+
 @pre @a recordNumber <= childCount() of CompressedVectorNode.
 @pre The associated ImageFile must be open.
 @pre This CompressedVectorReader must be open (i.e isOpen())
@@ -25,6 +25,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
 #include "CompressedVectorReaderImpl.h"
 #include "CheckedFile.h"
 #include "CompressedVectorNodeImpl.h"
@@ -132,6 +134,11 @@ namespace e57
       uint64_t dataLogicalOffset =
          imf->file_->physicalToLogical( sectionHeader.dataPhysicalOffset );
 
+      dataLogicalOffset_ = dataLogicalOffset;
+      indexLogicalOffset_ = ( sectionHeader.indexPhysicalOffset != 0 )
+                               ? imf->file_->physicalToLogical( sectionHeader.indexPhysicalOffset )
+                               : 0;
+
       //??? what if fault in this constructor?
       cache_ = new PacketReadCache( imf->file_, 32 );
 
@@ -216,6 +223,15 @@ namespace e57
 
             // Throw exception if old and new not compatible
             oldBuf->checkCompatible( newBuf );
+
+            // The decoders keep filling the buffers they were created with, so they can't change
+            // size either
+            if ( oldBuf->capacity() != newBuf->capacity() )
+            {
+               throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                                     "capacity=" + toString( oldBuf->capacity() ) +
+                                        " newCapacity=" + toString( newBuf->capacity() ) );
+            }
          }
       }
 
@@ -542,12 +558,156 @@ namespace e57
       return UINT64_MAX;
    }
 
-   void CompressedVectorReaderImpl::seek( uint64_t /*recordNumber*/ )
+   void CompressedVectorReaderImpl::seek( uint64_t recordNumber )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
-      // !!! implement
-      throw E57_EXCEPTION1( ErrorNotImplemented );
+      if ( recordNumber > maxRecordCount_ )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "recordNumber=" + toString( recordNumber ) +
+                                  " recordCount=" + toString( maxRecordCount_ ) +
+                                  " imageFileName=" + cVector_->imageFileName() +
+                                  " cvPathName=" + cVector_->pathName() );
+      }
+
+      // Nothing left to read
+      if ( recordNumber == maxRecordCount_ )
+      {
+         for ( auto &channel : channels_ )
+         {
+            channel.decoder->setRecordRange( maxRecordCount_, maxRecordCount_ );
+         }
+
+         return;
+      }
+
+      // Start decoding at the beginning of the chunk containing recordNumber, and read up to
+      // recordNumber into the dbufs. They are overwritten by the next read() anyway.
+      uint64_t chunkLogicalOffset = 0;
+      const uint64_t cChunkRecordNumber = findChunk( recordNumber, chunkLogicalOffset );
+
+      restartChannels( chunkLogicalOffset, cChunkRecordNumber, recordNumber );
+
+      auto reachedRecord = [this, recordNumber] {
+         for ( const auto &channel : channels_ )
+         {
+            if ( channel.decoder->totalRecordsCompleted() != recordNumber )
+            {
+               return false;
+            }
+         }
+
+         return true;
+      };
+
+      while ( !reachedRecord() )
+      {
+         if ( read() == 0 )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket,
+                                  "recordNumber=" + toString( recordNumber ) +
+                                     " chunkRecordNumber=" + toString( cChunkRecordNumber ) +
+                                     " imageFileName=" + cVector_->imageFileName() +
+                                     " cvPathName=" + cVector_->pathName() );
+         }
+      }
+
+      // Carry on from recordNumber to the end
+      for ( auto &channel : channels_ )
+      {
+         channel.maxRecordCount = maxRecordCount_;
+         channel.decoder->setRecordRange( recordNumber, maxRecordCount_ );
+      }
+   }
+
+   // Walk down the index packets to the chunk containing recordNumber. Returns the number of the
+   // chunk's first record, and the logical offset of its first data packet in chunkLogicalOffset.
+   // Without an index, the whole section is one chunk.
+   uint64_t CompressedVectorReaderImpl::findChunk( uint64_t recordNumber,
+                                                   uint64_t &chunkLogicalOffset ) const
+   {
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      uint64_t chunkRecordNumber = 0;
+      chunkLogicalOffset = dataLogicalOffset_;
+
+      uint64_t indexLogicalOffset = indexLogicalOffset_;
+
+      // Levels must go down by one each step, so there can't be more than this
+      for ( int level = 0; ( indexLogicalOffset != 0 ) && ( level <= 5 ); ++level )
+      {
+         char *anyPacket = nullptr;
+         std::unique_ptr<PacketLock> packetLock = cache_->lock( indexLogicalOffset, anyPacket );
+
+         auto ipkt = reinterpret_cast<const IndexPacket *>( anyPacket );
+
+         if ( ipkt->header.packetType != INDEX_PACKET )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket,
+                                  "packetType=" + toString( ipkt->header.packetType ) );
+         }
+
+         // Find the last entry which starts at or before recordNumber
+         const IndexPacket::Entry *begin = ipkt->entries;
+         const IndexPacket::Entry *end = begin + ipkt->header.entryCount;
+
+         const IndexPacket::Entry *entry =
+            std::upper_bound( begin, end, recordNumber,
+                              []( uint64_t record, const IndexPacket::Entry &e ) {
+                                 return record < e.chunkRecordNumber;
+                              } );
+
+         // All of the entries are past recordNumber, so start from the beginning
+         if ( entry == begin )
+         {
+            break;
+         }
+
+         --entry;
+
+         const uint64_t cEntryLogicalOffset =
+            imf->file_->physicalToLogical( entry->chunkPhysicalOffset );
+
+         if ( ipkt->header.indexLevel == 0 )
+         {
+            chunkRecordNumber = entry->chunkRecordNumber;
+            chunkLogicalOffset = cEntryLogicalOffset;
+            break;
+         }
+
+         indexLogicalOffset = cEntryLogicalOffset;
+      }
+
+      return chunkRecordNumber;
+   }
+
+   // Point all channels at the start of the data packet at packetLogicalOffset, which starts with
+   // recordIndex in every bytestream, and decode up to endRecordIndex.
+   void CompressedVectorReaderImpl::restartChannels( uint64_t packetLogicalOffset,
+                                                     uint64_t recordIndex, uint64_t endRecordIndex )
+   {
+      auto dpkt = dataPacket( packetLogicalOffset );
+
+      if ( dpkt->header.packetType != DATA_PACKET )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket,
+                               "packetType=" + toString( dpkt->header.packetType ) );
+      }
+
+      for ( auto &channel : channels_ )
+      {
+         channel.decoder->stateReset();
+         channel.decoder->setRecordRange( recordIndex, endRecordIndex );
+
+         channel.maxRecordCount = endRecordIndex;
+         channel.currentPacketLogicalOffset = packetLogicalOffset;
+         channel.currentBytestreamBufferIndex = 0;
+         channel.currentBytestreamBufferLength =
+            dpkt->getBytestreamBufferLength( channel.bytestreamNumber );
+         channel.inputFinished = false;
+      }
    }
 
    bool CompressedVectorReaderImpl::isOpen() const
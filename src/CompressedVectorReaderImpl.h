@@ -62,6 +62,9 @@ namespace e57
       DataPacket *dataPacket( uint64_t inLogicalOffset ) const;
       void feedPacketToDecoders( uint64_t currentPacketLogicalOffset );
       uint64_t findNextDataPacket( uint64_t nextPacketLogicalOffset );
+      uint64_t findChunk( uint64_t recordNumber, uint64_t &chunkLogicalOffset ) const;
+      void restartChannels( uint64_t packetLogicalOffset, uint64_t recordIndex,
+                            uint64_t endRecordIndex );
 
       //??? no default ctor, copy, assignment?
 
@@ -75,5 +78,7 @@ namespace e57
       uint64_t recordCount_; /// number of records written so far
       uint64_t maxRecordCount_;
       uint64_t sectionEndLogicalOffset_;
+      uint64_t dataLogicalOffset_;  /// first data packet
+      uint64_t indexLogicalOffset_; /// top level index packet (0 if none)
    };
 }
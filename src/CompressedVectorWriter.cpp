@@ -70,8 +70,9 @@ void CompressedVectorWriter::checkInvariant( bool /*doRecurse*/ )
       throw E57_EXCEPTION1( ErrorInvarianceViolation );
    }
 
-   // Dest ImageFile must have exactly 1 writer (this one)
-   if ( imf.writerCount() != 1 )
+   // Dest ImageFile must have at least 1 writer (this one). There may be others if they are all
+   // staging their sections.
+   if ( imf.writerCount() < 1 )
    {
       throw E57_EXCEPTION1( ErrorInvarianceViolation );
    }
@@ -315,6 +316,49 @@ CompressedVectorNode CompressedVectorWriter::compressedVectorNode() const
    return impl_->compressedVectorNode();
 }
 
+/*!
+@brief Return how many records and packets have been written, and how full the data packets are.
+
+@details
+This may be called before or after CompressedVectorWriter::close. Records still being encoded are
+counted, but their data packets aren't until they are written. The index packets are written by
+CompressedVectorWriter::close.
+
+@return The statistics so far.
+
+@see CompressedVectorWriterStatistics
+*/
+CompressedVectorWriterStatistics CompressedVectorWriter::statistics() const
+{
+   return impl_->statistics();
+}
+
+/*!
+@brief Return the smallest and largest values written to a field so far.
+
+@details
+The range is worked out by the encoders as they write each value, so it costs no extra pass over
+the data. The values are those stored in the file: Integer values, ScaledInteger values after
+rounding and scaling, and Float values after any conversion to single precision. NaNs are ignored.
+This may be called before or after CompressedVectorWriter::close.
+
+@param [in] pathName The name of the field, relative to the prototype (e.g. "cartesianX").
+@param [out] minimum The smallest value written.
+@param [out] maximum The largest value written.
+
+@return True if the range is known, false if no values have been written yet or the field is a
+String.
+
+@throw ::ErrorPathUndefined if @a pathName isn't in the prototype
+@throw ::ErrorBadAPIArgument if @a pathName isn't a field (e.g. a Structure)
+@throw ::ErrorInternal All objects in undocumented state
+*/
+bool CompressedVectorWriter::valueRange( const ustring &pathName, double &minimum,
+                                         double &maximum ) const
+{
+   return impl_->valueRange( pathName, minimum, maximum );
+}
+
 /*!
 @brief Diagnostic function to print internal state of object to output stream in an indented format.
 @copydetails Node::dump()
@@ -26,7 +26,7 @@
  */
 
 #include <cmath>
-#include <numeric>
+#include <cstring>
 
 #include "CheckedFile.h"
 #include "CompressedVectorNodeImpl.h"
@@ -35,9 +35,34 @@
 #include "SectionHeaders.h"
 #include "SourceDestBufferImpl.h"
 #include "StringFunctions.h"
+#include "ThreadPool.h"
 
 namespace e57
 {
+   // Number of data packets to cycle through when writing in the background
+   constexpr size_t cBackgroundDataPacketCount = 3;
+
+   // Chunks start on a multiple of this many records. Bit-packed records are at most 64 bits and
+   // registers are at most 64 bits, so every bytestream ends on a whole register at a chunk
+   // boundary and the chunk's first data packet starts cleanly on its first record in every
+   // bytestream. Nothing needs padding, so readers which ignore the index read the same records.
+   constexpr uint64_t cChunkRecordAlignment = 64;
+
+#ifdef E57_WRITE_CRAZY_PACKET_MODE
+   //??? depends on number of streams
+   constexpr size_t cTargetPacketSize = 500;
+#else
+   constexpr size_t cTargetPacketSize = DATA_PACKET_MAX;
+#endif
+
+   // Smallest slice of a data packet we hand out. Any encoder can make progress with this much room
+   // (one 64-bit register, one double, or the long form of a string length prefix).
+   constexpr size_t cMinBufferSize = 8;
+
+   // When a channel fills its slice, the packet is written unless at least this much more of it
+   // could be shared out again. Smaller means fuller packets but more rounds of moving slices.
+   constexpr size_t cMinRegrowSize = DATA_PACKET_MAX / 128;
+
    struct SortByBytestreamNumber
    {
       bool operator()( const std::shared_ptr<Encoder> &lhs,
@@ -49,9 +74,18 @@ namespace e57
 
    CompressedVectorWriterImpl::CompressedVectorWriterImpl(
       std::shared_ptr<CompressedVectorNodeImpl> ni, std::vector<SourceDestBuffer> &sbufs,
-      bool writeIndexPackets ) :
-      cVector_( ni ), writeIndexPackets_(writeIndexPackets), isOpen_( false ) // set to true when succeed below
+      const CompressedVectorWriterOptions &options ) :
+      cVector_( ni ),
+      dataPackets_( ( options.writePacketsInBackground && !options.stageSection )
+                       ? cBackgroundDataPacketCount
+                       : 1 ),
+      dataPacketWriteTickets_( dataPackets_.size(), 0 ),
+      writeIndexPackets_( options.writeIndexPackets ), stageSection_( options.stageSection ),
+      dataPacketsPerIndexEntry_( options.writeIndexPackets ? options.dataPacketsPerIndexEntry : 0 ),
+      isOpen_( false ) // set to true when succeed below
    {
+      dataPacket_ = &dataPackets_[0];
+
       //???  check if cvector already been written (can't write twice)
 
       // Empty sbufs is an error
@@ -109,24 +143,45 @@ namespace e57
       }
 #endif
 
+      // Point each encoder at its slice of the (empty) data packet
+      packetSetupBuffers();
+
+      // No point in having more threads than bytestreams
+      if ( ( options.encoderThreadCount != 1 ) && ( bytestreams_.size() > 1 ) )
+      {
+         unsigned threadCount = options.encoderThreadCount;
+         if ( ( threadCount == 0 ) || ( threadCount > bytestreams_.size() ) )
+         {
+            threadCount = std::min( std::max( std::thread::hardware_concurrency(), 1U ),
+                                    static_cast<unsigned>( bytestreams_.size() ) );
+         }
+
+         if ( threadCount > 1 )
+         {
+            encoderPool_.reset( new ThreadPool( threadCount ) );
+         }
+      }
+
       ImageFileImplSharedPtr imf( ni->destImageFile_ );
 
       // Reserve space for CompressedVector binary section header, record location
       // so can save to when writer closes. Request that file be extended with
       // zeros since we will write to it at a later time (when writer closes).
+      // A staged section gets all its space when it is placed in the file by close().
       sectionHeaderLogicalStart_ =
-         imf->allocateSpace( sizeof( CompressedVectorSectionHeader ), true );
+         stageSection_ ? 0 : imf->allocateSpace( sizeof( CompressedVectorSectionHeader ), true );
 
       sectionLogicalLength_ = 0;
       dataPhysicalOffset_ = 0;
       topIndexPhysicalOffset_ = 0;
       recordCount_ = 0;
       dataPacketsCount_ = 0;
+      dataPacketsLength_ = 0;
       indexPacketsCount_ = 0;
 
       // Just before return (and can't throw) increment writer count  ??? safer
       // way to assure don't miss close?
-      imf->incrWriterCount();
+      imf->incrWriterCount( stageSection_ );
 
       // If get here, the writer is open
       isOpen_ = true;
@@ -149,6 +204,26 @@ namespace e57
       {
          //??? report?
       }
+
+      // If close() failed, data packets may still be queued for writing from our buffers.
+      // A staged section never queues any (and may be on a different thread to the file's owner).
+      try
+      {
+         if ( stageSection_ )
+         {
+            return;
+         }
+
+         ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+         if ( imf->file_ != nullptr )
+         {
+            imf->file_->waitForBackgroundWrites();
+         }
+      }
+      catch ( ... )
+      {
+      }
    }
 
    void CompressedVectorWriterImpl::close()
@@ -158,17 +233,18 @@ namespace e57
 #endif
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
-      // Before anything that can throw, decrement writer count
-      imf->decrWriterCount();
-
-      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
-      // don't call checkWriterOpen();
-
+      // Closing a closed writer does nothing (and mustn't count it as closing again)
       if ( !isOpen_ )
       {
          return;
       }
 
+      // Before anything that can throw, decrement writer count
+      imf->decrWriterCount( stageSection_ );
+
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      // don't call checkWriterOpen();
+
       // Set closed before do anything, so if get fault and start unwinding, don't
       // try to close again.
       isOpen_ = false;
@@ -184,9 +260,20 @@ namespace e57
          flush();
       }
 
+      // Staged sections may be closed on several threads at once, so put them in the file one at a
+      // time. Each goes at the current end of the file, in one piece.
+      std::unique_lock<std::mutex> stagedLock( imf->writerMutex_, std::defer_lock );
+
+      if ( stageSection_ )
+      {
+         stagedLock.lock();
+
+         placeStagedSection();
+      }
+
       if (writeIndexPackets_)
       {
-         // Write one index packet (required by standard).
+         // Write the index packets (at least one is required by standard).
          packetWriteIndex();
       }
 
@@ -223,7 +310,20 @@ namespace e57
       cVector_->setRecordCount( recordCount_ );
       cVector_->setBinarySectionLogicalStart( sectionHeaderLogicalStart_ );
 
-      // Free channels
+      if ( stagedLock.owns_lock() )
+      {
+         stagedLock.unlock();
+      }
+
+      // Keep the range of each channel's values, then free channels
+      for ( const auto &bytestream : bytestreams_ )
+      {
+         std::pair<double, double> range( 0.0, -1.0 );
+         bytestream->valueRange( range.first, range.second );
+         closedValueRanges_.push_back( range );
+      }
+
+      encoderPool_.reset();
       bytestreams_.clear();
 
 #ifdef E57_VERBOSE
@@ -245,6 +345,59 @@ namespace e57
       return cVector_;
    }
 
+   CompressedVectorWriterStatistics CompressedVectorWriterImpl::statistics() const
+   {
+      CompressedVectorWriterStatistics stats;
+
+      stats.recordCount = recordCount_;
+      stats.dataPacketCount = dataPacketsCount_;
+      stats.dataPacketBytes = dataPacketsLength_;
+      stats.indexPacketCount = indexPacketsCount_;
+
+      if ( dataPacketsCount_ > 0 )
+      {
+         stats.averageDataPacketFill = static_cast<double>( dataPacketsLength_ ) /
+                                       static_cast<double>( dataPacketsCount_ * DATA_PACKET_MAX );
+      }
+
+      return stats;
+   }
+
+   bool CompressedVectorWriterImpl::valueRange( const ustring &pathName, double &minimum,
+                                                double &maximum ) const
+   {
+      // Bytestreams are numbered by the position of their field in the prototype
+      NodeImplSharedPtr node = proto_->get( pathName );
+      uint64_t bytestreamNumber = 0;
+      if ( !proto_->findTerminalPosition( node, bytestreamNumber ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + pathName );
+      }
+
+      const auto cIndex = static_cast<size_t>( bytestreamNumber );
+
+      if ( !bytestreams_.empty() )
+      {
+         return bytestreams_.at( cIndex )->valueRange( minimum, maximum );
+      }
+
+      if ( cIndex >= closedValueRanges_.size() )
+      {
+         return false;
+      }
+
+      const std::pair<double, double> &range = closedValueRanges_[cIndex];
+      if ( range.first > range.second )
+      {
+         return false;
+      }
+
+      minimum = range.first;
+      maximum = range.second;
+
+      return true;
+   }
+
    void CompressedVectorWriterImpl::setBuffers( std::vector<SourceDestBuffer> &sbufs )
    {
       // don't checkImageFileOpen
@@ -285,6 +438,21 @@ namespace e57
       // don't checkWriterOpen(), write(unsigned) will do it
 
       setBuffers( sbufs );
+
+      // Point each channel at its new buffer. The channels are ordered by bytestream number.
+      for ( auto &sbuf : sbufs_ )
+      {
+         NodeImplSharedPtr node = proto_->get( sbuf.pathName() );
+         uint64_t bytestreamNumber = 0;
+         if ( !proto_->findTerminalPosition( node, bytestreamNumber ) )
+         {
+            throw E57_EXCEPTION2( ErrorInternal, "pathName=" + sbuf.pathName() );
+         }
+
+         std::vector<SourceDestBuffer> vTemp{ sbuf };
+         bytestreams_.at( static_cast<size_t>( bytestreamNumber ) )->sourceBufferSetNew( vTemp );
+      }
+
       write( requestedRecordCount );
    }
 
@@ -322,87 +490,98 @@ namespace e57
       uint64_t endRecordIndex = recordCount_ + requestedRecordCount;
       while ( true )
       {
-         // Calc remaining record counts for all channels
-         uint64_t totalRecordCount = 0;
-         for ( auto &bytestream : bytestreams_ )
+         // If this is the chunk's last data packet, end the chunk where the packet should fill up
+         if ( ( dataPacketsPerIndexEntry_ > 0 ) && ( chunkEndRecord_ == UINT64_MAX ) )
          {
-            totalRecordCount += endRecordIndex - bytestream->currentRecordIndex();
+            const unsigned cPacketsWritten = chunkStartPending_ ? 0 : chunkDataPacketCount_;
+
+            if ( cPacketsWritten + 1 >= dataPacketsPerIndexEntry_ )
+            {
+               chunkSetEnd();
+            }
          }
-#ifdef E57_VERBOSE
-         std::cout << "  totalRecordCount=" << totalRecordCount << std::endl; //???
-#endif
 
-         // We are done if have no more work, break out of loop
-         if ( totalRecordCount == 0 )
+         const uint64_t cStopRecordIndex = std::min( endRecordIndex, chunkEndRecord_ );
+
+         if ( encodeRecords( cStopRecordIndex ) )
          {
+            // Every channel is at the end of the chunk, so send what we have and start the next
+            // chunk with a new data packet.
+            if ( cStopRecordIndex == chunkEndRecord_ )
+            {
+               packetWrite();
+
+               chunkStartRecord_ = chunkEndRecord_;
+               chunkStartPending_ = true;
+               chunkEndRecord_ = UINT64_MAX;
+               continue;
+            }
+
+            // We are done if all channels completed the request. Any output left in the packet is
+            // written by a later write() or by close().
             break;
          }
 
-         // Estimate how many records can write before have enough data to fill
-         // data packet to efficient length Efficient packet length is >= 75%
-         // of maximum packet length. It is OK if get too much data (more than
-         // one packet) in an iteration. Reader will be able to handle packets
-         // whose streams are not exactly synchronized to the record
-         // boundaries. But try to do a good job of keeping the stream
-         // synchronization "close enough" (so a reader that can cache only two
-         // packets is efficient).
-
 #ifdef E57_VERBOSE
-         std::cout << "  currentPacketSize()=" << currentPacketSize() << std::endl; //???
+         std::cout << "  packet full, totalOutputAvailable()=" << totalOutputAvailable()
+                   << std::endl; //???
 #endif
 
-#ifdef E57_WRITE_CRAZY_PACKET_MODE
-         //??? depends on number of streams
-         constexpr size_t E57_TARGET_PACKET_SIZE = 500;
-#else
-         constexpr size_t E57_TARGET_PACKET_SIZE = ( DATA_PACKET_MAX * 3 / 4 );
-#endif
-         // If have more than target fraction of packet, send it now
-         if ( currentPacketSize() >= E57_TARGET_PACKET_SIZE )
-         { //???
+         // A channel has filled its slice. Share out what the others haven't used, or if the packet
+         // is nearly full, send it, which also gives every channel an empty slice to continue with.
+         // It is OK that channels are not exactly synchronized to the record boundaries, the reader
+         // is able to handle that. If the chunk ends in this packet, use every last byte trying to
+         // get there, rather than starting another packet for the few records left.
+         if ( !packetGrowBuffers( ( chunkEndRecord_ == UINT64_MAX ) ? cMinRegrowSize : 0 ) )
+         {
             packetWrite();
-            continue; // restart loop so recalc statistics (packet size may not be
-                      // zero after write, if have too much data)
          }
+      }
 
-#ifdef E57_VERBOSE
-         //??? useful?
-         // Get approximation of number of bytes per record of CompressedVector
-         // and total of bytes used
-         float totalBitsPerRecord = 0; // an estimate of future performance
-         for ( auto &bytestream : bytestreams_ )
-         {
-            totalBitsPerRecord += bytestream->bitsPerRecord();
-         }
+      recordCount_ += requestedRecordCount;
 
-         const float totalBytesPerRecord = std::max( totalBitsPerRecord / 8, 0.1F ); //??? trust
+      // When we leave this function, will likely still have data in channel
+      // ioBuffers as well as partial words in Encoder registers.
+   }
 
-         std::cout << "  totalBytesPerRecord=" << totalBytesPerRecord << std::endl; //???
-#endif
+   // Let each channel encode as many of its records up to endRecordIndex as will fit in its slice
+   // of the data packet. A channel that comes up short has filled its slice.
+   // Returns true if all channels reached endRecordIndex.
+   bool CompressedVectorWriterImpl::encodeRecords( uint64_t endRecordIndex )
+   {
+      // Each channel reads its own source buffer and writes its own slice of dataPacket_, so they
+      // can be run in any order, or concurrently, and produce the same bytes.
+      auto encodeChannel = [this, endRecordIndex]( size_t i ) {
+         auto &bytestream = bytestreams_[i];
 
-         // Don't allow straggler to get too far behind. ???
-         // Don't allow a single channel to get too far ahead ???
-         // Process channels that are furthest behind first. ???
+         if ( bytestream->currentRecordIndex() < endRecordIndex )
+         {
+            uint64_t recordCount = endRecordIndex - bytestream->currentRecordIndex();
+            bytestream->processRecords( static_cast<size_t>( recordCount ) );
+         }
+      };
 
-         // !!!! For now just process one record per loop until packet is full
-         // enough, or completed request
-         for ( auto &bytestream : bytestreams_ )
+      if ( encoderPool_ )
+      {
+         encoderPool_->run( bytestreams_.size(), encodeChannel );
+      }
+      else
+      {
+         for ( size_t i = 0; i < bytestreams_.size(); ++i )
          {
-            if ( bytestream->currentRecordIndex() < endRecordIndex )
-            {
-               // !!! For now, process up to 50 records at a time
-               uint64_t recordCount = endRecordIndex - bytestream->currentRecordIndex();
-               recordCount =
-                  ( recordCount < 50ULL ) ? recordCount : 50ULL; // min(recordCount, 50ULL);
-               bytestream->processRecords( static_cast<unsigned>( recordCount ) );
-            }
+            encodeChannel( i );
          }
       }
 
-      recordCount_ += requestedRecordCount;
+      for ( const auto &bytestream : bytestreams_ )
+      {
+         if ( bytestream->currentRecordIndex() < endRecordIndex )
+         {
+            return false;
+         }
+      }
 
-      // When we leave this function, will likely still have data in channel
-      // ioBuffers as well as partial words in Encoder registers.
+      return true;
    }
 
    size_t CompressedVectorWriterImpl::totalOutputAvailable() const
@@ -417,132 +596,290 @@ namespace e57
       return total;
    }
 
-   size_t CompressedVectorWriterImpl::currentPacketSize() const
+   // Work out how big each encoder's slice of dataPacket_'s payload should be. Each slice holds
+   // what the encoder has already written to this packet (nothing if emptyPacket), the smallest
+   // slice we hand out, and a share of the rest of the payload. The shares are sized from each
+   // encoder's bits per record and how far along it is, so that all channels should fill their
+   // slice at about the same record. Sizes are 0 for channels that don't produce output (e.g.
+   // constant integers).
+   // Returns that record, or UINT64_MAX if there is no spare space or no channel produces output.
+   uint64_t CompressedVectorWriterImpl::packetPlanBuffers( bool emptyPacket,
+                                                           std::vector<size_t> &sizes ) const
+   {
+      const size_t cNumByteStreams = bytestreams_.size();
+      const size_t cOverhead = sizeof( DataPacketHeader ) + cNumByteStreams * sizeof( uint16_t );
+      const size_t cPayloadSize =
+         ( cTargetPacketSize > cOverhead ) ? ( cTargetPacketSize - cOverhead ) : 0;
+
+      std::vector<double> bytesPerRecord( cNumByteStreams );
+      uint64_t firstRecordIndex = UINT64_MAX;
+      size_t used = 0;
+
+      sizes.assign( cNumByteStreams, 0 );
+
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
+      {
+         bytesPerRecord[i] = bytestreams_[i]->bitsPerRecord() / 8.0;
+
+         if ( bytesPerRecord[i] > 0.0 )
+         {
+            sizes[i] = ( emptyPacket ? 0 : bytestreams_[i]->outputAvailable() ) + cMinBufferSize;
+            used += sizes[i];
+
+            firstRecordIndex = std::min( firstRecordIndex, bytestreams_[i]->currentRecordIndex() );
+         }
+      }
+
+      if ( used >= cPayloadSize )
+      {
+         return UINT64_MAX;
+      }
+
+      // Records each channel is ahead of the one furthest behind
+      std::vector<double> lead( cNumByteStreams, 0.0 );
+      std::vector<bool> sharing( cNumByteStreams );
+
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
+      {
+         sharing[i] = ( bytesPerRecord[i] > 0.0 );
+
+         if ( sharing[i] )
+         {
+            lead[i] =
+               static_cast<double>( bytestreams_[i]->currentRecordIndex() - firstRecordIndex );
+         }
+      }
+
+      // Find the record all sharing channels would reach with the spare space. Channels which are
+      // already past it don't get any, which leaves more for the others, so repeat until none are.
+      const auto cSpare = static_cast<double>( cPayloadSize - used );
+      double targetRecord = 0.0;
+
+      while ( true )
+      {
+         double spare = cSpare;
+         double rate = 0.0;
+
+         for ( size_t i = 0; i < cNumByteStreams; ++i )
+         {
+            if ( sharing[i] )
+            {
+               spare += bytesPerRecord[i] * lead[i];
+               rate += bytesPerRecord[i];
+            }
+         }
+
+         if ( rate == 0.0 )
+         {
+            return UINT64_MAX;
+         }
+
+         targetRecord = spare / rate;
+
+         bool dropped = false;
+
+         for ( size_t i = 0; i < cNumByteStreams; ++i )
+         {
+            if ( sharing[i] && ( lead[i] >= targetRecord ) )
+            {
+               sharing[i] = false;
+               dropped = true;
+            }
+         }
+
+         if ( !dropped )
+         {
+            break;
+         }
+      }
+
+      // Round down, so the slices are guaranteed to fit
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
+      {
+         if ( sharing[i] )
+         {
+            sizes[i] += static_cast<size_t>( bytesPerRecord[i] * ( targetRecord - lead[i] ) );
+         }
+      }
+
+      return firstRecordIndex + static_cast<uint64_t>( targetRecord );
+   }
+
+   // Give each encoder an empty slice of dataPacket_'s payload to write into, after the
+   // bytestreamBufferLength array.
+   void CompressedVectorWriterImpl::packetSetupBuffers()
    {
-      // Calc current packet size
-      return ( sizeof( DataPacketHeader ) + bytestreams_.size() * sizeof( uint16_t ) +
-               totalOutputAvailable() );
+      const size_t cNumByteStreams = bytestreams_.size();
+
+      std::vector<size_t> sizes;
+      packetTargetRecord_ = packetPlanBuffers( true, sizes );
+
+      size_t offset = cNumByteStreams * sizeof( uint16_t );
+      for ( size_t size : sizes )
+      {
+         offset += size;
+      }
+
+      if ( sizeof( DataPacketHeader ) + offset > DATA_PACKET_MAX )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "bytestreamCount=" + toString( cNumByteStreams ) +
+                                                 " minimumSize=" + toString( offset ) );
+      }
+
+      bytestreamBufferOffsets_.resize( cNumByteStreams );
+
+      auto payload = reinterpret_cast<char *>( dataPacket_->payload );
+      offset = cNumByteStreams * sizeof( uint16_t );
+
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
+      {
+         bytestreamBufferOffsets_[i] = offset;
+         bytestreams_[i]->outputSetBuffer( payload + offset, sizes[i] );
+
+         offset += sizes[i];
+      }
    }
 
-   uint64_t CompressedVectorWriterImpl::packetWrite()
+   // One of the channels has filled its slice of dataPacket_. If at least minGrowSize bytes are
+   // left in the packet, on top of the smallest slice for each channel, move the slices around so
+   // the space the other channels haven't used is shared out again, and return true so encoding
+   // can continue in the same packet. Otherwise return false, and the packet should be written.
+   bool CompressedVectorWriterImpl::packetGrowBuffers( size_t minGrowSize )
    {
-#ifdef E57_VERBOSE
-      std::cout << "CompressedVectorWriterImpl::packetWrite() called" << std::endl; //???
-#endif
+      const size_t cNumByteStreams = bytestreams_.size();
+      const size_t cLengthsSize = cNumByteStreams * sizeof( uint16_t );
 
-      // Double check that we have work to do
-      const size_t cTotalOutput = totalOutputAvailable();
-      if ( cTotalOutput == 0 )
+      size_t used = cLengthsSize;
+      size_t activeCount = 0;
+
+      for ( const auto &bytestream : bytestreams_ )
       {
-         return ( 0 );
+         used += bytestream->outputAvailable();
+
+         if ( bytestream->bitsPerRecord() > 0 )
+         {
+            ++activeCount;
+         }
       }
 
-      // const bytestreams_ so it's clear it isn't modified in this function
-      const auto &cStreams = bytestreams_;
-      const auto cNumByteStreams = cStreams.size();
+      const size_t cPayloadSize = cTargetPacketSize - sizeof( DataPacketHeader );
+      if ( used + activeCount * cMinBufferSize + minGrowSize > cPayloadSize )
+      {
+         return false;
+      }
 
-      // Calc maximum number of bytestream values can put in data packet.
-      const size_t cPacketMaxPayloadBytes =
-         DATA_PACKET_MAX - sizeof( DataPacketHeader ) - cNumByteStreams * sizeof( uint16_t );
+      std::vector<size_t> sizes;
+      packetTargetRecord_ = packetPlanBuffers( false, sizes );
 
-#ifdef E57_VERBOSE
-      std::cout << "  totalOutput=" << cTotalOutput << std::endl;
-      std::cout << "  cNumByteStreams=" << cNumByteStreams << std::endl;
-      std::cout << "  packetMaxPayloadBytes=" << cPacketMaxPayloadBytes << std::endl;
+      std::vector<size_t> offsets( cNumByteStreams );
+      size_t offset = cLengthsSize;
+
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
+      {
+         offsets[i] = offset;
+         offset += sizes[i];
+      }
+
+#if VALIDATE_BASIC
+      // Double check the slices fit in the payload
+      if ( offset > DataPacket::PayloadSize )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "offset=" + toString( offset ) );
+      }
 #endif
 
-      // Allocate vector for number of bytes that each bytestream will write to file.
-      std::vector<size_t> count( cNumByteStreams );
+      // Slices stay in bytestream order, so moving the ones going down in that order and then the
+      // ones going up in reverse order never overwrites output we haven't moved yet.
+      auto payload = reinterpret_cast<char *>( dataPacket_->payload );
 
-      // See if we can fit into a single data packet
-      if ( cTotalOutput < cPacketMaxPayloadBytes )
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
       {
-         // We can fit everything in one packet
-         for ( unsigned i = 0; i < cNumByteStreams; ++i )
+         if ( offsets[i] < bytestreamBufferOffsets_[i] )
          {
-            count.at( i ) = cStreams.at( i )->outputAvailable();
+            memmove( payload + offsets[i], payload + bytestreamBufferOffsets_[i],
+                     bytestreams_[i]->outputAvailable() );
          }
       }
-      else
+
+      for ( size_t i = cNumByteStreams; i-- > 0; )
       {
-         // We have too much data for one packet.  Send proportional amounts from
-         // each bytestream. Adjust packetMaxPayloadBytes down by one so have a
-         // little slack for floating point weirdness.
-         const float cFractionToSend =
-            ( cPacketMaxPayloadBytes - 1 ) / static_cast<float>( cTotalOutput );
-         for ( unsigned i = 0; i < cNumByteStreams; ++i )
+         if ( offsets[i] > bytestreamBufferOffsets_[i] )
          {
-            // Round down here so sum <= packetMaxPayloadBytes
-            count.at( i ) = static_cast<unsigned>(
-               std::floor( cFractionToSend * cStreams.at( i )->outputAvailable() ) );
+            memmove( payload + offsets[i], payload + bytestreamBufferOffsets_[i],
+                     bytestreams_[i]->outputAvailable() );
          }
       }
 
-#ifdef E57_VERBOSE
-      for ( unsigned i = 0; i < cNumByteStreams; ++i )
+      for ( size_t i = 0; i < cNumByteStreams; ++i )
       {
-         std::cout << "  count[" << i << "]=" << count.at( i ) << std::endl;
+         bytestreamBufferOffsets_[i] = offsets[i];
+         bytestreams_[i]->outputMoveBuffer( payload + offsets[i], sizes[i] );
       }
-#endif
 
-#if VALIDATE_BASIC
-      // Double check sum of count is <= packetMaxPayloadBytes
-      const size_t cTotalByteCount =
-         std::accumulate( count.begin(), count.end(), static_cast<size_t>( 0 ) );
+      return true;
+   }
 
-      if ( cTotalByteCount > cPacketMaxPayloadBytes )
+   uint64_t CompressedVectorWriterImpl::packetWrite()
+   {
+#ifdef E57_VERBOSE
+      std::cout << "CompressedVectorWriterImpl::packetWrite() called" << std::endl; //???
+#endif
+
+      // Double check that we have work to do
+      const size_t cTotalOutput = totalOutputAvailable();
+      if ( cTotalOutput == 0 )
       {
-         throw E57_EXCEPTION2( ErrorInternal,
-                               "totalByteCount=" + toString( cTotalByteCount ) +
-                                  " packetMaxPayloadBytes=" + toString( cPacketMaxPayloadBytes ) );
+         return ( 0 );
       }
+
+      // const bytestreams_ so it's clear it isn't modified in this function
+      const auto &cStreams = bytestreams_;
+      const auto cNumByteStreams = cStreams.size();
+
+#ifdef E57_VERBOSE
+      std::cout << "  totalOutput=" << cTotalOutput << std::endl;
+      std::cout << "  cNumByteStreams=" << cNumByteStreams << std::endl;
 #endif
 
       // Get smart pointer to ImageFileImpl from associated CompressedVector
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
       // Use temp buf in object (is 64KBytes long) instead of allocating each time here
-      char *packet = reinterpret_cast<char *>( &dataPacket_ );
+      char *packet = reinterpret_cast<char *>( dataPacket_ );
+      auto payload = reinterpret_cast<char *>( dataPacket_->payload );
 
       // To be safe, clear header part of packet
-      dataPacket_.header.reset();
+      dataPacket_->header.reset();
 
       // Write bytestreamBufferLength[bytestreamCount] after header, in dataPacket_
-      auto bsbLength = reinterpret_cast<uint16_t *>( &packet[sizeof( DataPacketHeader )] );
+      auto bsbLength = reinterpret_cast<uint16_t *>( payload );
 #ifdef E57_VERBOSE
       std::cout << "  packet=" << static_cast<void *>( packet ) << std::endl; //???
       std::cout << "  bsbLength=" << bsbLength << std::endl;                  //???
 #endif
-      for ( unsigned i = 0; i < cNumByteStreams; ++i )
-      {
-         bsbLength[i] = static_cast<uint16_t>( count.at( i ) ); // %%% Truncation
-#ifdef E57_VERBOSE
-         std::cout << "  Writing " << bsbLength[i] << " bytes into bytestream " << i
-                   << std::endl; //???
-#endif
-      }
 
       // Get pointer to end of data so far
       auto *p = reinterpret_cast<char *>( &bsbLength[cNumByteStreams] );
-#ifdef E57_VERBOSE
-      std::cout << "  after bsbLength, p=" << static_cast<void *>( p ) << std::endl; //???
-#endif
 
-      // Write contents of each bytestream in dataPacket_
+      // The encoders have already written their output into their slices of dataPacket_, so
+      // all that is left is to record the lengths and close up the gaps between the slices.
       for ( size_t i = 0; i < cNumByteStreams; ++i )
       {
-         size_t n = count.at( i );
+         const size_t n = cStreams.at( i )->outputAvailable();
 
-#if VALIDATE_BASIC
-         // Double check we aren't accidentally going to write off end of vector<char>
-         if ( &p[n] > &packet[DATA_PACKET_MAX] )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "n=" + toString( n ) );
-         }
+         bsbLength[i] = static_cast<uint16_t>( n );
+#ifdef E57_VERBOSE
+         std::cout << "  Writing " << bsbLength[i] << " bytes into bytestream " << i
+                   << std::endl; //???
 #endif
 
-         // Read from encoder output into packet
-         cStreams.at( i )->outputRead( p, n );
+         // Slices are in bytestream order and p never passes the start of the current one, so
+         // this only ever moves data down. Overlapping regions ok with memmove().
+         const char *src = payload + bytestreamBufferOffsets_.at( i );
+         if ( src != p )
+         {
+            memmove( p, src, n );
+         }
 
          // Move pointer to end of current data
          p += n;
@@ -557,12 +894,12 @@ namespace e57
 #if VALIDATE_BASIC
       // Double check that packetLength is what we expect
       if ( packetLength !=
-           sizeof( DataPacketHeader ) + cNumByteStreams * sizeof( uint16_t ) + cTotalByteCount )
+           sizeof( DataPacketHeader ) + cNumByteStreams * sizeof( uint16_t ) + cTotalOutput )
       {
          throw E57_EXCEPTION2( ErrorInternal, "packetLength=" + toString( packetLength ) +
                                                  " bytestreamSize=" +
                                                  toString( cNumByteStreams * sizeof( uint16_t ) ) +
-                                                 " totalByteCount=" + toString( cTotalByteCount ) );
+                                                 " totalOutput=" + toString( cTotalOutput ) );
       }
 #endif
 
@@ -571,7 +908,7 @@ namespace e57
       {
          // Double check we aren't accidentally going to write off end of
          // vector<char>
-         if ( p >= &packet[DATA_PACKET_MAX - 1] )
+         if ( p >= packet + DATA_PACKET_MAX )
          {
             throw E57_EXCEPTION1( ErrorInternal );
          }
@@ -584,26 +921,52 @@ namespace e57
       }
 
       // Prepare header in dataPacket_, now that we are sure of packetLength
-      dataPacket_.header.packetLogicalLengthMinus1 =
+      dataPacket_->header.packetLogicalLengthMinus1 =
          static_cast<uint16_t>( packetLength - 1 ); // %%% Truncation
-      dataPacket_.header.bytestreamCount =
+      dataPacket_->header.bytestreamCount =
          static_cast<uint16_t>( cNumByteStreams ); // %%% Truncation
 
       // Double check that data packet is well formed
-      dataPacket_.verify( packetLength );
-
-      // Write whole data packet at beginning of free space in file
-      uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
-      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
-      imf->file_->seek( packetLogicalOffset ); //??? have seekLogical and seekPhysical instead?
-                                               // more explicit
-      imf->file_->write( packet, packetLength );
+      dataPacket_->verify( packetLength );
 
 #ifdef E57_VERBOSE
 //  std::cout << "data packet:" << std::endl;
-//  dataPacket_.dump(4);
+//  dataPacket_->dump(4);
 #endif
 
+      uint64_t packetPhysicalOffset = 0;
+
+      if ( stageSection_ )
+      {
+         packetPhysicalOffset = packetStage( packet, packetLength );
+      }
+      else
+      {
+         // Write whole data packet at beginning of free space in file
+         uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
+         packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
+
+         if ( dataPackets_.size() > 1 )
+         {
+            // Queue the packet to be written (and CRC'd) on the file's background thread, and
+            // move on to the next packet buffer. We only have to wait if it is still being written.
+            dataPacketWriteTickets_[currentDataPacket_] =
+               imf->file_->writeInBackground( packetLogicalOffset, packet, packetLength );
+
+            currentDataPacket_ = ( currentDataPacket_ + 1 ) % dataPackets_.size();
+
+            imf->file_->waitForBackgroundWrite( dataPacketWriteTickets_[currentDataPacket_] );
+
+            dataPacket_ = &dataPackets_[currentDataPacket_];
+         }
+         else
+         {
+            imf->file_->seek( packetLogicalOffset ); //??? have seekLogical and seekPhysical
+                                                     // instead? more explicit
+            imf->file_->write( packet, packetLength );
+         }
+      }
+
       // If first data packet written for this CompressedVector binary section,
       // save address to put in section header
       //??? what if no data packets?
@@ -615,23 +978,73 @@ namespace e57
          dataPhysicalOffset_ = packetPhysicalOffset;
       }
       dataPacketsCount_++;
+      dataPacketsLength_ += packetLength;
 
-      // !!! update seekIndex here? if started new chunk?
+      if ( dataPacketsPerIndexEntry_ > 0 )
+      {
+         // The first data packet of a chunk gets the index entry
+         if ( chunkStartPending_ )
+         {
+            IndexPacket::Entry entry;
+            entry.chunkRecordNumber = chunkStartRecord_;
+            entry.chunkPhysicalOffset = packetPhysicalOffset;
+
+            indexEntries_.push_back( entry );
+
+            chunkStartPending_ = false;
+            chunkDataPacketCount_ = 0;
+         }
+
+         ++chunkDataPacketCount_;
+      }
 
-      // Return physical offset of data packet for potential use in seekIndex
+      // Start the next packet with empty slices
+      packetSetupBuffers();
+
+      // Return physical offset of data packet
       return ( packetPhysicalOffset ); //??? needed
    }
 
+   // The current data packet is the last one the chunk needs, so end the chunk at the last aligned
+   // record before the packet is expected to be full. If a channel has already passed that, use the
+   // first aligned record that no channel has passed yet instead. write() stops encoding at the end
+   // and starts a new chunk.
+   void CompressedVectorWriterImpl::chunkSetEnd()
+   {
+      // A chunk must have at least one record, even if (part of a long string) is all we wrote
+      uint64_t endRecord = chunkStartRecord_ + 1;
+
+      for ( const auto &bytestream : bytestreams_ )
+      {
+         // Channels without output (constant integers) are always done with the whole request
+         if ( bytestream->bitsPerRecord() > 0 )
+         {
+            endRecord = std::max( endRecord, bytestream->currentRecordIndex() );
+         }
+      }
+
+      endRecord = ( endRecord + cChunkRecordAlignment - 1 ) / cChunkRecordAlignment *
+                  cChunkRecordAlignment;
+
+      if ( packetTargetRecord_ != UINT64_MAX )
+      {
+         endRecord = std::max( endRecord, packetTargetRecord_ / cChunkRecordAlignment *
+                                             cChunkRecordAlignment );
+      }
+
+      chunkEndRecord_ = endRecord;
+   }
+
    // If we don't have any records, write a packet which is only the header + zero padding.
    // Code is a simplified version of packetWrite().
    void CompressedVectorWriterImpl::packetWriteZeroRecords()
    {
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
-      dataPacket_.header.reset();
+      dataPacket_->header.reset();
 
       // Use temp buf in object (is 64KBytes long) instead of allocating each time here
-      char *packet = reinterpret_cast<char *>( &dataPacket_ );
+      char *packet = reinterpret_cast<char *>( dataPacket_ );
 
       auto packetLength = static_cast<unsigned int>( sizeof( DataPacketHeader ) );
 
@@ -645,17 +1058,26 @@ namespace e57
       }
 
       // Prepare header in dataPacket_, now that we are sure of packetLength
-      dataPacket_.header.packetLogicalLengthMinus1 = static_cast<uint16_t>( packetLength - 1 );
+      dataPacket_->header.packetLogicalLengthMinus1 = static_cast<uint16_t>( packetLength - 1 );
 
       // Double check that data packet is well formed
-      dataPacket_.verify( packetLength );
+      dataPacket_->verify( packetLength );
 
-      // Write packet at beginning of free space in file
-      uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
-      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
+      uint64_t packetPhysicalOffset = 0;
 
-      imf->file_->seek( packetLogicalOffset );
-      imf->file_->write( packet, packetLength );
+      if ( stageSection_ )
+      {
+         packetPhysicalOffset = packetStage( packet, packetLength );
+      }
+      else
+      {
+         // Write packet at beginning of free space in file
+         uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
+         packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
+
+         imf->file_->seek( packetLogicalOffset );
+         imf->file_->write( packet, packetLength );
+      }
 
       // If first data packet written for this CompressedVector binary section,
       // save address to put in section header
@@ -665,31 +1087,130 @@ namespace e57
       }
 
       dataPacketsCount_++;
+      dataPacketsLength_ += packetLength;
+   }
+
+   // Add a data packet to the section being staged in memory.
+   // Returns its offset from the start of the staged data packets.
+   uint64_t CompressedVectorWriterImpl::packetStage( const char *packet, unsigned packetLength )
+   {
+      const uint64_t cOffset = stagedPackets_.size();
+
+      stagedPackets_.insert( stagedPackets_.end(), packet, packet + packetLength );
+
+      return cOffset;
    }
 
-   // Write one index packet.
-   // We don't have an interface to work with index packets, but one is required by the standard, so
-   // write one index packet with one entry pointing to the first data packet.
+   // Reserve space at the end of the file for the section header and the staged data packets, and
+   // write the packets there. Their offsets become physical ones, ready for the index packets and
+   // the section header, which are written after them in the usual way.
+   // The caller must hold the ImageFile's writerMutex_.
+   void CompressedVectorWriterImpl::placeStagedSection()
+   {
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      sectionHeaderLogicalStart_ =
+         imf->allocateSpace( sizeof( CompressedVectorSectionHeader ), true );
+
+      const uint64_t cPacketsLogicalStart = imf->allocateSpace( stagedPackets_.size(), false );
+
+      if ( !stagedPackets_.empty() )
+      {
+         imf->file_->seek( cPacketsLogicalStart );
+         imf->file_->write( stagedPackets_.data(), stagedPackets_.size() );
+      }
+
+      if ( dataPacketsCount_ > 0 )
+      {
+         dataPhysicalOffset_ =
+            imf->file_->logicalToPhysical( cPacketsLogicalStart + dataPhysicalOffset_ );
+      }
+
+      for ( auto &entry : indexEntries_ )
+      {
+         entry.chunkPhysicalOffset =
+            imf->file_->logicalToPhysical( cPacketsLogicalStart + entry.chunkPhysicalOffset );
+      }
+
+      // Free the memory now, the writer object may be kept around for a while
+      std::vector<char>().swap( stagedPackets_ );
+   }
+
+   // Write the index packets as a tree.
+   // Level 0 packets have an entry for each chunk of records, pointing to its first data packet.
+   // Each level above has an entry for each packet of the level below, until one packet holds
+   // them all. That is the top level index packet the section header points to.
    void e57::CompressedVectorWriterImpl::packetWriteIndex()
    {
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
-      IndexPacket indexPacket;
+      std::vector<IndexPacket::Entry> entries = indexEntries_;
 
-      indexPacket.entries[0].chunkPhysicalOffset = dataPhysicalOffset_;
+      // If we didn't split the records into chunks, one chunk starts at the first data packet.
+      if ( entries.empty() )
+      {
+         IndexPacket::Entry entry;
+         entry.chunkPhysicalOffset = dataPhysicalOffset_;
 
-      const auto cPacketLength = sizeof( IndexPacketHeader ) + sizeof( IndexPacket::Entry );
+         entries.push_back( entry );
+      }
+
+      // 32k, so keep it off the stack
+      std::unique_ptr<IndexPacket> indexPacket( new IndexPacket );
+
+      uint8_t indexLevel = 0;
+
+      while ( true )
+      {
+         std::vector<IndexPacket::Entry> parentEntries;
+
+         // Spread the entries evenly over the packets. Index packets above level 0 must have at
+         // least two entries, so we can't leave a lone entry at the end.
+         const size_t cPacketCount =
+            ( entries.size() + IndexPacket::MAX_ENTRIES - 1 ) / IndexPacket::MAX_ENTRIES;
+
+         for ( size_t i = 0; i < cPacketCount; ++i )
+         {
+            const size_t first = i * entries.size() / cPacketCount;
+            const size_t cEntryCount = ( i + 1 ) * entries.size() / cPacketCount - first;
+            const auto cPacketLength =
+               sizeof( IndexPacketHeader ) + cEntryCount * sizeof( IndexPacket::Entry );
+
+            indexPacket->header.packetLogicalLengthMinus1 =
+               static_cast<uint16_t>( cPacketLength - 1 );
+            indexPacket->header.entryCount = static_cast<uint16_t>( cEntryCount );
+            indexPacket->header.indexLevel = indexLevel;
+
+            std::copy( &entries[first], &entries[first] + cEntryCount, indexPacket->entries );
 
-      indexPacket.header.packetLogicalLengthMinus1 = cPacketLength - 1;
-      indexPacket.header.entryCount = 1;
+#if VALIDATE_BASIC
+            indexPacket->verify( static_cast<unsigned>( cPacketLength ) );
+#endif
+
+            uint64_t packetLogicalOffset = imf->allocateSpace( cPacketLength, false );
 
-      uint64_t packetLogicalOffset = imf->allocateSpace( cPacketLength, false );
-      topIndexPhysicalOffset_ = imf->file_->logicalToPhysical( packetLogicalOffset );
+            imf->file_->seek( packetLogicalOffset );
+            imf->file_->write( reinterpret_cast<const char *>( indexPacket.get() ),
+                               cPacketLength );
 
-      imf->file_->seek( packetLogicalOffset );
-      imf->file_->write( reinterpret_cast<const char *>( &indexPacket ), cPacketLength );
+            indexPacketsCount_++;
+
+            IndexPacket::Entry parentEntry;
+            parentEntry.chunkRecordNumber = entries[first].chunkRecordNumber;
+            parentEntry.chunkPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
+
+            parentEntries.push_back( parentEntry );
+         }
 
-      indexPacketsCount_++;
+         if ( parentEntries.size() == 1 )
+         {
+            topIndexPhysicalOffset_ = parentEntries[0].chunkPhysicalOffset;
+            break;
+         }
+
+         entries.swap( parentEntries );
+         ++indexLevel;
+      }
    }
 
    void CompressedVectorWriterImpl::flush()
@@ -747,7 +1268,7 @@ namespace e57
       // Don't call dump() for DataPacket, since it may contain junk when
       // debugging.  Just print a few byte values.
       os << space( indent ) << "dataPacket:" << std::endl;
-      auto p = reinterpret_cast<uint8_t *>( &dataPacket_ );
+      auto p = reinterpret_cast<uint8_t *>( dataPacket_ );
 
       for ( unsigned i = 0; i < 40; ++i )
       {
@@ -764,7 +1285,9 @@ namespace e57
          << std::endl;
       os << space( indent ) << "recordCount:               " << recordCount_ << std::endl;
       os << space( indent ) << "dataPacketsCount:          " << dataPacketsCount_ << std::endl;
+      os << space( indent ) << "dataPacketsLength:         " << dataPacketsLength_ << std::endl;
       os << space( indent ) << "indexPacketsCount:         " << indexPacketsCount_ << std::endl;
+      os << space( indent ) << "indexEntriesCount:         " << indexEntries_.size() << std::endl;
    }
 #endif
 }
@@ -31,18 +31,22 @@
 
 namespace e57
 {
+   class ThreadPool;
+
    class CompressedVectorWriterImpl
    {
    public:
       CompressedVectorWriterImpl( std::shared_ptr<CompressedVectorNodeImpl> ni,
                                   std::vector<SourceDestBuffer> &sbufs,
-                                  bool writeIndexPackets = true );
+                                  const CompressedVectorWriterOptions &options );
       ~CompressedVectorWriterImpl();
 
       void write( size_t requestedRecordCount );
       void write( std::vector<SourceDestBuffer> &sbufs, size_t requestedRecordCount );
       bool isOpen() const;
       std::shared_ptr<CompressedVectorNodeImpl> compressedVectorNode() const;
+      CompressedVectorWriterStatistics statistics() const;
+      bool valueRange( const ustring &pathName, double &minimum, double &maximum ) const;
       void close();
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -55,10 +59,16 @@ namespace e57
       void checkWriterOpen( const char *srcFileName, int srcLineNumber,
                             const char *srcFunctionName ) const;
       void setBuffers( std::vector<SourceDestBuffer> &sbufs ); //???needed?
+      bool encodeRecords( uint64_t endRecordIndex );
       size_t totalOutputAvailable() const;
-      size_t currentPacketSize() const;
+      void packetSetupBuffers();
+      bool packetGrowBuffers( size_t minGrowSize );
+      uint64_t packetPlanBuffers( bool emptyPacket, std::vector<size_t> &sizes ) const;
       uint64_t packetWrite();
       void packetWriteZeroRecords();
+      uint64_t packetStage( const char *packet, unsigned packetLength );
+      void placeStagedSection();
+      void chunkSetEnd();
       void packetWriteIndex();
 
       void flush();
@@ -68,9 +78,41 @@ namespace e57
       NodeImplSharedPtr proto_;
 
       std::vector<std::shared_ptr<Encoder>> bytestreams_;
-      DataPacket dataPacket_;
+
+      /// Range of the values of each bytestream, kept when the encoders are freed by close()
+      /// (minimum > maximum if there are none)
+      std::vector<std::pair<double, double>> closedValueRanges_;
+
+      /// Data packets. With background writes, one is being filled by the encoders while the
+      /// others are being written.
+      std::vector<DataPacket> dataPackets_;
+      std::vector<uint64_t> dataPacketWriteTickets_; /// background write of each data packet
+      size_t currentDataPacket_ = 0;
+      DataPacket *dataPacket_ = nullptr; /// the data packet being filled
+      std::vector<size_t> bytestreamBufferOffsets_; /// start of each encoder's slice of payload
+      uint64_t packetTargetRecord_ = UINT64_MAX; /// record the data packet should be full at
+
+      /// Encodes the bytestreams concurrently (null if encoding on the calling thread)
+      std::unique_ptr<ThreadPool> encoderPool_;
 
       bool writeIndexPackets_;             /// set this to false for backwards compatibility
+
+      /// Build the section in memory, and write it to the file when closed. Until then, the
+      /// physical offsets of the data packets (dataPhysicalOffset_ and the index entries) are
+      /// offsets into stagedPackets_.
+      bool stageSection_;
+      std::vector<char> stagedPackets_; /// data packets written so far, when staging the section
+
+      /// Records are written in chunks of about this many data packets, each with an index entry
+      /// (0 = a single chunk)
+      unsigned dataPacketsPerIndexEntry_;
+      std::vector<IndexPacket::Entry> indexEntries_; /// first record & data packet of each chunk
+      uint64_t chunkStartRecord_ = 0;                /// first record of the current chunk
+      bool chunkStartPending_ = true;    /// current chunk has no data packet (or index entry) yet
+      unsigned chunkDataPacketCount_ = 0; /// data packets written in the current chunk
+                                          /// (if it has any)
+      uint64_t chunkEndRecord_ = UINT64_MAX; /// where the current chunk ends, once we know
+
       bool isOpen_;
       uint64_t sectionHeaderLogicalStart_; /// start of CompressedVector binary section
       uint64_t sectionLogicalLength_;      /// total length of CompressedVector binary section
@@ -78,6 +120,7 @@ namespace e57
       uint64_t topIndexPhysicalOffset_;    /// top level index packet
       uint64_t recordCount_;               /// number of records written so far
       uint64_t dataPacketsCount_;          /// number of data packets written so far
+      uint64_t dataPacketsLength_;         /// total length of the data packets written so far
       uint64_t indexPacketsCount_;         /// number of index packets written so far
    };
 }
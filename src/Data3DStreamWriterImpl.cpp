@@ -0,0 +1,418 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#include "Data3DStreamWriterImpl.h"
+
+#include "Common.h"
+#include "StringFunctions.h"
+#include "WriterImpl.h"
+
+namespace e57
+{
+   // The minimum & maximum of a range which hasn't been set (the Data3DPointsData_t constructor
+   // sets them to the float limits when using floats)
+   static bool _isRangeUnset( double inMinimum, double inMaximum )
+   {
+      return ( ( inMinimum == DOUBLE_MIN ) || ( inMinimum == FLOAT_MIN ) ) &&
+             ( ( inMaximum == DOUBLE_MAX ) || ( inMaximum == FLOAT_MAX ) );
+   }
+
+   // We can't work out the ranges needed to encode the points from the points themselves before
+   // they are written, so they have to be in the header.
+   static void _validateStreamHeader( const Data3D &inData3DHeader )
+   {
+      const auto &fields = inData3DHeader.pointFields;
+
+      const bool cHasPointRange =
+         fields.cartesianXField || fields.cartesianYField || fields.cartesianZField ||
+         fields.sphericalRangeField;
+
+      if ( cHasPointRange && ( fields.pointRangeNodeType == NumericalNodeType::ScaledInteger ) &&
+           _isRangeUnset( fields.pointRangeMinimum, fields.pointRangeMaximum ) )
+      {
+         throw E57_EXCEPTION2( ErrorInvalidData3DValue,
+                               "pointRangeMinimum and pointRangeMaximum must be set to stream "
+                               "ScaledInteger points" );
+      }
+
+      const bool cHasAngle = fields.sphericalAzimuthField || fields.sphericalElevationField;
+
+      if ( cHasAngle && ( fields.angleNodeType == NumericalNodeType::ScaledInteger ) &&
+           _isRangeUnset( fields.angleMinimum, fields.angleMaximum ) )
+      {
+         throw E57_EXCEPTION2( ErrorInvalidData3DValue,
+                               "angleMinimum and angleMaximum must be set to stream ScaledInteger "
+                               "angles" );
+      }
+
+      if ( fields.timeStampField && ( fields.timeNodeType == NumericalNodeType::ScaledInteger ) &&
+           _isRangeUnset( fields.timeMinimum, fields.timeMaximum ) )
+      {
+         throw E57_EXCEPTION2( ErrorInvalidData3DValue,
+                               "timeMinimum and timeMaximum must be set to stream ScaledInteger "
+                               "time stamps" );
+      }
+
+      const bool cIntegerIntensity =
+         ( fields.intensityNodeType == NumericalNodeType::Integer ) ||
+         ( fields.intensityNodeType == NumericalNodeType::ScaledInteger );
+
+      if ( fields.intensityField && cIntegerIntensity &&
+           ( inData3DHeader.intensityLimits == IntensityLimits{} ) )
+      {
+         throw E57_EXCEPTION2( ErrorInvalidData3DValue,
+                               "intensityLimits must be set to stream Integer or ScaledInteger "
+                               "intensities" );
+      }
+
+      const bool cHasColor =
+         fields.colorRedField || fields.colorGreenField || fields.colorBlueField;
+
+      if ( cHasColor && ( inData3DHeader.colorLimits == ColorLimits{} ) )
+      {
+         throw E57_EXCEPTION2( ErrorInvalidData3DValue,
+                               "colorLimits must be set to stream colors" );
+      }
+   }
+
+   Data3DStreamWriterImpl::Data3DStreamWriterImpl( std::shared_ptr<WriterImpl> writer,
+                                                   const Data3D &data3DHeader,
+                                                   const Data3DFieldRanges &fieldRanges ) :
+      writer_( std::move( writer ) ),
+      header_( data3DHeader )
+   {
+      scanIndex_ = writer_->NewData3D( header_, fieldRanges );
+
+      header_.pointCount = 0;
+   }
+
+   void Data3DStreamWriterImpl::ValidateHeader( const Data3D &data3DHeader )
+   {
+      _validateStreamHeader( data3DHeader );
+   }
+
+   Data3DStreamWriterImpl::~Data3DStreamWriterImpl()
+   {
+      // Try to close the stream, but don't throw from a destructor
+      try
+      {
+         Close();
+      }
+      catch ( ... )
+      {
+      }
+   }
+
+   template <typename COORDTYPE>
+   void Data3DStreamWriterImpl::Append( const Data3DPointsData_t<COORDTYPE> &buffers,
+                                        size_t pointCount )
+   {
+      checkOpen();
+
+      if ( pointCount == 0 )
+      {
+         return;
+      }
+
+      // This has to see the bounds as they were before the chunk is written
+      addInvalidPoints( buffers, pointCount );
+
+      // The first chunk sets up the writer. After that the writer is pointed at each chunk's
+      // buffers in turn, so they may be of any size.
+      if ( !dataWriter_ )
+      {
+         dataWriter_.reset( new CompressedVectorWriter(
+            writer_->SetUpData3DPointsData( scanIndex_, pointCount, buffers ) ) );
+
+         dataWriter_->write( pointCount );
+      }
+      else
+      {
+         std::vector<SourceDestBuffer> sourceBuffers =
+            writer_->Data3DSourceBuffers( scanIndex_, pointCount, buffers );
+
+         dataWriter_->write( sourceBuffers, pointCount );
+      }
+
+      pointCount_ += pointCount;
+      header_.pointCount = static_cast<size_t>( pointCount_ );
+   }
+
+   // Explicit template instantiation
+   template void Data3DStreamWriterImpl::Append( const Data3DPointsData_t<float> &buffers,
+                                                 size_t pointCount );
+
+   template void Data3DStreamWriterImpl::Append( const Data3DPointsData_t<double> &buffers,
+                                                 size_t pointCount );
+
+   int64_t Data3DStreamWriterImpl::Close()
+   {
+      if ( !isOpen_ )
+      {
+         return scanIndex_;
+      }
+
+      isOpen_ = false;
+
+      // If no points were appended, we still need to write the (empty) binary section
+      if ( !dataWriter_ )
+      {
+         Data3D emptyHeader = header_;
+         emptyHeader.pointCount = 0;
+
+         const Data3DPointsDouble buffers( emptyHeader );
+
+         dataWriter_.reset( new CompressedVectorWriter(
+            writer_->SetUpData3DPointsData( scanIndex_, 0, buffers ) ) );
+
+         dataWriter_->write( 0 );
+      }
+
+      dataWriter_->close();
+
+      setHeaderBounds();
+
+      dataWriter_.reset();
+
+      StructureNode scan( writer_->GetRawData3D().get( scanIndex_ ) );
+
+      writer_->SetData3DBounds( scan, header_ );
+
+      return scanIndex_;
+   }
+
+   bool Data3DStreamWriterImpl::IsOpen() const
+   {
+      return isOpen_;
+   }
+
+   uint64_t Data3DStreamWriterImpl::PointCount() const
+   {
+      return pointCount_;
+   }
+
+   const Data3D &Data3DStreamWriterImpl::Header() const
+   {
+      return header_;
+   }
+
+   void Data3DStreamWriterImpl::checkOpen() const
+   {
+      if ( !isOpen_ )
+      {
+         throw E57_EXCEPTION2( ErrorWriterNotOpen, "scanIndex=" + toString( scanIndex_ ) );
+      }
+   }
+
+   // The range of the values written to a field, if it's in the prototype
+   Data3DStreamWriterImpl::Range
+      Data3DStreamWriterImpl::writtenRange( const char *fieldName ) const
+   {
+      Range range;
+
+      const StructureNode scan( writer_->GetRawData3D().get( scanIndex_ ) );
+      const CompressedVectorNode points( scan.get( "points" ) );
+      const StructureNode proto( points.prototype() );
+
+      if ( proto.isDefined( fieldName ) )
+      {
+         dataWriter_->valueRange( fieldName, range.minimum, range.maximum );
+      }
+
+      return range;
+   }
+
+   // When a chunk has points marked as invalid, switch the group of fields they are in to working
+   // out the bounds ourselves, starting from the range of what was written before. Then add the
+   // valid points of the chunk to the groups which have been switched.
+   template <typename COORDTYPE>
+   void Data3DStreamWriterImpl::addInvalidPoints( const Data3DPointsData_t<COORDTYPE> &buffers,
+                                                  size_t pointCount )
+   {
+      const auto &fields = header_.pointFields;
+
+      // Points with a cartesian invalid state of 1 (direction only) or 2 (meaningless) are left out
+      // of the cartesian bounds. A spherical invalid state of 1 means only the range is
+      // meaningless, so those points still count towards the azimuth and elevation bounds.
+      const auto hasInvalid = [pointCount]( const int8_t *inFlags, int8_t inValid ) {
+         if ( inFlags == nullptr )
+         {
+            return false;
+         }
+
+         int8_t flagsMax = inValid;
+         for ( size_t i = 0; i < pointCount; ++i )
+         {
+            flagsMax = std::max( flagsMax, inFlags[i] );
+         }
+
+         return flagsMax > inValid;
+      };
+
+      const auto startFiltering = [this]( const char *inFieldNames[], Range *ioRanges,
+                                          size_t inCount ) {
+         for ( size_t i = 0; i < inCount; ++i )
+         {
+            ioRanges[i] = dataWriter_ ? writtenRange( inFieldNames[i] ) : Range{};
+         }
+      };
+
+      const int8_t *cartesianInvalid =
+         fields.cartesianInvalidStateField ? buffers.cartesianInvalidState : nullptr;
+      const int8_t *sphericalInvalid =
+         fields.sphericalInvalidStateField ? buffers.sphericalInvalidState : nullptr;
+      const int8_t *intensityInvalid =
+         fields.isIntensityInvalidField ? buffers.isIntensityInvalid : nullptr;
+
+      const bool cCartesian = fields.cartesianXField && fields.cartesianYField &&
+                              fields.cartesianZField && ( buffers.cartesianX != nullptr ) &&
+                              ( buffers.cartesianY != nullptr ) &&
+                              ( buffers.cartesianZ != nullptr );
+
+      if ( cCartesian && !cartesianFiltered_ && hasInvalid( cartesianInvalid, 0 ) )
+      {
+         const char *cNames[] = { "cartesianX", "cartesianY", "cartesianZ" };
+         startFiltering( cNames, cartesian_, 3 );
+         cartesianFiltered_ = true;
+      }
+
+      const bool cSpherical = fields.sphericalRangeField && fields.sphericalAzimuthField &&
+                              fields.sphericalElevationField &&
+                              ( buffers.sphericalRange != nullptr ) &&
+                              ( buffers.sphericalAzimuth != nullptr ) &&
+                              ( buffers.sphericalElevation != nullptr );
+
+      if ( cSpherical && !sphericalFiltered_ && hasInvalid( sphericalInvalid, 0 ) )
+      {
+         const char *cNames[] = { "sphericalRange", "sphericalAzimuth", "sphericalElevation" };
+         startFiltering( cNames, spherical_, 3 );
+         sphericalFiltered_ = true;
+      }
+
+      const bool cIntensity = fields.intensityField && ( buffers.intensity != nullptr );
+
+      if ( cIntensity && !intensityFiltered_ && hasInvalid( intensityInvalid, 0 ) )
+      {
+         const char *cNames[] = { "intensity" };
+         startFiltering( cNames, &intensity_, 1 );
+         intensityFiltered_ = true;
+      }
+
+      for ( size_t i = 0; i < pointCount; ++i )
+      {
+         if ( cartesianFiltered_ &&
+              ( ( cartesianInvalid == nullptr ) || ( cartesianInvalid[i] == 0 ) ) )
+         {
+            cartesian_[0].add( buffers.cartesianX[i] );
+            cartesian_[1].add( buffers.cartesianY[i] );
+            cartesian_[2].add( buffers.cartesianZ[i] );
+         }
+
+         if ( sphericalFiltered_ )
+         {
+            const int8_t cState = ( sphericalInvalid == nullptr ) ? 0 : sphericalInvalid[i];
+
+            if ( cState == 0 )
+            {
+               spherical_[0].add( buffers.sphericalRange[i] );
+            }
+
+            if ( cState != 2 )
+            {
+               spherical_[1].add( buffers.sphericalAzimuth[i] );
+               spherical_[2].add( buffers.sphericalElevation[i] );
+            }
+         }
+
+         if ( intensityFiltered_ &&
+              ( ( intensityInvalid == nullptr ) || ( intensityInvalid[i] == 0 ) ) )
+         {
+            intensity_.add( buffers.intensity[i] );
+         }
+      }
+   }
+
+   // Fill in the bounds & limits which weren't set in the header from the points we wrote
+   void Data3DStreamWriterImpl::setHeaderBounds()
+   {
+      const auto &fields = header_.pointFields;
+
+      Range x = cartesian_[0];
+      Range y = cartesian_[1];
+      Range z = cartesian_[2];
+
+      if ( !cartesianFiltered_ && fields.cartesianXField && fields.cartesianYField &&
+           fields.cartesianZField )
+      {
+         x = writtenRange( "cartesianX" );
+         y = writtenRange( "cartesianY" );
+         z = writtenRange( "cartesianZ" );
+      }
+
+      if ( ( header_.cartesianBounds == CartesianBounds{} ) && !x.isEmpty() )
+      {
+         header_.cartesianBounds.xMinimum = x.minimum;
+         header_.cartesianBounds.xMaximum = x.maximum;
+         header_.cartesianBounds.yMinimum = y.minimum;
+         header_.cartesianBounds.yMaximum = y.maximum;
+         header_.cartesianBounds.zMinimum = z.minimum;
+         header_.cartesianBounds.zMaximum = z.maximum;
+      }
+
+      Range range = spherical_[0];
+      Range azimuth = spherical_[1];
+      Range elevation = spherical_[2];
+
+      if ( !sphericalFiltered_ && fields.sphericalRangeField && fields.sphericalAzimuthField &&
+           fields.sphericalElevationField )
+      {
+         range = writtenRange( "sphericalRange" );
+         azimuth = writtenRange( "sphericalAzimuth" );
+         elevation = writtenRange( "sphericalElevation" );
+      }
+
+      if ( ( header_.sphericalBounds == SphericalBounds{} ) && !range.isEmpty() )
+      {
+         header_.sphericalBounds.rangeMinimum = range.minimum;
+         header_.sphericalBounds.rangeMaximum = range.maximum;
+         header_.sphericalBounds.azimuthStart = azimuth.minimum;
+         header_.sphericalBounds.azimuthEnd = azimuth.maximum;
+         header_.sphericalBounds.elevationMinimum = elevation.minimum;
+         header_.sphericalBounds.elevationMaximum = elevation.maximum;
+      }
+
+      if ( header_.indexBounds == IndexBounds{} )
+      {
+         const Range row = writtenRange( "rowIndex" );
+         if ( !row.isEmpty() )
+         {
+            header_.indexBounds.rowMinimum = static_cast<int64_t>( row.minimum );
+            header_.indexBounds.rowMaximum = static_cast<int64_t>( row.maximum );
+         }
+
+         const Range column = writtenRange( "columnIndex" );
+         if ( !column.isEmpty() )
+         {
+            header_.indexBounds.columnMinimum = static_cast<int64_t>( column.minimum );
+            header_.indexBounds.columnMaximum = static_cast<int64_t>( column.maximum );
+         }
+
+         const Range returnIndex = writtenRange( "returnIndex" );
+         if ( !returnIndex.isEmpty() )
+         {
+            header_.indexBounds.returnMinimum = static_cast<int64_t>( returnIndex.minimum );
+            header_.indexBounds.returnMaximum = static_cast<int64_t>( returnIndex.maximum );
+         }
+      }
+
+      // Only floating point intensities may be written without their limits (see
+      // _validateStreamHeader())
+      const Range intensity = intensityFiltered_ ? intensity_ : writtenRange( "intensity" );
+
+      if ( ( header_.intensityLimits == IntensityLimits{} ) && !intensity.isEmpty() )
+      {
+         header_.intensityLimits.intensityMinimum = intensity.minimum;
+         header_.intensityLimits.intensityMaximum = intensity.maximum;
+      }
+   }
+}
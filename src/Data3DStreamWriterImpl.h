@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#pragma once
+
+#include <limits>
+#include <memory>
+
+#include "WriterImpl.h"
+
+namespace e57
+{
+   /// Writes a scan's points in chunks, keeping track of the point count and of the bounds and
+   /// limits of the points so they can be added to the scan when it is closed.
+   class Data3DStreamWriterImpl
+   {
+   public:
+      /// Starts a new scan. The field ranges are passed on to WriterImpl::NewData3D().
+      Data3DStreamWriterImpl( std::shared_ptr<WriterImpl> writer, const Data3D &data3DHeader,
+                              const Data3DFieldRanges &fieldRanges = {} );
+      ~Data3DStreamWriterImpl();
+
+      /// Throws if the header is missing a range needed to encode the points as they come
+      static void ValidateHeader( const Data3D &data3DHeader );
+
+      // disallow copying a Data3DStreamWriterImpl
+      Data3DStreamWriterImpl( const Data3DStreamWriterImpl & ) = delete;
+      Data3DStreamWriterImpl &operator=( const Data3DStreamWriterImpl & ) = delete;
+
+      template <typename COORDTYPE>
+      void Append( const Data3DPointsData_t<COORDTYPE> &buffers, size_t pointCount );
+
+      int64_t Close();
+
+      bool IsOpen() const;
+
+      uint64_t PointCount() const;
+
+      const Data3D &Header() const;
+
+   private:
+      /// Minimum & maximum of the valid values of a field
+      struct Range
+      {
+         double minimum = std::numeric_limits<double>::infinity();
+         double maximum = -std::numeric_limits<double>::infinity();
+
+         bool isEmpty() const
+         {
+            return minimum > maximum;
+         }
+
+         template <typename T> void add( T value )
+         {
+            // Written this way so NaNs are skipped
+            if ( value < minimum )
+            {
+               minimum = static_cast<double>( value );
+            }
+            if ( value > maximum )
+            {
+               maximum = static_cast<double>( value );
+            }
+         }
+      };
+
+      void checkOpen() const;
+
+      Range writtenRange( const char *fieldName ) const;
+
+      template <typename COORDTYPE>
+      void addInvalidPoints( const Data3DPointsData_t<COORDTYPE> &buffers, size_t pointCount );
+
+      void setHeaderBounds();
+
+      std::shared_ptr<WriterImpl> writer_;
+      Data3D header_;
+      int64_t scanIndex_;
+      uint64_t pointCount_ = 0;
+
+      std::unique_ptr<CompressedVectorWriter> dataWriter_;
+      bool isOpen_ = true;
+
+      // The encoders keep track of the range of each field. Once a chunk has points marked as
+      // invalid, the bounds of its group of fields have to leave them out, so from then on we work
+      // them out ourselves.
+      bool cartesianFiltered_ = false;
+      Range cartesian_[3]; // x, y, z
+      bool sphericalFiltered_ = false;
+      Range spherical_[3]; // range, azimuth, elevation
+      bool intensityFiltered_ = false;
+      Range intensity_;
+   };
+}
@@ -308,6 +308,12 @@ void BitpackDecoder::stateReset()
    inBufferEndByte_ = 0;
 }
 
+void BitpackDecoder::setRecordRange( uint64_t currentRecordIndex, uint64_t maxRecordCount )
+{
+   currentRecordIndex_ = currentRecordIndex;
+   maxRecordCount_ = maxRecordCount;
+}
+
 void BitpackDecoder::inBufferShiftDown()
 {
    // Move uneaten data down to beginning of inBuffer_.
@@ -512,9 +518,10 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
    size_t nBytesAvailable = ( endBit - firstBit ) >> 3;
    size_t nBytesRead = 0;
 
-   // Loop until we've finished all the records, or ran out of input currently
+   // Loop until we've finished all the records, filled destBuffer, or ran out of input currently
    // available
-   while ( currentRecordIndex_ < maxRecordCount_ && nBytesRead < nBytesAvailable )
+   while ( currentRecordIndex_ < maxRecordCount_ && nBytesRead < nBytesAvailable &&
+           destBuffer_->nextIndex() < destBuffer_->capacity() )
    {
 #ifdef E57_VERBOSE
       std::cout << "read string loop1: readingPrefix=" << readingPrefix_
@@ -635,6 +642,20 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
    return ( nBytesRead * 8 );
 }
 
+void BitpackStringDecoder::stateReset()
+{
+   BitpackDecoder::stateReset();
+
+   // Forget any partly read string
+   readingPrefix_ = true;
+   prefixLength_ = 1;
+   memset( prefixBytes_, 0, sizeof( prefixBytes_ ) );
+   nBytesPrefixRead_ = 0;
+   stringLength_ = 0;
+   currentString_ = "";
+   nBytesStringRead_ = 0;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void BitpackStringDecoder::dump( int indent, std::ostream &os )
 {
@@ -891,19 +912,14 @@ size_t ConstantIntegerDecoder::inputProcess( const char *source, const size_t av
       count = static_cast<unsigned>( remainingRecordCount );
    }
 
+   // Every record has the same value, so convert it once and fill the rest of the range.
    if ( isScaledInteger_ )
    {
-      for ( size_t i = 0; i < count; i++ )
-      {
-         destBuffer_->setNextInt64( minimum_, scale_, offset_ );
-      }
+      destBuffer_->fillNextInt64( minimum_, scale_, offset_, count );
    }
    else
    {
-      for ( size_t i = 0; i < count; i++ )
-      {
-         destBuffer_->setNextInt64( minimum_ );
-      }
+      destBuffer_->fillNextInt64( minimum_, count );
    }
    currentRecordIndex_ += count;
    return ( count );
@@ -913,6 +929,12 @@ void ConstantIntegerDecoder::stateReset()
 {
 }
 
+void ConstantIntegerDecoder::setRecordRange( uint64_t currentRecordIndex, uint64_t maxRecordCount )
+{
+   currentRecordIndex_ = currentRecordIndex;
+   maxRecordCount_ = maxRecordCount;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void ConstantIntegerDecoder::dump( int indent, std::ostream &os )
 {
@@ -44,8 +44,13 @@ namespace e57
       virtual void destBufferSetNew( std::vector<SourceDestBuffer> &dbufs ) = 0;
       virtual uint64_t totalRecordsCompleted() = 0;
       virtual size_t inputProcess( const char *source, size_t count ) = 0;
+
+      /// Drop any input which hasn't been decoded yet (e.g. to start again at a chunk)
       virtual void stateReset() = 0;
 
+      /// Set the record the next input starts with, and how many records to stop decoding at
+      virtual void setRecordRange( uint64_t currentRecordIndex, uint64_t maxRecordCount ) = 0;
+
       unsigned bytestreamNumber() const
       {
          return bytestreamNumber_;
@@ -75,6 +80,7 @@ namespace e57
       virtual size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) = 0;
 
       void stateReset() override;
+      void setRecordRange( uint64_t currentRecordIndex, uint64_t maxRecordCount ) override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
@@ -123,6 +129,8 @@ namespace e57
 
       size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) override;
 
+      void stateReset() override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
 #endif
@@ -176,6 +184,7 @@ namespace e57
 
       size_t inputProcess( const char *source, size_t availableByteCount ) override;
       void stateReset() override;
+      void setRecordRange( uint64_t currentRecordIndex, uint64_t maxRecordCount ) override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
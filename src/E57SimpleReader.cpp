@@ -56,6 +56,11 @@ namespace e57
       return impl_->GetE57Root( fileHeader );
    }
 
+   bool Reader::ReadHeaders( E57Headers &headers, unsigned threadCount ) const
+   {
+      return impl_->ReadHeaders( headers, threadCount );
+   }
+
    int64_t Reader::GetImage2DCount() const
    {
       return impl_->GetImage2DCount();
@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <limits>
 
+#include "Data3DStreamWriterImpl.h"
 #include "E57SimpleWriter.h"
 #include "WriterImpl.h"
 
@@ -141,6 +142,83 @@ namespace
                                   const e57::Data3DPointsFloat &inBuffers );
    template void _fillMinMaxData( e57::Data3D &ioData3DHeader,
                                   const e57::Data3DPointsDouble &inBuffers );
+
+   // Find the range of the values in each field which may be stored as an integer, so
+   // WriterImpl::NewData3D() can fit the prototype to them.
+   template <typename COORDTYPE>
+   e57::Data3DFieldRanges _fieldRanges( const e57::Data3D &inData3DHeader,
+                                        const e57::Data3DPointsData_t<COORDTYPE> &inBuffers )
+   {
+      e57::Data3DFieldRanges ranges;
+
+      const auto cPointCount = static_cast<size_t>( inData3DHeader.pointCount );
+
+      const auto addRange = [&]( const char *inFieldName, bool inHasField, const auto *inValues ) {
+         if ( !inHasField || ( inValues == nullptr ) || ( cPointCount == 0 ) )
+         {
+            return;
+         }
+
+         double minimum = std::numeric_limits<double>::infinity();
+         double maximum = -std::numeric_limits<double>::infinity();
+
+         // Written this way so NaNs are skipped
+         for ( size_t i = 0; i < cPointCount; ++i )
+         {
+            const auto value = static_cast<double>( inValues[i] );
+
+            if ( value < minimum )
+            {
+               minimum = value;
+            }
+
+            if ( value > maximum )
+            {
+               maximum = value;
+            }
+         }
+
+         if ( minimum <= maximum )
+         {
+            ranges[inFieldName] = { minimum, maximum };
+         }
+      };
+
+      const auto &fields = inData3DHeader.pointFields;
+
+      addRange( "cartesianX", fields.cartesianXField, inBuffers.cartesianX );
+      addRange( "cartesianY", fields.cartesianYField, inBuffers.cartesianY );
+      addRange( "cartesianZ", fields.cartesianZField, inBuffers.cartesianZ );
+      addRange( "cartesianInvalidState", fields.cartesianInvalidStateField,
+                inBuffers.cartesianInvalidState );
+
+      addRange( "sphericalRange", fields.sphericalRangeField, inBuffers.sphericalRange );
+      addRange( "sphericalAzimuth", fields.sphericalAzimuthField, inBuffers.sphericalAzimuth );
+      addRange( "sphericalElevation", fields.sphericalElevationField,
+                inBuffers.sphericalElevation );
+      addRange( "sphericalInvalidState", fields.sphericalInvalidStateField,
+                inBuffers.sphericalInvalidState );
+
+      addRange( "intensity", fields.intensityField, inBuffers.intensity );
+      addRange( "isIntensityInvalid", fields.isIntensityInvalidField,
+                inBuffers.isIntensityInvalid );
+
+      addRange( "colorRed", fields.colorRedField, inBuffers.colorRed );
+      addRange( "colorGreen", fields.colorGreenField, inBuffers.colorGreen );
+      addRange( "colorBlue", fields.colorBlueField, inBuffers.colorBlue );
+      addRange( "isColorInvalid", fields.isColorInvalidField, inBuffers.isColorInvalid );
+
+      addRange( "rowIndex", fields.rowIndexField, inBuffers.rowIndex );
+      addRange( "columnIndex", fields.columnIndexField, inBuffers.columnIndex );
+      addRange( "returnIndex", fields.returnIndexField, inBuffers.returnIndex );
+      addRange( "returnCount", fields.returnCountField, inBuffers.returnCount );
+
+      addRange( "timeStamp", fields.timeStampField, inBuffers.timeStamp );
+      addRange( "isTimeStampInvalid", fields.isTimeStampInvalidField,
+                inBuffers.isTimeStampInvalid );
+
+      return ranges;
+   }
 }
 
 namespace e57
@@ -150,6 +228,11 @@ namespace e57
    {
    }
 
+   Writer::Writer( std::shared_ptr<ImageFileSink> sink, const WriterOptions &options ) :
+      impl_( new WriterImpl( std::move( sink ), options ) )
+   {
+   }
+
    // Note that this constructor is deprecated (see header).
    Writer::Writer( const ustring &filePath, const ustring &coordinateMetadata ) :
       Writer( filePath, WriterOptions{ {}, coordinateMetadata } )
@@ -203,13 +286,20 @@ namespace e57
    {
       _fillMinMaxData( data3DHeader, buffers );
 
-      const int64_t scanIndex = impl_->NewData3D( data3DHeader );
+      Data3DFieldRanges fieldRanges;
+      if ( impl_->UsesFieldRanges() )
+      {
+         fieldRanges = _fieldRanges( data3DHeader, buffers );
+      }
+
+      // Writing the points as a single chunk works out the bounds & limits as they are encoded
+      Data3DStreamWriterImpl stream( impl_, data3DHeader, fieldRanges );
 
-      e57::CompressedVectorWriter dataWriter =
-         impl_->SetUpData3DPointsData( scanIndex, data3DHeader.pointCount, buffers );
+      stream.Append( buffers, data3DHeader.pointCount );
 
-      dataWriter.write( data3DHeader.pointCount );
-      dataWriter.close();
+      const int64_t scanIndex = stream.Close();
+
+      data3DHeader = stream.Header();
 
       return scanIndex;
    }
@@ -218,13 +308,20 @@ namespace e57
    {
       _fillMinMaxData( data3DHeader, buffers );
 
-      const int64_t scanIndex = impl_->NewData3D( data3DHeader );
+      Data3DFieldRanges fieldRanges;
+      if ( impl_->UsesFieldRanges() )
+      {
+         fieldRanges = _fieldRanges( data3DHeader, buffers );
+      }
+
+      // Writing the points as a single chunk works out the bounds & limits as they are encoded
+      Data3DStreamWriterImpl stream( impl_, data3DHeader, fieldRanges );
+
+      stream.Append( buffers, data3DHeader.pointCount );
 
-      e57::CompressedVectorWriter dataWriter =
-         impl_->SetUpData3DPointsData( scanIndex, data3DHeader.pointCount, buffers );
+      const int64_t scanIndex = stream.Close();
 
-      dataWriter.write( data3DHeader.pointCount );
-      dataWriter.close();
+      data3DHeader = stream.Header();
 
       return scanIndex;
    }
@@ -246,6 +343,13 @@ namespace e57
       return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
    }
 
+   Data3DStreamWriter Writer::NewData3DStream( const Data3D &data3DHeader )
+   {
+      Data3DStreamWriterImpl::ValidateHeader( data3DHeader );
+
+      return Data3DStreamWriter( std::make_shared<Data3DStreamWriterImpl>( impl_, data3DHeader ) );
+   }
+
    bool Writer::WriteData3DGroupsData( int64_t dataIndex, size_t groupCount,
                                        int64_t *idElementValue, int64_t *startPointIndex,
                                        int64_t *pointCount )
@@ -254,6 +358,41 @@ namespace e57
                                            pointCount );
    }
 
+   Data3DStreamWriter::Data3DStreamWriter( std::shared_ptr<Data3DStreamWriterImpl> impl ) :
+      impl_( std::move( impl ) )
+   {
+   }
+
+   void Data3DStreamWriter::Append( const Data3DPointsFloat &buffers, size_t pointCount )
+   {
+      impl_->Append( buffers, pointCount );
+   }
+
+   void Data3DStreamWriter::Append( const Data3DPointsDouble &buffers, size_t pointCount )
+   {
+      impl_->Append( buffers, pointCount );
+   }
+
+   int64_t Data3DStreamWriter::Close()
+   {
+      return impl_->Close();
+   }
+
+   bool Data3DStreamWriter::IsOpen() const
+   {
+      return impl_->IsOpen();
+   }
+
+   uint64_t Data3DStreamWriter::PointCount() const
+   {
+      return impl_->PointCount();
+   }
+
+   const Data3D &Data3DStreamWriter::Header() const
+   {
+      return impl_->Header();
+   }
+
    ImageFile Writer::GetRawIMF()
    {
       return impl_->GetRawIMF();
@@ -0,0 +1,494 @@
+/*
+ * Original work Copyright 2009 - 2010 Kevin Ackley (kackley@gwi.net)
+ * Modified work Copyright 2018 - 2020 Andy Maloney <asmaloney@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include <xercesc/sax/InputSource.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/util/BinInputStream.hpp>
+#include <xercesc/util/TransService.hpp>
+
+#include "CheckedFile.h"
+#include "E57XercesParser.h"
+#include "E57XmlParser.h"
+#include "StringFunctions.h"
+
+using namespace e57;
+using namespace XERCES_CPP_NAMESPACE;
+
+static_assert( std::is_same<size_t, XMLSize_t>::value,
+               "size_t and XMLSize_t should be the same type" );
+
+namespace
+{
+   ustring toUString( const XMLCh *const xml_str )
+   {
+      ustring u_str;
+      if ( ( xml_str != nullptr ) && *xml_str )
+      {
+         TranscodeToStr UTF8Transcoder( xml_str, "UTF-8" );
+         u_str = ustring( reinterpret_cast<const char *>( UTF8Transcoder.str() ) );
+      }
+      return ( u_str );
+   }
+
+   ustring toUString( const XMLCh *const xml_str, XMLSize_t length )
+   {
+      ustring u_str;
+      if ( ( xml_str != nullptr ) && ( length > 0 ) )
+      {
+         TranscodeToStr UTF8Transcoder( xml_str, length, "UTF-8" );
+         u_str = ustring( reinterpret_cast<const char *>( UTF8Transcoder.str() ),
+                          UTF8Transcoder.length() );
+      }
+      return ( u_str );
+   }
+}
+
+//=============================================================================
+// E57FileInputStream
+
+class E57FileInputStream : public BinInputStream
+{
+public:
+   E57FileInputStream( CheckedFile *cf, uint64_t logicalStart, uint64_t logicalLength );
+   ~E57FileInputStream() override = default;
+
+   E57FileInputStream( const E57FileInputStream & ) = delete;
+   E57FileInputStream &operator=( const E57FileInputStream & ) = delete;
+
+   XMLFilePos curPos() const override
+   {
+      return ( logicalPosition_ );
+   }
+
+   XMLSize_t readBytes( XMLByte *toFill, XMLSize_t maxToRead ) override;
+
+   const XMLCh *getContentType() const override
+   {
+      return nullptr;
+   }
+
+private:
+   //??? lifetime of cf_ must be longer than this object!
+   CheckedFile *cf_;
+   uint64_t logicalStart_;
+   uint64_t logicalLength_;
+   uint64_t logicalPosition_;
+};
+
+E57FileInputStream::E57FileInputStream( CheckedFile *cf, uint64_t logicalStart,
+                                        uint64_t logicalLength ) :
+   cf_( cf ), logicalStart_( logicalStart ), logicalLength_( logicalLength ),
+   logicalPosition_( logicalStart )
+{
+}
+
+XMLSize_t E57FileInputStream::readBytes( XMLByte *const toFill, const XMLSize_t maxToRead )
+{
+   if ( logicalPosition_ > logicalStart_ + logicalLength_ )
+   {
+      return ( 0 );
+   }
+
+   int64_t available = logicalStart_ + logicalLength_ - logicalPosition_;
+   if ( available <= 0 )
+   {
+      return ( 0 );
+   }
+
+   size_t maxToRead_size = maxToRead;
+
+   // Be careful if size_t is smaller than int64_t
+   size_t available_size;
+
+   // Assign to var to avoid MSVC warning
+   // This section can be simplified in C++17 using a "constexpr if".
+   constexpr bool cSizeCheck = ( sizeof( size_t ) >= sizeof( int64_t ) );
+   if ( cSizeCheck )
+   {
+      // size_t is at least as big as int64_t
+      available_size = static_cast<size_t>( available );
+   }
+   else
+   {
+      // size_t is smaller than int64_t, Calc max that size_t can hold
+      const int64_t size_max = std::numeric_limits<size_t>::max();
+
+      // read smaller of size_max, available
+      //??? redo
+      if ( size_max < available )
+      {
+         available_size = static_cast<size_t>( size_max );
+      }
+      else
+      {
+         available_size = static_cast<size_t>( available );
+      }
+   }
+
+   size_t readCount = std::min( maxToRead_size, available_size );
+
+   cf_->seek( logicalPosition_ );
+   cf_->read( reinterpret_cast<char *>( toFill ), readCount ); //??? cast ok?
+   logicalPosition_ += readCount;
+   return ( readCount );
+}
+
+//=============================================================================
+// E57XmlFileInputSource
+
+class E57XmlFileInputSource : public InputSource
+{
+public:
+   E57XmlFileInputSource( CheckedFile *cf, uint64_t logicalStart, uint64_t logicalLength );
+   ~E57XmlFileInputSource() override = default;
+
+   E57XmlFileInputSource( const E57XmlFileInputSource & ) = delete;
+   E57XmlFileInputSource &operator=( const E57XmlFileInputSource & ) = delete;
+
+   BinInputStream *makeStream() const override;
+
+private:
+   //??? lifetime of cf_ must be longer than this object!
+   CheckedFile *cf_;
+   uint64_t logicalStart_;
+   uint64_t logicalLength_;
+};
+
+E57XmlFileInputSource::E57XmlFileInputSource( CheckedFile *cf, uint64_t logicalStart,
+                                              uint64_t logicalLength ) :
+   InputSource( "E57File",
+                XMLPlatformUtils::fgMemoryManager ), //??? what if want to use our own memory
+                                                     // manager?, what bufid is good?
+   cf_( cf ), logicalStart_( logicalStart ), logicalLength_( logicalLength )
+{
+}
+
+BinInputStream *E57XmlFileInputSource::makeStream() const
+{
+   return new E57FileInputStream( cf_, logicalStart_, logicalLength_ );
+}
+
+//=============================================================================
+// XMLReaderPool
+
+namespace
+{
+   // Process-wide pool of SAX2 readers. Xerces is initialized once, the first time a file is
+   // opened, and terminated when the library is unloaded. Readers are handed back once a file
+   // has been parsed so the next one opened (on any thread) can reuse them.
+   class XMLReaderPool
+   {
+   public:
+      static XMLReaderPool &instance();
+
+      SAX2XMLReader *acquire();
+      void release( SAX2XMLReader *reader, bool reusable );
+
+   private:
+      XMLReaderPool();
+      ~XMLReaderPool();
+
+      // Most unused readers to hold on to
+      static constexpr size_t cMaxIdleReaders = 16;
+
+      std::mutex mutex_;
+      std::vector<SAX2XMLReader *> idleReaders_;
+   };
+
+   XMLReaderPool &XMLReaderPool::instance()
+   {
+      // Function-level statics are initialized once, even when several threads get here at
+      // the same time. If initialization throws, the next call tries again.
+      static XMLReaderPool sPool;
+
+      return sPool;
+   }
+
+   XMLReaderPool::XMLReaderPool()
+   {
+      try
+      {
+         XMLPlatformUtils::Initialize();
+      }
+      catch ( const XMLException &ex )
+      {
+         // Turn parser exception into E57Exception
+         throw E57_EXCEPTION2( ErrorXMLParserInit,
+                               "parserMessage=" +
+                                  ustring( XMLString::transcode( ex.getMessage() ) ) );
+      }
+
+      idleReaders_.reserve( cMaxIdleReaders );
+   }
+
+   XMLReaderPool::~XMLReaderPool()
+   {
+      for ( SAX2XMLReader *reader : idleReaders_ )
+      {
+         delete reader;
+      }
+
+      XMLPlatformUtils::Terminate();
+   }
+
+   SAX2XMLReader *XMLReaderPool::acquire()
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         if ( !idleReaders_.empty() )
+         {
+            SAX2XMLReader *reader = idleReaders_.back();
+
+            idleReaders_.pop_back();
+
+            return reader;
+         }
+      }
+
+      SAX2XMLReader *reader = XMLReaderFactory::createXMLReader();
+
+      if ( reader == nullptr )
+      {
+         throw E57_EXCEPTION2( ErrorXMLParserInit, "could not create the xml reader" );
+      }
+
+      return reader;
+   }
+
+   void XMLReaderPool::release( SAX2XMLReader *reader, bool reusable )
+   {
+      // Don't leave the reader pointing at a parser which is going away
+      reader->setContentHandler( nullptr );
+      reader->setErrorHandler( nullptr );
+
+      // Readers abandoned part way through a parse (which threw) aren't reused
+      if ( reusable )
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         if ( idleReaders_.size() < cMaxIdleReaders )
+         {
+            idleReaders_.push_back( reader );
+            return;
+         }
+      }
+
+      delete reader;
+   }
+}
+
+//=============================================================================
+// XercesAttributes
+
+namespace
+{
+   // Presents a Xerces element's attributes to E57XmlParser, transcoding only those it asks for.
+   class XercesAttributes : public E57XmlAttributes
+   {
+   public:
+      explicit XercesAttributes( const Attributes &attributes ) : attributes_( attributes )
+      {
+      }
+
+      size_t count() const override
+      {
+         return attributes_.getLength();
+      }
+
+      ustring uri( size_t index ) const override
+      {
+         return toUString( attributes_.getURI( index ) );
+      }
+
+      ustring localName( size_t index ) const override
+      {
+         return toUString( attributes_.getLocalName( index ) );
+      }
+
+      ustring qName( size_t index ) const override
+      {
+         return toUString( attributes_.getQName( index ) );
+      }
+
+      ustring value( size_t index ) const override
+      {
+         return toUString( attributes_.getValue( index ) );
+      }
+
+      bool find( const char *qName, size_t &index ) const override
+      {
+         // Our attribute names are ASCII, so compare them to the XMLCh strings directly
+         for ( XMLSize_t i = 0; i < attributes_.getLength(); ++i )
+         {
+            const XMLCh *name = attributes_.getQName( i );
+            size_t c = 0;
+
+            while ( ( qName[c] != 0 ) && ( name[c] == static_cast<XMLCh>( qName[c] ) ) )
+            {
+               ++c;
+            }
+
+            if ( ( qName[c] == 0 ) && ( name[c] == 0 ) )
+            {
+               index = i;
+               return true;
+            }
+         }
+
+         return false;
+      }
+
+   private:
+      const Attributes &attributes_;
+   };
+}
+
+//=============================================================================
+// E57XercesHandler
+
+namespace
+{
+   // SAX2 handler which transcodes the events from Xerces to UTF-8 and passes them on to the
+   // E57XmlParser building the node tree.
+   class E57XercesHandler : public DefaultHandler
+   {
+   public:
+      explicit E57XercesHandler( E57XmlParser &parser ) : parser_( parser )
+      {
+      }
+
+   private:
+      /// SAX interface
+      void startElement( const XMLCh *uri, const XMLCh *localName, const XMLCh *qName,
+                         const Attributes &attributes ) override;
+      void endElement( const XMLCh *uri, const XMLCh *localName, const XMLCh *qName ) override;
+      void characters( const XMLCh *chars, XMLSize_t length ) override;
+
+      /// SAX error interface
+      void warning( const SAXParseException &ex ) override;
+      void error( const SAXParseException &ex ) override;
+      void fatalError( const SAXParseException &ex ) override;
+
+      E57XmlParser &parser_;
+   };
+
+   void E57XercesHandler::startElement( const XMLCh *const uri, const XMLCh *const localName,
+                                        const XMLCh *const qName, const Attributes &attributes )
+   {
+      parser_.startElement( toUString( uri ), toUString( localName ), toUString( qName ),
+                            XercesAttributes( attributes ) );
+   }
+
+   void E57XercesHandler::endElement( const XMLCh *const uri, const XMLCh *const localName,
+                                      const XMLCh *const qName )
+   {
+      parser_.endElement( toUString( uri ), toUString( localName ), toUString( qName ) );
+   }
+
+   void E57XercesHandler::characters( const XMLCh *const chars, const XMLSize_t length )
+   {
+      const ustring text = toUString( chars, length );
+
+      parser_.characters( text.data(), text.length() );
+   }
+
+   void E57XercesHandler::error( const SAXParseException &ex )
+   {
+      throw E57_EXCEPTION2(
+         ErrorXMLParser, "systemId=" + ustring( XMLString::transcode( ex.getSystemId() ) ) +
+                            " xmlLine=" + toString( ex.getLineNumber() ) +
+                            " xmlColumn=" + toString( ex.getColumnNumber() ) + " parserMessage=" +
+                            ustring( XMLString::transcode( ex.getMessage() ) ) );
+   }
+
+   void E57XercesHandler::fatalError( const SAXParseException &ex )
+   {
+      throw E57_EXCEPTION2(
+         ErrorXMLParser, "systemId=" + ustring( XMLString::transcode( ex.getSystemId() ) ) +
+                            " xmlLine=" + toString( ex.getLineNumber() ) +
+                            " xmlColumn=" + toString( ex.getColumnNumber() ) + " parserMessage=" +
+                            ustring( XMLString::transcode( ex.getMessage() ) ) );
+   }
+
+   void E57XercesHandler::warning( const SAXParseException &ex )
+   {
+      // Don't take any action on warning from parser, just report
+      std::cerr << "**** XML parser warning: " << ustring( XMLString::transcode( ex.getMessage() ) )
+                << std::endl;
+      std::cerr << "  Debug info:" << std::endl;
+      std::cerr << "    systemId=" << XMLString::transcode( ex.getSystemId() ) << std::endl;
+      std::cerr << ",   xmlLine=" << ex.getLineNumber() << std::endl;
+      std::cerr << ",   xmlColumn=" << ex.getColumnNumber() << std::endl;
+   }
+}
+
+void e57::parseXmlWithXerces( E57XmlParser &parser, CheckedFile *cf, uint64_t logicalStart,
+                              uint64_t logicalLength, bool validate )
+{
+   E57XercesHandler handler( parser );
+
+   // Borrow a reader, initializing Xerces if this is the first file opened
+   XMLReaderPool &pool = XMLReaderPool::instance();
+   SAX2XMLReader *xmlReader = pool.acquire();
+
+   // From here on, the reader goes back to the pool (or is deleted) however we leave
+   try
+   {
+      //??? check these are right
+      // Without validation, Xerces only checks the XML is well formed (using its faster scanner).
+      // E57XmlParser checks the E57 structure either way.
+      xmlReader->setFeature( XMLUni::fgSAX2CoreValidation, validate );
+      xmlReader->setFeature( XMLUni::fgXercesDynamic, validate );
+      xmlReader->setFeature( XMLUni::fgSAX2CoreNameSpaces, true );
+      xmlReader->setFeature( XMLUni::fgXercesSchema, validate );
+      xmlReader->setFeature( XMLUni::fgXercesSchemaFullChecking, validate );
+      xmlReader->setFeature( XMLUni::fgSAX2CoreNameSpacePrefixes, true );
+
+      xmlReader->setContentHandler( &handler );
+      xmlReader->setErrorHandler( &handler );
+
+      // Create input source (XML section of E57 file turned into a stream).
+      E57XmlFileInputSource xmlSection( cf, logicalStart, logicalLength );
+
+      xmlReader->parse( xmlSection );
+   }
+   catch ( ... )
+   {
+      pool.release( xmlReader, false );
+      throw;
+   }
+
+   pool.release( xmlReader, true );
+}
@@ -29,16 +29,11 @@
 #include <locale>
 #include <sstream>
 
-#include <xercesc/sax2/Attributes.hpp>
-#include <xercesc/sax2/XMLReaderFactory.hpp>
-
-#include <xercesc/util/BinInputStream.hpp>
-#include <xercesc/util/TransService.hpp>
-
 #include "BlobNodeImpl.h"
 #include "CheckedFile.h"
 #include "CompressedVectorNodeImpl.h"
 #include "E57XmlParser.h"
+#include "E57XmlPullParser.h"
 #include "FloatNodeImpl.h"
 #include "ImageFileImpl.h"
 #include "IntegerNodeImpl.h"
@@ -47,38 +42,11 @@
 #include "StringNodeImpl.h"
 #include "VectorNodeImpl.h"
 
+#ifndef E57_BUILTIN_XML_PARSER
+#include "E57XercesParser.h"
+#endif
+
 using namespace e57;
-using namespace XERCES_CPP_NAMESPACE;
-
-// define convenient constants for the attribute names
-static const XMLCh att_minimum[] = { chLatin_m, chLatin_i, chLatin_n, chLatin_i,
-                                     chLatin_m, chLatin_u, chLatin_m, chNull };
-static const XMLCh att_maximum[] = { chLatin_m, chLatin_a, chLatin_x, chLatin_i,
-                                     chLatin_m, chLatin_u, chLatin_m, chNull };
-static const XMLCh att_scale[] = { chLatin_s, chLatin_c, chLatin_a, chLatin_l, chLatin_e, chNull };
-static const XMLCh att_offset[] = { chLatin_o, chLatin_f, chLatin_f, chLatin_s,
-                                    chLatin_e, chLatin_t, chNull };
-static const XMLCh att_precision[] = { chLatin_p, chLatin_r, chLatin_e, chLatin_c, chLatin_i,
-                                       chLatin_s, chLatin_i, chLatin_o, chLatin_n, chNull };
-static const XMLCh att_allowHeterogeneousChildren[] = {
-   chLatin_a, chLatin_l, chLatin_l, chLatin_o, chLatin_w, chLatin_H, chLatin_e,
-   chLatin_t, chLatin_e, chLatin_r, chLatin_o, chLatin_g, chLatin_e, chLatin_n,
-   chLatin_e, chLatin_o, chLatin_u, chLatin_s, chLatin_C, chLatin_h, chLatin_i,
-   chLatin_l, chLatin_d, chLatin_r, chLatin_e, chLatin_n, chNull
-};
-static const XMLCh att_fileOffset[] = { chLatin_f, chLatin_i, chLatin_l, chLatin_e,
-                                        chLatin_O, chLatin_f, chLatin_f, chLatin_s,
-                                        chLatin_e, chLatin_t, chNull };
-
-static const XMLCh att_type[] = { chLatin_t, chLatin_y, chLatin_p, chLatin_e, chNull };
-static const XMLCh att_length[] = { chLatin_l, chLatin_e, chLatin_n, chLatin_g,
-                                    chLatin_t, chLatin_h, chNull };
-static const XMLCh att_recordCount[] = { chLatin_r, chLatin_e, chLatin_c, chLatin_o,
-                                         chLatin_r, chLatin_d, chLatin_C, chLatin_o,
-                                         chLatin_u, chLatin_n, chLatin_t, chNull };
-
-static_assert( std::is_same<size_t, XMLSize_t>::value,
-               "size_t and XMLSize_t should be the same type" );
 
 namespace
 {
@@ -93,141 +61,23 @@ namespace
 #endif
    }
 
-   ustring toUString( const XMLCh *const xml_str )
+   ustring lookupAttribute( const E57XmlAttributes &attributes, const char *attribute_name )
    {
-      ustring u_str;
-      if ( ( xml_str != nullptr ) && *xml_str )
+      size_t attr_index;
+      if ( !attributes.find( attribute_name, attr_index ) )
       {
-         TranscodeToStr UTF8Transcoder( xml_str, "UTF-8" );
-         u_str = ustring( reinterpret_cast<const char *>( UTF8Transcoder.str() ) );
+         throw E57_EXCEPTION2( ErrorBadXMLFormat, "attributeName=" + ustring( attribute_name ) );
       }
-      return ( u_str );
+      return ( attributes.value( attr_index ) );
    }
 
-   ustring lookupAttribute( const Attributes &attributes, const XMLCh *attribute_name )
+   bool isAttributeDefined( const E57XmlAttributes &attributes, const char *attribute_name )
    {
-      XMLSize_t attr_index;
-      if ( !attributes.getIndex( attribute_name, attr_index ) )
-      {
-         throw E57_EXCEPTION2( ErrorBadXMLFormat, "attributeName=" + toUString( attribute_name ) );
-      }
-      return ( toUString( attributes.getValue( attr_index ) ) );
-   }
-
-   bool isAttributeDefined( const Attributes &attributes, const XMLCh *attribute_name )
-   {
-      XMLSize_t attr_index;
-      return ( attributes.getIndex( attribute_name, attr_index ) );
+      size_t attr_index;
+      return ( attributes.find( attribute_name, attr_index ) );
    }
 }
 
-//=============================================================================
-// E57FileInputStream
-
-class E57FileInputStream : public BinInputStream
-{
-public:
-   E57FileInputStream( CheckedFile *cf, uint64_t logicalStart, uint64_t logicalLength );
-   ~E57FileInputStream() override = default;
-
-   E57FileInputStream( const E57FileInputStream & ) = delete;
-   E57FileInputStream &operator=( const E57FileInputStream & ) = delete;
-
-   XMLFilePos curPos() const override
-   {
-      return ( logicalPosition_ );
-   }
-
-   XMLSize_t readBytes( XMLByte *toFill, XMLSize_t maxToRead ) override;
-
-   const XMLCh *getContentType() const override
-   {
-      return nullptr;
-   }
-
-private:
-   //??? lifetime of cf_ must be longer than this object!
-   CheckedFile *cf_;
-   uint64_t logicalStart_;
-   uint64_t logicalLength_;
-   uint64_t logicalPosition_;
-};
-
-E57FileInputStream::E57FileInputStream( CheckedFile *cf, uint64_t logicalStart,
-                                        uint64_t logicalLength ) :
-   cf_( cf ), logicalStart_( logicalStart ), logicalLength_( logicalLength ),
-   logicalPosition_( logicalStart )
-{
-}
-
-XMLSize_t E57FileInputStream::readBytes( XMLByte *const toFill, const XMLSize_t maxToRead )
-{
-   if ( logicalPosition_ > logicalStart_ + logicalLength_ )
-   {
-      return ( 0 );
-   }
-
-   int64_t available = logicalStart_ + logicalLength_ - logicalPosition_;
-   if ( available <= 0 )
-   {
-      return ( 0 );
-   }
-
-   size_t maxToRead_size = maxToRead;
-
-   // Be careful if size_t is smaller than int64_t
-   size_t available_size;
-
-   // Assign to var to avoid MSVC warning
-   // This section can be simplified in C++17 using a "constexpr if".
-   constexpr bool cSizeCheck = ( sizeof( size_t ) >= sizeof( int64_t ) );
-   if ( cSizeCheck )
-   {
-      // size_t is at least as big as int64_t
-      available_size = static_cast<size_t>( available );
-   }
-   else
-   {
-      // size_t is smaller than int64_t, Calc max that size_t can hold
-      const int64_t size_max = std::numeric_limits<size_t>::max();
-
-      // read smaller of size_max, available
-      //??? redo
-      if ( size_max < available )
-      {
-         available_size = static_cast<size_t>( size_max );
-      }
-      else
-      {
-         available_size = static_cast<size_t>( available );
-      }
-   }
-
-   size_t readCount = std::min( maxToRead_size, available_size );
-
-   cf_->seek( logicalPosition_ );
-   cf_->read( reinterpret_cast<char *>( toFill ), readCount ); //??? cast ok?
-   logicalPosition_ += readCount;
-   return ( readCount );
-}
-
-//=============================================================================
-// E57XmlFileInputSource
-
-E57XmlFileInputSource::E57XmlFileInputSource( CheckedFile *cf, uint64_t logicalStart,
-                                              uint64_t logicalLength ) :
-   InputSource( "E57File",
-                XMLPlatformUtils::fgMemoryManager ), //??? what if want to use our own memory
-                                                     // manager?, what bufid is good?
-   cf_( cf ), logicalStart_( logicalStart ), logicalLength_( logicalLength )
-{
-}
-
-BinInputStream *E57XmlFileInputSource::makeStream() const
-{
-   return new E57FileInputStream( cf_, logicalStart_, logicalLength_ );
-}
-
 //=============================================================================
 // E57XmlParser::ParseInfo
 
@@ -267,82 +117,150 @@ void E57XmlParser::ParseInfo::dump( int indent, std::ostream &os ) const
 //=============================================================================
 // E57XmlParser
 
-E57XmlParser::E57XmlParser( ImageFileImplSharedPtr imf ) : imf_( imf ), xmlReader( nullptr )
+E57XmlParser::E57XmlParser( ImageFileImplSharedPtr imf ) :
+   imf_( imf ), validate_( true ), lazy_( false )
 {
 }
 
-E57XmlParser::~E57XmlParser()
+void E57XmlParser::init( bool validate, bool lazy )
 {
-   delete xmlReader;
-
-   xmlReader = nullptr;
-
-   XMLPlatformUtils::Terminate();
+   validate_ = validate;
+   lazy_ = lazy;
 }
 
-void E57XmlParser::init()
+void E57XmlParser::parse( CheckedFile *cf, uint64_t logicalStart, uint64_t logicalLength )
 {
-   // Initialize the XML4C2 system
-   try
+#ifndef E57_BUILTIN_XML_PARSER
+   if ( !lazy_ )
    {
-      // NOTE: This is not thread safe for multiple simultaneous E57 readers.
-      //       Ideally we'd do this once, not once per reader.
-      XMLPlatformUtils::Initialize();
+      parseXmlWithXerces( *this, cf, logicalStart, logicalLength, validate_ );
+      return;
    }
-   catch ( const XMLException &ex )
+#endif
+
+   // The XML section is split up by the checksums at the end of each page, so read it into one
+   // buffer which the parser then works on in place. Lazy node trees keep it in the ImageFileImpl
+   // to build the rest of the tree from.
+   if ( logicalLength > std::numeric_limits<size_t>::max() )
    {
-      // Turn parser exception into E57Exception
-      throw E57_EXCEPTION2( ErrorXMLParserInit,
-                            "parserMessage=" + ustring( XMLString::transcode( ex.getMessage() ) ) );
+      throw E57_EXCEPTION2( ErrorBadXMLFormat, "xmlLogicalLength=" + toString( logicalLength ) );
    }
 
-   xmlReader = XMLReaderFactory::createXMLReader(); //??? auto_ptr?
+   std::vector<char> buffer;
+   std::vector<char> &xml = lazy_ ? imf_->xmlText_ : buffer;
+
+   xml.resize( static_cast<size_t>( logicalLength ) );
+
+   cf->seek( logicalStart );
+   cf->read( xml.data(), xml.size() );
+
+   E57XmlPullParser reader( xml.data(), xml.size() );
+
+   parseEvents( reader );
+}
+
+void E57XmlParser::buildLazyChildren( const std::shared_ptr<StructureNodeImpl> &node,
+                                      const E57XmlLazyContent &content )
+{
+   ImageFileImplSharedPtr imf( node->destImageFile() );
+
+   E57XmlParser parser( imf );
+
+   parser.init( false, true );
+   parser.namespaces_ = content.namespaces;
+
+   // The elements of the content are added to the node
+   ParseInfo pi;
+   pi.nodeType = node->type();
+   pi.container_ni = node;
+
+   parser.stack_.push( pi );
+
+   E57XmlPullParser reader( imf->xmlText_.data(), content.begin, content.end, *content.namespaces );
+
+   parser.parseEvents( reader );
+}
 
-   if ( xmlReader == nullptr )
+void E57XmlParser::parseEvents( E57XmlPullParser &reader )
+{
+   for ( ;; )
    {
-      throw E57_EXCEPTION2( ErrorXMLParserInit, "could not create the xml reader" );
-   }
+      switch ( reader.next() )
+      {
+         case E57XmlPullParser::StartElement:
+         {
+            startElement( reader.uri(), reader.localName(), reader.qName(), reader.attributes() );
+
+            const NodeType nodeType = stack_.top().nodeType;
+
+            // Leave the children of structures & vectors other than the root until needed
+            if ( lazy_ && ( stack_.size() > 1 ) &&
+                 ( ( nodeType == TypeStructure ) || ( nodeType == TypeVector ) ) )
+            {
+               skipContent( reader );
+            }
+         }
+         break;
 
-   //??? check these are right
-   xmlReader->setFeature( XMLUni::fgSAX2CoreValidation, true );
-   xmlReader->setFeature( XMLUni::fgXercesDynamic, true );
-   xmlReader->setFeature( XMLUni::fgSAX2CoreNameSpaces, true );
-   xmlReader->setFeature( XMLUni::fgXercesSchema, true );
-   xmlReader->setFeature( XMLUni::fgXercesSchemaFullChecking, true );
-   xmlReader->setFeature( XMLUni::fgSAX2CoreNameSpacePrefixes, true );
+         case E57XmlPullParser::EndElement:
+            endElement( reader.uri(), reader.localName(), reader.qName() );
+            break;
 
-   xmlReader->setContentHandler( this );
-   xmlReader->setErrorHandler( this );
+         case E57XmlPullParser::Characters:
+            characters( reader.text(), reader.textLength() );
+            break;
+
+         case E57XmlPullParser::EndDocument:
+            return;
+      }
+   }
 }
 
-void E57XmlParser::parse( InputSource &inputSource )
+// Skip the content of the structure or vector which has just started, recording where it is so
+// its children can be built later.
+void E57XmlParser::skipContent( E57XmlPullParser &reader )
 {
-   xmlReader->parse( inputSource );
+   std::unique_ptr<E57XmlLazyContent> content( new E57XmlLazyContent );
+
+   reader.skipContent( content->begin, content->end );
+
+   if ( content->begin == content->end )
+   {
+      return;
+   }
+
+   // Usually all the namespaces are declared in the root, so they can be shared
+   if ( !namespaces_ || ( *namespaces_ != reader.namespaces() ) )
+   {
+      namespaces_ = std::make_shared<const E57XmlNamespaces>( reader.namespaces() );
+   }
+
+   content->namespaces = namespaces_;
+
+   std::static_pointer_cast<StructureNodeImpl>( stack_.top().container_ni )
+      ->setLazyContent( std::move( content ) );
 }
 
-void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const localName,
-                                 const XMLCh *const qName, const Attributes &attributes )
+void E57XmlParser::startElement( const ustring &uri, const ustring &localName, const ustring &qName,
+                                 const E57XmlAttributes &attributes )
 {
 #ifdef E57_VERBOSE
    std::cout << "startElement" << std::endl;
-   std::cout << space( 2 ) << "URI:       " << toUString( uri ) << std::endl;
-   std::cout << space( 2 ) << "localName: " << toUString( localName ) << std::endl;
-   std::cout << space( 2 ) << "qName:     " << toUString( qName ) << std::endl;
+   std::cout << space( 2 ) << "URI:       " << uri << std::endl;
+   std::cout << space( 2 ) << "localName: " << localName << std::endl;
+   std::cout << space( 2 ) << "qName:     " << qName << std::endl;
 
-   for ( size_t i = 0; i < attributes.getLength(); i++ )
+   for ( size_t i = 0; i < attributes.count(); i++ )
    {
       std::cout << space( 2 ) << "Attribute[" << i << "]" << std::endl;
-      std::cout << space( 4 ) << "URI:       " << toUString( attributes.getURI( i ) ) << std::endl;
-      std::cout << space( 4 ) << "localName: " << toUString( attributes.getLocalName( i ) )
-                << std::endl;
-      std::cout << space( 4 ) << "qName:     " << toUString( attributes.getQName( i ) )
-                << std::endl;
-      std::cout << space( 4 ) << "value:     " << toUString( attributes.getValue( i ) )
-                << std::endl;
+      std::cout << space( 4 ) << "URI:       " << attributes.uri( i ) << std::endl;
+      std::cout << space( 4 ) << "localName: " << attributes.localName( i ) << std::endl;
+      std::cout << space( 4 ) << "qName:     " << attributes.qName( i ) << std::endl;
+      std::cout << space( 4 ) << "value:     " << attributes.value( i ) << std::endl;
    }
 #endif
    // Get Type attribute
-   ustring node_type = lookupAttribute( attributes, att_type );
+   ustring node_type = lookupAttribute( attributes, "type" );
 
    //??? check to make sure not in primitive type (can only nest inside compound types).
 
@@ -356,9 +274,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       //??? check validity of numeric strings
       pi.nodeType = TypeInteger;
 
-      if ( isAttributeDefined( attributes, att_minimum ) )
+      if ( isAttributeDefined( attributes, "minimum" ) )
       {
-         ustring minimum_str = lookupAttribute( attributes, att_minimum );
+         ustring minimum_str = lookupAttribute( attributes, "minimum" );
 
          pi.minimum = convertStrToLL( minimum_str );
       }
@@ -368,9 +286,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.minimum = INT64_MIN;
       }
 
-      if ( isAttributeDefined( attributes, att_maximum ) )
+      if ( isAttributeDefined( attributes, "maximum" ) )
       {
-         ustring maximum_str = lookupAttribute( attributes, att_maximum );
+         ustring maximum_str = lookupAttribute( attributes, "maximum" );
 
          pi.maximum = convertStrToLL( maximum_str );
       }
@@ -390,9 +308,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       pi.nodeType = TypeScaledInteger;
 
       //??? check validity of numeric strings
-      if ( isAttributeDefined( attributes, att_minimum ) )
+      if ( isAttributeDefined( attributes, "minimum" ) )
       {
-         ustring minimum_str = lookupAttribute( attributes, att_minimum );
+         ustring minimum_str = lookupAttribute( attributes, "minimum" );
 
          pi.minimum = convertStrToLL( minimum_str );
       }
@@ -402,9 +320,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.minimum = INT64_MIN;
       }
 
-      if ( isAttributeDefined( attributes, att_maximum ) )
+      if ( isAttributeDefined( attributes, "maximum" ) )
       {
-         ustring maximum_str = lookupAttribute( attributes, att_maximum );
+         ustring maximum_str = lookupAttribute( attributes, "maximum" );
 
          pi.maximum = convertStrToLL( maximum_str );
       }
@@ -414,9 +332,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.maximum = INT64_MAX;
       }
 
-      if ( isAttributeDefined( attributes, att_scale ) )
+      if ( isAttributeDefined( attributes, "scale" ) )
       {
-         ustring scale_str = lookupAttribute( attributes, att_scale );
+         ustring scale_str = lookupAttribute( attributes, "scale" );
          pi.scale = strToDouble( scale_str ); //??? use exact rounding library
       }
       else
@@ -425,9 +343,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.scale = 1.0;
       }
 
-      if ( isAttributeDefined( attributes, att_offset ) )
+      if ( isAttributeDefined( attributes, "offset" ) )
       {
-         ustring offset_str = lookupAttribute( attributes, att_offset );
+         ustring offset_str = lookupAttribute( attributes, "offset" );
          pi.offset = strToDouble( offset_str ); //??? use exact rounding library
       }
       else
@@ -445,9 +363,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 #endif
       pi.nodeType = TypeFloat;
 
-      if ( isAttributeDefined( attributes, att_precision ) )
+      if ( isAttributeDefined( attributes, "precision" ) )
       {
-         ustring precision_str = lookupAttribute( attributes, att_precision );
+         ustring precision_str = lookupAttribute( attributes, "precision" );
          if ( precision_str == "single" )
          {
             pi.precision = PrecisionSingle;
@@ -460,9 +378,8 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          {
             throw E57_EXCEPTION2( ErrorBadXMLFormat, "precisionString=" + precision_str +
                                                         " fileName=" + imf_->fileName() +
-                                                        " uri=" + toUString( uri ) +
-                                                        " localName=" + toUString( localName ) +
-                                                        " qName=" + toUString( qName ) );
+                                                        " uri=" + uri + " localName=" + localName +
+                                                        " qName=" + qName );
          }
       }
       else
@@ -471,9 +388,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.precision = PrecisionDouble;
       }
 
-      if ( isAttributeDefined( attributes, att_minimum ) )
+      if ( isAttributeDefined( attributes, "minimum" ) )
       {
-         ustring minimum_str = lookupAttribute( attributes, att_minimum );
+         ustring minimum_str = lookupAttribute( attributes, "minimum" );
          pi.floatMinimum = strToDouble( minimum_str ); //??? use exact rounding library
       }
       else
@@ -489,9 +406,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          }
       }
 
-      if ( isAttributeDefined( attributes, att_maximum ) )
+      if ( isAttributeDefined( attributes, "maximum" ) )
       {
-         ustring maximum_str = lookupAttribute( attributes, att_maximum );
+         ustring maximum_str = lookupAttribute( attributes, "maximum" );
          pi.floatMaximum = strToDouble( maximum_str ); //??? use exact rounding library
       }
       else
@@ -528,12 +445,12 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       //??? check validity of numeric strings
 
       // fileOffset is required to be defined
-      ustring fileOffset_str = lookupAttribute( attributes, att_fileOffset );
+      ustring fileOffset_str = lookupAttribute( attributes, "fileOffset" );
 
       pi.fileOffset = convertStrToLL( fileOffset_str );
 
       // length is required to be defined
-      ustring length_str = lookupAttribute( attributes, att_length );
+      ustring length_str = lookupAttribute( attributes, "length" );
 
       pi.length = convertStrToLL( length_str );
 
@@ -547,33 +464,31 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       pi.nodeType = TypeStructure;
 
       // Read name space decls, if e57Root element
-      if ( toUString( localName ) == "e57Root" )
+      if ( localName == "e57Root" )
       {
          // Search attributes for namespace declarations (only allowed in E57Root structure)
          bool gotDefault = false;
-         for ( size_t i = 0; i < attributes.getLength(); i++ )
+         for ( size_t i = 0; i < attributes.count(); i++ )
          {
             // Check if declaring the default namespace
-            if ( toUString( attributes.getQName( i ) ) == "xmlns" )
+            if ( attributes.qName( i ) == "xmlns" )
             {
 #ifdef E57_VERBOSE
-               std::cout << "declared default namespace, URI="
-                         << toUString( attributes.getValue( i ) ) << std::endl;
+               std::cout << "declared default namespace, URI=" << attributes.value( i )
+                         << std::endl;
 #endif
-               imf_->extensionsAdd( "", toUString( attributes.getValue( i ) ) );
+               imf_->extensionsAdd( "", attributes.value( i ) );
                gotDefault = true;
             }
 
             // Check if declaring a namespace
-            if ( toUString( attributes.getURI( i ) ) == "http://www.w3.org/2000/xmlns/" )
+            if ( attributes.uri( i ) == "http://www.w3.org/2000/xmlns/" )
             {
 #ifdef E57_VERBOSE
-               std::cout << "declared extension, prefix="
-                         << toUString( attributes.getLocalName( i ) )
-                         << " URI=" << toUString( attributes.getValue( i ) ) << std::endl;
+               std::cout << "declared extension, prefix=" << attributes.localName( i )
+                         << " URI=" << attributes.value( i ) << std::endl;
 #endif
-               imf_->extensionsAdd( toUString( attributes.getLocalName( i ) ),
-                                    toUString( attributes.getValue( i ) ) );
+               imf_->extensionsAdd( attributes.localName( i ), attributes.value( i ) );
             }
          }
 
@@ -581,19 +496,18 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          if ( !gotDefault )
          {
             throw E57_EXCEPTION2( ErrorBadXMLFormat, "fileName=" + imf_->fileName() +
-                                                        " uri=" + toUString( uri ) +
-                                                        " localName=" + toUString( localName ) +
-                                                        " qName=" + toUString( qName ) );
+                                                        " uri=" + uri + " localName=" + localName +
+                                                        " qName=" + qName );
          }
       }
 
       // Create container now, so can hold children
-      std::shared_ptr<StructureNodeImpl> s_ni( new StructureNodeImpl( imf_ ) );
+      std::shared_ptr<StructureNodeImpl> s_ni( imf_->makeNode<StructureNodeImpl>() );
       pi.container_ni = s_ni;
 
       // After have Structure, check again if E57Root, if so mark attached so all children will be
       // attached when added
-      if ( toUString( localName ) == "e57Root" )
+      if ( localName == "e57Root" )
       {
          s_ni->setAttachedRecursive();
       }
@@ -607,9 +521,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 #endif
       pi.nodeType = TypeVector;
 
-      if ( isAttributeDefined( attributes, att_allowHeterogeneousChildren ) )
+      if ( isAttributeDefined( attributes, "allowHeterogeneousChildren" ) )
       {
-         ustring allowHetero_str = lookupAttribute( attributes, att_allowHeterogeneousChildren );
+         ustring allowHetero_str = lookupAttribute( attributes, "allowHeterogeneousChildren" );
 
          int64_t i64 = convertStrToLL( allowHetero_str );
 
@@ -625,9 +539,8 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          {
             throw E57_EXCEPTION2( ErrorBadXMLFormat,
                                   "allowHeterogeneousChildren=" + toString( i64 ) +
-                                     "fileName=" + imf_->fileName() + " uri=" + toUString( uri ) +
-                                     " localName=" + toUString( localName ) +
-                                     " qName=" + toUString( qName ) );
+                                     "fileName=" + imf_->fileName() + " uri=" + uri +
+                                     " localName=" + localName + " qName=" + qName );
          }
       }
       else
@@ -638,7 +551,7 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 
       // Create container now, so can hold children
       std::shared_ptr<VectorNodeImpl> v_ni(
-         new VectorNodeImpl( imf_, pi.allowHeterogeneousChildren ) );
+         imf_->makeNode<VectorNodeImpl>( pi.allowHeterogeneousChildren ) );
       pi.container_ni = v_ni;
 
       stack_.push( pi );
@@ -651,17 +564,17 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       pi.nodeType = TypeCompressedVector;
 
       // fileOffset is required to be defined
-      ustring fileOffset_str = lookupAttribute( attributes, att_fileOffset );
+      ustring fileOffset_str = lookupAttribute( attributes, "fileOffset" );
 
       pi.fileOffset = convertStrToLL( fileOffset_str );
 
       // recordCount is required to be defined
-      ustring recordCount_str = lookupAttribute( attributes, att_recordCount );
+      ustring recordCount_str = lookupAttribute( attributes, "recordCount" );
 
       pi.recordCount = convertStrToLL( recordCount_str );
 
       // Create container now, so can hold children
-      std::shared_ptr<CompressedVectorNodeImpl> cv_ni( new CompressedVectorNodeImpl( imf_ ) );
+      std::shared_ptr<CompressedVectorNodeImpl> cv_ni( imf_->makeNode<CompressedVectorNodeImpl>() );
       cv_ni->setRecordCount( pi.recordCount );
       cv_ni->setBinarySectionLogicalStart(
          imf_->file_->physicalToLogical( pi.fileOffset ) ); //??? what if file_ is NULL?
@@ -671,18 +584,16 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
    }
    else
    {
-      throw E57_EXCEPTION2( ErrorBadXMLFormat,
-                            "nodeType=" + node_type + " fileName=" + imf_->fileName() +
-                               " uri=" + toUString( uri ) + " localName=" + toUString( localName ) +
-                               " qName=" + toUString( qName ) );
+      throw E57_EXCEPTION2( ErrorBadXMLFormat, "nodeType=" + node_type +
+                                                  " fileName=" + imf_->fileName() + " uri=" + uri +
+                                                  " localName=" + localName + " qName=" + qName );
    }
 #ifdef E57_VERBOSE
    pi.dump( 4 );
 #endif
 }
 
-void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localName,
-                               const XMLCh *const qName )
+void E57XmlParser::endElement( const ustring &uri, const ustring &localName, const ustring &qName )
 {
 #ifdef E57_VERBOSE
    std::cout << "endElement" << std::endl;
@@ -724,7 +635,7 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
          }
 
          std::shared_ptr<IntegerNodeImpl> i_ni(
-            new IntegerNodeImpl( imf_, intValue, pi.minimum, pi.maximum ) );
+            imf_->makeNode<IntegerNodeImpl>( intValue, pi.minimum, pi.maximum ) );
 
          if ( foundValue )
          {
@@ -746,8 +657,8 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
             foundValue = true;
          }
 
-         std::shared_ptr<ScaledIntegerNodeImpl> si_ni( new ScaledIntegerNodeImpl(
-            imf_, intValue, pi.minimum, pi.maximum, pi.scale, pi.offset ) );
+         std::shared_ptr<ScaledIntegerNodeImpl> si_ni( imf_->makeNode<ScaledIntegerNodeImpl>(
+            intValue, pi.minimum, pi.maximum, pi.scale, pi.offset ) );
 
          if ( foundValue )
          {
@@ -769,8 +680,8 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
             foundValue = true;
          }
 
-         std::shared_ptr<FloatNodeImpl> f_ni(
-            new FloatNodeImpl( imf_, floatValue, pi.precision, pi.floatMinimum, pi.floatMaximum ) );
+         std::shared_ptr<FloatNodeImpl> f_ni( imf_->makeNode<FloatNodeImpl>(
+            floatValue, pi.precision, pi.floatMinimum, pi.floatMaximum ) );
 
          if ( foundValue )
          {
@@ -782,21 +693,21 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
       break;
       case TypeString:
       {
-         std::shared_ptr<StringNodeImpl> s_ni( new StringNodeImpl( imf_, pi.childText ) );
+         std::shared_ptr<StringNodeImpl> s_ni( imf_->makeNode<StringNodeImpl>( pi.childText ) );
          current_ni = s_ni;
       }
       break;
       case TypeBlob:
       {
-         std::shared_ptr<BlobNodeImpl> b_ni( new BlobNodeImpl( imf_, pi.fileOffset, pi.length ) );
+         std::shared_ptr<BlobNodeImpl> b_ni(
+            imf_->makeNode<BlobNodeImpl>( pi.fileOffset, pi.length ) );
          current_ni = b_ni;
       }
       break;
       default:
-         throw E57_EXCEPTION2(
-            ErrorInternal, "nodeType=" + toString( pi.nodeType ) + " fileName=" + imf_->fileName() +
-                              " uri=" + toUString( uri ) + " localName=" + toUString( localName ) +
-                              " qName=" + toUString( qName ) );
+         throw E57_EXCEPTION2( ErrorInternal, "nodeType=" + toString( pi.nodeType ) +
+                                                 " fileName=" + imf_->fileName() + " uri=" + uri +
+                                                 " localName=" + localName + " qName=" + qName );
    }
 #ifdef E57_VERBOSE
    current_ni->dump( 4 );
@@ -810,9 +721,8 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
       {
          throw E57_EXCEPTION2( ErrorBadXMLFormat, "currentType=" + toString( current_ni->type() ) +
                                                      " fileName=" + imf_->fileName() +
-                                                     " uri=" + toUString( uri ) +
-                                                     " localName=" + toUString( localName ) +
-                                                     " qName=" + toUString( qName ) );
+                                                     " uri=" + uri + " localName=" + localName +
+                                                     " qName=" + qName );
       }
       imf_->root_ = std::static_pointer_cast<StructureNodeImpl>( current_ni );
       return;
@@ -823,10 +733,8 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
 
    if ( !parent_ni )
    {
-      throw E57_EXCEPTION2( ErrorBadXMLFormat, "fileName=" + imf_->fileName() +
-                                                  " uri=" + toUString( uri ) +
-                                                  " localName=" + toUString( localName ) +
-                                                  " qName=" + toUString( qName ) );
+      throw E57_EXCEPTION2( ErrorBadXMLFormat, "fileName=" + imf_->fileName() + " uri=" + uri +
+                                                  " localName=" + localName + " qName=" + qName );
    }
 
    // Add current node into parent at top of stack
@@ -838,7 +746,7 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
             std::static_pointer_cast<StructureNodeImpl>( parent_ni );
 
          // Add named child to structure
-         struct_ni->set( toUString( qName ), current_ni );
+         struct_ni->set( qName, current_ni );
       }
       break;
       case TypeVector:
@@ -854,22 +762,19 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
       {
          std::shared_ptr<CompressedVectorNodeImpl> cv_ni =
             std::static_pointer_cast<CompressedVectorNodeImpl>( parent_ni );
-         ustring uQName = toUString( qName );
-
          // n can be either prototype or codecs
-         if ( uQName == "prototype" )
+         if ( qName == "prototype" )
          {
             cv_ni->setPrototype( current_ni );
          }
-         else if ( uQName == "codecs" )
+         else if ( qName == "codecs" )
          {
             if ( current_ni->type() != TypeVector )
             {
-               throw E57_EXCEPTION2(
-                  ErrorBadXMLFormat,
-                  "currentType=" + toString( current_ni->type() ) +
-                     " fileName=" + imf_->fileName() + " uri=" + toUString( uri ) +
-                     " localName=" + toUString( localName ) + " qName=" + toUString( qName ) );
+               throw E57_EXCEPTION2( ErrorBadXMLFormat,
+                                     "currentType=" + toString( current_ni->type() ) +
+                                        " fileName=" + imf_->fileName() + " uri=" + uri +
+                                        " localName=" + localName + " qName=" + qName );
             }
             std::shared_ptr<VectorNodeImpl> vi =
                std::static_pointer_cast<VectorNodeImpl>( current_ni );
@@ -877,11 +782,10 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
             // Check VectorNode is hetero
             if ( !vi->allowHeteroChildren() )
             {
-               throw E57_EXCEPTION2(
-                  ErrorBadXMLFormat,
-                  "currentType=" + toString( current_ni->type() ) +
-                     " fileName=" + imf_->fileName() + " uri=" + toUString( uri ) +
-                     " localName=" + toUString( localName ) + " qName=" + toUString( qName ) );
+               throw E57_EXCEPTION2( ErrorBadXMLFormat,
+                                     "currentType=" + toString( current_ni->type() ) +
+                                        " fileName=" + imf_->fileName() + " uri=" + uri +
+                                        " localName=" + localName + " qName=" + qName );
             }
 
             cv_ni->setCodecs( vi );
@@ -890,9 +794,8 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
          {
             // Found unknown XML child element of CompressedVector, not prototype or codecs
             throw E57_EXCEPTION2( ErrorBadXMLFormat, +"fileName=" + imf_->fileName() +
-                                                        " uri=" + toUString( uri ) +
-                                                        " localName=" + toUString( localName ) +
-                                                        " qName=" + toUString( qName ) );
+                                                        " uri=" + uri + " localName=" + localName +
+                                                        " qName=" + qName );
          }
       }
       break;
@@ -900,19 +803,16 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
          // Have bad XML nesting, parent should have been a container.
          throw E57_EXCEPTION2( ErrorBadXMLFormat, "parentType=" + toString( parent_ni->type() ) +
                                                      " fileName=" + imf_->fileName() +
-                                                     " uri=" + toUString( uri ) +
-                                                     " localName=" + toUString( localName ) +
-                                                     " qName=" + toUString( qName ) );
+                                                     " uri=" + uri + " localName=" + localName +
+                                                     " qName=" + qName );
    }
 }
 
-void E57XmlParser::characters( const XMLCh *const chars, const XMLSize_t length )
+void E57XmlParser::characters( const char *chars, size_t length )
 {
-//??? use length to make ustring
 #ifdef E57_VERBOSE
-   std::cout << "characters, chars=\"" << toUString( chars ) << "\" length=" << length << std::endl;
-#else
-   E57_UNUSED( length );
+   std::cout << "characters, chars=\"" << ustring( chars, length ) << "\" length=" << length
+             << std::endl;
 #endif
 
    // Get active element
@@ -927,44 +827,18 @@ void E57XmlParser::characters( const XMLCh *const chars, const XMLSize_t length
       case TypeBlob:
       {
          // If characters aren't whitespace, have an error, else ignore
-         ustring s = toUString( chars );
-         if ( s.find_first_not_of( " \t\n\r" ) != std::string::npos )
+         for ( size_t i = 0; i < length; ++i )
          {
-            throw E57_EXCEPTION2( ErrorBadXMLFormat, "chars=" + toUString( chars ) );
+            if ( ( chars[i] != ' ' ) && ( chars[i] != '\t' ) && ( chars[i] != '\n' ) &&
+                 ( chars[i] != '\r' ) )
+            {
+               throw E57_EXCEPTION2( ErrorBadXMLFormat, "chars=" + ustring( chars, length ) );
+            }
          }
       }
       break;
       default:
          // Append to any previous characters
-         pi.childText += toUString( chars );
+         pi.childText.append( chars, length );
    }
 }
-
-void E57XmlParser::error( const SAXParseException &ex )
-{
-   throw E57_EXCEPTION2(
-      ErrorXMLParser, "systemId=" + ustring( XMLString::transcode( ex.getSystemId() ) ) +
-                         " xmlLine=" + toString( ex.getLineNumber() ) +
-                         " xmlColumn=" + toString( ex.getColumnNumber() ) +
-                         " parserMessage=" + ustring( XMLString::transcode( ex.getMessage() ) ) );
-}
-
-void E57XmlParser::fatalError( const SAXParseException &ex )
-{
-   throw E57_EXCEPTION2(
-      ErrorXMLParser, "systemId=" + ustring( XMLString::transcode( ex.getSystemId() ) ) +
-                         " xmlLine=" + toString( ex.getLineNumber() ) +
-                         " xmlColumn=" + toString( ex.getColumnNumber() ) +
-                         " parserMessage=" + ustring( XMLString::transcode( ex.getMessage() ) ) );
-}
-
-void E57XmlParser::warning( const SAXParseException &ex )
-{
-   // Don't take any action on warning from parser, just report
-   std::cerr << "**** XML parser warning: " << ustring( XMLString::transcode( ex.getMessage() ) )
-             << std::endl;
-   std::cerr << "  Debug info:" << std::endl;
-   std::cerr << "    systemId=" << XMLString::transcode( ex.getSystemId() ) << std::endl;
-   std::cerr << ",   xmlLine=" << ex.getLineNumber() << std::endl;
-   std::cerr << ",   xmlColumn=" << ex.getColumnNumber() << std::endl;
-}
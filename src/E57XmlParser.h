@@ -28,46 +28,83 @@
 #pragma once
 
 #include <stack>
-
-#include <xercesc/sax/InputSource.hpp>
-#include <xercesc/sax2/DefaultHandler.hpp>
+#include <utility>
+#include <vector>
 
 #include "Common.h"
 
-using namespace XERCES_CPP_NAMESPACE;
-
-namespace XERCES_CPP_NAMESPACE
-{
-   class SAX2XMLReader;
-}
-
 namespace e57
 {
    class CheckedFile;
+   class E57XmlPullParser;
+   class StructureNodeImpl;
+
+   /// Namespace prefixes & their URIs
+   using E57XmlNamespaces = std::vector<std::pair<ustring, ustring>>;
 
-   class E57XmlParser : public DefaultHandler
+   /// Where the child elements of a structure or vector are in the XML section, when they are
+   /// built the first time they're needed (see ImageFileReadOptions::lazyNodeTree)
+   struct E57XmlLazyContent
+   {
+      const char *begin; /// in the XML section kept by the ImageFileImpl
+      const char *end;
+      std::shared_ptr<const E57XmlNamespaces> namespaces; /// in scope
+   };
+
+   /// The attributes of an XML element, as an XML parser reports them to E57XmlParser (UTF-8).
+   class E57XmlAttributes
+   {
+   public:
+      virtual ~E57XmlAttributes() = default;
+
+      virtual size_t count() const = 0;
+
+      virtual ustring uri( size_t index ) const = 0;
+      virtual ustring localName( size_t index ) const = 0;
+      virtual ustring qName( size_t index ) const = 0;
+      virtual ustring value( size_t index ) const = 0;
+
+      /// Find the attribute with the (ASCII) qualified name @a qName.
+      virtual bool find( const char *qName, size_t &index ) const = 0;
+   };
+
+   /// Builds an ImageFile's node tree from the elements of its XML section.
+   ///
+   /// The XML is parsed either by Xerces or, if the library is built with
+   /// E57_BUILTIN_XML_PARSER, by E57XmlPullParser. Both report the elements to the same
+   /// startElement(), endElement() & characters() here. Lazy node trees need to know where the
+   /// elements are in the XML, which Xerces doesn't say, so they always use E57XmlPullParser.
+   class E57XmlParser
    {
    public:
       explicit E57XmlParser( ImageFileImplSharedPtr imf );
-      ~E57XmlParser() override;
 
-      void init();
+      /// With @a lazy, structures & vectors below the root are built without their children,
+      /// which are built from the XML when they are first needed (see buildLazyChildren()).
+      void init( bool validate = true, bool lazy = false );
 
-      void parse( InputSource &inputSource );
+      /// Parse the XML section of @a cf, building up the node tree.
+      void parse( CheckedFile *cf, uint64_t logicalStart, uint64_t logicalLength );
 
-   private:
-      /// SAX interface
-      void startElement( const XMLCh *uri, const XMLCh *localName, const XMLCh *qName,
-                         const Attributes &attributes ) override;
-      void endElement( const XMLCh *uri, const XMLCh *localName, const XMLCh *qName ) override;
-      void characters( const XMLCh *chars, XMLSize_t length ) override;
+      /// Build the children of @a node from their XML.
+      static void buildLazyChildren( const std::shared_ptr<StructureNodeImpl> &node,
+                                     const E57XmlLazyContent &content );
 
-      /// SAX error interface
-      void warning( const SAXParseException &ex ) override;
-      void error( const SAXParseException &ex ) override;
-      void fatalError( const SAXParseException &ex ) override;
+      /// Element events from the XML parser
+      void startElement( const ustring &uri, const ustring &localName, const ustring &qName,
+                         const E57XmlAttributes &attributes );
+      void endElement( const ustring &uri, const ustring &localName, const ustring &qName );
+      void characters( const char *chars, size_t length );
+
+   private:
+      void parseEvents( E57XmlPullParser &reader );
+      void skipContent( E57XmlPullParser &reader );
 
       ImageFileImplSharedPtr imf_; /// Image file we are reading
+      bool validate_;              /// have Xerces validate the XML (ignored by the built-in parser)
+      bool lazy_;                  /// leave the children of structures & vectors until needed
+
+      std::shared_ptr<const E57XmlNamespaces> namespaces_; /// last ones given to lazy content
 
       struct ParseInfo
       {
@@ -98,25 +135,5 @@ namespace e57
       };
 
       std::stack<ParseInfo> stack_; /// Stores the current path in tree we are reading
-
-      SAX2XMLReader *xmlReader;
-   };
-
-   class E57XmlFileInputSource : public InputSource
-   {
-   public:
-      E57XmlFileInputSource( CheckedFile *cf, uint64_t logicalStart, uint64_t logicalLength );
-      ~E57XmlFileInputSource() override = default;
-
-      E57XmlFileInputSource( const E57XmlFileInputSource & ) = delete;
-      E57XmlFileInputSource &operator=( const E57XmlFileInputSource & ) = delete;
-
-      BinInputStream *makeStream() const override;
-
-   private:
-      //??? lifetime of cf_ must be longer than this object!
-      CheckedFile *cf_;
-      uint64_t logicalStart_;
-      uint64_t logicalLength_;
    };
 }
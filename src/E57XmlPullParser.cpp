@@ -0,0 +1,1080 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "E57XmlPullParser.h"
+#include "StringFunctions.h"
+
+namespace e57
+{
+   static const char *cXmlnsURI = "http://www.w3.org/2000/xmlns/";
+   static const char *cXmlURI = "http://www.w3.org/XML/1998/namespace";
+
+   static inline bool isSpace( char c )
+   {
+      return ( c == ' ' ) || ( c == '\t' ) || ( c == '\n' ) || ( c == '\r' );
+   }
+
+   static inline bool isNameStartChar( char c )
+   {
+      const auto uc = static_cast<unsigned char>( c );
+
+      // Anything outside ASCII is part of a UTF-8 sequence, which we let through
+      return ( ( uc >= 'a' ) && ( uc <= 'z' ) ) || ( ( uc >= 'A' ) && ( uc <= 'Z' ) ) ||
+             ( uc == '_' ) || ( uc == ':' ) || ( uc >= 0x80 );
+   }
+
+   static inline bool isNameChar( char c )
+   {
+      return isNameStartChar( c ) || ( ( c >= '0' ) && ( c <= '9' ) ) || ( c == '-' ) ||
+             ( c == '.' );
+   }
+
+   // Case folding for the ASCII keywords we compare against. Unlike std::tolower() and
+   // std::toupper(), these are fine with the bytes of UTF-8 sequences (negative as char).
+   static inline char toLowerASCII( char c )
+   {
+      return ( ( c >= 'A' ) && ( c <= 'Z' ) ) ? static_cast<char>( c - 'A' + 'a' ) : c;
+   }
+
+   static inline char toUpperASCII( char c )
+   {
+      return ( ( c >= 'a' ) && ( c <= 'z' ) ) ? static_cast<char>( c - 'a' + 'A' ) : c;
+   }
+
+   static void appendUTF8( ustring &out, uint32_t codePoint )
+   {
+      if ( codePoint < 0x80 )
+      {
+         out += static_cast<char>( codePoint );
+      }
+      else if ( codePoint < 0x800 )
+      {
+         out += static_cast<char>( 0xC0 | ( codePoint >> 6 ) );
+         out += static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+      }
+      else if ( codePoint < 0x10000 )
+      {
+         out += static_cast<char>( 0xE0 | ( codePoint >> 12 ) );
+         out += static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+         out += static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+      }
+      else
+      {
+         out += static_cast<char>( 0xF0 | ( codePoint >> 18 ) );
+         out += static_cast<char>( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) );
+         out += static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) );
+         out += static_cast<char>( 0x80 | ( codePoint & 0x3F ) );
+      }
+   }
+
+   // Replace the references in [begin, end) & normalize its line ends (and, in attribute values,
+   // its whitespace) as XML requires. Returns false if there's a bad reference.
+   static bool replaceReferences( const char *begin, const char *end, bool isAttribute,
+                                  ustring &out )
+   {
+      out.clear();
+      out.reserve( static_cast<size_t>( end - begin ) );
+
+      for ( const char *c = begin; c < end; ++c )
+      {
+         if ( *c == '&' )
+         {
+            const char *semicolon =
+               static_cast<const char *>( memchr( c, ';', static_cast<size_t>( end - c ) ) );
+
+            if ( semicolon == nullptr )
+            {
+               return false;
+            }
+
+            const ustring name( c + 1, semicolon );
+
+            if ( name == "lt" )
+            {
+               out += '<';
+            }
+            else if ( name == "gt" )
+            {
+               out += '>';
+            }
+            else if ( name == "amp" )
+            {
+               out += '&';
+            }
+            else if ( name == "quot" )
+            {
+               out += '"';
+            }
+            else if ( name == "apos" )
+            {
+               out += '\'';
+            }
+            else if ( ( name.length() > 1 ) && ( name[0] == '#' ) )
+            {
+               const bool hex = ( name[1] == 'x' );
+               const char *digits = name.c_str() + ( hex ? 2 : 1 );
+               char *digitsEnd = nullptr;
+
+               const unsigned long codePoint = strtoul( digits, &digitsEnd, hex ? 16 : 10 );
+
+               if ( ( *digits == 0 ) || ( *digitsEnd != 0 ) ||
+                    !isxdigit( static_cast<unsigned char>( *digits ) ) ||
+                    ( codePoint == 0 ) || ( codePoint > 0x10FFFF ) ||
+                    ( ( codePoint >= 0xD800 ) && ( codePoint <= 0xDFFF ) ) )
+               {
+                  return false;
+               }
+
+               appendUTF8( out, static_cast<uint32_t>( codePoint ) );
+            }
+            else
+            {
+               // We don't read DTDs, so there are no other entities
+               return false;
+            }
+
+            c = semicolon;
+         }
+         else if ( *c == '\r' )
+         {
+            // "\r\n" and "\r" are line ends, which are read as "\n"
+            if ( ( c + 1 < end ) && ( c[1] == '\n' ) )
+            {
+               ++c;
+            }
+
+            out += isAttribute ? ' ' : '\n';
+         }
+         else if ( isAttribute && ( ( *c == '\n' ) || ( *c == '\t' ) ) )
+         {
+            out += ' ';
+         }
+         else
+         {
+            out += *c;
+         }
+      }
+
+      return true;
+   }
+
+   //=============================================================================
+   // E57XmlPullParser::AttributeList
+
+   size_t E57XmlPullParser::AttributeList::count() const
+   {
+      return list.size();
+   }
+
+   ustring E57XmlPullParser::AttributeList::uri( size_t index ) const
+   {
+      return list.at( index ).uri;
+   }
+
+   ustring E57XmlPullParser::AttributeList::localName( size_t index ) const
+   {
+      const Attribute &attribute = list.at( index );
+      const size_t skip = ( attribute.prefixLength > 0 ) ? attribute.prefixLength + 1 : 0;
+
+      return ustring( attribute.qName.data + skip, attribute.qName.length - skip );
+   }
+
+   ustring E57XmlPullParser::AttributeList::qName( size_t index ) const
+   {
+      const Attribute &attribute = list.at( index );
+
+      return ustring( attribute.qName.data, attribute.qName.length );
+   }
+
+   ustring E57XmlPullParser::AttributeList::value( size_t index ) const
+   {
+      const Span &value = list.at( index ).value;
+      const char *valueEnd = value.data + value.length;
+
+      const bool plain = std::none_of( value.data, valueEnd, []( char c ) {
+         return ( c == '&' ) || ( c == '\r' ) || ( c == '\n' ) || ( c == '\t' );
+      } );
+
+      if ( plain )
+      {
+         return ustring( value.data, value.length );
+      }
+
+      // The references were checked in parseStartTag()
+      ustring replaced;
+      replaceReferences( value.data, valueEnd, true, replaced );
+
+      return replaced;
+   }
+
+   bool E57XmlPullParser::AttributeList::find( const char *qName, size_t &index ) const
+   {
+      const size_t length = strlen( qName );
+
+      for ( size_t i = 0; i < list.size(); ++i )
+      {
+         const Span &name = list[i].qName;
+
+         if ( ( name.length == length ) && ( memcmp( name.data, qName, length ) == 0 ) )
+         {
+            index = i;
+            return true;
+         }
+      }
+
+      return false;
+   }
+
+   //=============================================================================
+   // E57XmlPullParser
+
+   E57XmlPullParser::E57XmlPullParser( const char *xml, size_t length ) :
+      begin_( xml ), end_( xml + length ), pos_( xml ), content_( false ), seenRoot_( false ),
+      emptyElement_( false ), qName_{ nullptr, 0 }, prefixLength_( 0 ), text_( nullptr ),
+      textLength_( 0 )
+   {
+      // Skip the UTF-8 byte order mark
+      if ( startsWith( "\xEF\xBB\xBF" ) )
+      {
+         pos_ += 3;
+      }
+
+      checkCharacters();
+   }
+
+   E57XmlPullParser::E57XmlPullParser( const char *xml, const char *contentBegin,
+                                       const char *contentEnd,
+                                       const E57XmlNamespaces &namespaces ) :
+      begin_( xml ), end_( contentEnd ), pos_( contentBegin ), content_( true ),
+      seenRoot_( false ), emptyElement_( false ), namespaces_( namespaces ), qName_{ nullptr, 0 },
+      prefixLength_( 0 ), text_( nullptr ), textLength_( 0 )
+   {
+      // The characters were checked when the whole document was
+   }
+
+   E57XmlPullParser::Event E57XmlPullParser::next()
+   {
+      if ( emptyElement_ )
+      {
+         emptyElement_ = false;
+
+         endElement();
+
+         return EndElement;
+      }
+
+      while ( pos_ < end_ )
+      {
+         if ( *pos_ != '<' )
+         {
+            const char *textBegin = pos_;
+
+            pos_ = find( "<", 1 );
+
+            if ( pos_ == nullptr )
+            {
+               pos_ = end_;
+            }
+
+            if ( elements_.empty() && !content_ )
+            {
+               if ( !std::all_of( textBegin, pos_, isSpace ) )
+               {
+                  fail( textBegin, "text outside of the root element" );
+               }
+
+               continue;
+            }
+
+            setText( textBegin, pos_, true );
+
+            return Characters;
+         }
+
+         if ( startsWith( "<?" ) )
+         {
+            parseProcessingInstruction();
+         }
+         else if ( startsWith( "<!--" ) )
+         {
+            const char *commentEnd = find( "-->", 3 );
+
+            if ( commentEnd == nullptr )
+            {
+               fail( pos_, "unterminated comment" );
+            }
+
+            pos_ = commentEnd + 3;
+         }
+         else if ( startsWith( "<![CDATA[" ) )
+         {
+            if ( elements_.empty() && !content_ )
+            {
+               fail( pos_, "CDATA section outside of the root element" );
+            }
+
+            const char *cdataBegin = pos_ + 9;
+            pos_ = cdataBegin;
+
+            const char *cdataEnd = find( "]]>", 3 );
+
+            if ( cdataEnd == nullptr )
+            {
+               fail( cdataBegin, "unterminated CDATA section" );
+            }
+
+            pos_ = cdataEnd + 3;
+
+            setText( cdataBegin, cdataEnd, false );
+
+            return Characters;
+         }
+         else if ( startsWith( "<!DOCTYPE" ) )
+         {
+            skipDoctype();
+         }
+         else if ( startsWith( "</" ) )
+         {
+            parseEndTag();
+
+            return EndElement;
+         }
+         else
+         {
+            parseStartTag();
+
+            return StartElement;
+         }
+      }
+
+      if ( !seenRoot_ && !content_ )
+      {
+         fail( pos_, "no root element" );
+      }
+
+      if ( !elements_.empty() )
+      {
+         fail( pos_, "unexpected end of the XML" );
+      }
+
+      return EndDocument;
+   }
+
+   const ustring &E57XmlPullParser::uri() const
+   {
+      return uri_;
+   }
+
+   ustring E57XmlPullParser::localName() const
+   {
+      const size_t skip = ( prefixLength_ > 0 ) ? prefixLength_ + 1 : 0;
+
+      return ustring( qName_.data + skip, qName_.length - skip );
+   }
+
+   ustring E57XmlPullParser::qName() const
+   {
+      return ustring( qName_.data, qName_.length );
+   }
+
+   const E57XmlAttributes &E57XmlPullParser::attributes() const
+   {
+      return attributes_;
+   }
+
+   const E57XmlNamespaces &E57XmlPullParser::namespaces() const
+   {
+      return namespaces_;
+   }
+
+   const char *E57XmlPullParser::text() const
+   {
+      return text_;
+   }
+
+   size_t E57XmlPullParser::textLength() const
+   {
+      return textLength_;
+   }
+
+   void E57XmlPullParser::fail( const char *where, const ustring &message ) const
+   {
+      // Work out the line & column only now, so we don't have to keep track of them
+      where = std::min( std::max( where, begin_ ), end_ );
+
+      const int64_t line = 1 + std::count( begin_, where, '\n' );
+
+      const char *lineBegin = where;
+
+      while ( ( lineBegin > begin_ ) && ( lineBegin[-1] != '\n' ) )
+      {
+         --lineBegin;
+      }
+
+      throw E57_EXCEPTION2( ErrorXMLParser, "xmlLine=" + toString( line ) + " xmlColumn=" +
+                                               toString( where - lineBegin + 1 ) +
+                                               " parserMessage=" + message );
+   }
+
+   // Check the XML is UTF-8 and only has the characters XML allows.
+   void E57XmlPullParser::checkCharacters() const
+   {
+      const auto *c = reinterpret_cast<const unsigned char *>( pos_ );
+      const auto *end = reinterpret_cast<const unsigned char *>( end_ );
+
+      while ( c < end )
+      {
+         if ( *c < 0x80 )
+         {
+            if ( ( *c < 0x20 ) && ( *c != '\t' ) && ( *c != '\n' ) && ( *c != '\r' ) )
+            {
+               fail( reinterpret_cast<const char *>( c ), "invalid character" );
+            }
+
+            ++c;
+            continue;
+         }
+
+         // Number of continuation bytes & smallest code point for the sequence's length
+         size_t count = 0;
+         uint32_t codePoint = 0;
+         uint32_t minimum = 0;
+
+         if ( ( *c & 0xE0 ) == 0xC0 )
+         {
+            count = 1;
+            codePoint = *c & 0x1F;
+            minimum = 0x80;
+         }
+         else if ( ( *c & 0xF0 ) == 0xE0 )
+         {
+            count = 2;
+            codePoint = *c & 0x0F;
+            minimum = 0x800;
+         }
+         else if ( ( *c & 0xF8 ) == 0xF0 )
+         {
+            count = 3;
+            codePoint = *c & 0x07;
+            minimum = 0x10000;
+         }
+         else
+         {
+            fail( reinterpret_cast<const char *>( c ), "invalid UTF-8" );
+         }
+
+         if ( static_cast<size_t>( end - c ) <= count )
+         {
+            fail( reinterpret_cast<const char *>( c ), "invalid UTF-8" );
+         }
+
+         for ( size_t i = 1; i <= count; ++i )
+         {
+            if ( ( c[i] & 0xC0 ) != 0x80 )
+            {
+               fail( reinterpret_cast<const char *>( c ), "invalid UTF-8" );
+            }
+
+            codePoint = ( codePoint << 6 ) | ( c[i] & 0x3F );
+         }
+
+         if ( ( codePoint < minimum ) || ( codePoint > 0x10FFFF ) ||
+              ( ( codePoint >= 0xD800 ) && ( codePoint <= 0xDFFF ) ) ||
+              ( codePoint == 0xFFFE ) || ( codePoint == 0xFFFF ) )
+         {
+            fail( reinterpret_cast<const char *>( c ), "invalid UTF-8" );
+         }
+
+         c += count + 1;
+      }
+   }
+
+   bool E57XmlPullParser::startsWith( const char *str ) const
+   {
+      const size_t length = strlen( str );
+
+      return ( static_cast<size_t>( end_ - pos_ ) >= length ) &&
+             ( memcmp( pos_, str, length ) == 0 );
+   }
+
+   // Skip whitespace, returning whether there was any.
+   bool E57XmlPullParser::skipSpace()
+   {
+      const char *start = pos_;
+
+      while ( ( pos_ < end_ ) && isSpace( *pos_ ) )
+      {
+         ++pos_;
+      }
+
+      return pos_ != start;
+   }
+
+   // Find str (of length characters) from the current position, or nullptr if it isn't there.
+   const char *E57XmlPullParser::find( const char *str, size_t length ) const
+   {
+      if ( length == 1 )
+      {
+         return static_cast<const char *>(
+            memchr( pos_, *str, static_cast<size_t>( end_ - pos_ ) ) );
+      }
+
+      const char *found = std::search( pos_, end_, str, str + length );
+
+      return ( found == end_ ) ? nullptr : found;
+   }
+
+   E57XmlPullParser::Span E57XmlPullParser::parseName()
+   {
+      if ( ( pos_ >= end_ ) || !isNameStartChar( *pos_ ) )
+      {
+         fail( pos_, "expected a name" );
+      }
+
+      const char *nameBegin = pos_;
+
+      while ( ( pos_ < end_ ) && isNameChar( *pos_ ) )
+      {
+         ++pos_;
+      }
+
+      return { nameBegin, static_cast<size_t>( pos_ - nameBegin ) };
+   }
+
+   // Work out the length of the namespace prefix of a name. Names may only have one colon, which
+   // can't be at the beginning or the end.
+   static size_t prefixLength( const char *name, size_t length, bool &valid )
+   {
+      const char *colon = static_cast<const char *>( memchr( name, ':', length ) );
+
+      if ( colon == nullptr )
+      {
+         valid = true;
+         return 0;
+      }
+
+      const auto prefix = static_cast<size_t>( colon - name );
+
+      valid = ( prefix > 0 ) && ( prefix + 1 < length ) &&
+              ( memchr( colon + 1, ':', length - prefix - 1 ) == nullptr );
+
+      return prefix;
+   }
+
+   void E57XmlPullParser::parseStartTag()
+   {
+      if ( seenRoot_ && elements_.empty() && !content_ )
+      {
+         fail( pos_, "more than one root element" );
+      }
+
+      const char *tagBegin = pos_;
+
+      ++pos_; // '<'
+
+      qName_ = parseName();
+      attributes_.list.clear();
+
+      for ( ;; )
+      {
+         const bool hadSpace = skipSpace();
+
+         if ( pos_ >= end_ )
+         {
+            fail( tagBegin, "unterminated start tag" );
+         }
+
+         if ( *pos_ == '>' )
+         {
+            ++pos_;
+            break;
+         }
+
+         if ( *pos_ == '/' )
+         {
+            if ( ( pos_ + 1 < end_ ) && ( pos_[1] == '>' ) )
+            {
+               pos_ += 2;
+               emptyElement_ = true;
+               break;
+            }
+
+            fail( pos_, "expected '>'" );
+         }
+
+         if ( !hadSpace )
+         {
+            fail( pos_, "expected whitespace before the attribute" );
+         }
+
+         AttributeList::Attribute attribute;
+         attribute.qName = parseName();
+
+         skipSpace();
+
+         if ( ( pos_ >= end_ ) || ( *pos_ != '=' ) )
+         {
+            fail( pos_, "expected '='" );
+         }
+
+         ++pos_;
+
+         skipSpace();
+
+         if ( ( pos_ >= end_ ) || ( ( *pos_ != '"' ) && ( *pos_ != '\'' ) ) )
+         {
+            fail( pos_, "expected a quoted attribute value" );
+         }
+
+         const char quote = *pos_++;
+         const char *valueBegin = pos_;
+         const char *valueEnd = static_cast<const char *>(
+            memchr( valueBegin, quote, static_cast<size_t>( end_ - valueBegin ) ) );
+
+         if ( valueEnd == nullptr )
+         {
+            fail( valueBegin, "unterminated attribute value" );
+         }
+
+         if ( memchr( valueBegin, '<', static_cast<size_t>( valueEnd - valueBegin ) ) != nullptr )
+         {
+            fail( valueBegin, "'<' in attribute value" );
+         }
+
+         if ( memchr( valueBegin, '&', static_cast<size_t>( valueEnd - valueBegin ) ) != nullptr )
+         {
+            ustring replaced;
+
+            if ( !replaceReferences( valueBegin, valueEnd, true, replaced ) )
+            {
+               fail( valueBegin, "bad reference in attribute value" );
+            }
+         }
+
+         attribute.value = { valueBegin, static_cast<size_t>( valueEnd - valueBegin ) };
+         pos_ = valueEnd + 1;
+
+         bool valid = false;
+         attribute.prefixLength =
+            prefixLength( attribute.qName.data, attribute.qName.length, valid );
+
+         if ( !valid )
+         {
+            fail( attribute.qName.data, "bad attribute name" );
+         }
+
+         for ( const auto &other : attributes_.list )
+         {
+            if ( ( other.qName.length == attribute.qName.length ) &&
+                 ( memcmp( other.qName.data, attribute.qName.data, other.qName.length ) == 0 ) )
+            {
+               fail( attribute.qName.data, "duplicate attribute" );
+            }
+         }
+
+         attributes_.list.push_back( attribute );
+      }
+
+      bool valid = false;
+      prefixLength_ = prefixLength( qName_.data, qName_.length, valid );
+
+      if ( !valid )
+      {
+         fail( qName_.data, "bad element name" );
+      }
+
+      // Bring the element's namespace declarations into scope
+      elements_.push_back( { qName_, namespaces_.size() } );
+
+      for ( size_t i = 0; i < attributes_.list.size(); ++i )
+      {
+         const AttributeList::Attribute &attribute = attributes_.list[i];
+         const ustring name( attribute.qName.data, attribute.qName.length );
+
+         if ( name == "xmlns" )
+         {
+            namespaces_.emplace_back( "", attributes_.value( i ) );
+         }
+         else if ( ( attribute.prefixLength == 5 ) && ( name.compare( 0, 5, "xmlns" ) == 0 ) )
+         {
+            namespaces_.emplace_back( name.substr( 6 ), attributes_.value( i ) );
+
+            if ( namespaces_.back().second.empty() )
+            {
+               fail( attribute.qName.data, "empty namespace URI" );
+            }
+         }
+      }
+
+      for ( auto &attribute : attributes_.list )
+      {
+         resolveNamespace( attribute.qName, attribute.prefixLength, true, attribute.uri );
+      }
+
+      // Attributes whose prefixes are bound to the same namespace are duplicates too
+      for ( size_t i = 0; i < attributes_.list.size(); ++i )
+      {
+         if ( attributes_.list[i].prefixLength == 0 )
+         {
+            continue;
+         }
+
+         for ( size_t j = 0; j < i; ++j )
+         {
+            if ( ( attributes_.list[j].prefixLength > 0 ) &&
+                 ( attributes_.list[j].uri == attributes_.list[i].uri ) &&
+                 ( attributes_.localName( j ) == attributes_.localName( i ) ) )
+            {
+               fail( attributes_.list[i].qName.data, "duplicate attribute" );
+            }
+         }
+      }
+
+      resolveNamespace( qName_, prefixLength_, false, uri_ );
+
+      seenRoot_ = true;
+   }
+
+   void E57XmlPullParser::parseEndTag()
+   {
+      const char *tagBegin = pos_;
+
+      pos_ += 2; // "</"
+
+      const Span name = parseName();
+
+      skipSpace();
+
+      if ( ( pos_ >= end_ ) || ( *pos_ != '>' ) )
+      {
+         fail( pos_, "expected '>'" );
+      }
+
+      ++pos_;
+
+      if ( elements_.empty() )
+      {
+         fail( tagBegin, "end tag without a start tag" );
+      }
+
+      const Span &open = elements_.back().qName;
+
+      if ( ( name.length != open.length ) || ( memcmp( name.data, open.data, name.length ) != 0 ) )
+      {
+         fail( tagBegin, "end tag doesn't match the start tag <" +
+                            ustring( open.data, open.length ) + ">" );
+      }
+
+      qName_ = open;
+
+      bool valid = false;
+      prefixLength_ = prefixLength( qName_.data, qName_.length, valid );
+
+      resolveNamespace( qName_, prefixLength_, false, uri_ );
+
+      endElement();
+   }
+
+   // Take the element which has ended (whose names are in qName_ & uri_) off the stack, along
+   // with its namespace declarations.
+   void E57XmlPullParser::endElement()
+   {
+      namespaces_.resize( elements_.back().namespaceCount );
+      elements_.pop_back();
+   }
+
+   void E57XmlPullParser::skipContent( const char *&contentBegin, const char *&contentEnd )
+   {
+      contentBegin = pos_;
+      contentEnd = pos_;
+
+      if ( emptyElement_ )
+      {
+         return;
+      }
+
+      // Only look for the tags, to find the element's end tag
+      size_t depth = 0;
+
+      for ( ;; )
+      {
+         const char *tag = find( "<", 1 );
+
+         if ( tag == nullptr )
+         {
+            fail( contentBegin, "unterminated element" );
+         }
+
+         pos_ = tag;
+
+         const char *close = nullptr;
+         size_t closeLength = 1;
+
+         if ( startsWith( "<!--" ) )
+         {
+            close = "-->";
+         }
+         else if ( startsWith( "<![CDATA[" ) )
+         {
+            close = "]]>";
+         }
+         else if ( startsWith( "<?" ) )
+         {
+            close = "?>";
+         }
+
+         if ( close != nullptr )
+         {
+            closeLength = strlen( close );
+         }
+         else if ( startsWith( "</" ) )
+         {
+            if ( depth == 0 )
+            {
+               // Leave the end tag for next()
+               contentEnd = pos_;
+               return;
+            }
+
+            --depth;
+            close = ">";
+         }
+         else
+         {
+            // Start tag, whose attribute values may contain '>'
+            char quote = 0;
+
+            for ( ++pos_; pos_ < end_; ++pos_ )
+            {
+               if ( quote != 0 )
+               {
+                  if ( *pos_ == quote )
+                  {
+                     quote = 0;
+                  }
+               }
+               else if ( ( *pos_ == '"' ) || ( *pos_ == '\'' ) )
+               {
+                  quote = *pos_;
+               }
+               else if ( *pos_ == '>' )
+               {
+                  break;
+               }
+            }
+
+            if ( pos_ >= end_ )
+            {
+               fail( tag, "unterminated start tag" );
+            }
+
+            if ( pos_[-1] != '/' )
+            {
+               ++depth;
+            }
+
+            ++pos_;
+            continue;
+         }
+
+         const char *closeAt = find( close, closeLength );
+
+         if ( closeAt == nullptr )
+         {
+            fail( tag, "unterminated markup" );
+         }
+
+         pos_ = closeAt + closeLength;
+      }
+   }
+
+   void E57XmlPullParser::parseProcessingInstruction()
+   {
+      const char *piBegin = pos_;
+
+      pos_ += 2; // "<?"
+
+      const Span target = parseName();
+
+      const char *piEnd = find( "?>", 2 );
+
+      if ( piEnd == nullptr )
+      {
+         fail( piBegin, "unterminated processing instruction" );
+      }
+
+      ustring targetName( target.data, target.length );
+      std::transform( targetName.begin(), targetName.end(), targetName.begin(), toLowerASCII );
+
+      if ( targetName == "xml" )
+      {
+         // Only allowed as the XML declaration, where all we care about is the encoding
+         const bool atStart =
+            !content_ && ( ( piBegin == begin_ ) ||
+                           ( ( piBegin == begin_ + 3 ) && ( *begin_ == '\xEF' ) ) );
+
+         if ( !atStart || ( target.length != 3 ) || ( memcmp( target.data, "xml", 3 ) != 0 ) )
+         {
+            fail( piBegin, "misplaced XML declaration" );
+         }
+
+         const ustring declaration( pos_, piEnd );
+         const size_t encoding = declaration.find( "encoding" );
+
+         if ( encoding != ustring::npos )
+         {
+            const size_t valueBegin = declaration.find_first_of( "\"'", encoding );
+            const size_t valueEnd =
+               ( valueBegin == ustring::npos )
+                  ? ustring::npos
+                  : declaration.find( declaration[valueBegin], valueBegin + 1 );
+
+            if ( valueEnd == ustring::npos )
+            {
+               fail( piBegin, "bad XML declaration" );
+            }
+
+            ustring name = declaration.substr( valueBegin + 1, valueEnd - valueBegin - 1 );
+            std::transform( name.begin(), name.end(), name.begin(), toUpperASCII );
+
+            if ( ( name != "UTF-8" ) && ( name != "UTF8" ) && ( name != "US-ASCII" ) )
+            {
+               fail( piBegin, "unsupported encoding " + name + " (only UTF-8 is supported)" );
+            }
+         }
+      }
+
+      pos_ = piEnd + 2;
+   }
+
+   void E57XmlPullParser::skipDoctype()
+   {
+      if ( seenRoot_ || content_ )
+      {
+         fail( pos_, "misplaced DOCTYPE" );
+      }
+
+      const char *doctypeBegin = pos_;
+
+      pos_ += 9; // "<!DOCTYPE"
+
+      char quote = 0;
+
+      for ( ; pos_ < end_; ++pos_ )
+      {
+         if ( quote != 0 )
+         {
+            if ( *pos_ == quote )
+            {
+               quote = 0;
+            }
+         }
+         else if ( ( *pos_ == '"' ) || ( *pos_ == '\'' ) )
+         {
+            quote = *pos_;
+         }
+         else if ( *pos_ == '[' )
+         {
+            // Its declarations (e.g. of entities) could change how the document is read
+            fail( pos_, "DOCTYPE internal subsets aren't supported" );
+         }
+         else if ( *pos_ == '>' )
+         {
+            ++pos_;
+            return;
+         }
+      }
+
+      fail( doctypeBegin, "unterminated DOCTYPE" );
+   }
+
+   // Look up the namespace URI of a name's prefix. Names without a prefix are in the default
+   // namespace, except for attributes, which aren't in any.
+   void E57XmlPullParser::resolveNamespace( const Span &qName, size_t prefixLength,
+                                            bool isAttribute, ustring &uri ) const
+   {
+      const ustring prefix( qName.data, prefixLength );
+
+      if ( isAttribute && ( ( prefixLength == 0 ) || ( prefix == "xmlns" ) ) )
+      {
+         // Namespace declarations are in the xmlns namespace (except for the default one)
+         uri = ( prefixLength == 0 ) ? "" : cXmlnsURI;
+         return;
+      }
+
+      if ( prefix == "xml" )
+      {
+         uri = cXmlURI;
+         return;
+      }
+
+      for ( auto it = namespaces_.rbegin(); it != namespaces_.rend(); ++it )
+      {
+         if ( it->first == prefix )
+         {
+            uri = it->second;
+            return;
+         }
+      }
+
+      if ( prefixLength > 0 )
+      {
+         fail( qName.data, "undeclared namespace prefix " + prefix );
+      }
+
+      uri.clear();
+   }
+
+   void E57XmlPullParser::setText( const char *begin, const char *end, bool hasReferences )
+   {
+      const auto length = static_cast<size_t>( end - begin );
+
+      const bool plain = ( memchr( begin, '\r', length ) == nullptr ) &&
+                         ( !hasReferences || ( memchr( begin, '&', length ) == nullptr ) );
+
+      if ( plain )
+      {
+         text_ = begin;
+         textLength_ = length;
+         return;
+      }
+
+      if ( hasReferences )
+      {
+         if ( !replaceReferences( begin, end, false, textBuffer_ ) )
+         {
+            fail( begin, "bad reference" );
+         }
+      }
+      else
+      {
+         // CDATA sections only need their line ends normalized
+         textBuffer_.clear();
+
+         for ( const char *c = begin; c < end; ++c )
+         {
+            if ( *c == '\r' )
+            {
+               if ( ( c + 1 < end ) && ( c[1] == '\n' ) )
+               {
+                  ++c;
+               }
+
+               textBuffer_ += '\n';
+            }
+            else
+            {
+               textBuffer_ += *c;
+            }
+         }
+      }
+
+      text_ = textBuffer_.data();
+      textLength_ = textBuffer_.length();
+   }
+}
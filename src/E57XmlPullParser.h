@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#pragma once
+
+#include <vector>
+
+#include "E57XmlParser.h"
+
+namespace e57
+{
+   /// A small XML pull parser for the XML section of E57 files, used instead of Xerces when the
+   /// library is built with E57_BUILTIN_XML_PARSER, and to read files with lazy node trees (see
+   /// ImageFileReadOptions::lazyNodeTree).
+   ///
+   /// It reads UTF-8 in place from the buffer it is given: names, attribute values, and text are
+   /// pointers into it, and are only copied when they contain references (e.g. "&amp;") or
+   /// carriage returns to replace. It checks the XML is well formed and handles namespaces, but
+   /// doesn't support DTDs or validate against a schema.
+   class E57XmlPullParser
+   {
+   public:
+      enum Event
+      {
+         StartElement,
+         EndElement,
+         Characters,
+         EndDocument
+      };
+
+      /// @a xml must stay valid while parsing.
+      E57XmlPullParser( const char *xml, size_t length );
+
+      /// Parse the content of an element of @a xml which was skipped with skipContent(), with the
+      /// namespaces which were in scope there. Its child elements & text are reported as if they
+      /// were at the top level.
+      E57XmlPullParser( const char *xml, const char *contentBegin, const char *contentEnd,
+                        const E57XmlNamespaces &namespaces );
+
+      /// Move on to the next event. Throws ErrorXMLParser if the XML isn't well formed.
+      Event next();
+
+      /// Skip the content of the element which has just started (StartElement) without parsing
+      /// it, so the next event is its EndElement. Sets @a contentBegin & @a contentEnd to the
+      /// content skipped, which is only checked to be well formed when it is parsed.
+      void skipContent( const char *&contentBegin, const char *&contentEnd );
+
+      /// Namespace URI & names of the element (StartElement, EndElement)
+      const ustring &uri() const;
+      ustring localName() const;
+      ustring qName() const;
+
+      /// Attributes of the element (StartElement)
+      const E57XmlAttributes &attributes() const;
+
+      /// Namespace prefixes & URIs in scope in the element (StartElement)
+      const E57XmlNamespaces &namespaces() const;
+
+      /// Text of the element (Characters)
+      const char *text() const;
+      size_t textLength() const;
+
+   private:
+      /// A string in the XML buffer
+      struct Span
+      {
+         const char *data;
+         size_t length;
+      };
+
+      class AttributeList : public E57XmlAttributes
+      {
+      public:
+         struct Attribute
+         {
+            Span qName;
+            size_t prefixLength; /// length of the namespace prefix (0 if none)
+            Span value;          /// as it is in the XML (before replacing references)
+            ustring uri;
+         };
+
+         size_t count() const override;
+
+         ustring uri( size_t index ) const override;
+         ustring localName( size_t index ) const override;
+         ustring qName( size_t index ) const override;
+         ustring value( size_t index ) const override;
+
+         bool find( const char *qName, size_t &index ) const override;
+
+         std::vector<Attribute> list;
+      };
+
+      /// An element which has started but not ended
+      struct OpenElement
+      {
+         Span qName;
+         size_t namespaceCount; /// namespaces_ in scope before the element's declarations
+      };
+
+      [[noreturn]] void fail( const char *where, const ustring &message ) const;
+
+      void checkCharacters() const;
+
+      bool startsWith( const char *str ) const;
+      bool skipSpace();
+      const char *find( const char *str, size_t length ) const;
+      Span parseName();
+
+      void parseStartTag();
+      void parseEndTag();
+      void parseProcessingInstruction();
+      void skipDoctype();
+      void endElement();
+
+      void resolveNamespace( const Span &qName, size_t prefixLength, bool isAttribute,
+                             ustring &uri ) const;
+
+      void setText( const char *begin, const char *end, bool hasReferences );
+
+      const char *begin_;
+      const char *end_;
+      const char *pos_;
+
+      bool content_;  /// parsing the content of an element rather than a whole document
+      bool seenRoot_;
+      bool emptyElement_; /// the current element ended with "/>", so it ends on the next call
+
+      std::vector<OpenElement> elements_;
+      E57XmlNamespaces namespaces_; /// in scope
+
+      Span qName_;
+      size_t prefixLength_;
+      ustring uri_;
+      AttributeList attributes_;
+
+      const char *text_;
+      size_t textLength_;
+      ustring textBuffer_; /// text with its references replaced
+   };
+}
@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <limits>
 
 #include "CompressedVectorNodeImpl.h"
 #include "Encoder.h"
@@ -77,13 +78,12 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
 
          unsigned bitsPerRecord = imf->bitsNeeded( ini->minimum(), ini->maximum() );
 
-         // !!! need to pick smarter channel buffer sizes, here and elsewhere
          // Construct Integer encoder with appropriate register size, based on number of bits
          // stored.
          if ( bitsPerRecord == 0 )
          {
             std::shared_ptr<Encoder> encoder(
-               new ConstantIntegerEncoder( bytestreamNumber, sbuf, ini->minimum() ) );
+               new ConstantIntegerEncoder( false, bytestreamNumber, sbuf, ini->minimum() ) );
 
             return encoder;
          }
@@ -91,30 +91,26 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint8_t>(
-               false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(),
-               ini->maximum(), 1.0, 0.0 ) );
+               false, bytestreamNumber, sbuf, ini->minimum(), ini->maximum(), 1.0, 0.0 ) );
             return encoder;
          }
 
          if ( bitsPerRecord <= 16 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint16_t>(
-               false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(),
-               ini->maximum(), 1.0, 0.0 ) );
+               false, bytestreamNumber, sbuf, ini->minimum(), ini->maximum(), 1.0, 0.0 ) );
             return encoder;
          }
 
          if ( bitsPerRecord <= 32 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint32_t>(
-               false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(),
-               ini->maximum(), 1.0, 0.0 ) );
+               false, bytestreamNumber, sbuf, ini->minimum(), ini->maximum(), 1.0, 0.0 ) );
             return encoder;
          }
 
          std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint64_t>(
-            false, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, ini->minimum(), ini->maximum(),
-            1.0, 0.0 ) );
+            false, bytestreamNumber, sbuf, ini->minimum(), ini->maximum(), 1.0, 0.0 ) );
          return encoder;
       }
 
@@ -132,13 +128,13 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
 
          unsigned bitsPerRecord = imf->bitsNeeded( sini->minimum(), sini->maximum() );
 
-         // !!! need to pick smarter channel buffer sizes, here and elsewhere
          // Construct ScaledInteger encoder with appropriate register size,  based on number of bits
          // stored.
          if ( bitsPerRecord == 0 )
          {
             std::shared_ptr<Encoder> encoder(
-               new ConstantIntegerEncoder( bytestreamNumber, sbuf, sini->minimum() ) );
+               new ConstantIntegerEncoder( true, bytestreamNumber, sbuf, sini->minimum(),
+                                           sini->scale(), sini->offset() ) );
 
             return encoder;
          }
@@ -146,30 +142,30 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint8_t>(
-               true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(),
-               sini->maximum(), sini->scale(), sini->offset() ) );
+               true, bytestreamNumber, sbuf, sini->minimum(), sini->maximum(), sini->scale(),
+               sini->offset() ) );
             return encoder;
          }
 
          if ( bitsPerRecord <= 16 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint16_t>(
-               true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(),
-               sini->maximum(), sini->scale(), sini->offset() ) );
+               true, bytestreamNumber, sbuf, sini->minimum(), sini->maximum(), sini->scale(),
+               sini->offset() ) );
             return encoder;
          }
 
          if ( bitsPerRecord <= 32 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint32_t>(
-               true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(),
-               sini->maximum(), sini->scale(), sini->offset() ) );
+               true, bytestreamNumber, sbuf, sini->minimum(), sini->maximum(), sini->scale(),
+               sini->offset() ) );
             return encoder;
          }
 
          std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint64_t>(
-            true, bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, sini->minimum(), sini->maximum(),
-            sini->scale(), sini->offset() ) );
+            true, bytestreamNumber, sbuf, sini->minimum(), sini->maximum(), sini->scale(),
+            sini->offset() ) );
          return encoder;
       }
 
@@ -178,16 +174,15 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
          std::shared_ptr<FloatNodeImpl> fni =
             std::static_pointer_cast<FloatNodeImpl>( encodeNode ); // downcast to correct type
 
-         // !!! need to pick smarter channel buffer sizes, here and elsewhere
-         std::shared_ptr<Encoder> encoder( new BitpackFloatEncoder(
-            bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, fni->precision() ) );
+         std::shared_ptr<Encoder> encoder(
+            new BitpackFloatEncoder( bytestreamNumber, sbuf, fni->precision() ) );
          return encoder;
       }
 
       case TypeString:
       {
          std::shared_ptr<Encoder> encoder(
-            new BitpackStringEncoder( bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/ ) );
+            new BitpackStringEncoder( bytestreamNumber, sbuf ) );
 
          return encoder;
       }
@@ -203,6 +198,11 @@ Encoder::Encoder( unsigned bytestreamNumber ) : bytestreamNumber_( bytestreamNum
 {
 }
 
+bool Encoder::valueRange( double & /*minimum*/, double & /*maximum*/ ) const
+{
+   return false;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void Encoder::dump( int indent, std::ostream &os ) const
 {
@@ -212,11 +212,8 @@ void Encoder::dump( int indent, std::ostream &os ) const
 
 //================
 
-BitpackEncoder::BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                                unsigned outputMaxSize, unsigned alignmentSize ) :
-   Encoder( bytestreamNumber ), sourceBuffer_( sbuf.impl() ), outBuffer_( outputMaxSize ),
-   outBufferFirst_( 0 ), outBufferEnd_( 0 ), outBufferAlignmentSize_( alignmentSize ),
-   currentRecordIndex_( 0 )
+BitpackEncoder::BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf ) :
+   Encoder( bytestreamNumber ), sourceBuffer_( sbuf.impl() ), currentRecordIndex_( 0 )
 {
 }
 
@@ -232,55 +229,31 @@ uint64_t BitpackEncoder::currentRecordIndex()
 
 size_t BitpackEncoder::outputAvailable() const
 {
-   return outBufferEnd_ - outBufferFirst_;
+   return outBufferEnd_;
 }
 
-void BitpackEncoder::outputRead( char *dest, const size_t byteCount )
+void BitpackEncoder::outputSetBuffer( char *buffer, size_t bufferSize )
 {
 #ifdef E57_VERBOSE
-   std::cout << "BitpackEncoder::outputRead() called, dest=" << dest << " byteCount=" << byteCount
-             << std::endl; //???
+   std::cout << "BitpackEncoder::outputSetBuffer() called, buffer=" << static_cast<void *>( buffer )
+             << " bufferSize=" << bufferSize << std::endl; //???
 #endif
 
-   // Check we have enough bytes in queue
-   if ( byteCount > outputAvailable() )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "byteCount=" + toString( byteCount ) +
-                                              " outputAvailable=" + toString( outputAvailable() ) );
-   }
-
-   // Copy output bytes to caller
-   memcpy( dest, &outBuffer_[outBufferFirst_], byteCount );
+   outBuffer_ = buffer;
+   outBufferSize_ = bufferSize;
+   outBufferEnd_ = 0;
+}
 
-#ifdef E57_VERBOSE
+void BitpackEncoder::outputMoveBuffer( char *buffer, size_t bufferSize )
+{
+   if ( bufferSize < outBufferEnd_ )
    {
-      unsigned i;
-      for ( i = 0; i < byteCount && i < 20; i++ )
-      {
-         std::cout << "  outBuffer[" << outBufferFirst_ + i << "]="
-                   << static_cast<unsigned>(
-                         static_cast<unsigned char>( outBuffer_[outBufferFirst_ + i] ) )
-                   << std::endl; //???
-      }
-
-      if ( i < byteCount )
-      {
-         std::cout << "  " << byteCount - 1 << " bytes unprinted..." << std::endl;
-      }
+      throw E57_EXCEPTION2( ErrorInternal, "bufferSize=" + toString( bufferSize ) +
+                                              " outBufferEnd=" + toString( outBufferEnd_ ) );
    }
-#endif
-
-   // Advance head pointer.
-   outBufferFirst_ += byteCount;
 
-   // Don't slide remaining data down now, wait until do some more processing (that's when data
-   // needs to be aligned).
-}
-
-void BitpackEncoder::outputClear()
-{
-   outBufferFirst_ = 0;
-   outBufferEnd_ = 0;
+   outBuffer_ = buffer;
+   outBufferSize_ = bufferSize;
 }
 
 void BitpackEncoder::sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs )
@@ -294,93 +267,26 @@ void BitpackEncoder::sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs )
    sourceBuffer_ = sbufs.at( 0 ).impl();
 }
 
-size_t BitpackEncoder::outputGetMaxSize()
-{
-   // Its size that matters here, not capacity
-   return ( outBuffer_.size() );
-}
-
-void BitpackEncoder::outputSetMaxSize( unsigned byteCount )
-{
-   // Ignore if trying to shrink buffer (queue might get messed up).
-   if ( byteCount > outBuffer_.size() )
-   {
-      outBuffer_.resize( byteCount );
-   }
-}
-
-void BitpackEncoder::outBufferShiftDown()
-{
-   // Move data down closer to beginning of outBuffer_.
-   // But keep outBufferEnd_ as a multiple of outBufferAlignmentSize_.
-   // This ensures that writes into buffer can occur on natural boundaries.
-   // Otherwise some CPUs will fault.
-
-   if ( outBufferFirst_ == outBufferEnd_ )
-   {
-      // Buffer is empty, reset indices to 0
-      outBufferFirst_ = 0;
-      outBufferEnd_ = 0;
-      return;
-   }
-
-   // Round newEnd up to nearest multiple of outBufferAlignmentSize_.
-   size_t newEnd = outputAvailable();
-   size_t remainder = newEnd % outBufferAlignmentSize_;
-   if ( remainder > 0 )
-   {
-      newEnd += outBufferAlignmentSize_ - remainder;
-   }
-   size_t newFirst = outBufferFirst_ - ( outBufferEnd_ - newEnd );
-   size_t byteCount = outBufferEnd_ - outBufferFirst_;
-
-   // Double check round up worked
-   if ( newEnd % outBufferAlignmentSize_ )
-   {
-      throw E57_EXCEPTION2( ErrorInternal,
-                            "newEnd=" + toString( newEnd ) +
-                               " outBufferAlignmentSize=" + toString( outBufferAlignmentSize_ ) );
-   }
-
-   // Be paranoid before memory copy
-   if ( newFirst + byteCount > outBuffer_.size() )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "newFirst=" + toString( newFirst ) +
-                                              " byteCount=" + toString( byteCount ) +
-                                              " outBufferSize=" + toString( outBuffer_.size() ) );
-   }
-
-   // Move available data down closer to beginning of outBuffer_. Overlapping regions ok with
-   // memmove().
-   memmove( &outBuffer_[newFirst], &outBuffer_[outBufferFirst_], byteCount );
-
-   // Update indexes
-   outBufferFirst_ = newFirst;
-   outBufferEnd_ = newEnd;
-}
-
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void BitpackEncoder::dump( int indent, std::ostream &os ) const
 {
    Encoder::dump( indent, os );
    os << space( indent ) << "sourceBuffer:" << std::endl;
    sourceBuffer_->dump( indent + 4, os );
-   os << space( indent ) << "outBuffer.size:           " << outBuffer_.size() << std::endl;
-   os << space( indent ) << "outBufferFirst:           " << outBufferFirst_ << std::endl;
+   os << space( indent ) << "outBufferSize:            " << outBufferSize_ << std::endl;
    os << space( indent ) << "outBufferEnd:             " << outBufferEnd_ << std::endl;
-   os << space( indent ) << "outBufferAlignmentSize:   " << outBufferAlignmentSize_ << std::endl;
    os << space( indent ) << "currentRecordIndex:       " << currentRecordIndex_ << std::endl;
    os << space( indent ) << "outBuffer:" << std::endl;
    unsigned i;
-   for ( i = 0; i < outBuffer_.size() && i < 20; i++ )
+   for ( i = 0; i < outBufferEnd_ && i < 20; i++ )
    {
       os << space( indent + 4 ) << "outBuffer[" << i
-         << "]: " << static_cast<unsigned>( static_cast<unsigned char>( outBuffer_.at( i ) ) )
+         << "]: " << static_cast<unsigned>( static_cast<unsigned char>( outBuffer_[i] ) )
          << std::endl;
    }
-   if ( i < outBuffer_.size() )
+   if ( i < outBufferEnd_ )
    {
-      os << space( indent + 4 ) << outBuffer_.size() - i << " more unprinted..." << std::endl;
+      os << space( indent + 4 ) << outBufferEnd_ - i << " more unprinted..." << std::endl;
    }
 }
 #endif
@@ -388,10 +294,10 @@ void BitpackEncoder::dump( int indent, std::ostream &os ) const
 //================
 
 BitpackFloatEncoder::BitpackFloatEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                                          unsigned outputMaxSize, FloatPrecision precision ) :
-   BitpackEncoder( bytestreamNumber, sbuf, outputMaxSize,
-                   ( precision == PrecisionSingle ) ? sizeof( float ) : sizeof( double ) ),
-   precision_( precision )
+                                          FloatPrecision precision ) :
+   BitpackEncoder( bytestreamNumber, sbuf ), precision_( precision ),
+   valueMinimum_( std::numeric_limits<double>::infinity() ),
+   valueMaximum_( -std::numeric_limits<double>::infinity() )
 {
 }
 
@@ -402,24 +308,10 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
              << std::endl; //???
 #endif
 
-   // Before we add any more, try to shift current contents of outBuffer_ down to beginning of
-   // buffer. This leaves outBufferEnd_ at a natural boundary.
-   outBufferShiftDown();
-
    size_t typeSize = ( precision_ == PrecisionSingle ) ? sizeof( float ) : sizeof( double );
 
-#if VALIDATE_BASIC
-   // Verify that outBufferEnd_ is multiple of typeSize (so transfers of floats are aligned
-   // naturally in memory).
-   if ( outBufferEnd_ % typeSize )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "outBufferEnd=" + toString( outBufferEnd_ ) +
-                                              " typeSize=" + toString( typeSize ) );
-   }
-#endif
-
    // Figure out how many records will fit in output.
-   size_t maxOutputRecords = ( outBuffer_.size() - outBufferEnd_ ) / typeSize;
+   size_t maxOutputRecords = ( outBufferSize_ - outBufferEnd_ ) / typeSize;
 
    // Can't process more records than will safely fit in output stream
    if ( recordCount > maxOutputRecords )
@@ -430,31 +322,50 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
    if ( precision_ == PrecisionSingle )
    {
       // Form the starting address for next available location in outBuffer
-      auto outp = reinterpret_cast<float *>( &outBuffer_[outBufferEnd_] );
+      char *outp = &outBuffer_[outBufferEnd_];
+
+      float minimum = std::numeric_limits<float>::infinity();
+      float maximum = -std::numeric_limits<float>::infinity();
 
-      // Copy floats from sourceBuffer_ to outBuffer_
+      // Copy floats from sourceBuffer_ to outBuffer_, keeping track of their range. The
+      // comparisons are written this way so NaNs are skipped.
       for ( unsigned i = 0; i < recordCount; i++ )
       {
-         outp[i] = sourceBuffer_->getNextFloat();
+         const float value = sourceBuffer_->getNextFloat();
+         memcpy( outp + i * sizeof( float ), &value, sizeof( float ) );
+         minimum = ( value < minimum ) ? value : minimum;
+         maximum = ( value > maximum ) ? value : maximum;
 #ifdef E57_VERBOSE
-         std::cout << "encoding float: " << outp[i] << std::endl;
+         std::cout << "encoding float: " << value << std::endl;
 #endif
       }
+
+      valueMinimum_ = std::min( valueMinimum_, static_cast<double>( minimum ) );
+      valueMaximum_ = std::max( valueMaximum_, static_cast<double>( maximum ) );
    }
    else
    {
       // Double precision
       // Form the starting address for next available location in outBuffer
-      auto outp = reinterpret_cast<double *>( &outBuffer_[outBufferEnd_] );
+      char *outp = &outBuffer_[outBufferEnd_];
 
-      // Copy doubles from sourceBuffer_ to outBuffer_
+      double minimum = valueMinimum_;
+      double maximum = valueMaximum_;
+
+      // Copy doubles from sourceBuffer_ to outBuffer_, keeping track of their range
       for ( unsigned i = 0; i < recordCount; i++ )
       {
-         outp[i] = sourceBuffer_->getNextDouble();
+         const double value = sourceBuffer_->getNextDouble();
+         memcpy( outp + i * sizeof( double ), &value, sizeof( double ) );
+         minimum = ( value < minimum ) ? value : minimum;
+         maximum = ( value > maximum ) ? value : maximum;
 #ifdef E57_VERBOSE
-         std::cout << "encoding double: " << outp[i] << std::endl;
+         std::cout << "encoding double: " << value << std::endl;
 #endif
       }
+
+      valueMinimum_ = minimum;
+      valueMaximum_ = maximum;
    }
 
    // Update end of outBuffer
@@ -477,6 +388,19 @@ float BitpackFloatEncoder::bitsPerRecord()
    return ( ( precision_ == PrecisionSingle ) ? 32.0F : 64.0F );
 }
 
+bool BitpackFloatEncoder::valueRange( double &minimum, double &maximum ) const
+{
+   if ( valueMinimum_ > valueMaximum_ )
+   {
+      return false;
+   }
+
+   minimum = valueMinimum_;
+   maximum = valueMaximum_;
+
+   return true;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void BitpackFloatEncoder::dump( int indent, std::ostream &os ) const
 {
@@ -494,9 +418,8 @@ void BitpackFloatEncoder::dump( int indent, std::ostream &os ) const
 
 //================
 
-BitpackStringEncoder::BitpackStringEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                                            unsigned outputMaxSize ) :
-   BitpackEncoder( bytestreamNumber, sbuf, outputMaxSize, 1 ), totalBytesProcessed_( 0 ),
+BitpackStringEncoder::BitpackStringEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf ) :
+   BitpackEncoder( bytestreamNumber, sbuf ), totalBytesProcessed_( 0 ),
    isStringActive_( false ), prefixComplete_( false ), currentCharPosition_( 0 )
 {
 }
@@ -508,12 +431,8 @@ uint64_t BitpackStringEncoder::processRecords( size_t recordCount )
              << std::endl; //???
 #endif
 
-   // Before we add any more, try to shift current contents of outBuffer_ down to beginning of
-   // buffer.
-   outBufferShiftDown();
-
    // Figure out how many bytes outBuffer can accept.
-   size_t bytesFree = outBuffer_.size() - outBufferEnd_;
+   size_t bytesFree = outBufferSize_ - outBufferEnd_;
 
    // Form the starting address for next available location in outBuffer
    char *outp = &outBuffer_[outBufferEnd_];
@@ -612,7 +531,7 @@ uint64_t BitpackStringEncoder::processRecords( size_t recordCount )
    }
 
    // Update end of outBuffer
-   outBufferEnd_ = outBuffer_.size() - bytesFree;
+   outBufferEnd_ = outBufferSize_ - bytesFree;
 
    // Update counts of records processed
    currentRecordIndex_ += recordsProcessed;
@@ -652,11 +571,14 @@ void BitpackStringEncoder::dump( int indent, std::ostream &os ) const
 
 //================================================================
 
+// Required in C++14 since PackBlockSize is odr-used (std::min takes references).
+template <typename RegisterT> constexpr size_t BitpackIntegerEncoder<RegisterT>::PackBlockSize;
+
 template <typename RegisterT>
 BitpackIntegerEncoder<RegisterT>::BitpackIntegerEncoder(
-   bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &sbuf, unsigned outputMaxSize,
-   int64_t minimum, int64_t maximum, double scale, double offset ) :
-   BitpackEncoder( bytestreamNumber, sbuf, outputMaxSize, sizeof( RegisterT ) )
+   bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &sbuf, int64_t minimum,
+   int64_t maximum, double scale, double offset ) :
+   BitpackEncoder( bytestreamNumber, sbuf )
 {
    ImageFileImplSharedPtr imf( sbuf.impl()->destImageFile() ); //??? should be function for this,
                                                                // imf->parentFile()  --> ImageFile?
@@ -670,6 +592,8 @@ BitpackIntegerEncoder<RegisterT>::BitpackIntegerEncoder(
    sourceBitMask_ = ( bitsPerRecord_ == 64 ) ? ~0 : ( 1ULL << bitsPerRecord_ ) - 1;
    registerBitsUsed_ = 0;
    register_ = 0;
+   valueMinimum_ = std::numeric_limits<int64_t>::max();
+   valueMaximum_ = std::numeric_limits<int64_t>::min();
 }
 
 template <typename RegisterT>
@@ -690,23 +614,13 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
    }
 #endif
 
-   // Before we add any more, try to shift current contents of outBuffer_ down to beginning of
-   // buffer. This leaves outBufferEnd_ at a natural boundary.
-   outBufferShiftDown();
-
 #ifdef VALIDATE_BASIC
-   // Verify that outBufferEnd_ is multiple of sizeof(RegisterT) (so transfers of RegisterT are
-   // aligned naturally in memory).
-   if ( outBufferEnd_ % sizeof( RegisterT ) )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "outBufferEnd=" + toString( outBufferEnd_ ) );
-   }
-   size_t transferMax = ( outBuffer_.size() - outBufferEnd_ ) / sizeof( RegisterT );
+   size_t transferMax = ( outBufferSize_ - outBufferEnd_ ) / sizeof( RegisterT );
 #endif
 
    // Precalculate exact maximum number of records that will fit in output
    // before overflow.
-   size_t outputWordCapacity = ( outBuffer_.size() - outBufferEnd_ ) / sizeof( RegisterT );
+   size_t outputWordCapacity = ( outBufferSize_ - outBufferEnd_ ) / sizeof( RegisterT );
    size_t maxOutputRecords = ( outputWordCapacity * 8 * sizeof( RegisterT ) +
                                8 * sizeof( RegisterT ) - registerBitsUsed_ - 1 ) /
                              bitsPerRecord_;
@@ -720,103 +634,44 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
 #endif
 
    // Form the starting address for next available location in outBuffer
-   auto outp = reinterpret_cast<RegisterT *>( &outBuffer_[outBufferEnd_] );
-   unsigned outTransferred = 0;
+   char *outp = &outBuffer_[outBufferEnd_];
+   size_t outTransferred = 0;
 
-   // Copy bits from sourceBuffer_ to outBuffer_
-   for ( unsigned i = 0; i < recordCount; i++ )
+   // Copy bits from sourceBuffer_ to outBuffer_ a block at a time: fetch the raw values, check
+   // the whole block against min/max, then pack it.
+   int64_t values[PackBlockSize];
+
+   for ( size_t done = 0; done < recordCount; )
    {
-      int64_t rawValue;
+      const size_t count = std::min( recordCount - done, PackBlockSize );
 
-      // The parameter isScaledInteger_ determines which version of getNextInt64 gets called
+      // The parameter isScaledInteger_ determines which version of getNextInt64Block gets called
       if ( isScaledInteger_ )
       {
-         rawValue = sourceBuffer_->getNextInt64( scale_, offset_ );
+         sourceBuffer_->getNextInt64Block( values, count, scale_, offset_ );
       }
       else
       {
-         rawValue = sourceBuffer_->getNextInt64();
+         sourceBuffer_->getNextInt64Block( values, count );
       }
 
-      // Enforce min/max specification on value
-      if ( rawValue < minimum_ || maximum_ < rawValue )
-      {
-         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( rawValue ) +
-                                                         " minimum=" + toString( minimum_ ) +
-                                                         " maximum=" + toString( maximum_ ) );
-      }
+      checkBlockRange( values, count );
 
-      auto uValue = static_cast<uint64_t>( rawValue - minimum_ );
+      outTransferred += packBlock( values, count, outp + outTransferred * sizeof( RegisterT ) );
 
-#ifdef E57_VERBOSE
-      std::cout << "encoding integer rawValue=" << binaryString( rawValue ) << " = "
-                << hexString( rawValue ) << std::endl;
-      std::cout << "                 uValue  =" << binaryString( uValue ) << " = "
-                << hexString( uValue ) << std::endl;
-#endif
 #ifdef VALIDATE_BASIC
-      // Double check that no bits outside of the mask are set
-      if ( uValue & ~static_cast<uint64_t>( sourceBitMask_ ) )
+      // Double check we stayed within bounds
+      if ( outTransferred > transferMax )
       {
-         throw E57_EXCEPTION2( ErrorInternal, "uValue=" + toString( uValue ) );
+         throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
+                                                 " transferMax" + toString( transferMax ) );
       }
 #endif
-      // Mask off upper bits (just in case)
-      uValue &= static_cast<uint64_t>( sourceBitMask_ );
 
-      // See if uValue bits will fit in register
-      unsigned newRegisterBitsUsed = registerBitsUsed_ + bitsPerRecord_;
-#ifdef E57_VERBOSE
-      std::cout << "  registerBitsUsed=" << registerBitsUsed_
-                << "  newRegisterBitsUsed=" << newRegisterBitsUsed << std::endl;
-#endif
-      if ( newRegisterBitsUsed > 8 * sizeof( RegisterT ) )
-      {
-         // Have more than one registers worth, fill register, transfer, then fill some more
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-#ifdef VALIDATE_BASIC
-         // Before transfer, double check address within bounds
-         if ( outTransferred >= transferMax )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
-                                                    " transferMax" + toString( transferMax ) );
-         }
-#endif
-         outp[outTransferred] = register_;
-
-         outTransferred++;
-
-         register_ =
-            static_cast<RegisterT>( uValue ) >> ( 8 * sizeof( RegisterT ) - registerBitsUsed_ );
-         registerBitsUsed_ = newRegisterBitsUsed - 8 * sizeof( RegisterT );
-      }
-      else if ( newRegisterBitsUsed == 8 * sizeof( RegisterT ) )
-      {
-         // Input will exactly fill register, insert value, then transfer
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-#ifdef VALIDATE_BASIC
-         // Before transfer, double check address within bounds
-         if ( outTransferred >= transferMax )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
-                                                    " transferMax" + toString( transferMax ) );
-         }
-#endif
-         outp[outTransferred] = register_;
+      done += count;
 
-         outTransferred++;
-
-         register_ = 0;
-         registerBitsUsed_ = 0;
-      }
-      else
-      {
-         // There is extra room in register, insert value, but don't do transfer yet
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-         registerBitsUsed_ = newRegisterBitsUsed;
-      }
 #ifdef E57_VERBOSE
-      std::cout << "  After " << outTransferred << " transfers and " << i + 1
+      std::cout << "  After " << outTransferred << " transfers and " << done
                 << " records, encoder:" << std::endl;
       dump( 4 );
 #endif
@@ -826,10 +681,10 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
    outBufferEnd_ += outTransferred * sizeof( RegisterT );
 #ifdef VALIDATE_BASIC
    // Double check end is ok
-   if ( outBufferEnd_ > outBuffer_.size() )
+   if ( outBufferEnd_ > outBufferSize_ )
    {
       throw E57_EXCEPTION2( ErrorInternal, "outBufferEnd=" + toString( outBufferEnd_ ) +
-                                              " outBuffersize=" + toString( outBuffer_.size() ) );
+                                              " outBufferSize=" + toString( outBufferSize_ ) );
    }
 #endif
 
@@ -839,6 +694,95 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
    return ( currentRecordIndex_ );
 }
 
+template <typename RegisterT>
+void BitpackIntegerEncoder<RegisterT>::checkBlockRange( const int64_t *values, size_t count )
+{
+   // Reduce to min/max first (this loop vectorizes), and only go looking for the culprit if the
+   // block is out of bounds. The min/max also gives us the range of the values encoded.
+   int64_t blockMin = values[0];
+   int64_t blockMax = values[0];
+
+   for ( size_t i = 1; i < count; ++i )
+   {
+      blockMin = std::min( blockMin, values[i] );
+      blockMax = std::max( blockMax, values[i] );
+   }
+
+   if ( blockMin >= minimum_ && blockMax <= maximum_ )
+   {
+      valueMinimum_ = std::min( valueMinimum_, blockMin );
+      valueMaximum_ = std::max( valueMaximum_, blockMax );
+      return;
+   }
+
+   for ( size_t i = 0; i < count; ++i )
+   {
+      const int64_t rawValue = values[i];
+
+      if ( rawValue < minimum_ || maximum_ < rawValue )
+      {
+         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( rawValue ) +
+                                                         " minimum=" + toString( minimum_ ) +
+                                                         " maximum=" + toString( maximum_ ) );
+      }
+   }
+}
+
+template <typename RegisterT>
+size_t BitpackIntegerEncoder<RegisterT>::packBlock( const int64_t *values, size_t count,
+                                                    char *outp )
+{
+   constexpr unsigned cRegisterBits = 8 * sizeof( RegisterT );
+
+   const auto minimum = static_cast<uint64_t>( minimum_ );
+
+   // Records which exactly fill a register (8, 16, 32, 64 bits) never leave bits behind, so they
+   // are a straight copy.
+   if ( bitsPerRecord_ == cRegisterBits && registerBitsUsed_ == 0 )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         const auto word = static_cast<RegisterT>( static_cast<uint64_t>( values[i] ) - minimum );
+         memcpy( outp + i * sizeof( RegisterT ), &word, sizeof( RegisterT ) );
+      }
+
+      return count;
+   }
+
+   // Otherwise pack LSB first into the register, writing it out each time it fills up. The output
+   // is a slice of the packet payload with no particular alignment, hence memcpy().
+   // Works on locals so the compiler can keep them in registers.
+   RegisterT reg = register_;
+   unsigned bitsUsed = registerBitsUsed_;
+   size_t outTransferred = 0;
+
+   for ( size_t i = 0; i < count; ++i )
+   {
+      const uint64_t uValue = ( static_cast<uint64_t>( values[i] ) - minimum ) & sourceBitMask_;
+
+      reg |= static_cast<RegisterT>( uValue ) << bitsUsed;
+      bitsUsed += bitsPerRecord_;
+
+      if ( bitsUsed >= cRegisterBits )
+      {
+         memcpy( outp + outTransferred * sizeof( RegisterT ), &reg, sizeof( RegisterT ) );
+         ++outTransferred;
+
+         // Carry over any bits of uValue that did not fit
+         bitsUsed -= cRegisterBits;
+         reg = ( bitsUsed > 0 )
+                  ? static_cast<RegisterT>( static_cast<RegisterT>( uValue ) >>
+                                            ( bitsPerRecord_ - bitsUsed ) )
+                  : 0;
+      }
+   }
+
+   register_ = reg;
+   registerBitsUsed_ = bitsUsed;
+
+   return outTransferred;
+}
+
 template <typename RegisterT> bool BitpackIntegerEncoder<RegisterT>::registerFlushToOutput()
 {
 #ifdef E57_VERBOSE
@@ -851,10 +795,9 @@ template <typename RegisterT> bool BitpackIntegerEncoder<RegisterT>::registerFlu
    // RegisterT boundary
    if ( registerBitsUsed_ > 0 )
    {
-      if ( outBufferEnd_ < outBuffer_.size() - sizeof( RegisterT ) )
+      if ( outBufferSize_ - outBufferEnd_ >= sizeof( RegisterT ) )
       {
-         auto outp = reinterpret_cast<RegisterT *>( &outBuffer_[outBufferEnd_] );
-         *outp = register_;
+         memcpy( &outBuffer_[outBufferEnd_], &register_, sizeof( RegisterT ) );
          register_ = 0;
          registerBitsUsed_ = 0;
          outBufferEnd_ += sizeof( RegisterT );
@@ -872,6 +815,32 @@ template <typename RegisterT> float BitpackIntegerEncoder<RegisterT>::bitsPerRec
    return ( static_cast<float>( bitsPerRecord_ ) );
 }
 
+template <typename RegisterT>
+bool BitpackIntegerEncoder<RegisterT>::valueRange( double &minimum, double &maximum ) const
+{
+   if ( valueMinimum_ > valueMaximum_ )
+   {
+      return false;
+   }
+
+   minimum = static_cast<double>( valueMinimum_ );
+   maximum = static_cast<double>( valueMaximum_ );
+
+   if ( isScaledInteger_ )
+   {
+      minimum = minimum * scale_ + offset_;
+      maximum = maximum * scale_ + offset_;
+
+      // A negative scale reverses the order
+      if ( minimum > maximum )
+      {
+         std::swap( minimum, maximum );
+      }
+   }
+
+   return true;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 template <typename RegisterT>
 void BitpackIntegerEncoder<RegisterT>::dump( int indent, std::ostream &os ) const
@@ -893,10 +862,11 @@ void BitpackIntegerEncoder<RegisterT>::dump( int indent, std::ostream &os ) cons
 
 //================================================================
 
-ConstantIntegerEncoder::ConstantIntegerEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                                                int64_t minimum ) :
-   Encoder( bytestreamNumber ), sourceBuffer_( sbuf.impl() ), currentRecordIndex_( 0 ),
-   minimum_( minimum )
+ConstantIntegerEncoder::ConstantIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber,
+                                                SourceDestBuffer &sbuf, int64_t minimum,
+                                                double scale, double offset ) :
+   Encoder( bytestreamNumber ), isScaledInteger_( isScaledInteger ), sourceBuffer_( sbuf.impl() ),
+   currentRecordIndex_( 0 ), minimum_( minimum ), scale_( scale ), offset_( offset )
 {
 }
 
@@ -909,9 +879,11 @@ uint64_t ConstantIntegerEncoder::processRecords( size_t recordCount )
 #endif
 
    // Check that all source values are == minimum_
+   // (ScaledInteger values are first converted to raw values, as with BitpackIntegerEncoder)
    for ( unsigned i = 0; i < recordCount; i++ )
    {
-      int64_t nextInt64 = sourceBuffer_->getNextInt64();
+      int64_t nextInt64 = isScaledInteger_ ? sourceBuffer_->getNextInt64( scale_, offset_ )
+                                           : sourceBuffer_->getNextInt64();
       if ( nextInt64 != minimum_ )
       {
          throw E57_EXCEPTION2( ErrorValueOutOfBounds, "nextInt64=" + toString( nextInt64 ) +
@@ -952,17 +924,14 @@ size_t ConstantIntegerEncoder::outputAvailable() const
    return 0;
 }
 
-void ConstantIntegerEncoder::outputRead( char * /*dest*/, const size_t byteCount )
+void ConstantIntegerEncoder::outputSetBuffer( char * /*buffer*/, size_t /*bufferSize*/ )
 {
-   // Should never request any output data
-   if ( byteCount > 0 )
-   {
-      throw E57_EXCEPTION2( ErrorInternal, "byteCount=" + toString( byteCount ) );
-   }
+   // Ignore, since don't produce any output
 }
 
-void ConstantIntegerEncoder::outputClear()
+void ConstantIntegerEncoder::outputMoveBuffer( char * /*buffer*/, size_t /*bufferSize*/ )
 {
+   // Ignore, since don't produce any output
 }
 
 void ConstantIntegerEncoder::sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs )
@@ -976,15 +945,17 @@ void ConstantIntegerEncoder::sourceBufferSetNew( std::vector<SourceDestBuffer> &
    sourceBuffer_ = sbufs.at( 0 ).impl();
 }
 
-size_t ConstantIntegerEncoder::outputGetMaxSize()
+bool ConstantIntegerEncoder::valueRange( double &minimum, double &maximum ) const
 {
-   // We don't produce any output
-   return ( 0 );
-}
+   if ( currentRecordIndex_ == 0 )
+   {
+      return false;
+   }
 
-void ConstantIntegerEncoder::outputSetMaxSize( unsigned /*byteCount*/ )
-{
-   // Ignore, since don't produce any output
+   minimum = static_cast<double>( minimum_ ) * scale_ + offset_;
+   maximum = minimum;
+
+   return true;
 }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
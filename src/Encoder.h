@@ -46,13 +46,21 @@ namespace e57
       virtual float bitsPerRecord() = 0;
       virtual bool registerFlushToOutput() = 0;
 
-      virtual size_t outputAvailable() const = 0; /// number of bytes that can be read
-      virtual void outputRead( char *dest, size_t byteCount ) = 0; /// get data from encoder
-      virtual void outputClear() = 0;
+      /// Number of bytes written into the current output buffer
+      virtual size_t outputAvailable() const = 0;
+
+      /// Give the encoder a new (empty) output buffer to write into. The encoder doesn't own it.
+      virtual void outputSetBuffer( char *buffer, size_t bufferSize ) = 0;
+
+      /// Carry on writing into a different output buffer. The caller has already moved the
+      /// outputAvailable() bytes written so far to its start.
+      virtual void outputMoveBuffer( char *buffer, size_t bufferSize ) = 0;
 
       virtual void sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs ) = 0;
-      virtual size_t outputGetMaxSize() = 0;
-      virtual void outputSetMaxSize( unsigned byteCount ) = 0;
+
+      /// Minimum & maximum of the values encoded so far, as stored in the file (so scaled for a
+      /// ScaledInteger). Returns false if there are none, or the field isn't numeric.
+      virtual bool valueRange( double &minimum, double &maximum ) const;
 
       unsigned bytestreamNumber() const
       {
@@ -78,30 +86,26 @@ namespace e57
       float bitsPerRecord() override = 0;
       bool registerFlushToOutput() override = 0;
 
-      size_t outputAvailable() const override;                  /// number of bytes that can be read
-      void outputRead( char *dest, size_t byteCount ) override; /// get data from encoder
-      void outputClear() override;
+      size_t outputAvailable() const override;
+      void outputSetBuffer( char *buffer, size_t bufferSize ) override;
+      void outputMoveBuffer( char *buffer, size_t bufferSize ) override;
 
       void sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs ) override;
-      size_t outputGetMaxSize() override;
-      void outputSetMaxSize( unsigned byteCount ) override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
 
    protected:
-      BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf, unsigned outputMaxSize,
-                      unsigned alignmentSize );
-
-      void outBufferShiftDown();
+      BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf );
 
       std::shared_ptr<SourceDestBufferImpl> sourceBuffer_;
 
-      std::vector<char> outBuffer_;
-      size_t outBufferFirst_;
-      size_t outBufferEnd_;
-      size_t outBufferAlignmentSize_;
+      /// Output buffer, usually a slice of the writer's data packet payload. No alignment is
+      /// guaranteed, so all stores go through memcpy().
+      char *outBuffer_ = nullptr;
+      size_t outBufferSize_ = 0;
+      size_t outBufferEnd_ = 0;
 
       uint64_t currentRecordIndex_;
    };
@@ -110,25 +114,29 @@ namespace e57
    {
    public:
       BitpackFloatEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                           unsigned outputMaxSize, FloatPrecision precision );
+                           FloatPrecision precision );
 
       uint64_t processRecords( size_t recordCount ) override;
       bool registerFlushToOutput() override;
       float bitsPerRecord() override;
 
+      bool valueRange( double &minimum, double &maximum ) const override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
 
    protected:
       FloatPrecision precision_;
+
+      double valueMinimum_;
+      double valueMaximum_;
    };
 
    class BitpackStringEncoder : public BitpackEncoder
    {
    public:
-      BitpackStringEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                            unsigned outputMaxSize );
+      BitpackStringEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf );
 
       uint64_t processRecords( size_t recordCount ) override;
       bool registerFlushToOutput() override;
@@ -150,18 +158,26 @@ namespace e57
    {
    public:
       BitpackIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber,
-                             SourceDestBuffer &sbuf, unsigned outputMaxSize, int64_t minimum,
-                             int64_t maximum, double scale, double offset );
+                             SourceDestBuffer &sbuf, int64_t minimum, int64_t maximum,
+                             double scale, double offset );
 
       uint64_t processRecords( size_t recordCount ) override;
       bool registerFlushToOutput() override;
       float bitsPerRecord() override;
 
+      bool valueRange( double &minimum, double &maximum ) const override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
 
    protected:
+      /// Number of records fetched, range checked, and packed at a time in processRecords()
+      static constexpr size_t PackBlockSize = 256;
+
+      void checkBlockRange( const int64_t *values, size_t count );
+      size_t packBlock( const int64_t *values, size_t count, char *outp );
+
       bool isScaledInteger_;
       int64_t minimum_;
       int64_t maximum_;
@@ -171,33 +187,42 @@ namespace e57
       uint64_t sourceBitMask_;
       unsigned registerBitsUsed_;
       RegisterT register_;
+
+      /// Raw range of the values encoded so far
+      int64_t valueMinimum_;
+      int64_t valueMaximum_;
    };
 
    class ConstantIntegerEncoder : public Encoder
    {
    public:
-      ConstantIntegerEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf, int64_t minimum );
+      ConstantIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber,
+                              SourceDestBuffer &sbuf, int64_t minimum, double scale = 1.0,
+                              double offset = 0.0 );
       uint64_t processRecords( size_t recordCount ) override;
       unsigned sourceBufferNextIndex() override;
       uint64_t currentRecordIndex() override;
       float bitsPerRecord() override;
       bool registerFlushToOutput() override;
 
-      size_t outputAvailable() const override;                  /// number of bytes that can be read
-      void outputRead( char *dest, size_t byteCount ) override; /// get data from encoder
-      void outputClear() override;
+      size_t outputAvailable() const override;
+      void outputSetBuffer( char *buffer, size_t bufferSize ) override;
+      void outputMoveBuffer( char *buffer, size_t bufferSize ) override;
 
       void sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs ) override;
-      size_t outputGetMaxSize() override;
-      void outputSetMaxSize( unsigned byteCount ) override;
+
+      bool valueRange( double &minimum, double &maximum ) const override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
 
    protected:
+      bool isScaledInteger_;
       std::shared_ptr<SourceDestBufferImpl> sourceBuffer_;
       uint64_t currentRecordIndex_;
       int64_t minimum_;
+      double scale_;
+      double offset_;
    };
 }
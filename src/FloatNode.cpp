@@ -30,6 +30,7 @@
 /// @file FloatNode.cpp
 
 #include "FloatNodeImpl.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
 
 using namespace e57;
@@ -151,7 +152,7 @@ be true).
 */
 FloatNode::FloatNode( const ImageFile &destImageFile, double value, FloatPrecision precision,
                       double minimum, double maximum ) :
-   impl_( new FloatNodeImpl( destImageFile.impl(), value, precision, minimum, maximum ) )
+   impl_( destImageFile.impl()->makeNode<FloatNodeImpl>( value, precision, minimum, maximum ) )
 {
    impl_->validateValue();
 }
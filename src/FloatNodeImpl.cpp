@@ -26,8 +26,9 @@
  */
 
 #include "FloatNodeImpl.h"
-#include "CheckedFile.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -144,7 +145,7 @@ namespace e57
       }
    }
 
-   void FloatNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, CheckedFile &cf, int indent,
+   void FloatNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, XmlWriter &xml, int indent,
                                  const char *forcedFieldName )
    {
       // don't checkImageFileOpen
@@ -159,29 +160,29 @@ namespace e57
          fieldName = elementName_;
       }
 
-      cf << space( indent ) << "<" << fieldName << " type=\"Float\"";
+      xml.indent( indent ) << "<" << fieldName << " type=\"Float\"";
       if ( precision_ == PrecisionSingle )
       {
-         cf << " precision=\"single\"";
+         xml << " precision=\"single\"";
 
          // Don't need to write if are default values
          if ( minimum_ > FLOAT_MIN )
          {
-            cf << " minimum=\"" << static_cast<float>( minimum_ ) << "\"";
+            xml << " minimum=\"" << static_cast<float>( minimum_ ) << "\"";
          }
          if ( maximum_ < FLOAT_MAX )
          {
-            cf << " maximum=\"" << static_cast<float>( maximum_ ) << "\"";
+            xml << " maximum=\"" << static_cast<float>( maximum_ ) << "\"";
          }
 
          // Write value as child text, unless it is the default value
          if ( value_ != 0.0 )
          {
-            cf << ">" << static_cast<float>( value_ ) << "</" << fieldName << ">\n";
+            xml << ">" << static_cast<float>( value_ ) << "</" << fieldName << ">\n";
          }
          else
          {
-            cf << "/>\n";
+            xml << "/>\n";
          }
       }
       else
@@ -191,25 +192,32 @@ namespace e57
          // Don't need to write if are default values
          if ( minimum_ > DOUBLE_MIN )
          {
-            cf << " minimum=\"" << minimum_ << "\"";
+            xml << " minimum=\"" << minimum_ << "\"";
          }
          if ( maximum_ < DOUBLE_MAX )
          {
-            cf << " maximum=\"" << maximum_ << "\"";
+            xml << " maximum=\"" << maximum_ << "\"";
          }
 
          // Write value as child text, unless it is the default value
          if ( value_ != 0.0 )
          {
-            cf << ">" << value_ << "</" << fieldName << ">\n";
+            xml << ">" << value_ << "</" << fieldName << ">\n";
          }
          else
          {
-            cf << "/>\n";
+            xml << "/>\n";
          }
       }
    }
 
+   NodeImplSharedPtr FloatNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      return destImageFile->makeNode<FloatNodeImpl>( value_, precision_, minimum_, maximum_ );
+   }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
    void FloatNodeImpl::dump( int indent, std::ostream &os ) const
    {
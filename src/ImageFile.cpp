@@ -90,8 +90,8 @@ void ImageFile::checkInvariant( bool doRecurse ) const
       throw E57_EXCEPTION1( ErrorInvarianceViolation );
    }
 
-   // Can't have more than one writer
-   if ( 1 < wCount )
+   // Can't have more than one writer, unless they are all staging their sections
+   if ( ( 1 < wCount ) && ( impl_->unstagedWriterCount() > 0 ) )
    {
       throw E57_EXCEPTION1( ErrorInvarianceViolation );
    }
@@ -246,7 +246,8 @@ that files that meet all of the requirements for a legal ASTM E57 file format us
 ".e57". It is recommended that files that utilize the low-level E57 element data types, but do not
 have all the required element names required by ASTM E57 file format standard use the file extension
 @c "._e57".
-@param [in] mode Either "w" for writing or "r" for reading.
+@param [in] mode Either "w" for writing, "r" for reading, or "u" for updating the metadata of an
+existing file.
 @param [in] checksumPolicy The percentage of checksums we compute and verify as an int. Clamped to
 0-100.
 
@@ -263,6 +264,18 @@ Read mode files may be shared.
 Write API operations are not legal for an ImageFile opened in read mode (i.e. the ImageFile is
 read-only). There is no API support for appending data onto an existing E57 data file.
 
+@par Update Mode
+Update mode reads an existing file so its metadata can be changed: nodes other than BlobNode and
+CompressedVectorNode can be added with StructureNode::set and VectorNode::append, and replaced with
+StructureNode::replace. Binary data can be read, but not written. Only the XML section and the
+header of the file are rewritten, by ImageFile::close, so this is fast however large the file is.
+The XML section is written over the old one if it is at the end of the file (and the file
+truncated if it gets shorter), otherwise after it. ImageFile::cancel (or destroying the ImageFile
+without closing it) leaves the file unchanged.
+
+@warning The file is changed in place, so if ImageFile::close fails part way, e.g. because the
+disk is full, the file may be left unreadable.
+
 @post Resulting ImageFile is in @c open state if constructor succeeds (no exception thrown).
 
 @throw ::ErrorBadAPIArgument
@@ -291,12 +304,71 @@ ImageFile::ImageFile( const ustring &fname, const ustring &mode,
    impl_->construct2( fname, mode );
 }
 
+/*!
+@brief Open an ImageFile for reading, with options.
+
+@param [in] fname File name to open.
+@param [in] options Options for reading the file.
+
+@details
+Same as ImageFile(const ustring&, const ustring&, ReadChecksumPolicy) using mode "r", but with all
+the read options.
+
+@see ImageFileReadOptions
+*/
+ImageFile::ImageFile( const ustring &fname, const ImageFileReadOptions &options ) :
+   impl_( new ImageFileImpl( options.checksumPolicy, options.validateXml, options.lazyNodeTree ) )
+{
+   impl_->construct2( fname, "r" );
+}
+
 ImageFile::ImageFile( const char *input, const uint64_t size, ReadChecksumPolicy checksumPolicy ) :
    impl_( new ImageFileImpl( checksumPolicy ) )
 {
    impl_->construct2( input, size );
 }
 
+/*!
+@brief Open an ImageFile for reading from memory, with options.
+
+@param [in] input The bytes of the E57 file. They must stay valid until the ImageFile is closed.
+@param [in] size The number of bytes in @a input.
+@param [in] options Options for reading the file.
+
+@see ImageFileReadOptions
+*/
+ImageFile::ImageFile( const char *input, const uint64_t size,
+                      const ImageFileReadOptions &options ) :
+   impl_( new ImageFileImpl( options.checksumPolicy, options.validateXml, options.lazyNodeTree ) )
+{
+   impl_->construct2( input, size );
+}
+
+/*!
+@brief Create an ImageFile which is written to a sink instead of a file on disk.
+
+@param [in] sink Where to write the E57 file. It must be empty.
+
+@details
+The ImageFile is opened in write mode, and behaves the same as one created with
+ImageFile(const ustring&, const ustring&, ReadChecksumPolicy) using mode "w". The bytes of the E57
+file are passed to the @a sink as they are written (see ImageFileSink), and it is complete once the
+ImageFile has been closed. Use a MemoryImageFileSink to build the file in memory, with no temporary
+file. fileName() returns "<ImageFileSink>".
+
+@post Resulting ImageFile is in @c open state if constructor succeeds (no exception thrown).
+
+@throw ::ErrorBadAPIArgument if @a sink is null or isn't empty
+@throw ::ErrorInternal All objects in undocumented state
+
+@see ImageFileSink, MemoryImageFileSink
+*/
+ImageFile::ImageFile( std::shared_ptr<ImageFileSink> sink ) :
+   impl_( new ImageFileImpl( ChecksumAll ) )
+{
+   impl_->construct2( std::move( sink ) );
+}
+
 /*!
 @brief Get the pre-established root StructureNode of the E57 ImageFile.
 
@@ -317,6 +389,52 @@ StructureNode ImageFile::root() const
    return StructureNode( impl_->root() );
 }
 
+/*!
+@brief Copy a node of another ImageFile, with all of its children, into this ImageFile.
+
+@param [in] source The node to copy. It may be in any open ImageFile, including this one.
+
+@details
+This makes a new, unattached node in this ImageFile which is a copy of @a source and its children.
+Like any new node, it must be added to the tree (e.g. with StructureNode::set() or
+VectorNode::append()) to be written to the file.
+
+The binary sections of BlobNode and CompressedVectorNode nodes are copied as they are, without
+decoding & encoding the records of a CompressedVectorNode. Only the offsets in the section are
+changed for where it is in this file. This makes it quick to merge the scans of several files,
+split a file into one per scan, or strip parts of a file (e.g. its images) by copying the rest of
+it.
+
+An extension used in an element name must already have been declared in this ImageFile (see
+extensionsAdd()), though it may have a different prefix here.
+
+@pre This ImageFile must be open (i.e. isOpen()).
+@pre This ImageFile must have been opened in write mode (i.e. isWritable()). If it was opened to
+update its metadata ("u" mode), @a source can't be or contain a BlobNode or a CompressedVectorNode.
+@pre The ImageFile of @a source must be open.
+@pre No CompressedVectorWriter may be writing to this ImageFile, unless it is staging its section
+(see CompressedVectorWriterOptions::stageSection).
+
+@return A smart Node handle referencing the new node.
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorFileReadOnly
+@throw ::ErrorTooManyWriters
+@throw ::ErrorBadPathName if an extension used by @a source isn't declared in this ImageFile
+@throw ::ErrorBadCVHeader
+@throw ::ErrorBadCVPacket
+@throw ::ErrorBadChecksum
+@throw ::ErrorReadFailed
+@throw ::ErrorWriteFailed
+@throw ::ErrorInternal All objects in undocumented state
+
+@see ImageFile::extensionsAdd, StructureNode::set, VectorNode::append
+*/
+Node ImageFile::copyNode( const Node &source )
+{
+   return Node( impl_->copyNode( source.impl() ) );
+}
+
 /*!
 @brief Complete any write operations on an ImageFile, and close the file on the disk.
 
@@ -391,9 +509,13 @@ bool ImageFile::isOpen() const
 /*!
 @brief Test whether ImageFile was opened in write mode.
 
+@details
+A file opened to update its metadata ("u" mode) is writable too, but new BlobNodes and
+CompressedVectorNodes can't be created in it.
+
 @post No visible state is modified.
 
-@return true if ImageFile was opened in write mode.
+@return true if ImageFile was opened in write mode ("w") or update mode ("u").
 
 @throw No E57Exceptions.
 
@@ -401,7 +523,7 @@ bool ImageFile::isOpen() const
 */
 bool ImageFile::isWritable() const
 {
-   return impl_->isWriter();
+   return impl_->isWriter() || impl_->isUpdater();
 }
 
 /*!
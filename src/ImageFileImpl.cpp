@@ -25,12 +25,15 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <cstring>
+
 #include "ImageFileImpl.h"
 #include "ASTMVersion.h"
 #include "CheckedFile.h"
 #include "E57XmlParser.h"
 #include "StringFunctions.h"
 #include "StructureNodeImpl.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -74,10 +77,12 @@ namespace e57
    }
 #endif
 
-   ImageFileImpl::ImageFileImpl( ReadChecksumPolicy policy ) :
-      isWriter_( false ), writerCount_( 0 ), readerCount_( 0 ),
-      checksumPolicy( std::max( 0, std::min( policy, 100 ) ) ), file_( nullptr ),
-      xmlLogicalOffset_( 0 ), xmlLogicalLength_( 0 ), unusedLogicalStart_( 0 )
+   ImageFileImpl::ImageFileImpl( ReadChecksumPolicy policy, bool validateXml, bool lazyNodeTree ) :
+      isWriter_( false ), isUpdater_( false ), writerCount_( 0 ), stagedWriterCount_( 0 ),
+      readerCount_( 0 ), checksumPolicy( std::max( 0, std::min( policy, 100 ) ) ),
+      validateXml_( validateXml ), lazyNodeTree_( lazyNodeTree ), file_( nullptr ),
+      xmlLogicalOffset_( 0 ), xmlLogicalLength_( 0 ), unusedLogicalStart_( 0 ),
+      nodeArena_( std::make_shared<NodeArena>() )
    {
       // First phase of construction, can't do much until have the ImageFile object. See
       // ImageFileImpl::construct2() for second phase.
@@ -96,10 +101,11 @@ namespace e57
       // Get shared_ptr to this object
       ImageFileImplSharedPtr imf = shared_from_this();
 
-      // Accept "w" or "r" modes
+      // Accept "w", "u", or "r" modes
       isWriter_ = ( mode == "w" );
+      isUpdater_ = ( mode == "u" );
 
-      if ( !isWriter_ && ( mode != "r" ) )
+      if ( !isWriter_ && !isUpdater_ && ( mode != "r" ) )
       {
          throw E57_EXCEPTION2( ErrorBadAPIArgument, "mode=" + ustring( mode ) );
       }
@@ -114,7 +120,7 @@ namespace e57
             // Open file for writing, truncate if already exists.
             file_ = new CheckedFile( fileName_, CheckedFile::Write, checksumPolicy );
 
-            std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
+            std::shared_ptr<StructureNodeImpl> root( makeNode<StructureNodeImpl>() );
             root_ = root;
             root_->setAttachedRecursive();
 
@@ -133,13 +139,14 @@ namespace e57
          return;
       }
 
-      // Reading
+      // Reading (or updating)
       try
       {
          // Open file for reading.
-         file_ = new CheckedFile( fileName_, CheckedFile::Read, checksumPolicy );
+         file_ = new CheckedFile( fileName_, isUpdater_ ? CheckedFile::Update : CheckedFile::Read,
+                                  checksumPolicy );
 
-         std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
+         std::shared_ptr<StructureNodeImpl> root( makeNode<StructureNodeImpl>() );
          root_ = root;
          root_->setAttachedRecursive();
 
@@ -159,18 +166,15 @@ namespace e57
 
       try
       {
-         // Create parser state, attach its event handers to the SAX2 reader
+         // Create parser state
          E57XmlParser parser( imf );
 
-         parser.init();
-
-         // Create input source (XML section of E57 file turned into a stream).
-         E57XmlFileInputSource xmlSection( file_, xmlLogicalOffset_, xmlLogicalLength_ );
+         parser.init( validateXml_, lazyNodeTree_ );
 
          unusedLogicalStart_ = sizeof( E57FileHeader );
 
-         // Do the parse, building up the node tree
-         parser.parse( xmlSection );
+         // Do the parse of the XML section, building up the node tree
+         parser.parse( file_, xmlLogicalOffset_, xmlLogicalLength_ );
       }
       catch ( ... )
       {
@@ -179,6 +183,26 @@ namespace e57
 
          throw;
       }
+
+      // When updating, the new XML section replaces the old one if it's at the end of the file.
+      // Otherwise it goes after the last page, leaving the old one unused.
+      if ( isUpdater_ )
+      {
+         const uint64_t xmlPhysicalEnd =
+            CheckedFile::logicalToPhysical( xmlLogicalOffset_ + xmlLogicalLength_ );
+         const uint64_t xmlPagesEnd = ( ( xmlPhysicalEnd + CheckedFile::physicalPageSize - 1 ) /
+                                        CheckedFile::physicalPageSize ) *
+                                      CheckedFile::physicalPageSize;
+
+         if ( xmlPagesEnd == file_->length( CheckedFile::Physical ) )
+         {
+            unusedLogicalStart_ = xmlLogicalOffset_;
+         }
+         else
+         {
+            unusedLogicalStart_ = file_->length( CheckedFile::Logical );
+         }
+      }
    }
 
    void ImageFileImpl::construct2( const char *input, const uint64_t size )
@@ -202,7 +226,7 @@ namespace e57
          // Open file for reading.
          file_ = new CheckedFile( input, size, checksumPolicy );
 
-         std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
+         std::shared_ptr<StructureNodeImpl> root( makeNode<StructureNodeImpl>() );
          root_ = root;
          root_->setAttachedRecursive();
 
@@ -222,18 +246,52 @@ namespace e57
 
       try
       {
-         // Create parser state, attach its event handers to the SAX2 reader
+         // Create parser state
          E57XmlParser parser( imf );
 
-         parser.init();
-
-         // Create input source (XML section of E57 file turned into a stream).
-         E57XmlFileInputSource xmlSection( file_, xmlLogicalOffset_, xmlLogicalLength_ );
+         parser.init( validateXml_, lazyNodeTree_ );
 
          unusedLogicalStart_ = sizeof( E57FileHeader );
 
-         // Do the parse, building up the node tree
-         parser.parse( xmlSection );
+         // Do the parse of the XML section, building up the node tree
+         parser.parse( file_, xmlLogicalOffset_, xmlLogicalLength_ );
+      }
+      catch ( ... )
+      {
+         delete file_;
+         file_ = nullptr;
+
+         throw;
+      }
+   }
+
+   void ImageFileImpl::construct2( std::shared_ptr<ImageFileSink> sink )
+   {
+      // Second phase of construction, now we have a well-formed ImageFile object.
+
+#ifdef E57_VERBOSE
+      std::cout << "ImageFileImpl() called, fileName=<ImageFileSink> mode=w" << std::endl;
+#endif
+      unusedLogicalStart_ = sizeof( E57FileHeader );
+      fileName_ = "<ImageFileSink>";
+
+      // Get shared_ptr to this object
+      ImageFileImplSharedPtr imf = shared_from_this();
+
+      isWriter_ = true;
+      file_ = nullptr;
+
+      try
+      {
+         // Write to the sink instead of a file
+         file_ = new CheckedFile( std::move( sink ) );
+
+         std::shared_ptr<StructureNodeImpl> root( makeNode<StructureNodeImpl>() );
+         root_ = root;
+         root_->setAttachedRecursive();
+
+         xmlLogicalOffset_ = 0;
+         xmlLogicalLength_ = 0;
       }
       catch ( ... )
       {
@@ -251,6 +309,18 @@ namespace e57
       return root_;
    }
 
+   NodeImplSharedPtr ImageFileImpl::copyNode( const NodeImplSharedPtr &source )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( !isWriter_ && !isUpdater_ )
+      {
+         throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
+      }
+
+      return source->copy( shared_from_this() );
+   }
+
    void ImageFileImpl::close()
    {
       // If file already closed, have nothing to do
@@ -259,16 +329,18 @@ namespace e57
          return;
       }
 
-      if ( isWriter_ )
+      if ( isWriter_ || isUpdater_ )
       {
          // Go to end of file, note physical position
          xmlLogicalOffset_ = unusedLogicalStart_;
          file_->seek( xmlLogicalOffset_, CheckedFile::Logical );
          uint64_t xmlPhysicalOffset = file_->position( CheckedFile::Physical );
-         *file_ << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+         XmlWriter xml( *file_ );
+         xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
 
          //??? need to add name space attributes to e57Root
-         root_->writeXml( shared_from_this(), *file_, 0, "e57Root" );
+         root_->writeXml( shared_from_this(), xml, 0, "e57Root" );
+         xml.flush();
 
          // Pad XML section so length is multiple of 4
          while ( ( file_->position( CheckedFile::Logical ) - xmlLogicalOffset_ ) % 4 != 0 )
@@ -279,6 +351,12 @@ namespace e57
          // Note logical length
          xmlLogicalLength_ = file_->position( CheckedFile::Logical ) - xmlLogicalOffset_;
 
+         // Cut off what is left of a longer XML section being replaced
+         if ( isUpdater_ )
+         {
+            file_->truncate( xmlLogicalOffset_ + xmlLogicalLength_ );
+         }
+
          // Init header contents
          E57FileHeader header;
 
@@ -303,6 +381,9 @@ namespace e57
 
       delete file_;
       file_ = nullptr;
+
+      // Nodes can't be built once the file is closed, so their XML isn't needed
+      std::vector<char>().swap( xmlText_ );
    }
 
    void ImageFileImpl::cancel()
@@ -338,11 +419,25 @@ namespace e57
       return isWriter_;
    }
 
+   bool ImageFileImpl::isUpdater() const
+   {
+      return isUpdater_;
+   }
+
    int ImageFileImpl::writerCount() const
    {
+      std::lock_guard<std::mutex> lock( writerMutex_ );
+
       return writerCount_;
    }
 
+   int ImageFileImpl::unstagedWriterCount() const
+   {
+      std::lock_guard<std::mutex> lock( writerMutex_ );
+
+      return writerCount_ - stagedWriterCount_;
+   }
+
    int ImageFileImpl::readerCount() const
    {
       return readerCount_;
@@ -662,17 +757,31 @@ namespace e57
 #endif
    }
 
-   void ImageFileImpl::incrWriterCount()
+   void ImageFileImpl::incrWriterCount( bool staged )
    {
+      std::lock_guard<std::mutex> lock( writerMutex_ );
+
       writerCount_++;
+
+      if ( staged )
+      {
+         stagedWriterCount_++;
+      }
    }
 
-   void ImageFileImpl::decrWriterCount()
+   void ImageFileImpl::decrWriterCount( bool staged )
    {
+      std::lock_guard<std::mutex> lock( writerMutex_ );
+
       writerCount_--;
 
+      if ( staged )
+      {
+         stagedWriterCount_--;
+      }
+
 #if ( E57_VALIDATION_LEVEL == VALIDATION_DEEP )
-      if ( writerCount_ < 0 )
+      if ( ( writerCount_ < 0 ) || ( stagedWriterCount_ < 0 ) )
       {
          throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ +
                                                  " writerCount=" + toString( writerCount_ ) +
@@ -869,6 +978,7 @@ namespace e57
       os << space( indent ) << "writerCount: " << writerCount_ << std::endl;
       os << space( indent ) << "readerCount: " << readerCount_ << std::endl;
       os << space( indent ) << "isWriter:    " << isWriter_ << std::endl;
+      os << space( indent ) << "isUpdater:   " << isUpdater_ << std::endl;
       for ( size_t i = 0; i < extensionsCount(); i++ )
       {
          os << space( indent ) << "nameSpace[" << i << "]: prefix=" << extensionsPrefix( i )
@@ -28,8 +28,10 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 
 #include "Common.h"
+#include "NodeArena.h"
 
 namespace e57
 {
@@ -41,18 +43,31 @@ namespace e57
    class ImageFileImpl : public std::enable_shared_from_this<ImageFileImpl>
    {
    public:
-      explicit ImageFileImpl( ReadChecksumPolicy policy );
+      explicit ImageFileImpl( ReadChecksumPolicy policy, bool validateXml = true,
+                             bool lazyNodeTree = false );
 
       void construct2( const ustring &fileName, const ustring &mode );
       void construct2( const char *input, uint64_t size );
+      void construct2( std::shared_ptr<ImageFileSink> sink );
 
       std::shared_ptr<StructureNodeImpl> root();
+      NodeImplSharedPtr copyNode( const NodeImplSharedPtr &source );
+
+      /// Make a node of this file, allocated from its arena. @a args are passed to the node's
+      /// constructor after the file.
+      template <typename T, typename... Args> std::shared_ptr<T> makeNode( Args &&...args )
+      {
+         return std::allocate_shared<T>( NodeArenaAllocator<T>( nodeArena_ ), shared_from_this(),
+                                         std::forward<Args>( args )... );
+      }
 
       void close();
       void cancel();
       bool isOpen() const;
       bool isWriter() const;
+      bool isUpdater() const;
       int writerCount() const;
+      int unstagedWriterCount() const;
       int readerCount() const;
       ~ImageFileImpl();
 
@@ -77,8 +92,8 @@ namespace e57
       void pathNameCheckWellFormed( const ustring &pathName );
       void pathNameParse( const ustring &pathName, bool &isRelative, StringList &fields );
 
-      void incrWriterCount();
-      void decrWriterCount();
+      void incrWriterCount( bool staged = false );
+      void decrWriterCount( bool staged = false );
       void incrReaderCount();
       void decrReaderCount();
 
@@ -96,6 +111,7 @@ namespace e57
    private:
       friend class E57XmlParser;
       friend class BlobNodeImpl;
+      friend class CompressedVectorNodeImpl;
       friend class CompressedVectorWriterImpl;
       friend class CompressedVectorReaderImpl;
 
@@ -106,10 +122,18 @@ namespace e57
 
       ustring fileName_;
       bool isWriter_;
+      bool isUpdater_; /// opened to update the XML section of an existing file ("u" mode)
       int writerCount_;
+      int stagedWriterCount_; /// open writers staging their section (included in writerCount_)
       int readerCount_;
 
+      /// Guards the writer counts and the placing of staged sections, which happens on whichever
+      /// thread closes their writers. Blobs hold it while they use the file too.
+      mutable std::mutex writerMutex_;
+
       ReadChecksumPolicy checksumPolicy;
+      bool validateXml_; /// have the XML parser validate the XML section when reading
+      bool lazyNodeTree_; /// build the node tree as it is used when reading (see xmlText_)
 
       CheckedFile *file_;
 
@@ -117,12 +141,18 @@ namespace e57
       uint64_t xmlLogicalOffset_;
       uint64_t xmlLogicalLength_;
 
+      /// XML section of a file read with a lazy node tree, which the rest of the tree is built from
+      std::vector<char> xmlText_;
+
       // Write file attributes
       uint64_t unusedLogicalStart_;
 
       /// Bidirectional map from namespace prefix to uri
       std::vector<NameSpace> nameSpaces_;
 
+      /// Memory the nodes are allocated from (see makeNode())
+      std::shared_ptr<NodeArena> nodeArena_;
+
       /// Smart pointer to metadata tree
       std::shared_ptr<StructureNodeImpl> root_;
    };
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+/// @file ImageFileSink.cpp
+
+#include <cstring>
+
+#include "Common.h"
+#include "StringFunctions.h"
+
+namespace e57
+{
+   void MemoryImageFileSink::write( uint64_t offset, const char *buffer, size_t count )
+   {
+      const uint64_t cEnd = offset + count;
+
+      if ( cEnd > data_.size() )
+      {
+         data_.resize( static_cast<size_t>( cEnd ) );
+      }
+
+      memcpy( data_.data() + offset, buffer, count );
+   }
+
+   void MemoryImageFileSink::read( uint64_t offset, char *buffer, size_t count )
+   {
+      if ( offset + count > data_.size() )
+      {
+         throw E57_EXCEPTION2( ErrorReadFailed, "offset=" + toString( offset ) +
+                                                   " count=" + toString( count ) +
+                                                   " length=" + toString( data_.size() ) );
+      }
+
+      memcpy( buffer, data_.data() + offset, count );
+   }
+
+   uint64_t MemoryImageFileSink::length() const
+   {
+      return data_.size();
+   }
+
+   const std::vector<char> &MemoryImageFileSink::data() const
+   {
+      return data_;
+   }
+
+   std::vector<char> MemoryImageFileSink::takeData()
+   {
+      std::vector<char> data;
+
+      data.swap( data_ );
+
+      return data;
+   }
+}
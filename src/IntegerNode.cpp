@@ -29,6 +29,7 @@
 
 /// @file IntegerNode.cpp
 
+#include "ImageFileImpl.h"
 #include "IntegerNodeImpl.h"
 #include "StringFunctions.h"
 
@@ -144,7 +145,7 @@ be true).
 */
 IntegerNode::IntegerNode( const ImageFile &destImageFile, int64_t value, int64_t minimum,
                           int64_t maximum ) :
-   impl_( new IntegerNodeImpl( destImageFile.impl(), value, minimum, maximum ) )
+   impl_( destImageFile.impl()->makeNode<IntegerNodeImpl>( value, minimum, maximum ) )
 {
    impl_->validateValue();
 }
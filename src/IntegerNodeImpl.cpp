@@ -26,8 +26,9 @@
  */
 
 #include "IntegerNodeImpl.h"
-#include "CheckedFile.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -117,7 +118,7 @@ namespace e57
       }
    }
 
-   void IntegerNodeImpl::writeXml( ImageFileImplSharedPtr /*imf???*/, CheckedFile &cf, int indent,
+   void IntegerNodeImpl::writeXml( ImageFileImplSharedPtr /*imf???*/, XmlWriter &xml, int indent,
                                    const char *forcedFieldName )
    {
       // don't checkImageFileOpen
@@ -132,29 +133,36 @@ namespace e57
          fieldName = elementName_;
       }
 
-      cf << space( indent ) << "<" << fieldName << " type=\"Integer\"";
+      xml.indent( indent ) << "<" << fieldName << " type=\"Integer\"";
 
       // Don't need to write if are default values
       if ( minimum_ != INT64_MIN )
       {
-         cf << " minimum=\"" << minimum_ << "\"";
+         xml << " minimum=\"" << minimum_ << "\"";
       }
       if ( maximum_ != INT64_MAX )
       {
-         cf << " maximum=\"" << maximum_ << "\"";
+         xml << " maximum=\"" << maximum_ << "\"";
       }
 
       // Write value as child text, unless it is the default value
       if ( value_ != 0 )
       {
-         cf << ">" << value_ << "</" << fieldName << ">\n";
+         xml << ">" << value_ << "</" << fieldName << ">\n";
       }
       else
       {
-         cf << "/>\n";
+         xml << "/>\n";
       }
    }
 
+   NodeImplSharedPtr IntegerNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      return destImageFile->makeNode<IntegerNodeImpl>( value_, minimum_, maximum_ );
+   }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
    void IntegerNodeImpl::dump( int indent, std::ostream &os ) const
    {
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#include <cstdint>
+
+#include "NodeArena.h"
+
+namespace e57
+{
+   namespace
+   {
+      /// Size of the blocks nodes are allocated from. Holds a few hundred nodes.
+      constexpr size_t cBlockSize = 64 * 1024;
+   }
+
+   void *NodeArena::allocate( size_t size, size_t alignment )
+   {
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      // Anything too big to share a block gets one of its own (blocks are aligned for any type)
+      if ( size > cBlockSize / 4 )
+      {
+         blocks_.emplace_back( new char[size] );
+
+         return blocks_.back().get();
+      }
+
+      size_t padding =
+         ( alignment - reinterpret_cast<uintptr_t>( next_ ) % alignment ) % alignment;
+
+      if ( padding + size > available_ )
+      {
+         blocks_.emplace_back( new char[cBlockSize] );
+
+         next_ = blocks_.back().get();
+         available_ = cBlockSize;
+         padding = 0;
+      }
+
+      void *memory = next_ + padding;
+
+      next_ += padding + size;
+      available_ -= padding + size;
+
+      return memory;
+   }
+}
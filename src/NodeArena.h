@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace e57
+{
+   /// Memory for the nodes of an ImageFile's tree. It is handed out from large blocks and only
+   /// freed, all at once, when the arena is destroyed, so making and destroying a node doesn't go
+   /// to the heap. The arena is shared by the file and each node allocated from it (see
+   /// NodeArenaAllocator), so node handles stay valid after the file is gone.
+   ///
+   /// Nodes which are made but never added to the tree keep their memory until then too.
+   class NodeArena
+   {
+   public:
+      NodeArena() = default;
+
+      NodeArena( const NodeArena & ) = delete;
+      NodeArena &operator=( const NodeArena & ) = delete;
+
+      /// Allocate @a size bytes aligned to @a alignment (which is at most alignof(max_align_t)).
+      /// Safe to call from several threads at once, which build parts of a lazy node tree.
+      void *allocate( size_t size, size_t alignment );
+
+   private:
+      std::mutex mutex_;
+
+      std::vector<std::unique_ptr<char[]>> blocks_;
+
+      /// Start of the unused part of the last block
+      char *next_ = nullptr;
+
+      /// Size of the unused part of the last block
+      size_t available_ = 0;
+   };
+
+   /// Allocator for std::allocate_shared() which allocates nodes, along with their reference
+   /// counts, from a NodeArena. Each allocation holds a reference to the arena.
+   template <typename T> class NodeArenaAllocator
+   {
+   public:
+      using value_type = T;
+
+      explicit NodeArenaAllocator( std::shared_ptr<NodeArena> arena ) noexcept :
+         arena_( std::move( arena ) )
+      {
+      }
+
+      template <typename U>
+      NodeArenaAllocator( const NodeArenaAllocator<U> &other ) noexcept : arena_( other.arena_ )
+      {
+      }
+
+      T *allocate( size_t n )
+      {
+         return static_cast<T *>( arena_->allocate( n * sizeof( T ), alignof( T ) ) );
+      }
+
+      void deallocate( T * /*p*/, size_t /*n*/ ) noexcept
+      {
+         // Freed along with the arena
+      }
+
+      template <typename U> bool operator==( const NodeArenaAllocator<U> &other ) const noexcept
+      {
+         return arena_ == other.arena_;
+      }
+
+      template <typename U> bool operator!=( const NodeArenaAllocator<U> &other ) const noexcept
+      {
+         return arena_ != other.arena_;
+      }
+
+   private:
+      template <typename U> friend class NodeArenaAllocator;
+
+      std::shared_ptr<NodeArena> arena_;
+   };
+}
@@ -31,7 +31,7 @@
 
 namespace e57
 {
-   class CheckedFile;
+   class XmlWriter;
 
    class NodeImpl : public std::enable_shared_from_this<NodeImpl>
    {
@@ -67,9 +67,12 @@ namespace e57
       void checkBuffers( const std::vector<SourceDestBuffer> &sdbufs, bool allowMissing );
       bool findTerminalPosition( const NodeImplSharedPtr &target, uint64_t &countFromLeft );
 
-      virtual void writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+      virtual void writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                              const char *forcedFieldName = nullptr ) = 0;
 
+      /// Make a copy of this node and its children in @a destImageFile (see ImageFile::copyNode())
+      virtual NodeImplSharedPtr copy( const ImageFileImplSharedPtr &destImageFile ) = 0;
+
       virtual ~NodeImpl() = default;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -29,6 +29,7 @@
 #include "ReaderImpl.h"
 #include "Common.h"
 #include "StringFunctions.h"
+#include "ThreadPool.h"
 
 namespace e57
 {
@@ -189,7 +190,9 @@ namespace e57
    }
 
    ReaderImpl::ReaderImpl( const ustring &filePath, const ReaderOptions &options ) :
-      imf_( filePath, "r", options.checksumPolicy ), root_( imf_.root() ),
+      imf_( filePath, ImageFileReadOptions{ options.checksumPolicy, options.validateXml,
+                                            options.lazyNodeTree } ),
+      root_( imf_.root() ),
       data3D_( root_.isDefined( "/data3D" ) ? root_.get( "/data3D" ) : VectorNode( imf_ ) ),
       images2D_( root_.isDefined( "/images2D" ) ? root_.get( "/images2D" ) : VectorNode( imf_ ) )
    {
@@ -265,6 +268,54 @@ namespace e57
       return true;
    }
 
+   bool ReaderImpl::ReadHeaders( E57Headers &headers, unsigned threadCount ) const
+   {
+      headers = {};
+
+      if ( !GetE57Root( headers.root ) )
+      {
+         return false;
+      }
+
+      const auto data3DCount = static_cast<size_t>( headers.root.data3DSize );
+      const auto images2DCount = static_cast<size_t>( headers.root.images2DSize );
+      const size_t taskCount = data3DCount + images2DCount;
+
+      headers.data3D.resize( data3DCount );
+      headers.images2D.resize( images2DCount );
+
+      // No point in having more threads than blocks
+      if ( threadCount == 0 )
+      {
+         threadCount = std::max( std::thread::hardware_concurrency(), 1U );
+      }
+      if ( threadCount > taskCount )
+      {
+         threadCount = static_cast<unsigned>( std::max<size_t>( taskCount, 1 ) );
+      }
+
+      // Each block is read by a single task, which is the only one to use its nodes, so with a
+      // lazy node tree each one's children are built on the thread reading it.
+      std::atomic<bool> readAll( true );
+
+      ThreadPool pool( threadCount );
+
+      pool.run( taskCount, [&]( size_t task ) {
+         const bool read =
+            ( task < data3DCount )
+               ? ReadData3D( static_cast<int64_t>( task ), headers.data3D[task] )
+               : ReadImage2D( static_cast<int64_t>( task - data3DCount ),
+                              headers.images2D[task - data3DCount] );
+
+         if ( !read )
+         {
+            readAll = false;
+         }
+      } );
+
+      return readAll;
+   }
+
    int64_t ReaderImpl::GetImage2DCount() const
    {
       return images2D_.childCount();
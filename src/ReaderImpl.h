@@ -51,6 +51,8 @@ namespace e57
 
       bool GetE57Root( E57Root &fileHeader ) const;
 
+      bool ReadHeaders( E57Headers &headers, unsigned threadCount ) const;
+
       int64_t GetImage2DCount() const;
 
       bool ReadImage2D( int64_t imageIndex, Image2D &Image2DHeader ) const;
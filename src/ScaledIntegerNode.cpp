@@ -29,6 +29,7 @@
 
 /// @file ScaledIntegerNode.cpp
 
+#include "ImageFileImpl.h"
 #include "ScaledIntegerNodeImpl.h"
 #include "StringFunctions.h"
 
@@ -150,25 +151,25 @@ be true).
 ScaledIntegerNode::ScaledIntegerNode( const ImageFile &destImageFile, int64_t rawValue,
                                       int64_t minimum, int64_t maximum, double scale,
                                       double offset ) :
-   impl_(
-      new ScaledIntegerNodeImpl( destImageFile.impl(), rawValue, minimum, maximum, scale, offset ) )
+   impl_( destImageFile.impl()->makeNode<ScaledIntegerNodeImpl>( rawValue, minimum, maximum, scale,
+                                                                 offset ) )
 {
    impl_->validateValue();
 }
 
 ScaledIntegerNode::ScaledIntegerNode( const ImageFile &destImageFile, int rawValue, int64_t minimum,
                                       int64_t maximum, double scale, double offset ) :
-   impl_( new ScaledIntegerNodeImpl( destImageFile.impl(), static_cast<int64_t>( rawValue ),
-                                     minimum, maximum, scale, offset ) )
+   impl_( destImageFile.impl()->makeNode<ScaledIntegerNodeImpl>(
+      static_cast<int64_t>( rawValue ), minimum, maximum, scale, offset ) )
 {
    impl_->validateValue();
 }
 
 ScaledIntegerNode::ScaledIntegerNode( const ImageFile &destImageFile, int rawValue, int minimum,
                                       int maximum, double scale, double offset ) :
-   impl_( new ScaledIntegerNodeImpl( destImageFile.impl(), static_cast<int64_t>( rawValue ),
-                                     static_cast<int64_t>( minimum ),
-                                     static_cast<int64_t>( maximum ), scale, offset ) )
+   impl_( destImageFile.impl()->makeNode<ScaledIntegerNodeImpl>(
+      static_cast<int64_t>( rawValue ), static_cast<int64_t>( minimum ),
+      static_cast<int64_t>( maximum ), scale, offset ) )
 {
    impl_->validateValue();
 }
@@ -212,8 +213,8 @@ be true).
 ScaledIntegerNode::ScaledIntegerNode( const ImageFile &destImageFile, double scaledValue,
                                       double scaledMinimum, double scaledMaximum, double scale,
                                       double offset ) :
-   impl_( new ScaledIntegerNodeImpl( destImageFile.impl(), scaledValue, scaledMinimum,
-                                     scaledMaximum, scale, offset ) )
+   impl_( destImageFile.impl()->makeNode<ScaledIntegerNodeImpl>( scaledValue, scaledMinimum,
+                                                                 scaledMaximum, scale, offset ) )
 {
    impl_->validateValue();
 }
@@ -27,9 +27,10 @@
 
 #include <cmath>
 
-#include "CheckedFile.h"
 #include "ScaledIntegerNodeImpl.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -177,7 +178,7 @@ namespace e57
       }
    }
 
-   void ScaledIntegerNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, CheckedFile &cf,
+   void ScaledIntegerNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, XmlWriter &xml,
                                          int indent, const char *forcedFieldName )
    {
       // don't checkImageFileOpen
@@ -192,37 +193,45 @@ namespace e57
          fieldName = elementName_;
       }
 
-      cf << space( indent ) << "<" << fieldName << " type=\"ScaledInteger\"";
+      xml.indent( indent ) << "<" << fieldName << " type=\"ScaledInteger\"";
 
       // Don't need to write if are default values
       if ( minimum_ != INT64_MIN )
       {
-         cf << " minimum=\"" << minimum_ << "\"";
+         xml << " minimum=\"" << minimum_ << "\"";
       }
       if ( maximum_ != INT64_MAX )
       {
-         cf << " maximum=\"" << maximum_ << "\"";
+         xml << " maximum=\"" << maximum_ << "\"";
       }
       if ( scale_ != 1.0 )
       {
-         cf << " scale=\"" << scale_ << "\"";
+         xml << " scale=\"" << scale_ << "\"";
       }
       if ( offset_ != 0.0 )
       {
-         cf << " offset=\"" << offset_ << "\"";
+         xml << " offset=\"" << offset_ << "\"";
       }
 
       // Write value as child text, unless it is the default value
       if ( value_ != 0 )
       {
-         cf << ">" << value_ << "</" << fieldName << ">\n";
+         xml << ">" << value_ << "</" << fieldName << ">\n";
       }
       else
       {
-         cf << "/>\n";
+         xml << "/>\n";
       }
    }
 
+   NodeImplSharedPtr ScaledIntegerNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      return destImageFile->makeNode<ScaledIntegerNodeImpl>( value_, minimum_, maximum_, scale_,
+                                                             offset_ );
+   }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
    void ScaledIntegerNodeImpl::dump( int indent, std::ostream &os ) const
    {
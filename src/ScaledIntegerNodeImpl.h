@@ -63,9 +63,11 @@ namespace e57
 
       void checkLeavesInSet( const StringSet &pathNames, NodeImplSharedPtr origin ) override;
 
-      void writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+      void writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                      const char *forcedFieldName = nullptr ) override;
 
+      NodeImplSharedPtr copy( const ImageFileImplSharedPtr &destImageFile ) override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
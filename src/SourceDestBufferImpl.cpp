@@ -25,7 +25,9 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "ImageFileImpl.h"
 #include "SourceDestBufferImpl.h"
@@ -33,6 +35,47 @@
 
 using namespace e57;
 
+namespace
+{
+   /// Read count elements of type T, stride bytes apart, converting each to int64_t.
+   template <typename T>
+   void gatherStrided( const char *p, size_t stride, size_t count, int64_t *values )
+   {
+      if ( stride == sizeof( T ) )
+      {
+         const T *src = reinterpret_cast<const T *>( p );
+         for ( size_t i = 0; i < count; ++i )
+         {
+            values[i] = static_cast<int64_t>( src[i] );
+         }
+         return;
+      }
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         values[i] = static_cast<int64_t>( *reinterpret_cast<const T *>( p + i * stride ) );
+      }
+   }
+
+   /// Replicate the element at p into the next count elements.
+   template <typename T> void fillStrided( char *p, size_t stride, size_t count )
+   {
+      const T value = *reinterpret_cast<const T *>( p );
+
+      if ( stride == sizeof( T ) )
+      {
+         T *first = reinterpret_cast<T *>( p + stride );
+         std::fill( first, first + count, value );
+         return;
+      }
+
+      for ( size_t i = 1; i <= count; ++i )
+      {
+         *reinterpret_cast<T *>( p + i * stride ) = value;
+      }
+   }
+}
+
 SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
                                             const ustring &pathName, const size_t capacity,
                                             bool doConversion, bool doScaling ) :
@@ -384,6 +427,73 @@ int64_t SourceDestBufferImpl::getNextInt64()
    return ( value );
 }
 
+void SourceDestBufferImpl::getNextInt64Block( int64_t *values, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   /// Same conversions as getNextInt64(), but the type dispatch and bounds check are done once
+   /// for the whole block.
+   if ( count > capacity_ - nextIndex_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal,
+                            "pathName=" + pathName_ + " count=" + toString( count ) );
+   }
+
+   const char *p = &base_[nextIndex_ * stride_];
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         gatherStrided<int8_t>( p, stride_, count, values );
+         break;
+      case UInt8:
+         gatherStrided<uint8_t>( p, stride_, count, values );
+         break;
+      case Int16:
+         gatherStrided<int16_t>( p, stride_, count, values );
+         break;
+      case UInt16:
+         gatherStrided<uint16_t>( p, stride_, count, values );
+         break;
+      case Int32:
+         gatherStrided<int32_t>( p, stride_, count, values );
+         break;
+      case UInt32:
+         gatherStrided<uint32_t>( p, stride_, count, values );
+         break;
+      case Int64:
+         gatherStrided<int64_t>( p, stride_, count, values );
+         break;
+      case Bool:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         gatherStrided<bool>( p, stride_, count, values );
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         gatherStrided<float>( p, stride_, count, values );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         gatherStrided<double>( p, stride_, count, values );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
 int64_t SourceDestBufferImpl::getNextInt64( double scale, double offset )
 {
    /// don't checkImageFileOpen
@@ -504,6 +614,153 @@ int64_t SourceDestBufferImpl::getNextInt64( double scale, double offset )
    return ( rawValue );
 }
 
+void SourceDestBufferImpl::getNextInt64Block( int64_t *values, size_t count, double scale,
+                                              double offset )
+{
+   /// don't checkImageFileOpen
+
+   /// Batch version of getNextInt64( scale, offset ). Each value is still calculated as
+   /// floor((x-offset)/scale + 0.5) - we keep the divide rather than multiplying by a reciprocal
+   /// since that does not always round the same way, and files must not change.
+
+   /// If the user did not request scaling, then we get raw values from user's buffer.
+   if ( !doScaling_ )
+   {
+      getNextInt64Block( values, count );
+      return;
+   }
+
+   /// Double check non-zero scale.  Going to divide by it below.
+   if ( scale == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   if ( count > capacity_ - nextIndex_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal,
+                            "pathName=" + pathName_ + " count=" + toString( count ) );
+   }
+
+   const char *p = &base_[nextIndex_ * stride_];
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         _quantizeBlock<int8_t>( p, count, scale, offset, values );
+         break;
+      case UInt8:
+         _quantizeBlock<uint8_t>( p, count, scale, offset, values );
+         break;
+      case Int16:
+         _quantizeBlock<int16_t>( p, count, scale, offset, values );
+         break;
+      case UInt16:
+         _quantizeBlock<uint16_t>( p, count, scale, offset, values );
+         break;
+      case Int32:
+         _quantizeBlock<int32_t>( p, count, scale, offset, values );
+         break;
+      case UInt32:
+         _quantizeBlock<uint32_t>( p, count, scale, offset, values );
+         break;
+      case Int64:
+         _quantizeBlock<int64_t>( p, count, scale, offset, values );
+         break;
+      case Bool:
+         _quantizeBlock<bool>( p, count, scale, offset, values );
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         _quantizeBlock<float>( p, count, scale, offset, values );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         _quantizeBlock<double>( p, count, scale, offset, values );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+template <typename T>
+void SourceDestBufferImpl::_quantizeBlock( const char *p, size_t count, double scale,
+                                           double offset, int64_t *values ) const
+{
+   /// Work in chunks so the intermediate doubles stay in a small local buffer.
+   constexpr size_t cChunkSize = 256;
+   double rounded[cChunkSize];
+
+   for ( size_t done = 0; done < count; done += cChunkSize )
+   {
+      const size_t n = std::min( cChunkSize, count - done );
+      const char *src = p + done * stride_;
+
+      /// Calc (x-offset)/scale + 0.5 for the chunk, tracking the range as we go. These loops
+      /// have no calls or branches in them, so they vectorize.
+      double lo = std::numeric_limits<double>::max();
+      double hi = std::numeric_limits<double>::lowest();
+
+      if ( stride_ == sizeof( T ) )
+      {
+         const T *typed = reinterpret_cast<const T *>( src );
+         for ( size_t i = 0; i < n; ++i )
+         {
+            rounded[i] = ( static_cast<double>( typed[i] ) - offset ) / scale + 0.5;
+            lo = std::min( lo, rounded[i] );
+            hi = std::max( hi, rounded[i] );
+         }
+      }
+      else
+      {
+         for ( size_t i = 0; i < n; ++i )
+         {
+            const T x = *reinterpret_cast<const T *>( src + i * stride_ );
+            rounded[i] = ( static_cast<double>( x ) - offset ) / scale + 0.5;
+            lo = std::min( lo, rounded[i] );
+            hi = std::max( hi, rounded[i] );
+         }
+      }
+
+      /// Make sure that values are representable in an int64_t. Since INT64_MIN and INT64_MAX
+      /// (as a double) are integers, checking before the floor gives the same answer as after.
+      if ( lo < INT64_MIN || hi > static_cast<double>( INT64_MAX ) )
+      {
+         for ( size_t i = 0; i < n; ++i )
+         {
+            const double doubleRawValue = std::floor( rounded[i] );
+
+            if ( doubleRawValue < INT64_MIN ||
+                 ( doubleRawValue > ( static_cast<double>( INT64_MAX ) ) ) )
+            {
+               throw E57_EXCEPTION2( ErrorScaledValueNotRepresentable,
+                                     "pathName=" + pathName_ +
+                                        " value=" + toString( doubleRawValue ) );
+            }
+         }
+      }
+
+      /// floor() without the library call: truncate, then step down if truncation went up
+      /// (negative non-integers).
+      for ( size_t i = 0; i < n; ++i )
+      {
+         auto rawValue = static_cast<int64_t>( rounded[i] );
+         rawValue -= ( static_cast<double>( rawValue ) > rounded[i] ) ? 1 : 0;
+         values[done + i] = rawValue;
+      }
+   }
+}
+
 float SourceDestBufferImpl::getNextFloat()
 {
    /// don't checkImageFileOpen
@@ -939,6 +1196,89 @@ void SourceDestBufferImpl::setNextInt64( int64_t value, double scale, double off
    nextIndex_++;
 }
 
+void SourceDestBufferImpl::fillNextInt64( int64_t value, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   if ( count == 0 )
+   {
+      return;
+   }
+
+   /// Verify have room for all of them before storing anything
+   if ( count > capacity_ - nextIndex_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal,
+                            "pathName=" + pathName_ + " count=" + toString( count ) );
+   }
+
+   /// Store the first one normally so all the range checks and conversions are done once, then
+   /// copy the stored representation into the rest.
+   setNextInt64( value );
+
+   _fillFromLast( count - 1 );
+}
+
+void SourceDestBufferImpl::fillNextInt64( int64_t value, double scale, double offset,
+                                          size_t count )
+{
+   /// don't checkImageFileOpen
+
+   if ( count == 0 )
+   {
+      return;
+   }
+
+   /// Verify have room for all of them before storing anything
+   if ( count > capacity_ - nextIndex_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal,
+                            "pathName=" + pathName_ + " count=" + toString( count ) );
+   }
+
+   setNextInt64( value, scale, offset );
+
+   _fillFromLast( count - 1 );
+}
+
+void SourceDestBufferImpl::_fillFromLast( size_t count )
+{
+   /// Caller has already stored one element and checked there is room for count more.
+   char *p = &base_[( nextIndex_ - 1 ) * stride_];
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+      case UInt8:
+         fillStrided<uint8_t>( p, stride_, count );
+         break;
+      case Int16:
+      case UInt16:
+         fillStrided<uint16_t>( p, stride_, count );
+         break;
+      case Int32:
+      case UInt32:
+         fillStrided<uint32_t>( p, stride_, count );
+         break;
+      case Int64:
+         fillStrided<int64_t>( p, stride_, count );
+         break;
+      case Bool:
+         fillStrided<bool>( p, stride_, count );
+         break;
+      case Real32:
+         fillStrided<float>( p, stride_, count );
+         break;
+      case Real64:
+         fillStrided<double>( p, stride_, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
 void SourceDestBufferImpl::setNextFloat( float value )
 {
    _setNextReal( value );
@@ -983,12 +1323,6 @@ void SourceDestBufferImpl::checkCompatible(
                             "memoryRepresentation=" + toString( memoryRepresentation_ ) +
                                " newMemoryType=" + toString( newBuf->memoryRepresentation() ) );
    }
-   if ( capacity_ != newBuf->capacity() )
-   {
-      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
-                            "capacity=" + toString( capacity_ ) +
-                               " newCapacity=" + toString( newBuf->capacity() ) );
-   }
    if ( doConversion_ != newBuf->doConversion() )
    {
       throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
@@ -101,11 +101,15 @@ namespace e57
 
       int64_t getNextInt64();
       int64_t getNextInt64( double scale, double offset );
+      void getNextInt64Block( int64_t *values, size_t count );
+      void getNextInt64Block( int64_t *values, size_t count, double scale, double offset );
       float getNextFloat();
       double getNextDouble();
       ustring getNextString();
       void setNextInt64( int64_t value );
       void setNextInt64( int64_t value, double scale, double offset );
+      void fillNextInt64( int64_t value, size_t count );
+      void fillNextInt64( int64_t value, double scale, double offset, size_t count );
       void setNextFloat( float value );
       void setNextDouble( double value );
       void setNextString( const ustring &value );
@@ -118,6 +122,10 @@ namespace e57
 
    private:
       template <typename T> void _setNextReal( T inValue );
+      void _fillFromLast( size_t count );
+      template <typename T>
+      void _quantizeBlock( const char *p, size_t count, double scale, double offset,
+                           int64_t *values ) const;
 
       /// Common routine to check that constructor arguments were ok, throws if not
       void checkState_() const;
@@ -1,65 +1,138 @@
 #include "StringFunctions.h"
 
-#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <locale>
 
 namespace e57
 {
+   namespace
+   {
+      inline bool isDigit( char c )
+      {
+         return ( c >= '0' ) && ( c <= '9' );
+      }
+   }
+
    template <class FTYPE> std::string floatingPointToStr( FTYPE value, int precision )
    {
       static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
 
-      std::stringstream ss;
-      ss.imbue( std::locale::classic() );
+      char buffer[cFloatingPointCharsMax];
 
-      ss << std::scientific << std::setprecision( precision ) << value;
+      return std::string( buffer, floatingPointToChars( buffer, value, precision ) );
+   }
 
-      // Try to remove trailing zeroes and decimal point
-      // e.g. 1.23456000000000000e+005  ==> 1.23456e+005
-      // e.g. 2.00000000000000000e+005  ==> 2e+005
+   template std::string floatingPointToStr<float>( float value, int precision );
+   template std::string floatingPointToStr<double>( double value, int precision );
 
-      std::string s = ss.str();
+   template <class FTYPE> size_t floatingPointToChars( char *buffer, FTYPE value, int precision )
+   {
+      static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
 
-      // Split into mantissa and exponent
-      // e.g. 1.23456000000000000e+005  ==> "1.23456000000000000" + "e+005"
-      auto index = s.find_last_of( 'e' );
-      assert( index != std::string::npos ); // should not be possible
+      // printf() formats the same way as a stream using std::scientific, but doesn't allocate.
+      // It uses the decimal point of the C locale though, so that is replaced with '.' below.
+      precision = std::min( std::max( precision, 0 ), 100 );
 
-      std::string mantissa = s.substr( 0, index );
-      const std::string exponent = s.substr( index );
+      char formatted[cFloatingPointCharsMax];
+      const int formattedLength = std::snprintf( formatted, sizeof( formatted ), "%.*e",
+                                                 precision, static_cast<double>( value ) );
 
-      // Double check that we understand the formatting
-      if ( exponent[0] == 'e' )
+      if ( !std::isfinite( value ) )
       {
-         // Trim trailing zeros from mantissa
-         while ( mantissa.back() == '0' )
+         memcpy( buffer, formatted, static_cast<size_t>( formattedLength ) );
+         return static_cast<size_t>( formattedLength );
+      }
+
+      const char *in = formatted;
+      char *out = buffer;
+
+      // Sign and first digit of the mantissa
+      if ( *in == '-' )
+      {
+         *out++ = *in++;
+      }
+      *out++ = *in++;
+
+      // Decimal point and the rest of the mantissa
+      if ( *in != 'e' )
+      {
+         while ( !isDigit( *in ) )
          {
-            mantissa.pop_back();
+            ++in;
          }
 
-         // Trim trailing decimal point if possible
-         if ( mantissa.back() == '.' )
+         *out++ = '.';
+
+         while ( isDigit( *in ) )
          {
-            mantissa.pop_back();
+            *out++ = *in++;
          }
 
-         // Reassemble whole floating point number
-         // Check if can drop exponent.
-         if ( ( exponent == "e+00" ) || ( exponent == "e+000" ) )
+         // Try to remove trailing zeroes and decimal point
+         // e.g. 1.23456000000000000e+005  ==> 1.23456e+005
+         // e.g. 2.00000000000000000e+005  ==> 2e+005
+         while ( out[-1] == '0' )
          {
-            s = mantissa;
+            --out;
          }
-         else
+
+         if ( out[-1] == '.' )
          {
-            s = mantissa + exponent;
+            --out;
          }
       }
 
-      return s;
+      // Drop the exponent if possible
+      const size_t exponentLength = static_cast<size_t>( formatted + formattedLength - in );
+
+      if ( ( exponentLength == 4 && memcmp( in, "e+00", 4 ) == 0 ) ||
+           ( exponentLength == 5 && memcmp( in, "e+000", 5 ) == 0 ) )
+      {
+         return static_cast<size_t>( out - buffer );
+      }
+
+      memcpy( out, in, exponentLength );
+
+      return static_cast<size_t>( out - buffer ) + exponentLength;
    }
 
-   template std::string floatingPointToStr<float>( float value, int precision );
-   template std::string floatingPointToStr<double>( double value, int precision );
+   template size_t floatingPointToChars<float>( char *buffer, float value, int precision );
+   template size_t floatingPointToChars<double>( char *buffer, double value, int precision );
+
+   size_t integerToChars( char *buffer, uint64_t value )
+   {
+      // Digits are generated from the end
+      char digits[cIntegerCharsMax];
+      char *first = digits + cIntegerCharsMax;
+
+      do
+      {
+         *--first = static_cast<char>( '0' + value % 10 );
+         value /= 10;
+      } while ( value != 0 );
+
+      const auto length = static_cast<size_t>( digits + cIntegerCharsMax - first );
+
+      memcpy( buffer, first, length );
+
+      return length;
+   }
+
+   size_t integerToChars( char *buffer, int64_t value )
+   {
+      if ( value >= 0 )
+      {
+         return integerToChars( buffer, static_cast<uint64_t>( value ) );
+      }
+
+      // Negate as unsigned so INT64_MIN doesn't overflow
+      buffer[0] = '-';
+
+      return 1 + integerToChars( buffer + 1, 0 - static_cast<uint64_t>( value ) );
+   }
 
    double strToDouble( const std::string &inStr )
    {
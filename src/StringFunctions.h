@@ -200,6 +200,30 @@ namespace e57
    extern template std::string floatingPointToStr<float>( float value, int precision );
    extern template std::string floatingPointToStr<double>( double value, int precision );
 
+   /// Room needed for the characters written by floatingPointToChars()
+   constexpr size_t cFloatingPointCharsMax = 128;
+
+   /// @brief Write a floating point number to @a buffer formatted as floatingPointToStr() does,
+   /// without allocating. @a buffer must have room for cFloatingPointCharsMax characters and isn't
+   /// null-terminated. Precision is limited to 100 digits.
+   /// @return The number of characters written.
+   template <class FTYPE> size_t floatingPointToChars( char *buffer, FTYPE value, int precision );
+
+   extern template size_t floatingPointToChars<float>( char *buffer, float value, int precision );
+   extern template size_t floatingPointToChars<double>( char *buffer, double value,
+                                                        int precision );
+
+   /// Room needed for the characters written by integerToChars()
+   constexpr size_t cIntegerCharsMax = 20;
+
+   /// @brief Write an integer to @a buffer in decimal, without allocating. @a buffer must have
+   /// room for cIntegerCharsMax characters and isn't null-terminated.
+   /// @return The number of characters written.
+   size_t integerToChars( char *buffer, uint64_t value );
+
+   /// @overload
+   size_t integerToChars( char *buffer, int64_t value );
+
    /// Parse a double according the the classic ("C") locale.
    /// @return The parsed double or 0.0 on error.
    double strToDouble( const std::string &inStr );
@@ -29,6 +29,7 @@
 
 /// @file StringNode.cpp
 
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
 #include "StringNodeImpl.h"
 
@@ -110,7 +111,7 @@ be true).
 @see StringNode::value, Node, CompressedVectorNode, CompressedVectorNode::prototype
 */
 StringNode::StringNode( const ImageFile &destImageFile, const ustring &value ) :
-   impl_( new StringNodeImpl( destImageFile.impl(), value ) )
+   impl_( destImageFile.impl()->makeNode<StringNodeImpl>( value ) )
 {
 }
 
@@ -26,8 +26,9 @@
  */
 
 #include "StringNodeImpl.h"
-#include "CheckedFile.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -78,7 +79,7 @@ namespace e57
       }
    }
 
-   void StringNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, CheckedFile &cf, int indent,
+   void StringNodeImpl::writeXml( ImageFileImplSharedPtr /*imf*/, XmlWriter &xml, int indent,
                                   const char *forcedFieldName )
    {
       // don't checkImageFileOpen
@@ -93,16 +94,16 @@ namespace e57
          fieldName = elementName_;
       }
 
-      cf << space( indent ) << "<" << fieldName << " type=\"String\"";
+      xml.indent( indent ) << "<" << fieldName << " type=\"String\"";
 
       // Write value as child text, unless it is the default value
       if ( value_.empty() )
       {
-         cf << "/>\n";
+         xml << "/>\n";
       }
       else
       {
-         cf << "><![CDATA[";
+         xml << "><![CDATA[";
 
          size_t currentPosition = 0;
          size_t len = value_.length();
@@ -116,24 +117,31 @@ namespace e57
             if ( found == std::string::npos )
             {
                // Didn't find any more "]]>", so can send the rest.
-               cf << value_.substr( currentPosition );
+               xml.write( value_.data() + currentPosition, len - currentPosition );
                break;
             }
 
             // Must output in two pieces, first send up to end of "]]"  (don't send the following
             // ">").
-            cf << value_.substr( currentPosition, found - currentPosition + 2 );
+            xml.write( value_.data() + currentPosition, found - currentPosition + 2 );
 
             // Then start a new CDATA
-            cf << "]]><![CDATA[";
+            xml << "]]><![CDATA[";
 
             // Keep looping to send the ">" plus the remaining part of the string
             currentPosition = found + 2;
          }
-         cf << "]]></" << fieldName << ">\n";
+         xml << "]]></" << fieldName << ">\n";
       }
    }
 
+   NodeImplSharedPtr StringNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      return destImageFile->makeNode<StringNodeImpl>( value_ );
+   }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
    void StringNodeImpl::dump( int indent, std::ostream &os ) const
    {
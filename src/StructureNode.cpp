@@ -29,6 +29,7 @@
 
 /// @file StructureNode.cpp
 
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
 #include "StructureNodeImpl.h"
 
@@ -133,7 +134,7 @@ be true).
 @see Node
 */
 StructureNode::StructureNode( const ImageFile &destImageFile ) :
-   impl_( new StructureNodeImpl( destImageFile.impl() ) )
+   impl_( destImageFile.impl()->makeNode<StructureNodeImpl>() )
 {
 }
 
@@ -236,6 +237,30 @@ bool StructureNode::isDefined( const ustring &pathName ) const
    return impl_->isDefined( pathName );
 }
 
+/*!
+@brief Is the given path defined relative to this node.
+
+@param [in] path The absolute path, or path relative to this object, to check.
+
+@details
+Same as isDefined(const ustring&) const, but the path name has already been checked and split into
+its element names, so it isn't parsed again.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@post No visible state is modified.
+
+@return true if path is currently defined.
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompiledPath, StructureNode::get(const CompiledPath&) const
+*/
+bool StructureNode::isDefined( const CompiledPath &path ) const
+{
+   return impl_->isDefined( path );
+}
+
 /*!
 @brief Get a child element by positional index.
 
@@ -290,6 +315,32 @@ Node StructureNode::get( const ustring &pathName ) const
    return Node( impl_->get( pathName ) );
 }
 
+/*!
+@brief Get a child by path.
+
+@param [in] path The absolute path, or path relative to this object, of the object to get.
+
+@details
+Same as get(const ustring&) const, but the path name has already been checked and split into its
+element names, so it isn't parsed again.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre The @a path must be defined (i.e. isDefined(path)).
+@post No visible state is modified.
+
+@return A smart Node handle referencing the child node.
+
+@throw ::ErrorPathUndefined
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompiledPath, StructureNode::isDefined(const CompiledPath&) const
+*/
+Node StructureNode::get( const CompiledPath &path ) const
+{
+   return Node( impl_->get( path ) );
+}
+
 /*!
 @brief Add a new child at a given path
 
@@ -338,6 +389,48 @@ void StructureNode::set( const ustring &pathName, const Node &n )
    impl_->set( pathName, n.impl(), false );
 }
 
+/*!
+@brief Replace the child at a given path with another node of the same type
+
+@param [in] pathName The absolute pathname, or pathname relative to this object, of the child to
+replace.
+@param [in] n The node to put in its place, with the same element name.
+
+@details
+Nodes can't be changed once they are set, so this is how the metadata of a file is edited, e.g. to
+give a scan a new name or pose. It is mostly useful with files opened in update mode (see
+ImageFile::ImageFile), whose XML section is rewritten when they are closed.
+
+The child keeps its place among its siblings. The node replaced is no longer part of the tree, and
+can't be added to it again.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre The associated destImageFile must have been opened in write or update mode.
+@pre The @a pathName must be defined (i.e. isDefined(pathName)), and be a child of a StructureNode
+in the tree of the ImageFile (not the root, an element of a VectorNode, or in the prototype of a
+CompressedVectorNode).
+@pre The child and @a n must be the same type, which can't be BlobNode or CompressedVectorNode.
+@pre The new node @a n must be a root node (i.e. n.isRoot()).
+@pre The associated destImageFile of this StructureNode and of @a n must be same (i.e.
+destImageFile() == n.destImageFile()).
+@post The @a pathName will be @a n (i.e. get(pathName) == n).
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorFileReadOnly
+@throw ::ErrorBadPathName
+@throw ::ErrorPathUndefined
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorAlreadyHasParent
+@throw ::ErrorDifferentDestImageFile
+@throw ::ErrorInternal All objects in undocumented state
+
+@see StructureNode::set
+*/
+void StructureNode::replace( const ustring &pathName, const Node &n )
+{
+   impl_->replace( pathName, n.impl() );
+}
+
 /*!
 @brief Diagnostic function to print internal state of object to output stream in an indented format.
 @copydetails Node::dump()
@@ -403,7 +496,7 @@ StructureNode::StructureNode( const Node &n )
 
 /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
 StructureNode::StructureNode( std::weak_ptr<ImageFileImpl> fileParent ) :
-   impl_( new StructureNodeImpl( fileParent ) )
+   impl_( ImageFileImplSharedPtr( fileParent )->makeNode<StructureNodeImpl>() )
 {
 }
 
@@ -25,21 +25,88 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <climits>
 
-#include "CheckedFile.h"
+#include "E57XmlParser.h"
 #include "ImageFileImpl.h"
 #include "StringFunctions.h"
 #include "StructureNodeImpl.h"
+#include "XmlWriter.h"
 
 using namespace e57;
 
+namespace
+{
+   /// Structures with at least this many children are indexed by element name
+   constexpr size_t cIndexedChildCount = 16;
+
+   // Whether elementName is a legal element name without an extension prefix, so it can be
+   // looked up as it is, rather than being parsed as a path name.
+   bool isPlainElementName( const ustring &elementName )
+   {
+      if ( elementName.empty() )
+      {
+         return false;
+      }
+
+      const char first = elementName[0];
+
+      if ( '0' <= first && first <= '9' )
+      {
+         return std::all_of( elementName.begin(), elementName.end(),
+                             []( char c ) { return '0' <= c && c <= '9'; } );
+      }
+
+      if ( !( ( 'a' <= first && first <= 'z' ) || ( 'A' <= first && first <= 'Z' ) ||
+              first == '_' ) )
+      {
+         return false;
+      }
+
+      return std::all_of( elementName.begin() + 1, elementName.end(), []( char c ) {
+         return ( 'a' <= c && c <= 'z' ) || ( 'A' <= c && c <= 'Z' ) || ( '0' <= c && c <= '9' ) ||
+                c == '_' || c == '-' || c == '.';
+      } );
+   }
+
+   // The name to give a copy of an element of sourceImageFile in destImageFile. The files may use
+   // different prefixes for an extension, so the prefix is looked up by the extension's URI.
+   ustring copiedElementName( const ImageFileImplSharedPtr &sourceImageFile,
+                              const ImageFileImplSharedPtr &destImageFile,
+                              const ustring &elementName )
+   {
+      if ( isPlainElementName( elementName ) )
+      {
+         return elementName;
+      }
+
+      ustring prefix;
+      ustring localPart;
+      ImageFileImpl::elementNameParse( elementName, prefix, localPart );
+
+      ustring uri;
+      ustring destPrefix;
+
+      if ( !sourceImageFile->extensionsLookupPrefix( prefix, uri ) ||
+           !destImageFile->extensionsLookupUri( uri, destPrefix ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadPathName, "elementName=" + elementName + " uri=" + uri +
+                                                    " fileName=" + destImageFile->fileName() );
+      }
+
+      return destPrefix.empty() ? localPart : ( destPrefix + ":" + localPart );
+   }
+}
+
 StructureNodeImpl::StructureNodeImpl( ImageFileImplWeakPtr destImageFile ) :
-   NodeImpl( destImageFile )
+   NodeImpl( destImageFile ), buildingLazyChildren_( false )
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 }
 
+StructureNodeImpl::~StructureNodeImpl() = default;
+
 NodeType StructureNodeImpl::type() const
 {
    // don't checkImageFileOpen
@@ -103,6 +170,13 @@ bool StructureNodeImpl::isDefined( const ustring &pathName )
    return ( ni != nullptr );
 }
 
+bool StructureNodeImpl::isDefined( const CompiledPath &path )
+{
+   checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+   NodeImplSharedPtr ni( lookup( path.isRelative_, path.elementNames_, 0 ) );
+   return ( ni != nullptr );
+}
+
 void StructureNodeImpl::setAttachedRecursive()
 {
    // Mark this node as attached to an ImageFile
@@ -119,12 +193,17 @@ int64_t StructureNodeImpl::childCount() const
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
+   // Building the children doesn't change the node as far as callers can tell
+   const_cast<StructureNodeImpl *>( this )->buildChildren();
+
    return children_.size();
 }
 
 NodeImplSharedPtr StructureNodeImpl::get( int64_t index )
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+   buildChildren();
+
    if ( index < 0 || index >= static_cast<int64_t>( children_.size() ) )
    { // %%% Possible truncation on platforms where size_t = uint64
       throw E57_EXCEPTION2( ErrorChildIndexOutOfBounds,
@@ -147,67 +226,178 @@ NodeImplSharedPtr StructureNodeImpl::get( const ustring &pathName )
    return ( ni );
 }
 
+NodeImplSharedPtr StructureNodeImpl::get( const CompiledPath &path )
+{
+   checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+   NodeImplSharedPtr ni( lookup( path.isRelative_, path.elementNames_, 0 ) );
+
+   if ( !ni )
+   {
+      throw E57_EXCEPTION2( ErrorPathUndefined,
+                            "this->pathName=" + this->pathName() + " pathName=" + path.pathName_ );
+   }
+   return ( ni );
+}
+
 NodeImplSharedPtr StructureNodeImpl::lookup( const ustring &pathName )
 {
    // don't checkImageFileOpen
-   //??? use lookup(fields, level) instead, for speed.
+
+   // Most lookups are of a child by name, which doesn't need to be split up
+   if ( isPlainElementName( pathName ) )
+   {
+      return findChild( pathName );
+   }
+
    bool isRelative;
    std::vector<ustring> fields;
    ImageFileImplSharedPtr imf( destImageFile_ );
    imf->pathNameParse( pathName, isRelative, fields ); // throws if bad pathName
 
-   if ( isRelative || isRoot() )
+   return lookup( isRelative, fields, 0 );
+}
+
+// Look up the path made of elementNames from level on.
+NodeImplSharedPtr StructureNodeImpl::lookup( bool isRelative, const StringList &elementNames,
+                                             size_t level )
+{
+   // don't checkImageFileOpen
+
+   if ( !isRelative && !isRoot() )
    {
-      if ( fields.empty() )
-      {
-         if ( isRelative )
-         {
-            return {}; // empty pointer
-         }
+      // Absolute pathname and we aren't at the root, so look it up from the root of the tree
+      // (whose nodes all have structures or vectors as parents)
+      std::shared_ptr<StructureNodeImpl> root(
+         std::static_pointer_cast<StructureNodeImpl>( getRoot() ) );
 
-         NodeImplSharedPtr root( getRoot() );
-         return ( root );
+      return root->lookup( isRelative, elementNames, level );
+   }
+
+   if ( level == elementNames.size() )
+   {
+      if ( isRelative )
+      {
+         return {}; // empty pointer
       }
 
-      // Find child with elementName that matches first field in path
-      unsigned i;
-      for ( i = 0; i < children_.size(); i++ )
+      return shared_from_this();
+   }
+
+   NodeImplSharedPtr child( findChild( elementNames[level] ) );
+
+   if ( !child || ( level == elementNames.size() - 1 ) )
+   {
+      return child;
+   }
+
+   // Only structures and vectors have children to look in
+   if ( ( child->type() != TypeStructure ) && ( child->type() != TypeVector ) )
+   {
+      return {}; // empty pointer
+   }
+
+   return std::static_pointer_cast<StructureNodeImpl>( child )->lookup( true, elementNames,
+                                                                        level + 1 );
+}
+
+// Find the child with the element name, or return an empty pointer.
+NodeImplSharedPtr StructureNodeImpl::findChild( const ustring &elementName )
+{
+   buildChildren();
+
+   // The children of vectors are named by their index
+   if ( ( type() == TypeVector ) && !elementName.empty() && ( elementName[0] != '0' ) &&
+        std::all_of( elementName.begin(), elementName.end(),
+                     []( char c ) { return '0' <= c && c <= '9'; } ) )
+   {
+      size_t index = 0;
+
+      for ( const char c : elementName )
       {
-         if ( fields.at( 0 ) == children_.at( i )->elementName() )
+         index = index * 10 + static_cast<size_t>( c - '0' );
+
+         if ( index >= children_.size() )
          {
             break;
          }
       }
-      if ( i == children_.size() )
+
+      if ( ( index < children_.size() ) && ( children_[index]->elementName_ == elementName ) )
       {
-         return {}; // empty pointer
+         return children_[index];
       }
+   }
 
-      if ( fields.size() == 1 )
+   if ( children_.size() < cIndexedChildCount )
+   {
+      for ( const auto &child : children_ )
       {
-         return ( children_.at( i ) );
+         if ( child->elementName_ == elementName )
+         {
+            return child;
+         }
       }
 
-      //??? use level here rather than unparse
-      // Remove first field in path
-      fields.erase( fields.begin() );
+      return {}; // empty pointer
+   }
 
-      // Call lookup on child object with remaining fields in path name
-      return children_.at( i )->lookup( imf->pathNameUnparse( true, fields ) );
+   if ( childIndex_.empty() )
+   {
+      childIndex_.reserve( children_.size() );
+
+      for ( size_t i = 0; i < children_.size(); ++i )
+      {
+         childIndex_.emplace( &children_[i]->elementName_, i );
+      }
    }
 
-   // Absolute pathname and we aren't at the root
-   // Find root of the tree
-   NodeImplSharedPtr root( getRoot() );
+   const auto found = childIndex_.find( &elementName );
 
-   // Call lookup on root
-   return ( root->lookup( pathName ) );
+   if ( found == childIndex_.end() )
+   {
+      return {}; // empty pointer
+   }
+
+   return children_[found->second];
+}
+
+void StructureNodeImpl::addChild( const NodeImplSharedPtr &ni )
+{
+   children_.push_back( ni );
+
+   // The index is built the first time it's needed, then kept up to date
+   if ( !childIndex_.empty() )
+   {
+      childIndex_.emplace( &ni->elementName_, children_.size() - 1 );
+   }
+}
+
+void StructureNodeImpl::replaceChild( const NodeImplSharedPtr &existing,
+                                      const NodeImplSharedPtr &ni )
+{
+   const auto found = std::find( children_.begin(), children_.end(), existing );
+
+   if ( found == children_.end() )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "this->pathName=" + this->pathName() );
+   }
+
+   *found = ni;
+
+   if ( !childIndex_.empty() )
+   {
+      childIndex_.erase( &existing->elementName_ );
+      childIndex_.emplace( &ni->elementName_,
+                           static_cast<size_t>( found - children_.begin() ) );
+   }
 }
 
 void StructureNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
+   buildChildren();
+
    auto index = static_cast<unsigned>( index64 );
 
    // Allow index == current number of elements, interpret as append
@@ -239,14 +429,15 @@ void StructureNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
    std::stringstream elementName;
    elementName << index;
 
-   // If this struct is type constrained, can't add new child
-   if ( isTypeConstrained() )
+   // If this struct is type constrained, can't add new child (children built from the XML were
+   // already in the file, so don't change its type)
+   if ( !buildingLazyChildren_ && isTypeConstrained() )
    {
       throw E57_EXCEPTION2( ErrorHomogeneousViolation, "this->pathName=" + this->pathName() );
    }
 
    ni->setParent( shared_from_this(), elementName.str() );
-   children_.push_back( ni );
+   addChild( ni );
 }
 
 void StructureNodeImpl::set( const ustring &pathName, NodeImplSharedPtr ni, bool autoPathCreate )
@@ -302,28 +493,28 @@ void StructureNodeImpl::set( const std::vector<ustring> &fields, unsigned level,
       throw E57_EXCEPTION2( ErrorSetTwice, "this->pathName=" + this->pathName() + " element=/" );
    }
 
-   // Serial search for matching field name, if find match, have error since can't set twice
-   for ( auto &child : children_ )
+   // Look for matching field name, if find match, have error since can't set twice
+   NodeImplSharedPtr existing( findChild( fields.at( level ) ) );
+
+   if ( existing )
    {
-      if ( fields.at( level ) == child->elementName() )
+      if ( level == fields.size() - 1 )
       {
-         if ( level == fields.size() - 1 )
-         {
-            // Enforce "set once" policy, don't allow reset
-            throw E57_EXCEPTION2( ErrorSetTwice, "this->pathName=" + this->pathName() +
-                                                    " element=" + fields[level] );
-         }
+         // Enforce "set once" policy, don't allow reset
+         throw E57_EXCEPTION2( ErrorSetTwice, "this->pathName=" + this->pathName() +
+                                                 " element=" + fields[level] );
+      }
 
-         // Recurse on child
-         child->set( fields, level + 1, ni );
+      // Recurse on child
+      existing->set( fields, level + 1, ni );
 
-         return;
-      }
+      return;
    }
    // Didn't find matching field name, so have a new child.
 
-   // If this struct is type constrained, can't add new child
-   if ( isTypeConstrained() )
+   // If this struct is type constrained, can't add new child (children built from the XML were
+   // already in the file, so don't change its type)
+   if ( !buildingLazyChildren_ && isTypeConstrained() )
    {
       throw E57_EXCEPTION2( ErrorHomogeneousViolation, "this->pathName=" + this->pathName() );
    }
@@ -333,7 +524,7 @@ void StructureNodeImpl::set( const std::vector<ustring> &fields, unsigned level,
    {
       // At bottom, so append node at end of children
       ni->setParent( shared_from_this(), fields.at( level ) );
-      children_.push_back( ni );
+      addChild( ni );
    }
    else
    {
@@ -346,10 +537,11 @@ void StructureNodeImpl::set( const std::vector<ustring> &fields, unsigned level,
       //??? what if extra fields are numbers?
 
       // Do autoPathCreate: Create nested Struct objects for extra field names in path
+      ImageFileImplSharedPtr imf( destImageFile_ );
       NodeImplSharedPtr parent( shared_from_this() );
       for ( ; level != fields.size() - 1; level++ )
       {
-         std::shared_ptr<StructureNodeImpl> child( new StructureNodeImpl( destImageFile_ ) );
+         std::shared_ptr<StructureNodeImpl> child( imf->makeNode<StructureNodeImpl>() );
          parent->set( fields.at( level ), child );
          parent = child;
       }
@@ -357,6 +549,55 @@ void StructureNodeImpl::set( const std::vector<ustring> &fields, unsigned level,
    }
 }
 
+void StructureNodeImpl::replace( const ustring &pathName, NodeImplSharedPtr ni )
+{
+   checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+   ImageFileImplSharedPtr imf( destImageFile_ );
+
+   if ( !imf->isWriter() && !imf->isUpdater() )
+   {
+      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + imf->fileName() );
+   }
+
+   NodeImplSharedPtr existing( get( pathName ) ); // throws if not defined
+
+   // Only the children of structures in the file's tree can be replaced (not the root, elements
+   // of vectors, or nodes in the prototype of a CompressedVector)
+   NodeImplSharedPtr parent( existing->parent() );
+
+   if ( existing->isRoot() || ( parent->type() != TypeStructure ) ||
+        ( existing->getRoot() != imf->root() ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadPathName,
+                            "this->pathName=" + this->pathName() + " pathName=" + pathName );
+   }
+
+   ImageFileImplSharedPtr niDest( ni->destImageFile() );
+
+   if ( imf != niDest )
+   {
+      throw E57_EXCEPTION2( ErrorDifferentDestImageFile, "this->destImageFile" + imf->fileName() +
+                                                            " ni->destImageFile" +
+                                                            niDest->fileName() );
+   }
+
+   // The replacement must be the same type, and not refer to a binary section
+   const NodeType existingType = existing->type();
+
+   if ( ( ni->type() != existingType ) || ( existingType == TypeBlob ) ||
+        ( existingType == TypeCompressedVector ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + existing->pathName() +
+                                                    " type=" + toString( existingType ) +
+                                                    " ni->type=" + toString( ni->type() ) );
+   }
+
+   ni->setParent( parent, existing->elementName() );
+
+   std::static_pointer_cast<StructureNodeImpl>( parent )->replaceChild( existing, ni );
+}
+
 void StructureNodeImpl::append( NodeImplSharedPtr ni )
 {
    // don't checkImageFileOpen, set() will do it
@@ -370,6 +611,8 @@ void StructureNodeImpl::checkLeavesInSet( const StringSet &pathNames, NodeImplSh
 {
    // don't checkImageFileOpen
 
+   buildChildren();
+
    // Not a leaf node, so check all our children
    for ( auto &child : children_ )
    {
@@ -377,12 +620,57 @@ void StructureNodeImpl::checkLeavesInSet( const StringSet &pathNames, NodeImplSh
    }
 }
 
+void StructureNodeImpl::setLazyContent( std::unique_ptr<E57XmlLazyContent> content )
+{
+   lazyContent_ = std::move( content );
+}
+
+bool StructureNodeImpl::hasLazyChildren( const NodeImplSharedPtr &ni )
+{
+   if ( ( ni->type() != TypeStructure ) && ( ni->type() != TypeVector ) )
+   {
+      return false;
+   }
+
+   return static_cast<const StructureNodeImpl *>( ni.get() )->lazyContent_ != nullptr;
+}
+
+void StructureNodeImpl::buildLazyChildren()
+{
+   checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+   // Take the content, so adding the children doesn't try to build them again
+   std::unique_ptr<E57XmlLazyContent> content( std::move( lazyContent_ ) );
+
+   buildingLazyChildren_ = true;
+
+   try
+   {
+      E57XmlParser::buildLazyChildren(
+         std::static_pointer_cast<StructureNodeImpl>( shared_from_this() ), *content );
+   }
+   catch ( ... )
+   {
+      // Leave the node as it was
+      children_.clear();
+      childIndex_.clear();
+      lazyContent_ = std::move( content );
+      buildingLazyChildren_ = false;
+
+      throw;
+   }
+
+   buildingLazyChildren_ = false;
+}
+
 //??? use visitor?
-void StructureNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+void StructureNodeImpl::writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                                   const char *forcedFieldName )
 {
    // don't checkImageFileOpen
 
+   buildChildren();
+
    ustring fieldName;
    if ( forcedFieldName != nullptr )
    {
@@ -393,7 +681,7 @@ void StructureNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, i
       fieldName = elementName_;
    }
 
-   cf << space( indent ) << "<" << fieldName << " type=\"Structure\"";
+   xml.indent( indent ) << "<" << fieldName << " type=\"Structure\"";
 
    const int numSpaces = indent + static_cast<int>( fieldName.length() ) + 2;
 
@@ -418,44 +706,66 @@ void StructureNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, i
 
          const int index = static_cast<int>( i );
 
-         cf << "\n"
-            << space( numSpaces ) << xmlnsExtension << imf->extensionsPrefix( index ) << "=\""
-            << imf->extensionsUri( index ) << "\"";
+         xml << "\n";
+         xml.indent( numSpaces ) << xmlnsExtension << imf->extensionsPrefix( index ) << "=\""
+                                 << imf->extensionsUri( index ) << "\"";
       }
 
       // If user didn't explicitly declare a default namespace, use the current E57 standard one.
       if ( !gotDefaultNamespace )
       {
-         cf << "\n" << space( numSpaces ) << "xmlns=\"" << VERSION_1_0_URI << "\"";
+         xml << "\n";
+         xml.indent( numSpaces ) << "xmlns=\"" << VERSION_1_0_URI << "\"";
       }
    }
    if ( !children_.empty() )
    {
-      cf << ">\n";
+      xml << ">\n";
 
       // Write all children nested inside Structure element
       for ( auto &child : children_ )
       {
-         child->writeXml( imf, cf, indent + 2 );
+         child->writeXml( imf, xml, indent + 2 );
       }
 
       // Write closing tag
-      cf << space( indent ) << "</" << fieldName << ">\n";
+      xml.indent( indent ) << "</" << fieldName << ">\n";
    }
    else
    {
       // XML element has no child elements
-      cf << "/>\n";
+      xml << "/>\n";
    }
 }
 
 //??? use visitor?
+NodeImplSharedPtr StructureNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+{
+   ImageFileImplSharedPtr imf( destImageFile_ );
+   std::shared_ptr<StructureNodeImpl> si( destImageFile->makeNode<StructureNodeImpl>() );
+
+   const int64_t cChildCount = childCount();
+
+   for ( int64_t i = 0; i < cChildCount; ++i )
+   {
+      NodeImplSharedPtr child( get( i ) );
+
+      si->set( copiedElementName( imf, destImageFile, child->elementName() ),
+               child->copy( destImageFile ) );
+   }
+
+   return si;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void StructureNodeImpl::dump( int indent, std::ostream &os ) const
 {
    // don't checkImageFileOpen
    os << space( indent ) << "type:        Structure" << " (" << type() << ")" << std::endl;
    NodeImpl::dump( indent, os );
+
+   const_cast<StructureNodeImpl *>( this )->buildChildren();
+
    for ( unsigned i = 0; i < children_.size(); i++ )
    {
       os << space( indent ) << "child[" << i << "]:" << std::endl;
@@ -27,26 +27,31 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include "NodeImpl.h"
 
 namespace e57
 {
+   struct E57XmlLazyContent;
 
    class StructureNodeImpl : public NodeImpl
    {
    public:
       explicit StructureNodeImpl( ImageFileImplWeakPtr destImageFile );
-      ~StructureNodeImpl() override = default;
+      ~StructureNodeImpl() override;
 
       NodeType type() const override;
       bool isTypeEquivalent( NodeImplSharedPtr ni ) override;
       bool isDefined( const ustring &pathName ) override;
+      bool isDefined( const CompiledPath &path );
       void setAttachedRecursive() override;
 
       virtual int64_t childCount() const;
 
       virtual NodeImplSharedPtr get( int64_t index );
       NodeImplSharedPtr get( const ustring &pathName ) override;
+      NodeImplSharedPtr get( const CompiledPath &path );
 
       virtual void set( int64_t index, NodeImplSharedPtr ni );
       void set( const ustring &pathName, NodeImplSharedPtr ni,
@@ -54,12 +59,21 @@ namespace e57
       void set( const StringList &fields, unsigned level, NodeImplSharedPtr ni,
                 bool autoPathCreate = false ) override;
       virtual void append( NodeImplSharedPtr ni );
+      void replace( const ustring &pathName, NodeImplSharedPtr ni );
 
       void checkLeavesInSet( const StringSet &pathNames, NodeImplSharedPtr origin ) override;
 
-      void writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+      /// Leave the children to be built from the XML the first time they're needed
+      void setLazyContent( std::unique_ptr<E57XmlLazyContent> content );
+
+      /// Whether @a ni is a structure or vector whose children haven't been built yet
+      static bool hasLazyChildren( const NodeImplSharedPtr &ni );
+
+      void writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                      const char *forcedFieldName = nullptr ) override;
 
+      NodeImplSharedPtr copy( const ImageFileImplSharedPtr &destImageFile ) override;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
@@ -68,7 +82,47 @@ namespace e57
       friend class CompressedVectorReaderImpl;
 
       NodeImplSharedPtr lookup( const ustring &pathName ) override;
+      NodeImplSharedPtr lookup( bool isRelative, const StringList &elementNames, size_t level );
+
+      NodeImplSharedPtr findChild( const ustring &elementName );
+      void addChild( const NodeImplSharedPtr &ni );
+      void replaceChild( const NodeImplSharedPtr &existing, const NodeImplSharedPtr &ni );
+
+      /// Build the children if they were left until needed
+      void buildChildren()
+      {
+         if ( lazyContent_ )
+         {
+            buildLazyChildren();
+         }
+      }
 
       std::vector<NodeImplSharedPtr> children_;
+
+   private:
+      void buildLazyChildren();
+
+      struct ElementNameHash
+      {
+         size_t operator()( const ustring *name ) const
+         {
+            return std::hash<ustring>()( *name );
+         }
+      };
+
+      struct ElementNameEqual
+      {
+         bool operator()( const ustring *lhs, const ustring *rhs ) const
+         {
+            return *lhs == *rhs;
+         }
+      };
+
+      /// Index into children_ by the children's element names, kept for structures with many
+      /// children (see findChild())
+      std::unordered_map<const ustring *, size_t, ElementNameHash, ElementNameEqual> childIndex_;
+
+      std::unique_ptr<E57XmlLazyContent> lazyContent_; /// XML of children not built yet
+      bool buildingLazyChildren_;
    };
 }
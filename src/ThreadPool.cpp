@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace e57
+{
+   ThreadPool::ThreadPool( unsigned threadCount )
+   {
+      if ( threadCount == 0 )
+      {
+         threadCount = std::max( std::thread::hardware_concurrency(), 1U );
+      }
+
+      // The thread calling run() is one of the threads
+      workers_.reserve( threadCount - 1 );
+
+      for ( unsigned i = 1; i < threadCount; ++i )
+      {
+         workers_.emplace_back( &ThreadPool::workerLoop, this );
+      }
+   }
+
+   ThreadPool::~ThreadPool()
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+         stopping_ = true;
+      }
+
+      startCondition_.notify_all();
+
+      for ( auto &worker : workers_ )
+      {
+         worker.join();
+      }
+   }
+
+   unsigned ThreadPool::threadCount() const
+   {
+      return static_cast<unsigned>( workers_.size() + 1 );
+   }
+
+   void ThreadPool::run( size_t taskCount, const Task &task )
+   {
+      if ( taskCount == 0 )
+      {
+         return;
+      }
+
+      // Nothing to gain from waking the workers
+      if ( workers_.empty() || taskCount == 1 )
+      {
+         for ( size_t i = 0; i < taskCount; ++i )
+         {
+            task( i );
+         }
+
+         return;
+      }
+
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         task_ = &task;
+         taskCount_ = taskCount;
+         nextTask_ = 0;
+         errors_.assign( taskCount, nullptr );
+
+         busyWorkers_ = workers_.size();
+         ++batch_;
+      }
+
+      startCondition_.notify_all();
+
+      runTasks();
+
+      {
+         std::unique_lock<std::mutex> lock( mutex_ );
+         doneCondition_.wait( lock, [this] { return busyWorkers_ == 0; } );
+
+         task_ = nullptr;
+      }
+
+      for ( const auto &error : errors_ )
+      {
+         if ( error != nullptr )
+         {
+            std::rethrow_exception( error );
+         }
+      }
+   }
+
+   void ThreadPool::workerLoop()
+   {
+      uint64_t lastBatch = 0;
+
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      while ( true )
+      {
+         startCondition_.wait( lock, [&] { return stopping_ || ( batch_ != lastBatch ); } );
+
+         if ( stopping_ )
+         {
+            return;
+         }
+
+         lastBatch = batch_;
+
+         lock.unlock();
+         runTasks();
+         lock.lock();
+
+         if ( --busyWorkers_ == 0 )
+         {
+            doneCondition_.notify_one();
+         }
+      }
+   }
+
+   void ThreadPool::runTasks()
+   {
+      // Tasks can be of very different sizes, so hand them out one at a time
+      while ( true )
+      {
+         const size_t taskIndex = nextTask_.fetch_add( 1 );
+
+         if ( taskIndex >= taskCount_ )
+         {
+            return;
+         }
+
+         try
+         {
+            ( *task_ )( taskIndex );
+         }
+         catch ( ... )
+         {
+            errors_[taskIndex] = std::current_exception();
+         }
+      }
+   }
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace e57
+{
+   /// A fixed set of worker threads which run a batch of independent, indexed tasks and wait for
+   /// all of them to finish. The calling thread does its share of the work too.
+   class ThreadPool
+   {
+   public:
+      using Task = std::function<void( size_t taskIndex )>;
+
+      /// @param threadCount Total number of threads to run tasks on, including the caller.
+      /// 0 means one per hardware thread.
+      explicit ThreadPool( unsigned threadCount );
+      ~ThreadPool();
+
+      ThreadPool( const ThreadPool & ) = delete;
+      ThreadPool &operator=( const ThreadPool & ) = delete;
+
+      /// Total number of threads tasks are run on, including the caller
+      unsigned threadCount() const;
+
+      /// Run task( i ) for each i in [0, taskCount) and return once they have all finished.
+      /// If any of them throw, the exception from the lowest task index is rethrown.
+      void run( size_t taskCount, const Task &task );
+
+   private:
+      void workerLoop();
+      void runTasks();
+
+      std::vector<std::thread> workers_;
+
+      std::mutex mutex_;
+      std::condition_variable startCondition_;
+      std::condition_variable doneCondition_;
+
+      // State of the current batch. Only changed by run() while no worker is busy.
+      const Task *task_ = nullptr;
+      size_t taskCount_ = 0;
+      std::atomic<size_t> nextTask_{ 0 };
+      std::vector<std::exception_ptr> errors_;
+
+      /// Incremented for each batch so workers know to wake
+      uint64_t batch_ = 0;
+
+      /// Workers which haven't finished the current batch
+      size_t busyWorkers_ = 0;
+
+      bool stopping_ = false;
+   };
+}
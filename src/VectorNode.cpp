@@ -29,6 +29,7 @@
 
 /// @file VectorNode.cpp
 
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
 #include "VectorNodeImpl.h"
 
@@ -152,7 +153,7 @@ be true).
 @see Node, VectorNode::allowHeteroChildren, ::ErrorHomogeneousViolation
 */
 VectorNode::VectorNode( const ImageFile &destImageFile, bool allowHeteroChildren ) :
-   impl_( new VectorNodeImpl( destImageFile.impl(), allowHeteroChildren ) )
+   impl_( destImageFile.impl()->makeNode<VectorNodeImpl>( allowHeteroChildren ) )
 {
 }
 
@@ -279,6 +280,30 @@ bool VectorNode::isDefined( const ustring &pathName ) const
    return impl_->isDefined( pathName );
 }
 
+/*!
+@brief Is the given path defined relative to this node.
+
+@param [in] path The absolute path, or path relative to this object, to check.
+
+@details
+Same as isDefined(const ustring&) const, but the path name has already been checked and split into
+its element names, so it isn't parsed again.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@post No visible state is modified.
+
+@return true if path is currently defined.
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompiledPath, StructureNode::isDefined(const CompiledPath&) const
+*/
+bool VectorNode::isDefined( const CompiledPath &path ) const
+{
+   return impl_->isDefined( path );
+}
+
 /*!
 @brief Get a child element by positional index.
 
@@ -331,6 +356,32 @@ Node VectorNode::get( const ustring &pathName ) const
    return Node( impl_->get( pathName ) );
 }
 
+/*!
+@brief Get a child element by path.
+
+@param [in] path The absolute path, or path relative to this object, of the object to get.
+
+@details
+Same as get(const ustring&) const, but the path name has already been checked and split into its
+element names, so it isn't parsed again.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre The @a path must be defined (i.e. isDefined(path)).
+@post No visible state is modified.
+
+@return A smart Node handle referencing the child node.
+
+@throw ::ErrorPathUndefined
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompiledPath, StructureNode::get(const CompiledPath&) const
+*/
+Node VectorNode::get( const CompiledPath &path ) const
+{
+   return Node( impl_->get( path ) );
+}
+
 /*!
 @brief Append a child element to end of VectorNode.
 
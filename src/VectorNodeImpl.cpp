@@ -26,8 +26,9 @@
  */
 
 #include "VectorNodeImpl.h"
-#include "CheckedFile.h"
+#include "ImageFileImpl.h"
 #include "StringFunctions.h"
+#include "XmlWriter.h"
 
 namespace e57
 {
@@ -83,16 +84,23 @@ namespace e57
    void VectorNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
-      if ( !allowHeteroChildren_ )
+      buildChildren();
+
+      if ( !allowHeteroChildren_ && !children_.empty() )
       {
-         // New node type must match all existing children
-         for ( auto &child : children_ )
+         // New node type must match all existing children, which all match the first one.
+         // Structures whose children haven't been built yet are only compared by type, as
+         // comparing their children would build them.
+         const NodeImplSharedPtr &first = children_.front();
+
+         const bool equivalent = ( hasLazyChildren( first ) || hasLazyChildren( ni ) )
+                                    ? ( first->type() == ni->type() )
+                                    : first->isTypeEquivalent( ni );
+
+         if ( !equivalent )
          {
-            if ( !child->isTypeEquivalent( ni ) )
-            {
-               throw E57_EXCEPTION2( ErrorHomogeneousViolation,
-                                     "this->pathName=" + this->pathName() );
-            }
+            throw E57_EXCEPTION2( ErrorHomogeneousViolation,
+                                  "this->pathName=" + this->pathName() );
          }
       }
 
@@ -100,11 +108,13 @@ namespace e57
       StructureNodeImpl::set( index64, ni );
    }
 
-   void VectorNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, int indent,
+   void VectorNodeImpl::writeXml( ImageFileImplSharedPtr imf, XmlWriter &xml, int indent,
                                   const char *forcedFieldName )
    {
       // don't checkImageFileOpen
 
+      buildChildren();
+
       ustring fieldName;
       if ( forcedFieldName != nullptr )
       {
@@ -115,13 +125,29 @@ namespace e57
          fieldName = elementName_;
       }
 
-      cf << space( indent ) << "<" << fieldName << " type=\"Vector\" allowHeterogeneousChildren=\""
-         << static_cast<int64_t>( allowHeteroChildren_ ) << "\">\n";
+      xml.indent( indent ) << "<" << fieldName << " type=\"Vector\" allowHeterogeneousChildren=\""
+                           << static_cast<int64_t>( allowHeteroChildren_ ) << "\">\n";
       for ( auto &child : children_ )
       {
-         child->writeXml( imf, cf, indent + 2, "vectorChild" );
+         child->writeXml( imf, xml, indent + 2, "vectorChild" );
+      }
+      xml.indent( indent ) << "</" << fieldName << ">\n";
+   }
+
+   NodeImplSharedPtr VectorNodeImpl::copy( const ImageFileImplSharedPtr &destImageFile )
+   {
+      std::shared_ptr<VectorNodeImpl> vi(
+         destImageFile->makeNode<VectorNodeImpl>( allowHeteroChildren_ ) );
+
+      // Children are named by their index, so only their contents need copying
+      const int64_t cChildCount = childCount();
+
+      for ( int64_t i = 0; i < cChildCount; ++i )
+      {
+         vi->append( get( i )->copy( destImageFile ) );
       }
-      cf << space( indent ) << "</" << fieldName << ">\n";
+
+      return vi;
    }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -130,6 +156,9 @@ namespace e57
       // don't checkImageFileOpen
       os << space( indent ) << "type:        Vector" << " (" << type() << ")" << std::endl;
       NodeImpl::dump( indent, os ); // NOLINT(bugprone-parent-virtual-call)
+
+      const_cast<VectorNodeImpl *>( this )->buildChildren();
+
       os << space( indent ) << "allowHeteroChildren: " << allowHeteroChildren() << std::endl;
       for ( unsigned i = 0; i < children_.size(); i++ )
       {
@@ -126,9 +126,26 @@ namespace e57
    }
 
    WriterImpl::WriterImpl( const ustring &filePath, const WriterOptions &options ) :
-      imf_( filePath, "w" ), root_( imf_.root() ), data3D_( imf_, true ), images2D_( imf_, true ),
-      writeIndexPackets_(options.writeIndexPackets)
+      WriterImpl( ImageFile( filePath, "w" ), options )
    {
+   }
+
+   WriterImpl::WriterImpl( std::shared_ptr<ImageFileSink> sink, const WriterOptions &options ) :
+      WriterImpl( ImageFile( std::move( sink ) ), options )
+   {
+   }
+
+   WriterImpl::WriterImpl( const ImageFile &imf, const WriterOptions &options ) :
+      imf_( imf ), root_( imf_.root() ), data3D_( imf_, true ), images2D_( imf_, true ),
+      fitIntegerRangesToData_( options.fitIntegerRangesToData ),
+      writeConstantFieldsAsConstant_( options.writeConstantFieldsAsConstant )
+   {
+      writerOptions_.writeIndexPackets = options.writeIndexPackets;
+      writerOptions_.dataPacketsPerIndexEntry = options.dataPacketsPerIndexEntry;
+      writerOptions_.encoderThreadCount = options.encoderThreadCount;
+      writerOptions_.writePacketsInBackground = options.writePacketsInBackground;
+      writerOptions_.stageSection = options.stageData3DSections;
+
       // We are using the E57 v1.0 data format standard field names.
       // The standard field names are used without an extension prefix (in the default namespace).
       // We explicitly register it for completeness (the reference implementation would do it for
@@ -474,7 +491,12 @@ namespace e57
       return 0;
    }
 
-   int64_t WriterImpl::NewData3D( Data3D &data3DHeader )
+   bool WriterImpl::UsesFieldRanges() const
+   {
+      return fitIntegerRangesToData_ || writeConstantFieldsAsConstant_;
+   }
+
+   int64_t WriterImpl::NewData3D( Data3D &data3DHeader, const Data3DFieldRanges &fieldRanges )
    {
       StructureNode scan( imf_ );
       data3D_.append( scan );
@@ -562,158 +584,7 @@ namespace e57
          scan.set( "atmosphericPressure", FloatNode( imf_, data3DHeader.atmosphericPressure ) );
       }
 
-      if ( data3DHeader.indexBounds != IndexBounds{} )
-      {
-         StructureNode ibox( imf_ );
-
-         if ( ( data3DHeader.indexBounds.rowMinimum != 0 ) ||
-              ( data3DHeader.indexBounds.rowMaximum != 0 ) )
-         {
-            ibox.set( "rowMinimum", IntegerNode( imf_, data3DHeader.indexBounds.rowMinimum ) );
-            ibox.set( "rowMaximum", IntegerNode( imf_, data3DHeader.indexBounds.rowMaximum ) );
-         }
-
-         if ( ( data3DHeader.indexBounds.columnMinimum != 0 ) ||
-              ( data3DHeader.indexBounds.columnMaximum != 0 ) )
-         {
-            ibox.set( "columnMinimum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.columnMinimum ) );
-            ibox.set( "columnMaximum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.columnMaximum ) );
-         }
-
-         if ( ( data3DHeader.indexBounds.returnMinimum != 0 ) ||
-              ( data3DHeader.indexBounds.returnMaximum != 0 ) )
-         {
-            ibox.set( "returnMinimum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.returnMinimum ) );
-            ibox.set( "returnMaximum",
-                      IntegerNode( imf_, data3DHeader.indexBounds.returnMaximum ) );
-         }
-
-         scan.set( "indexBounds", ibox );
-      }
-
-      if ( ( data3DHeader.intensityLimits.intensityMaximum != 0.0 ) ||
-           ( data3DHeader.intensityLimits.intensityMinimum != 0.0 ) )
-      {
-         StructureNode intbox( imf_ );
-
-         const double intensityMin = data3DHeader.intensityLimits.intensityMinimum;
-         const double intensityMax = data3DHeader.intensityLimits.intensityMaximum;
-
-         switch ( data3DHeader.pointFields.intensityNodeType )
-         {
-            case NumericalNodeType::Integer:
-            {
-               intbox.set( "intensityMinimum",
-                           IntegerNode( imf_, static_cast<int64_t>( intensityMin ) ) );
-               intbox.set( "intensityMaximum",
-                           IntegerNode( imf_, static_cast<int64_t>( intensityMax ) ) );
-
-               break;
-            }
-
-            case NumericalNodeType::ScaledInteger:
-            {
-               const double scale = data3DHeader.pointFields.intensityScale;
-               const double offset = 0.0;
-
-               const auto rawIntegerMinimum =
-                  static_cast<int64_t>( std::floor( ( intensityMin - offset ) / scale + .5 ) );
-               const auto rawIntegerMaximum =
-                  static_cast<int64_t>( std::floor( ( intensityMax - offset ) / scale + .5 ) );
-
-               intbox.set( "intensityMinimum",
-                           ScaledIntegerNode( imf_, rawIntegerMinimum, rawIntegerMinimum,
-                                              rawIntegerMaximum, scale, offset ) );
-               intbox.set( "intensityMaximum",
-                           ScaledIntegerNode( imf_, rawIntegerMaximum, rawIntegerMinimum,
-                                              rawIntegerMaximum, scale, offset ) );
-
-               break;
-            }
-
-            case NumericalNodeType::Float:
-            {
-               intbox.set( "intensityMinimum", FloatNode( imf_, intensityMin, PrecisionSingle ) );
-               intbox.set( "intensityMaximum", FloatNode( imf_, intensityMax, PrecisionSingle ) );
-
-               break;
-            }
-
-            case NumericalNodeType::Double:
-            {
-               intbox.set( "intensityMinimum", FloatNode( imf_, intensityMin, PrecisionDouble ) );
-               intbox.set( "intensityMaximum", FloatNode( imf_, intensityMax, PrecisionDouble ) );
-
-               break;
-            }
-         }
-
-         scan.set( "intensityLimits", intbox );
-      }
-
-      if ( ( data3DHeader.colorLimits.colorRedMaximum != 0.0 ) ||
-           ( data3DHeader.colorLimits.colorRedMinimum != 0.0 ) )
-      {
-         StructureNode colorbox( imf_ );
-
-         colorbox.set(
-            "colorRedMaximum",
-            IntegerNode( imf_, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMaximum ) ) );
-         colorbox.set(
-            "colorRedMinimum",
-            IntegerNode( imf_, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMinimum ) ) );
-         colorbox.set( "colorGreenMaximum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorGreenMaximum ) ) );
-         colorbox.set( "colorGreenMinimum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorGreenMinimum ) ) );
-         colorbox.set( "colorBlueMaximum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorBlueMaximum ) ) );
-         colorbox.set( "colorBlueMinimum",
-                       IntegerNode( imf_, static_cast<int64_t>(
-                                             data3DHeader.colorLimits.colorBlueMinimum ) ) );
-
-         scan.set( "colorLimits", colorbox );
-      }
-
-      // Add Cartesian bounding box to scan.
-      // Path names: "/data3D/0/cartesianBounds/xMinimum", etc...
-      if ( ( data3DHeader.cartesianBounds.xMinimum != -DOUBLE_MAX ) ||
-           ( data3DHeader.cartesianBounds.xMaximum != DOUBLE_MAX ) )
-      {
-         StructureNode bbox( imf_ );
-
-         bbox.set( "xMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.xMinimum ) );
-         bbox.set( "xMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.xMaximum ) );
-         bbox.set( "yMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.yMinimum ) );
-         bbox.set( "yMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.yMaximum ) );
-         bbox.set( "zMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.zMinimum ) );
-         bbox.set( "zMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.zMaximum ) );
-
-         scan.set( "cartesianBounds", bbox );
-      }
-
-      if ( ( data3DHeader.sphericalBounds.rangeMinimum != 0.0 ) ||
-           ( data3DHeader.sphericalBounds.rangeMaximum != DOUBLE_MAX ) )
-      {
-         StructureNode sbox( imf_ );
-
-         sbox.set( "rangeMinimum", FloatNode( imf_, data3DHeader.sphericalBounds.rangeMinimum ) );
-         sbox.set( "rangeMaximum", FloatNode( imf_, data3DHeader.sphericalBounds.rangeMaximum ) );
-         sbox.set( "elevationMinimum",
-                   FloatNode( imf_, data3DHeader.sphericalBounds.elevationMinimum ) );
-         sbox.set( "elevationMaximum",
-                   FloatNode( imf_, data3DHeader.sphericalBounds.elevationMaximum ) );
-         sbox.set( "azimuthStart", FloatNode( imf_, data3DHeader.sphericalBounds.azimuthStart ) );
-         sbox.set( "azimuthEnd", FloatNode( imf_, data3DHeader.sphericalBounds.azimuthEnd ) );
-
-         scan.set( "sphericalBounds", sbox );
-      }
+      SetData3DBounds( scan, data3DHeader );
 
       // Create pose structure for scan.
       // Path names: "/data3D/0/pose/rotation/w", etc...
@@ -829,6 +700,11 @@ namespace e57
       //      "/data3D/0/points/0/cartesianX"
       StructureNode proto( imf_ );
 
+      // Integer fields are narrowed to the range of the data we are about to write, if we know it
+      const auto setField = [&]( const ustring &name, const Node &node ) {
+         proto.set( name, FitNodeToRange( node, name, fieldRanges ) );
+      };
+
       const double pointRangeMin = data3DHeader.pointFields.pointRangeMinimum;
       const double pointRangeMax = data3DHeader.pointFields.pointRangeMaximum;
 
@@ -880,22 +756,22 @@ namespace e57
 
       if ( data3DHeader.pointFields.cartesianXField )
       {
-         proto.set( "cartesianX", getPointProto() );
+         setField( "cartesianX", getPointProto() );
       }
 
       if ( data3DHeader.pointFields.cartesianYField )
       {
-         proto.set( "cartesianY", getPointProto() );
+         setField( "cartesianY", getPointProto() );
       }
 
       if ( data3DHeader.pointFields.cartesianZField )
       {
-         proto.set( "cartesianZ", getPointProto() );
+         setField( "cartesianZ", getPointProto() );
       }
 
       if ( data3DHeader.pointFields.sphericalRangeField )
       {
-         proto.set( "sphericalRange", getPointProto() );
+         setField( "sphericalRange", getPointProto() );
       }
 
       const double angleMin = data3DHeader.pointFields.angleMinimum;
@@ -947,12 +823,12 @@ namespace e57
 
       if ( data3DHeader.pointFields.sphericalAzimuthField )
       {
-         proto.set( "sphericalAzimuth", getAngleProto() );
+         setField( "sphericalAzimuth", getAngleProto() );
       }
 
       if ( data3DHeader.pointFields.sphericalElevationField )
       {
-         proto.set( "sphericalElevation", getAngleProto() );
+         setField( "sphericalElevation", getAngleProto() );
       }
 
       if ( data3DHeader.pointFields.intensityField )
@@ -964,8 +840,8 @@ namespace e57
          {
             case NumericalNodeType::Integer:
             {
-               proto.set( "intensity", IntegerNode( imf_, 0, static_cast<int64_t>( intensityMin ),
-                                                    static_cast<int64_t>( intensityMax ) ) );
+               setField( "intensity", IntegerNode( imf_, 0, static_cast<int64_t>( intensityMin ),
+                                                   static_cast<int64_t>( intensityMax ) ) );
 
                break;
             }
@@ -980,26 +856,40 @@ namespace e57
                const auto rawIntegerMinimum =
                   static_cast<int64_t>( std::floor( ( intensityMin - offset ) / scale + .5 ) );
 
-               proto.set( "intensity", ScaledIntegerNode( imf_, 0, rawIntegerMinimum,
-                                                          rawIntegerMaximum, scale, offset ) );
+               setField( "intensity", ScaledIntegerNode( imf_, 0, rawIntegerMinimum,
+                                                         rawIntegerMaximum, scale, offset ) );
 
                break;
             }
 
+            // Floating point intensities don't need their limits to be encoded, so if they
+            // aren't set (e.g. when streaming the points) leave the field unbounded.
             case NumericalNodeType::Float:
             {
-               proto.set( "intensity", FloatNode( imf_, 0.0, PrecisionSingle,
-                                                  data3DHeader.intensityLimits.intensityMinimum,
-                                                  data3DHeader.intensityLimits.intensityMaximum ) );
+               if ( data3DHeader.intensityLimits == IntensityLimits{} )
+               {
+                  setField( "intensity",
+                            FloatNode( imf_, 0.0, PrecisionSingle, FLOAT_MIN, FLOAT_MAX ) );
+                  break;
+               }
+
+               setField( "intensity",
+                         FloatNode( imf_, 0.0, PrecisionSingle, intensityMin, intensityMax ) );
 
                break;
             }
 
             case NumericalNodeType::Double:
             {
-               proto.set( "intensity", FloatNode( imf_, 0.0, PrecisionDouble,
-                                                  data3DHeader.intensityLimits.intensityMinimum,
-                                                  data3DHeader.intensityLimits.intensityMaximum ) );
+               if ( data3DHeader.intensityLimits == IntensityLimits{} )
+               {
+                  setField( "intensity",
+                            FloatNode( imf_, 0.0, PrecisionDouble, DOUBLE_MIN, DOUBLE_MAX ) );
+                  break;
+               }
+
+               setField( "intensity",
+                         FloatNode( imf_, 0.0, PrecisionDouble, intensityMin, intensityMax ) );
 
                break;
             }
@@ -1008,21 +898,21 @@ namespace e57
 
       if ( data3DHeader.pointFields.colorRedField )
       {
-         proto.set(
+         setField(
             "colorRed",
             IntegerNode( imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMinimum ),
                          static_cast<int64_t>( data3DHeader.colorLimits.colorRedMaximum ) ) );
       }
       if ( data3DHeader.pointFields.colorGreenField )
       {
-         proto.set( "colorGreen",
-                    IntegerNode(
-                       imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorGreenMinimum ),
-                       static_cast<int64_t>( data3DHeader.colorLimits.colorGreenMaximum ) ) );
+         setField( "colorGreen",
+                   IntegerNode(
+                      imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorGreenMinimum ),
+                      static_cast<int64_t>( data3DHeader.colorLimits.colorGreenMaximum ) ) );
       }
       if ( data3DHeader.pointFields.colorBlueField )
       {
-         proto.set(
+         setField(
             "colorBlue",
             IntegerNode( imf_, 0, static_cast<int64_t>( data3DHeader.colorLimits.colorBlueMinimum ),
                          static_cast<int64_t>( data3DHeader.colorLimits.colorBlueMaximum ) ) );
@@ -1030,24 +920,24 @@ namespace e57
 
       if ( data3DHeader.pointFields.returnIndexField )
       {
-         proto.set( "returnIndex",
-                    IntegerNode( imf_, 0, UINT8_MIN, data3DHeader.pointFields.returnMaximum ) );
+         setField( "returnIndex",
+                   IntegerNode( imf_, 0, UINT8_MIN, data3DHeader.pointFields.returnMaximum ) );
       }
       if ( data3DHeader.pointFields.returnCountField )
       {
-         proto.set( "returnCount",
-                    IntegerNode( imf_, 0, UINT8_MIN, data3DHeader.pointFields.returnMaximum ) );
+         setField( "returnCount",
+                   IntegerNode( imf_, 0, UINT8_MIN, data3DHeader.pointFields.returnMaximum ) );
       }
 
       if ( data3DHeader.pointFields.rowIndexField )
       {
-         proto.set( "rowIndex",
-                    IntegerNode( imf_, 0, UINT32_MIN, data3DHeader.pointFields.rowIndexMaximum ) );
+         setField( "rowIndex",
+                   IntegerNode( imf_, 0, UINT32_MIN, data3DHeader.pointFields.rowIndexMaximum ) );
       }
       if ( data3DHeader.pointFields.columnIndexField )
       {
-         proto.set( "columnIndex", IntegerNode( imf_, 0, UINT32_MIN,
-                                                data3DHeader.pointFields.columnIndexMaximum ) );
+         setField( "columnIndex", IntegerNode( imf_, 0, UINT32_MIN,
+                                               data3DHeader.pointFields.columnIndexMaximum ) );
       }
 
       if ( data3DHeader.pointFields.timeStampField )
@@ -1059,8 +949,8 @@ namespace e57
          {
             case NumericalNodeType::Integer:
             {
-               proto.set( "timeStamp", IntegerNode( imf_, 0, static_cast<int64_t>( timeMinimum ),
-                                                    static_cast<int64_t>( timeMaximum ) ) );
+               setField( "timeStamp", IntegerNode( imf_, 0, static_cast<int64_t>( timeMinimum ),
+                                                   static_cast<int64_t>( timeMaximum ) ) );
                break;
             }
 
@@ -1074,22 +964,22 @@ namespace e57
                const auto rawIntegerMaximum =
                   static_cast<int64_t>( std::floor( ( timeMaximum - offset ) / scale + .5 ) );
 
-               proto.set( "timeStamp", ScaledIntegerNode( imf_, 0, rawIntegerMinimum,
-                                                          rawIntegerMaximum, scale, offset ) );
+               setField( "timeStamp", ScaledIntegerNode( imf_, 0, rawIntegerMinimum,
+                                                         rawIntegerMaximum, scale, offset ) );
                break;
             }
 
             case NumericalNodeType::Float:
             {
-               proto.set( "timeStamp",
-                          FloatNode( imf_, 0.0, PrecisionSingle, FLOAT_MIN, FLOAT_MAX ) );
+               setField( "timeStamp",
+                         FloatNode( imf_, 0.0, PrecisionSingle, FLOAT_MIN, FLOAT_MAX ) );
                break;
             }
 
             case NumericalNodeType::Double:
             {
-               proto.set( "timeStamp",
-                          FloatNode( imf_, 0.0, PrecisionDouble, DOUBLE_MIN, DOUBLE_MAX ) );
+               setField( "timeStamp",
+                         FloatNode( imf_, 0.0, PrecisionDouble, DOUBLE_MIN, DOUBLE_MAX ) );
                break;
             }
          }
@@ -1097,23 +987,23 @@ namespace e57
 
       if ( data3DHeader.pointFields.cartesianInvalidStateField )
       {
-         proto.set( "cartesianInvalidState", IntegerNode( imf_, 0, 0, 2 ) );
+         setField( "cartesianInvalidState", IntegerNode( imf_, 0, 0, 2 ) );
       }
       if ( data3DHeader.pointFields.sphericalInvalidStateField )
       {
-         proto.set( "sphericalInvalidState", IntegerNode( imf_, 0, 0, 2 ) );
+         setField( "sphericalInvalidState", IntegerNode( imf_, 0, 0, 2 ) );
       }
       if ( data3DHeader.pointFields.isIntensityInvalidField )
       {
-         proto.set( "isIntensityInvalid", IntegerNode( imf_, 0, 0, 1 ) );
+         setField( "isIntensityInvalid", IntegerNode( imf_, 0, 0, 1 ) );
       }
       if ( data3DHeader.pointFields.isColorInvalidField )
       {
-         proto.set( "isColorInvalid", IntegerNode( imf_, 0, 0, 1 ) );
+         setField( "isColorInvalid", IntegerNode( imf_, 0, 0, 1 ) );
       }
       if ( data3DHeader.pointFields.isTimeStampInvalidField )
       {
-         proto.set( "isTimeStampInvalid", IntegerNode( imf_, 0, 0, 1 ) );
+         setField( "isTimeStampInvalid", IntegerNode( imf_, 0, 0, 1 ) );
       }
 
       // E57_EXT_surface_normals
@@ -1131,15 +1021,15 @@ namespace e57
       // currently we support writing normals only as float32
       if ( data3DHeader.pointFields.normalXField )
       {
-         proto.set( "nor:normalX", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
+         setField( "nor:normalX", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
       }
       if ( data3DHeader.pointFields.normalYField )
       {
-         proto.set( "nor:normalY", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
+         setField( "nor:normalY", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
       }
       if ( data3DHeader.pointFields.normalZField )
       {
-         proto.set( "nor:normalZ", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
+         setField( "nor:normalZ", FloatNode( imf_, 0.0, PrecisionSingle, -1.0, 1.0 ) );
       }
 
       // Make empty codecs vector for use in creating points CompressedVector.
@@ -1156,6 +1046,258 @@ namespace e57
       return pos;
    }
 
+   // Add the index bounds, intensity & color limits, and cartesian & spherical bounds which are set
+   // in the header to the scan, unless the scan already has them.
+   void WriterImpl::SetData3DBounds( StructureNode &scan, const Data3D &data3DHeader )
+   {
+      if ( ( data3DHeader.indexBounds != IndexBounds{} ) && !scan.isDefined( "indexBounds" ) )
+      {
+         StructureNode ibox( imf_ );
+
+         if ( ( data3DHeader.indexBounds.rowMinimum != 0 ) ||
+              ( data3DHeader.indexBounds.rowMaximum != 0 ) )
+         {
+            ibox.set( "rowMinimum", IntegerNode( imf_, data3DHeader.indexBounds.rowMinimum ) );
+            ibox.set( "rowMaximum", IntegerNode( imf_, data3DHeader.indexBounds.rowMaximum ) );
+         }
+
+         if ( ( data3DHeader.indexBounds.columnMinimum != 0 ) ||
+              ( data3DHeader.indexBounds.columnMaximum != 0 ) )
+         {
+            ibox.set( "columnMinimum",
+                      IntegerNode( imf_, data3DHeader.indexBounds.columnMinimum ) );
+            ibox.set( "columnMaximum",
+                      IntegerNode( imf_, data3DHeader.indexBounds.columnMaximum ) );
+         }
+
+         if ( ( data3DHeader.indexBounds.returnMinimum != 0 ) ||
+              ( data3DHeader.indexBounds.returnMaximum != 0 ) )
+         {
+            ibox.set( "returnMinimum",
+                      IntegerNode( imf_, data3DHeader.indexBounds.returnMinimum ) );
+            ibox.set( "returnMaximum",
+                      IntegerNode( imf_, data3DHeader.indexBounds.returnMaximum ) );
+         }
+
+         scan.set( "indexBounds", ibox );
+      }
+
+      if ( ( ( data3DHeader.intensityLimits.intensityMaximum != 0.0 ) ||
+             ( data3DHeader.intensityLimits.intensityMinimum != 0.0 ) ) &&
+           !scan.isDefined( "intensityLimits" ) )
+      {
+         StructureNode intbox( imf_ );
+
+         const double intensityMin = data3DHeader.intensityLimits.intensityMinimum;
+         const double intensityMax = data3DHeader.intensityLimits.intensityMaximum;
+
+         switch ( data3DHeader.pointFields.intensityNodeType )
+         {
+            case NumericalNodeType::Integer:
+            {
+               intbox.set( "intensityMinimum",
+                           IntegerNode( imf_, static_cast<int64_t>( intensityMin ) ) );
+               intbox.set( "intensityMaximum",
+                           IntegerNode( imf_, static_cast<int64_t>( intensityMax ) ) );
+
+               break;
+            }
+
+            case NumericalNodeType::ScaledInteger:
+            {
+               const double scale = data3DHeader.pointFields.intensityScale;
+               const double offset = 0.0;
+
+               const auto rawIntegerMinimum =
+                  static_cast<int64_t>( std::floor( ( intensityMin - offset ) / scale + .5 ) );
+               const auto rawIntegerMaximum =
+                  static_cast<int64_t>( std::floor( ( intensityMax - offset ) / scale + .5 ) );
+
+               intbox.set( "intensityMinimum",
+                           ScaledIntegerNode( imf_, rawIntegerMinimum, rawIntegerMinimum,
+                                              rawIntegerMaximum, scale, offset ) );
+               intbox.set( "intensityMaximum",
+                           ScaledIntegerNode( imf_, rawIntegerMaximum, rawIntegerMinimum,
+                                              rawIntegerMaximum, scale, offset ) );
+
+               break;
+            }
+
+            case NumericalNodeType::Float:
+            {
+               intbox.set( "intensityMinimum", FloatNode( imf_, intensityMin, PrecisionSingle ) );
+               intbox.set( "intensityMaximum", FloatNode( imf_, intensityMax, PrecisionSingle ) );
+
+               break;
+            }
+
+            case NumericalNodeType::Double:
+            {
+               intbox.set( "intensityMinimum", FloatNode( imf_, intensityMin, PrecisionDouble ) );
+               intbox.set( "intensityMaximum", FloatNode( imf_, intensityMax, PrecisionDouble ) );
+
+               break;
+            }
+         }
+
+         scan.set( "intensityLimits", intbox );
+      }
+
+      if ( ( ( data3DHeader.colorLimits.colorRedMaximum != 0.0 ) ||
+             ( data3DHeader.colorLimits.colorRedMinimum != 0.0 ) ) &&
+           !scan.isDefined( "colorLimits" ) )
+      {
+         StructureNode colorbox( imf_ );
+
+         colorbox.set(
+            "colorRedMaximum",
+            IntegerNode( imf_, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMaximum ) ) );
+         colorbox.set(
+            "colorRedMinimum",
+            IntegerNode( imf_, static_cast<int64_t>( data3DHeader.colorLimits.colorRedMinimum ) ) );
+         colorbox.set( "colorGreenMaximum",
+                       IntegerNode( imf_, static_cast<int64_t>(
+                                             data3DHeader.colorLimits.colorGreenMaximum ) ) );
+         colorbox.set( "colorGreenMinimum",
+                       IntegerNode( imf_, static_cast<int64_t>(
+                                             data3DHeader.colorLimits.colorGreenMinimum ) ) );
+         colorbox.set( "colorBlueMaximum",
+                       IntegerNode( imf_, static_cast<int64_t>(
+                                             data3DHeader.colorLimits.colorBlueMaximum ) ) );
+         colorbox.set( "colorBlueMinimum",
+                       IntegerNode( imf_, static_cast<int64_t>(
+                                             data3DHeader.colorLimits.colorBlueMinimum ) ) );
+
+         scan.set( "colorLimits", colorbox );
+      }
+
+      // Add Cartesian bounding box to scan.
+      // Path names: "/data3D/0/cartesianBounds/xMinimum", etc...
+      if ( ( ( data3DHeader.cartesianBounds.xMinimum != -DOUBLE_MAX ) ||
+             ( data3DHeader.cartesianBounds.xMaximum != DOUBLE_MAX ) ) &&
+           !scan.isDefined( "cartesianBounds" ) )
+      {
+         StructureNode bbox( imf_ );
+
+         bbox.set( "xMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.xMinimum ) );
+         bbox.set( "xMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.xMaximum ) );
+         bbox.set( "yMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.yMinimum ) );
+         bbox.set( "yMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.yMaximum ) );
+         bbox.set( "zMinimum", FloatNode( imf_, data3DHeader.cartesianBounds.zMinimum ) );
+         bbox.set( "zMaximum", FloatNode( imf_, data3DHeader.cartesianBounds.zMaximum ) );
+
+         scan.set( "cartesianBounds", bbox );
+      }
+
+      if ( ( ( data3DHeader.sphericalBounds.rangeMinimum != 0.0 ) ||
+             ( data3DHeader.sphericalBounds.rangeMaximum != DOUBLE_MAX ) ) &&
+           !scan.isDefined( "sphericalBounds" ) )
+      {
+         StructureNode sbox( imf_ );
+
+         sbox.set( "rangeMinimum", FloatNode( imf_, data3DHeader.sphericalBounds.rangeMinimum ) );
+         sbox.set( "rangeMaximum", FloatNode( imf_, data3DHeader.sphericalBounds.rangeMaximum ) );
+         sbox.set( "elevationMinimum",
+                   FloatNode( imf_, data3DHeader.sphericalBounds.elevationMinimum ) );
+         sbox.set( "elevationMaximum",
+                   FloatNode( imf_, data3DHeader.sphericalBounds.elevationMaximum ) );
+         sbox.set( "azimuthStart", FloatNode( imf_, data3DHeader.sphericalBounds.azimuthStart ) );
+         sbox.set( "azimuthEnd", FloatNode( imf_, data3DHeader.sphericalBounds.azimuthEnd ) );
+
+         scan.set( "sphericalBounds", sbox );
+      }
+   }
+
+   // Narrow an Integer or ScaledInteger prototype node to the raw range of the values we are going
+   // to write to the field, rounded the same way the encoder rounds them. Other nodes, fields we
+   // don't have a range for, and data which doesn't fit in the declared range (so the writer still
+   // reports the bad value) keep the node as is. With only writeConstantFieldsAsConstant set, just
+   // the fields holding a single value are narrowed.
+   Node WriterImpl::FitNodeToRange( const Node &node, const ustring &fieldName,
+                                    const Data3DFieldRanges &fieldRanges )
+   {
+      const auto cRange = fieldRanges.find( fieldName );
+      if ( cRange == fieldRanges.end() )
+      {
+         return node;
+      }
+
+      double minimum = cRange->second.first;
+      double maximum = cRange->second.second;
+
+      // Keep well away from the edges of int64_t before converting
+      constexpr double cLimit = 9.0e18;
+
+      switch ( node.type() )
+      {
+         case TypeInteger:
+         {
+            const IntegerNode integerNode( node );
+
+            if ( !( minimum >= -cLimit && maximum <= cLimit ) )
+            {
+               return node;
+            }
+
+            // Floating point values are truncated when written to an Integer
+            const auto cRawMinimum = static_cast<int64_t>( minimum );
+            const auto cRawMaximum = static_cast<int64_t>( maximum );
+
+            if ( cRawMinimum < integerNode.minimum() || cRawMaximum > integerNode.maximum() )
+            {
+               return node;
+            }
+
+            if ( !fitIntegerRangesToData_ && ( cRawMinimum != cRawMaximum ) )
+            {
+               return node;
+            }
+
+            return IntegerNode( imf_, cRawMinimum, cRawMinimum, cRawMaximum );
+         }
+
+         case TypeScaledInteger:
+         {
+            const ScaledIntegerNode scaledNode( node );
+
+            const double scale = scaledNode.scale();
+            const double offset = scaledNode.offset();
+
+            minimum = std::floor( ( minimum - offset ) / scale + 0.5 );
+            maximum = std::floor( ( maximum - offset ) / scale + 0.5 );
+
+            if ( minimum > maximum )
+            {
+               std::swap( minimum, maximum );
+            }
+
+            if ( !( minimum >= -cLimit && maximum <= cLimit ) )
+            {
+               return node;
+            }
+
+            const auto cRawMinimum = static_cast<int64_t>( minimum );
+            const auto cRawMaximum = static_cast<int64_t>( maximum );
+
+            if ( cRawMinimum < scaledNode.minimum() || cRawMaximum > scaledNode.maximum() )
+            {
+               return node;
+            }
+
+            if ( !fitIntegerRangesToData_ && ( cRawMinimum != cRawMaximum ) )
+            {
+               return node;
+            }
+
+            return ScaledIntegerNode( imf_, cRawMinimum, cRawMinimum, cRawMaximum, scale,
+                                      offset );
+         }
+
+         default:
+            return node;
+      }
+   }
+
    template <typename COORDTYPE>
    CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
       int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers )
@@ -1164,6 +1306,31 @@ namespace e57
 
       const StructureNode scan( data3D_.get( dataIndex ) );
       CompressedVectorNode points( scan.get( "points" ) );
+
+      std::vector<SourceDestBuffer> sourceBuffers =
+         Data3DSourceBuffers( dataIndex, count, buffers );
+
+      // create the writer, all buffers must be setup before this call
+      CompressedVectorWriter writer = points.writer( sourceBuffers, writerOptions_ );
+
+      return writer;
+   }
+
+   // Explicit template instantiation
+   template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers );
+
+   template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers );
+
+   template <typename COORDTYPE>
+   std::vector<SourceDestBuffer> WriterImpl::Data3DSourceBuffers(
+      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers )
+   {
+      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
+
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      const CompressedVectorNode points( scan.get( "points" ) );
       const StructureNode proto( points.prototype() );
       std::vector<SourceDestBuffer> sourceBuffers;
 
@@ -1295,17 +1462,14 @@ namespace e57
          }
       }
 
-      // create the writer, all buffers must be setup before this call
-      CompressedVectorWriter writer = points.writer( sourceBuffers, writeIndexPackets_ );
-
-      return writer;
+      return sourceBuffers;
    }
 
    // Explicit template instantiation
-   template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
+   template std::vector<SourceDestBuffer> WriterImpl::Data3DSourceBuffers(
       int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers );
 
-   template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
+   template std::vector<SourceDestBuffer> WriterImpl::Data3DSourceBuffers(
       int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers );
 
    // This function writes out the group data
@@ -1346,7 +1510,7 @@ namespace e57
       groupSDBuffers.emplace_back( imf_, "startPointIndex", startPointIndex, groupCount, true );
       groupSDBuffers.emplace_back( imf_, "pointCount", pointCount, groupCount, true );
 
-      CompressedVectorWriter writer = groups.writer( groupSDBuffers, writeIndexPackets_ );
+      CompressedVectorWriter writer = groups.writer( groupSDBuffers, writerOptions_ );
       writer.write( groupCount );
       writer.close();
 
@@ -28,15 +28,21 @@
 
 #pragma once
 
+#include <map>
+
 #include "E57SimpleData.h"
 #include "E57SimpleWriter.h"
 
 namespace e57
 {
+   /// Minimum & maximum of the values in each field of a scan's points, by field name
+   using Data3DFieldRanges = std::map<ustring, std::pair<double, double>>;
+
    class WriterImpl
    {
    public:
       WriterImpl( const ustring &filePath, const WriterOptions &options );
+      WriterImpl( std::shared_ptr<ImageFileSink> sink, const WriterOptions &options );
       ~WriterImpl();
 
       // disallow copying a WriterImpl
@@ -55,12 +61,22 @@ namespace e57
                                Image2DProjection imageProjection, uint8_t *pBuffer, int64_t start,
                                size_t count );
 
-      int64_t NewData3D( Data3D &data3DHeader );
+      /// Whether WriteData3DData() should pass NewData3D() the range of each field
+      bool UsesFieldRanges() const;
+
+      int64_t NewData3D( Data3D &data3DHeader, const Data3DFieldRanges &fieldRanges = {} );
 
       template <typename COORDTYPE>
       CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                     const Data3DPointsData_t<COORDTYPE> &buffers );
 
+      /// Source buffers for the fields of a scan's prototype from the user-provided buffers
+      template <typename COORDTYPE>
+      std::vector<SourceDestBuffer> Data3DSourceBuffers(
+         int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<COORDTYPE> &buffers );
+
+      void SetData3DBounds( StructureNode &scan, const Data3D &data3DHeader );
+
       bool WriteData3DGroupsData( int64_t dataIndex, size_t groupCount, int64_t *idElementValue,
                                   int64_t *startPointIndex, int64_t *pointCount );
 
@@ -73,6 +89,11 @@ namespace e57
       ImageFile GetRawIMF();
 
    private:
+      WriterImpl( const ImageFile &imf, const WriterOptions &options );
+
+      Node FitNodeToRange( const Node &node, const ustring &fieldName,
+                           const Data3DFieldRanges &fieldRanges );
+
       ImageFile imf_;
       StructureNode root_;
 
@@ -80,6 +101,8 @@ namespace e57
 
       VectorNode images2D_;
 
-      bool writeIndexPackets_;
+      CompressedVectorWriterOptions writerOptions_;
+      bool fitIntegerRangesToData_;
+      bool writeConstantFieldsAsConstant_;
    }; // end Writer class
 } // end namespace e57
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#include <algorithm>
+#include <cstring>
+
+#include "CheckedFile.h"
+#include "StringFunctions.h"
+#include "XmlWriter.h"
+
+namespace e57
+{
+   namespace
+   {
+      /// Size of the buffer, in logical pages
+      constexpr size_t cBufferPages = 64;
+
+      constexpr size_t cBufferSize = cBufferPages * CheckedFile::logicalPageSize;
+   }
+
+   XmlWriter::XmlWriter( CheckedFile &cf ) :
+      cf_( cf ), buffer_( new char[cBufferSize] ),
+      pageOffset_( static_cast<size_t>( cf.position( CheckedFile::Logical ) %
+                                        CheckedFile::logicalPageSize ) )
+   {
+   }
+
+   XmlWriter &XmlWriter::operator<<( const ustring &s )
+   {
+      write( s.data(), s.length() );
+      return *this;
+   }
+
+   XmlWriter &XmlWriter::operator<<( const char *s )
+   {
+      write( s, strlen( s ) );
+      return *this;
+   }
+
+   XmlWriter &XmlWriter::operator<<( int64_t i )
+   {
+      char chars[cIntegerCharsMax];
+      write( chars, integerToChars( chars, i ) );
+      return *this;
+   }
+
+   XmlWriter &XmlWriter::operator<<( uint64_t i )
+   {
+      char chars[cIntegerCharsMax];
+      write( chars, integerToChars( chars, i ) );
+      return *this;
+   }
+
+   XmlWriter &XmlWriter::operator<<( float f )
+   {
+      char chars[cFloatingPointCharsMax];
+      write( chars, floatingPointToChars( chars, f, 7 ) );
+      return *this;
+   }
+
+   XmlWriter &XmlWriter::operator<<( double d )
+   {
+      char chars[cFloatingPointCharsMax];
+      write( chars, floatingPointToChars( chars, d, 17 ) );
+      return *this;
+   }
+
+   XmlWriter &XmlWriter::indent( int n )
+   {
+      static const char spaces[] = "                                ";
+
+      for ( auto remaining = static_cast<size_t>( n ); remaining > 0; )
+      {
+         const size_t count = std::min( remaining, sizeof( spaces ) - 1 );
+
+         write( spaces, count );
+         remaining -= count;
+      }
+
+      return *this;
+   }
+
+   void XmlWriter::flush()
+   {
+      if ( used_ > 0 )
+      {
+         cf_.write( buffer_.get(), used_ );
+
+         pageOffset_ = ( pageOffset_ + used_ ) % CheckedFile::logicalPageSize;
+         used_ = 0;
+      }
+   }
+
+   void XmlWriter::write( const char *data, size_t length )
+   {
+      while ( length > 0 )
+      {
+         if ( used_ == cBufferSize )
+         {
+            flushPages();
+         }
+
+         const size_t count = std::min( length, cBufferSize - used_ );
+
+         memcpy( buffer_.get() + used_, data, count );
+
+         used_ += count;
+         data += count;
+         length -= count;
+      }
+   }
+
+   // Write the whole pages in the buffer, keeping the rest of the last page for later.
+   void XmlWriter::flushPages()
+   {
+      const size_t end = pageOffset_ + used_;
+      const size_t remainder = end % CheckedFile::logicalPageSize;
+      const size_t count = used_ - remainder;
+
+      cf_.write( buffer_.get(), count );
+
+      memmove( buffer_.get(), buffer_.get() + count, remainder );
+
+      used_ = remainder;
+      pageOffset_ = 0;
+   }
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSL-1.0
+// Copyright 2026 Andy Maloney <asmaloney@gmail.com>
+
+#pragma once
+
+#include <memory>
+
+#include "Common.h"
+
+namespace e57
+{
+   class CheckedFile;
+
+   /// Writes the XML section of an ImageFile to its CheckedFile.
+   ///
+   /// Text & numbers are formatted straight into a large buffer, which is handed to the file a
+   /// run of whole logical pages at a time, so each page is only checksummed & written once.
+   /// Numbers are formatted the same way as CheckedFile::operator<<() did, so the XML is the same.
+   class XmlWriter
+   {
+   public:
+      /// Start writing at the current position of @a cf.
+      explicit XmlWriter( CheckedFile &cf );
+
+      XmlWriter( const XmlWriter & ) = delete;
+      XmlWriter &operator=( const XmlWriter & ) = delete;
+
+      void write( const char *data, size_t length );
+
+      XmlWriter &operator<<( const ustring &s );
+      XmlWriter &operator<<( const char *s );
+      XmlWriter &operator<<( int64_t i );
+      XmlWriter &operator<<( uint64_t i );
+      XmlWriter &operator<<( float f );
+      XmlWriter &operator<<( double d );
+
+      /// Write @a n spaces
+      XmlWriter &indent( int n );
+
+      /// Write what is still buffered to the file. Must be called when done, as destroying the
+      /// writer doesn't (so a failed write can't throw from a destructor).
+      void flush();
+
+   private:
+      void flushPages();
+
+      CheckedFile &cf_;
+
+      std::unique_ptr<char[]> buffer_;
+      size_t used_ = 0;
+
+      /// Offset of the start of buffer_ in its logical page
+      size_t pageOffset_ = 0;
+   };
+}
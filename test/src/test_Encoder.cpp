@@ -0,0 +1,137 @@
+// libE57Format testing Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "E57Format.h"
+#include "Encoder.h"
+
+namespace
+{
+   // Pack the values one record at a time, as BitpackIntegerEncoder did before it worked on blocks
+   // of records: LSB first into the register, which is written out each time it fills up.
+   template <typename RegisterT>
+   std::string packOneAtATime( const std::vector<int64_t> &inValues, int64_t inMinimum,
+                               unsigned inBitsPerRecord )
+   {
+      constexpr unsigned cRegisterBits = 8 * sizeof( RegisterT );
+
+      std::string packed;
+      RegisterT reg = 0;
+      unsigned bitsUsed = 0;
+
+      auto append = [&packed]( RegisterT inRegister ) {
+         char bytes[sizeof( RegisterT )];
+         memcpy( bytes, &inRegister, sizeof( RegisterT ) );
+         packed.append( bytes, sizeof( RegisterT ) );
+      };
+
+      for ( const int64_t value : inValues )
+      {
+         const auto uValue = static_cast<uint64_t>( value ) - static_cast<uint64_t>( inMinimum );
+         const unsigned newBitsUsed = bitsUsed + inBitsPerRecord;
+
+         reg |= static_cast<RegisterT>( static_cast<RegisterT>( uValue ) << bitsUsed );
+
+         if ( newBitsUsed > cRegisterBits )
+         {
+            append( reg );
+            reg = static_cast<RegisterT>( static_cast<RegisterT>( uValue ) >>
+                                          ( cRegisterBits - bitsUsed ) );
+            bitsUsed = newBitsUsed - cRegisterBits;
+         }
+         else if ( newBitsUsed == cRegisterBits )
+         {
+            append( reg );
+            reg = 0;
+            bitsUsed = 0;
+         }
+         else
+         {
+            bitsUsed = newBitsUsed;
+         }
+      }
+
+      if ( bitsUsed > 0 )
+      {
+         append( reg );
+      }
+
+      return packed;
+   }
+
+   // Encode the values with BitpackIntegerEncoder, handing them over in uneven batches so blocks
+   // (and the register) are split across calls to processRecords().
+   template <typename RegisterT>
+   std::string packInBlocks( e57::ImageFile &inImageFile, std::vector<int64_t> &inValues,
+                             int64_t inMinimum, int64_t inMaximum )
+   {
+      e57::SourceDestBuffer sbuf( inImageFile, "value", inValues.data(), inValues.size(), true );
+
+      std::shared_ptr<e57::Encoder> encoder( new e57::BitpackIntegerEncoder<RegisterT>(
+         false, 0, sbuf, inMinimum, inMaximum, 1.0, 0.0 ) );
+
+      std::vector<char> buffer( inValues.size() * sizeof( uint64_t ) + sizeof( uint64_t ) );
+      encoder->outputSetBuffer( buffer.data(), buffer.size() );
+
+      const size_t cBatches[] = { 1, 255, 300, 3, 256 };
+      size_t batch = 0;
+
+      while ( encoder->currentRecordIndex() < inValues.size() )
+      {
+         const size_t cRemaining = inValues.size() - encoder->currentRecordIndex();
+
+         encoder->processRecords( std::min( cRemaining, cBatches[batch++ % 5] ) );
+      }
+
+      EXPECT_TRUE( encoder->registerFlushToOutput() );
+
+      return { buffer.data(), encoder->outputAvailable() };
+   }
+
+   template <typename RegisterT> void testBitWidths( unsigned inFirstBits, unsigned inLastBits )
+   {
+      e57::ImageFile imf( "./BitpackIntegerEncoder.e57", "w" );
+
+      std::mt19937_64 generator( 42 );
+
+      for ( unsigned bits = inFirstBits; bits <= inLastBits; ++bits )
+      {
+         // An offset minimum, so the values are stored relative to it
+         const int64_t cMinimum = -5;
+         const int64_t cMaximum = cMinimum + static_cast<int64_t>( ( uint64_t( 1 ) << bits ) - 1 );
+
+         std::uniform_int_distribution<int64_t> distribution( cMinimum, cMaximum );
+
+         std::vector<int64_t> values( 1000 );
+
+         for ( auto &value : values )
+         {
+            value = distribution( generator );
+         }
+
+         // Include the extremes of the range
+         values[10] = cMinimum;
+         values[11] = cMaximum;
+
+         EXPECT_EQ( packInBlocks<RegisterT>( imf, values, cMinimum, cMaximum ),
+                    packOneAtATime<RegisterT>( values, cMinimum, bits ) )
+            << "bits=" << bits;
+      }
+
+      imf.cancel();
+   }
+}
+
+TEST( BitpackIntegerEncoder, SameAsPackingOneAtATime )
+{
+   testBitWidths<uint8_t>( 1, 8 );
+   testBitWidths<uint16_t>( 9, 16 );
+   testBitWidths<uint32_t>( 17, 32 );
+   // The range of a 64-bit field doesn't fit in an int64_t
+   testBitWidths<uint64_t>( 33, 63 );
+}
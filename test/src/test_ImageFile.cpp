@@ -0,0 +1,508 @@
+// libE57Format testing Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "E57Format.h"
+#include "E57SimpleReader.h"
+#include "E57SimpleWriter.h"
+
+#include "Helpers.h"
+
+TEST( ImageFile, CompiledPathLookup )
+{
+   e57::ImageFile imf( "./CompiledPathLookup.e57", "w" );
+
+   // Enough children for the structure's children to be indexed by name
+   e57::StructureNode fields( imf );
+   imf.root().set( "fields", fields );
+
+   for ( int i = 0; i < 40; ++i )
+   {
+      fields.set( "field" + std::to_string( i ), e57::IntegerNode( imf, i ) );
+   }
+
+   e57::VectorNode scans( imf, true );
+   imf.root().set( "scans", scans );
+
+   for ( int i = 0; i < 3; ++i )
+   {
+      e57::StructureNode pose( imf );
+      pose.set( "x", e57::FloatNode( imf, i * 0.5 ) );
+
+      e57::StructureNode scan( imf );
+      scan.set( "pose", pose );
+      scans.append( scan );
+   }
+
+   const e57::StructureNode scan( scans.get( 2 ) );
+
+   EXPECT_EQ( e57::IntegerNode( fields.get( "field39" ) ).value(), 39 );
+   EXPECT_EQ( e57::IntegerNode( fields.get( e57::CompiledPath( imf, "field7" ) ) ).value(), 7 );
+   EXPECT_EQ( e57::FloatNode( scans.get( "2/pose/x" ) ).value(), 1.0 );
+   EXPECT_EQ( e57::FloatNode( scan.get( e57::CompiledPath( imf, "pose/x" ) ) ).value(), 1.0 );
+
+   // Absolute paths are looked up from the root
+   const e57::CompiledPath absolutePath( imf, "/fields/field12" );
+   EXPECT_EQ( absolutePath.pathName(), "/fields/field12" );
+   EXPECT_EQ( e57::IntegerNode( scan.get( absolutePath ) ).value(), 12 );
+   EXPECT_EQ( scan.get( "/fields/field12" ).pathName(), "/fields/field12" );
+
+   // Children added after the index is built are found
+   fields.set( "late", e57::IntegerNode( imf, 100 ) );
+   EXPECT_TRUE( fields.isDefined( e57::CompiledPath( imf, "late" ) ) );
+   EXPECT_EQ( e57::IntegerNode( fields.get( "late" ) ).value(), 100 );
+
+   EXPECT_FALSE( fields.isDefined( "field40" ) );
+   EXPECT_FALSE( scans.isDefined( e57::CompiledPath( imf, "3/pose" ) ) );
+   EXPECT_FALSE( scans.isDefined( "02" ) );
+   EXPECT_FALSE( scan.isDefined( e57::CompiledPath( imf, "pose/x/y" ) ) );
+   EXPECT_THROW( scan.get( e57::CompiledPath( imf, "pose/y" ) ), e57::E57Exception );
+   EXPECT_THROW( fields.set( "field3", e57::IntegerNode( imf ) ), e57::E57Exception );
+   EXPECT_THROW( e57::CompiledPath( imf, "bad name" ), e57::E57Exception );
+
+   imf.close();
+}
+
+TEST( ImageFile, NodesOutliveClose )
+{
+   // Node handles kept after their ImageFile is closed and destroyed
+   std::vector<e57::Node> handles;
+
+   {
+      e57::ImageFile imf( "./NodesOutliveClose.e57", "w" );
+
+      e57::StructureNode scan( imf );
+      e57::StringNode name( imf, "Scan 0" );
+      e57::VectorNode names( imf, true );
+
+      scan.set( "name", name );
+      scan.set( "names", names );
+      imf.root().set( "scan", scan );
+
+      for ( int i = 0; i < 100; ++i )
+      {
+         names.append( e57::StringNode( imf, "Name " + std::to_string( i ) ) );
+      }
+
+      // A node which is never attached
+      const e57::StringNode unattached( imf, "Unattached" );
+
+      handles = { scan, name, names, unattached, names.get( 50 ) };
+
+      imf.close();
+
+      // The nodes can't be used once the file is closed
+      EXPECT_THROW( name.value(), e57::E57Exception );
+      EXPECT_THROW( names.childCount(), e57::E57Exception );
+   }
+
+   // Copying and releasing them after the ImageFile is gone is fine
+   std::vector<e57::Node> copies( handles );
+   handles.clear();
+   copies.pop_back();
+   copies.clear();
+
+   // The same for a file opened for reading, with the tree built as it's used
+   {
+      e57::ImageFileReadOptions options;
+      options.lazyNodeTree = true;
+
+      e57::ImageFile imf( "./NodesOutliveClose.e57", options );
+
+      const e57::StringNode name( imf.root().get( "/scan/name" ) );
+      EXPECT_EQ( name.value(), "Scan 0" );
+
+      const e57::VectorNode names( imf.root().get( "/scan/names" ) );
+      ASSERT_EQ( names.childCount(), 100 );
+      EXPECT_EQ( e57::StringNode( names.get( 99 ) ).value(), "Name 99" );
+
+      handles = { name, names, names.get( 10 ) };
+
+      imf.close();
+   }
+
+   handles.clear();
+}
+
+TEST( ImageFile, LargeNodeTree )
+{
+   constexpr int64_t cNumPoints = 20000;
+
+   auto buildTree = []( e57::ImageFile &imf ) {
+      e57::VectorNode points( imf, false );
+      imf.root().set( "points", points );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         e57::StructureNode point( imf );
+         point.set( "x", e57::FloatNode( imf, static_cast<double>( i ) ) );
+         point.set( "index", e57::IntegerNode( imf, i, 0, cNumPoints ) );
+         point.set( "label", e57::StringNode( imf, std::to_string( i ) ) );
+         points.append( point );
+
+         // Nodes which are made and dropped without being attached
+         e57::StructureNode( imf ).set( "y", e57::FloatNode( imf, 1.0 ) );
+      }
+   };
+
+   // Destroyed without being closed
+   {
+      e57::ImageFile imf( "./LargeNodeTree.e57", "w" );
+      E57_ASSERT_NO_THROW( buildTree( imf ) );
+   }
+
+   {
+      e57::ImageFile imf( "./LargeNodeTree.e57", "w" );
+      E57_ASSERT_NO_THROW( buildTree( imf ) );
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./LargeNodeTree.e57", "r" );
+
+   const e57::VectorNode points( imf.root().get( "points" ) );
+   ASSERT_EQ( points.childCount(), cNumPoints );
+
+   const e57::StructureNode last( points.get( cNumPoints - 1 ) );
+   EXPECT_EQ( e57::FloatNode( last.get( "x" ) ).value(), static_cast<double>( cNumPoints - 1 ) );
+   EXPECT_EQ( e57::IntegerNode( last.get( "index" ) ).value(), cNumPoints - 1 );
+   EXPECT_EQ( e57::StringNode( last.get( "label" ) ).value(), std::to_string( cNumPoints - 1 ) );
+
+   imf.close();
+}
+
+TEST( ImageFile, UpdateMetadata )
+{
+   constexpr int64_t cNumPoints = 4096;
+   const char *cFileName = "./UpdateMetadata.e57";
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Update Metadata File GUID";
+
+      e57::Writer writer( cFileName, options );
+
+      for ( int scan = 0; scan < 2; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Update Metadata Scan GUID " + std::to_string( scan );
+         header.name = "Scan " + std::to_string( scan );
+         header.pointCount = cNumPoints;
+         header.pose.translation.x = 1.0;
+
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         e57::Data3DPointsDouble pointsData( header );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.cartesianX[i] = static_cast<double>( i );
+            pointsData.cartesianY[i] = static_cast<double>( scan );
+            pointsData.cartesianZ[i] = 0.5;
+         }
+
+         writer.WriteData3DData( header, pointsData );
+      }
+   }
+
+   auto updateName = [&]( const e57::ustring &name, bool close ) {
+      e57::ImageFile imf( cFileName, "u" );
+
+      imf.root().replace( "/data3D/0/name", e57::StringNode( imf, name ) );
+
+      e57::StructureNode translation( imf.root().get( "/data3D/0/pose/translation" ) );
+      translation.replace( "x", e57::FloatNode( imf, 12.5 ) );
+
+      if ( close )
+      {
+         imf.close();
+      }
+   };
+
+   auto readScan = [&]( e57::Data3D &header, std::vector<double> &ys ) {
+      e57::Reader reader( cFileName, e57::ReaderOptions() );
+
+      ASSERT_EQ( reader.GetData3DCount(), 2 );
+      ASSERT_TRUE( reader.ReadData3D( 1, header ) );
+
+      e57::Data3DPointsDouble pointsData( header );
+      e57::CompressedVectorReader dataReader =
+         reader.SetUpData3DPointsData( 1, header.pointCount, pointsData );
+
+      ASSERT_EQ( dataReader.read(), static_cast<unsigned>( cNumPoints ) );
+      dataReader.close();
+
+      ys.assign( pointsData.cartesianY, pointsData.cartesianY + cNumPoints );
+
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+   };
+
+   // A longer XML section, then a shorter one (which truncates the file)
+   const e57::ustring longName( 5000, 'x' );
+
+   E57_ASSERT_NO_THROW( updateName( longName, true ) );
+
+   e57::Data3D header;
+   std::vector<double> ys;
+
+   E57_ASSERT_NO_THROW( readScan( header, ys ) );
+   EXPECT_EQ( header.name, longName );
+   EXPECT_EQ( header.pose.translation.x, 12.5 );
+   EXPECT_EQ( ys, std::vector<double>( cNumPoints, 1.0 ) );
+
+   E57_ASSERT_NO_THROW( updateName( "Renamed", true ) );
+
+   E57_ASSERT_NO_THROW( readScan( header, ys ) );
+   EXPECT_EQ( header.name, "Renamed" );
+   EXPECT_EQ( header.guid, "Update Metadata Scan GUID 0" );
+   EXPECT_EQ( ys, std::vector<double>( cNumPoints, 1.0 ) );
+
+   // Not closing the file leaves it unchanged
+   E57_ASSERT_NO_THROW( updateName( "Not Saved", false ) );
+
+   E57_ASSERT_NO_THROW( readScan( header, ys ) );
+   EXPECT_EQ( header.name, "Renamed" );
+
+   // A new blob is rejected before any space is allocated for it, so cancelling leaves the file's
+   // bytes as they were
+   auto fileContents = [&]() {
+      std::ifstream file( cFileName, std::ios::binary );
+
+      return std::string{ std::istreambuf_iterator<char>( file ),
+                          std::istreambuf_iterator<char>() };
+   };
+
+   const std::string contents = fileContents();
+
+   {
+      e57::ImageFile imf( cFileName, "u" );
+
+      EXPECT_TRUE( imf.isWritable() );
+      EXPECT_THROW( e57::BlobNode( imf, 4096 ), e57::E57Exception );
+
+      imf.cancel();
+   }
+
+   EXPECT_EQ( fileContents(), contents );
+
+   E57_ASSERT_NO_THROW( readScan( header, ys ) );
+   EXPECT_EQ( header.name, "Renamed" );
+
+   // Binary nodes and files opened for reading can't be changed
+   {
+      e57::ImageFile imf( cFileName, "u" );
+      e57::StructureNode root = imf.root();
+
+      EXPECT_THROW( root.replace( "/data3D/0/name", e57::FloatNode( imf, 1.0 ) ),
+                    e57::E57Exception );
+      EXPECT_THROW( root.replace( "/data3D/0/points", e57::StringNode( imf, "x" ) ),
+                    e57::E57Exception );
+      EXPECT_THROW( root.replace( "/data3D/0", e57::StructureNode( imf ) ), e57::E57Exception );
+
+      imf.close();
+   }
+   {
+      e57::ImageFile imf( cFileName, "r" );
+
+      EXPECT_THROW( imf.root().replace( "/data3D/0/name", e57::StringNode( imf, "x" ) ),
+                    e57::E57Exception );
+
+      imf.close();
+   }
+}
+
+TEST( ImageFile, CopySections )
+{
+   constexpr int64_t cNumPoints = 200000;
+   constexpr int cNumImages = 3;
+   constexpr size_t cImageSize = 1021; // not a multiple of 4, or of the page size
+
+   // Two files to merge. The first has normals, which use an extension.
+   for ( int file = 0; file < 2; ++file )
+   {
+      e57::WriterOptions options;
+      options.guid = "Copy Sections File GUID " + std::to_string( file );
+      options.dataPacketsPerIndexEntry = 1;
+
+      e57::Writer writer( "./CopySections" + std::to_string( file ) + ".e57", options );
+
+      e57::Data3D header;
+      header.guid = "Copy Sections Scan GUID " + std::to_string( file );
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.normalXField = ( file == 0 );
+      header.pointFields.normalYField = ( file == 0 );
+      header.pointFields.normalZField = ( file == 0 );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( file );
+         pointsData.cartesianZ[i] = 0.5;
+
+         if ( file == 0 )
+         {
+            pointsData.normalX[i] = 1.0f;
+            pointsData.normalY[i] = 0.0f;
+            pointsData.normalZ[i] = 0.0f;
+         }
+      }
+
+      writer.WriteData3DData( header, pointsData );
+
+      if ( file == 1 )
+      {
+         for ( int i = 0; i < cNumImages; ++i )
+         {
+            std::vector<uint8_t> png( cImageSize, static_cast<uint8_t>( i + 1 ) );
+
+            e57::Image2D imageHeader;
+            imageHeader.guid = "Copy Sections Image GUID " + std::to_string( i );
+            imageHeader.pinholeRepresentation.imageWidth = 4;
+            imageHeader.pinholeRepresentation.imageHeight = 4;
+            imageHeader.pinholeRepresentation.pngImageSize = cImageSize;
+
+            writer.WriteImage2DData( imageHeader, e57::ImagePNG, e57::ProjectionPinhole, 0,
+                                     png.data(), cImageSize );
+         }
+      }
+   }
+
+   // Merge the scans, and keep only the second image
+   {
+      e57::ImageFile first( "./CopySections0.e57", "r" );
+      e57::ImageFile second( "./CopySections1.e57", "r" );
+      e57::ImageFile dest( "./CopySections.e57", "w" );
+
+      for ( size_t i = 0; i < first.extensionsCount(); ++i )
+      {
+         dest.extensionsAdd( first.extensionsPrefix( i ), first.extensionsUri( i ) );
+      }
+
+      e57::StructureNode root = first.root();
+
+      for ( int64_t i = 0; i < root.childCount(); ++i )
+      {
+         e57::Node child = root.get( i );
+
+         if ( child.elementName() != "data3D" && child.elementName() != "images2D" )
+         {
+            dest.root().set( child.elementName(), dest.copyNode( child ) );
+         }
+      }
+
+      e57::VectorNode data3D( dest, true );
+      dest.root().set( "data3D", data3D );
+      data3D.append( dest.copyNode( first.root().get( "/data3D/0" ) ) );
+      data3D.append( dest.copyNode( second.root().get( "/data3D/0" ) ) );
+
+      e57::VectorNode images2D( dest, true );
+      dest.root().set( "images2D", images2D );
+      images2D.append( dest.copyNode( second.root().get( "/images2D/1" ) ) );
+
+      EXPECT_THROW( first.copyNode( dest.root() ), e57::E57Exception );
+
+      dest.close();
+      second.close();
+      first.close();
+   }
+
+   e57::Reader reader( "./CopySections.e57", e57::ReaderOptions() );
+
+   ASSERT_EQ( reader.GetData3DCount(), 2 );
+   ASSERT_EQ( reader.GetImage2DCount(), 1 );
+
+   for ( int scan = 0; scan < 2; ++scan )
+   {
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( scan, header ) );
+      EXPECT_EQ( header.guid, "Copy Sections Scan GUID " + std::to_string( scan ) );
+      EXPECT_EQ( header.pointFields.normalXField, ( scan == 0 ) );
+
+      e57::Data3DPointsDouble pointsData( header );
+      e57::CompressedVectorReader dataReader =
+         reader.SetUpData3DPointsData( scan, cNumPoints, pointsData );
+
+      ASSERT_EQ( dataReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      // The index packets point to where the data packets now are
+      for ( int64_t recordNumber : { 123456, 0, 199999 } )
+      {
+         dataReader.seek( recordNumber );
+         ASSERT_GT( dataReader.read(), 0U );
+         EXPECT_EQ( pointsData.cartesianX[0], static_cast<double>( recordNumber ) );
+         EXPECT_EQ( pointsData.cartesianY[0], static_cast<double>( scan ) );
+
+         if ( scan == 0 )
+         {
+            EXPECT_EQ( pointsData.normalX[0], 1.0f );
+         }
+      }
+
+      dataReader.close();
+   }
+
+   e57::Image2D imageHeader;
+   ASSERT_TRUE( reader.ReadImage2D( 0, imageHeader ) );
+   EXPECT_EQ( imageHeader.guid, "Copy Sections Image GUID 1" );
+
+   std::vector<uint8_t> png( cImageSize );
+   ASSERT_EQ( reader.ReadImage2DData( 0, e57::ProjectionPinhole, e57::ImagePNG, png.data(), 0,
+                                      cImageSize ),
+              static_cast<int64_t>( cImageSize ) );
+   EXPECT_EQ( png, std::vector<uint8_t>( cImageSize, 2 ) );
+}
+
+TEST( ImageFile, ParseXmlRepeatedly )
+{
+   // The XML parser's state (with Xerces, a pool of readers) is reused from one file to the next,
+   // including after a parse which failed
+   auto sink = std::make_shared<e57::MemoryImageFileSink>();
+
+   {
+      e57::ImageFile imf( sink );
+      imf.root().set( "value", e57::IntegerNode( imf, 42 ) );
+      imf.close();
+   }
+
+   const std::vector<char> good = sink->data();
+
+   // Break the XML section with an end tag which doesn't match
+   std::vector<char> bad = good;
+   const std::string cEndTag = "</e57Root>";
+   auto endTag = std::search( bad.begin(), bad.end(), cEndTag.begin(), cEndTag.end() );
+   ASSERT_TRUE( endTag != bad.end() );
+   *( endTag + 2 ) = 'x';
+
+   for ( const bool validate : { true, false } )
+   {
+      e57::ImageFileReadOptions options;
+      options.checksumPolicy = e57::ChecksumNone;
+      options.validateXml = validate;
+
+      auto readValue = [&]( const std::vector<char> &inData ) {
+         e57::ImageFile imf( inData.data(), inData.size(), options );
+         const int64_t value = e57::IntegerNode( imf.root().get( "value" ) ).value();
+         imf.close();
+         return value;
+      };
+
+      EXPECT_EQ( readValue( good ), 42 );
+      EXPECT_EQ( readValue( good ), 42 );
+
+      EXPECT_THROW( readValue( bad ), e57::E57Exception );
+
+      EXPECT_EQ( readValue( good ), 42 );
+   }
+}
@@ -4,6 +4,7 @@
 #include "gtest/gtest.h"
 
 #include "E57SimpleReader.h"
+#include "E57SimpleWriter.h"
 
 #include "Helpers.h"
 #include "TestData.h"
@@ -166,6 +167,28 @@ TEST( SimpleReaderData, DoNotCheckCRC )
       e57::Reader( TestData::Path() + "/self/bad-crc.e57", { e57::ChecksumNone } ) );
 }
 
+TEST( SimpleReaderData, DoNotValidateXml )
+{
+   e57::ReaderOptions options;
+   options.validateXml = false;
+
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW(
+      reader = new e57::Reader( TestData::Path() + "/self/ColouredCubeFloat.e57", options ) );
+
+   ASSERT_TRUE( reader->IsOpen() );
+   ASSERT_EQ( reader->GetData3DCount(), 1 );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   EXPECT_EQ( data3DHeader.pointCount, 7'680 );
+   EXPECT_EQ( data3DHeader.guid, "Coloured Cube Float Scan Header GUID" );
+
+   delete reader;
+}
+
 // https://github.com/asmaloney/libE57Format/issues/26
 TEST( SimpleReaderData, ChineseFileName )
 {
@@ -368,3 +391,158 @@ TEST( SimpleReaderData, ColourRepresentation )
 
    delete reader;
 }
+
+TEST( SimpleReader, ReadLazyNodeTree )
+{
+   constexpr int cNumScans = 3;
+   constexpr int64_t cNumPoints = 64;
+
+   e57::WriterOptions options;
+   options.guid = "Lazy Node Tree File GUID";
+
+   {
+      e57::Writer writer( "./ReadLazyNodeTree.e57", options );
+
+      for ( int scan = 0; scan < cNumScans; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Lazy Node Tree Scan GUID " + std::to_string( scan );
+         header.name = "Scan <" + std::to_string( scan ) + "> & more";
+         header.pointCount = cNumPoints;
+         header.pose.translation.x = scan;
+
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         e57::Data3DPointsDouble pointsData( header );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.cartesianX[i] = static_cast<double>( i );
+            pointsData.cartesianY[i] = static_cast<double>( scan );
+            pointsData.cartesianZ[i] = 0.5;
+         }
+
+         writer.WriteData3DData( header, pointsData );
+      }
+   }
+
+   // Read the middle scan with the node tree built as it is used, and compare with a normal read
+   auto readScan = [&]( bool lazy, e57::Data3D &header, std::vector<double> &ys ) {
+      e57::ReaderOptions readOptions;
+      readOptions.lazyNodeTree = lazy;
+
+      e57::Reader reader( "./ReadLazyNodeTree.e57", readOptions );
+
+      ASSERT_EQ( reader.GetData3DCount(), cNumScans );
+      ASSERT_TRUE( reader.ReadData3D( 1, header ) );
+
+      e57::Data3DPointsDouble pointsData( header );
+      e57::CompressedVectorReader dataReader =
+         reader.SetUpData3DPointsData( 1, header.pointCount, pointsData );
+
+      ASSERT_EQ( dataReader.read(), static_cast<unsigned>( cNumPoints ) );
+      dataReader.close();
+
+      ys.assign( pointsData.cartesianY, pointsData.cartesianY + cNumPoints );
+   };
+
+   e57::Data3D header;
+   e57::Data3D lazyHeader;
+   std::vector<double> ys;
+   std::vector<double> lazyYs;
+
+   E57_ASSERT_NO_THROW( readScan( false, header, ys ) );
+   E57_ASSERT_NO_THROW( readScan( true, lazyHeader, lazyYs ) );
+
+   EXPECT_EQ( lazyHeader.guid, header.guid );
+   EXPECT_EQ( lazyHeader.name, "Scan <1> & more" );
+   EXPECT_EQ( lazyHeader.pose.translation.x, 1.0 );
+   EXPECT_EQ( lazyHeader.pointCount, cNumPoints );
+   EXPECT_EQ( lazyYs, ys );
+   EXPECT_EQ( lazyYs.front(), 1.0 );
+}
+
+TEST( SimpleReader, ReadHeaders )
+{
+   constexpr int cNumScans = 4;
+   constexpr int cNumImages = 6;
+
+   e57::WriterOptions options;
+   options.guid = "Read Headers File GUID";
+
+   {
+      e57::Writer writer( "./ReadHeaders.e57", options );
+
+      for ( int i = 0; i < cNumScans; ++i )
+      {
+         e57::Data3D header;
+         header.guid = "Read Headers Scan GUID " + std::to_string( i );
+         header.name = "Scan " + std::to_string( i );
+         header.pose.translation.x = i;
+
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         writer.NewData3D( header );
+      }
+
+      uint8_t png[16] = {};
+
+      for ( int i = 0; i < cNumImages; ++i )
+      {
+         e57::Image2D header;
+         header.guid = "Read Headers Image GUID " + std::to_string( i );
+         header.associatedData3DGuid = "Read Headers Scan GUID " + std::to_string( i % 2 );
+         header.pinholeRepresentation.imageWidth = 4;
+         header.pinholeRepresentation.imageHeight = 4;
+         header.pinholeRepresentation.pngImageSize = sizeof( png );
+         header.pinholeRepresentation.focalLength = 0.01 * i;
+
+         writer.WriteImage2DData( header, e57::ImagePNG, e57::ProjectionPinhole, 0, png,
+                                  sizeof( png ) );
+      }
+   }
+
+   for ( bool lazy : { false, true } )
+   {
+      e57::ReaderOptions readOptions;
+      readOptions.lazyNodeTree = lazy;
+
+      for ( unsigned threads : { 1, 3 } )
+      {
+         e57::Reader reader( "./ReadHeaders.e57", readOptions );
+
+         e57::E57Headers headers;
+         ASSERT_TRUE( reader.ReadHeaders( headers, threads ) );
+
+         EXPECT_EQ( headers.root.guid, options.guid );
+         ASSERT_EQ( headers.data3D.size(), static_cast<size_t>( cNumScans ) );
+         ASSERT_EQ( headers.images2D.size(), static_cast<size_t>( cNumImages ) );
+
+         for ( int i = 0; i < cNumScans; ++i )
+         {
+            e57::Data3D header;
+            ASSERT_TRUE( reader.ReadData3D( i, header ) );
+
+            EXPECT_EQ( headers.data3D[i].guid, header.guid );
+            EXPECT_EQ( headers.data3D[i].name, "Scan " + std::to_string( i ) );
+            EXPECT_EQ( headers.data3D[i].pose, header.pose );
+            EXPECT_TRUE( headers.data3D[i].pointFields.cartesianZField );
+         }
+
+         for ( int i = 0; i < cNumImages; ++i )
+         {
+            e57::Image2D header;
+            ASSERT_TRUE( reader.ReadImage2D( i, header ) );
+
+            EXPECT_EQ( headers.images2D[i].guid, header.guid );
+            EXPECT_EQ( headers.images2D[i].associatedData3DGuid, header.associatedData3DGuid );
+            EXPECT_EQ( headers.images2D[i].pinholeRepresentation, header.pinholeRepresentation );
+            EXPECT_EQ( headers.images2D[i].pinholeRepresentation.focalLength, 0.01 * i );
+         }
+      }
+   }
+}
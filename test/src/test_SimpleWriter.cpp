@@ -3,9 +3,12 @@
 
 #include <array>
 #include <fstream>
+#include <iterator>
+#include <thread>
 
 #include "gtest/gtest.h"
 
+#include "E57SimpleReader.h"
 #include "E57SimpleWriter.h"
 
 #include "Helpers.h"
@@ -738,4 +741,1088 @@ TEST( SimpleWriter, PacketWriteIndexFlag )
    }
 
    delete writer;
-}
\ No newline at end of file
+}
+
+TEST( SimpleWriter, EncoderThreadsSameFile )
+{
+   // Write the same scan using one and several encoder threads - the files must be identical.
+   auto writeCube = []( const std::string &inFileName, unsigned inThreadCount ) {
+      Random::seed( 42 );
+
+      e57::WriterOptions options;
+      options.guid = "Encoder Threads File GUID";
+      options.encoderThreadCount = inThreadCount;
+
+      e57::Writer writer( inFileName, options );
+
+      constexpr uint16_t cNumPointsPerFace = 12800;
+      constexpr uint32_t cNumPoints = cNumPointsPerFace * cNumCubeFaces;
+
+      e57::Data3D header;
+      header.guid = "Encoder Threads Scan Header GUID";
+      header.pointCount = cNumPoints;
+
+      setUsingColouredCartesianPoints( header );
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      int64_t i = 0;
+      auto writePointLambda = [&]( uint8_t inFace, const Point &inPoint ) {
+         fillColouredCartesianPoint( pointsData, i, inFace, inPoint );
+         ++i;
+      };
+
+      generateCubePoints( 1.0, cNumPointsPerFace, writePointLambda );
+
+      writer.WriteData3DData( header, pointsData );
+   };
+
+   E57_ASSERT_NO_THROW( writeCube( "./EncoderThreads1.e57", 1 ) );
+   E57_ASSERT_NO_THROW( writeCube( "./EncoderThreads4.e57", 4 ) );
+
+   std::ifstream file1( "./EncoderThreads1.e57", std::ios::binary );
+   std::ifstream file4( "./EncoderThreads4.e57", std::ios::binary );
+
+   const std::string contents1{ std::istreambuf_iterator<char>( file1 ),
+                                std::istreambuf_iterator<char>() };
+   const std::string contents4{ std::istreambuf_iterator<char>( file4 ),
+                                std::istreambuf_iterator<char>() };
+
+   ASSERT_FALSE( contents1.empty() );
+   EXPECT_TRUE( contents1 == contents4 );
+}
+
+TEST( SimpleWriter, WritePacketsInBackgroundSameFile )
+{
+   // Write the same scan with data packets written on the calling thread and in the background -
+   // the files must be identical.
+   auto writeCube = []( const std::string &inFileName, bool inWritePacketsInBackground ) {
+      Random::seed( 42 );
+
+      e57::WriterOptions options;
+      options.guid = "Background Packets File GUID";
+      options.writePacketsInBackground = inWritePacketsInBackground;
+
+      e57::Writer writer( inFileName, options );
+
+      constexpr uint16_t cNumPointsPerFace = 12800;
+      constexpr uint32_t cNumPoints = cNumPointsPerFace * cNumCubeFaces;
+
+      e57::Data3D header;
+      header.guid = "Background Packets Scan Header GUID";
+      header.pointCount = cNumPoints;
+
+      setUsingColouredCartesianPoints( header );
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      int64_t i = 0;
+      auto writePointLambda = [&]( uint8_t inFace, const Point &inPoint ) {
+         fillColouredCartesianPoint( pointsData, i, inFace, inPoint );
+         ++i;
+      };
+
+      generateCubePoints( 1.0, cNumPointsPerFace, writePointLambda );
+
+      writer.WriteData3DData( header, pointsData );
+   };
+
+   E57_ASSERT_NO_THROW( writeCube( "./BackgroundPacketsOff.e57", false ) );
+   E57_ASSERT_NO_THROW( writeCube( "./BackgroundPacketsOn.e57", true ) );
+
+   std::ifstream fileOff( "./BackgroundPacketsOff.e57", std::ios::binary );
+   std::ifstream fileOn( "./BackgroundPacketsOn.e57", std::ios::binary );
+
+   const std::string contentsOff{ std::istreambuf_iterator<char>( fileOff ),
+                                  std::istreambuf_iterator<char>() };
+   const std::string contentsOn{ std::istreambuf_iterator<char>( fileOn ),
+                                 std::istreambuf_iterator<char>() };
+
+   ASSERT_FALSE( contentsOff.empty() );
+   EXPECT_TRUE( contentsOff == contentsOn );
+}
+
+TEST( SimpleWriter, DestroyUnclosedWriter )
+{
+   constexpr int64_t cNumPoints = 200000;
+
+   // Drop the CompressedVectorWriter without closing it, while packets are still being written in
+   // the background. Its destructor must close it and wait for them before freeing its buffers.
+   {
+      e57::WriterOptions options;
+      options.guid = "Unclosed Writer File GUID";
+      options.writePacketsInBackground = true;
+
+      e57::Writer writer( "./DestroyUnclosedWriter.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Unclosed Writer Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = 1.0;
+         pointsData.cartesianZ[i] = 0.5;
+      }
+
+      const int64_t scanIndex = writer.NewData3D( header );
+
+      {
+         e57::CompressedVectorWriter dataWriter =
+            writer.SetUpData3DPointsData( scanIndex, cNumPoints, pointsData );
+
+         dataWriter.write( cNumPoints );
+      }
+
+      writer.Close();
+   }
+
+   e57::Reader reader( "./DestroyUnclosedWriter.e57", e57::ReaderOptions() );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+   ASSERT_EQ( header.pointCount, cNumPoints );
+
+   e57::Data3DPointsDouble pointsData( header );
+   e57::CompressedVectorReader dataReader =
+      reader.SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   ASSERT_EQ( dataReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   dataReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( pointsData.cartesianX[i], static_cast<double>( i ) );
+      ASSERT_EQ( pointsData.cartesianY[i], 1.0 );
+   }
+}
+
+TEST( SimpleWriter, SeekUsingIndex )
+{
+   constexpr int64_t cNumPoints = 200000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Seek Using Index File GUID";
+      options.dataPacketsPerIndexEntry = 1;
+
+      e57::Writer writer( "./SeekUsingIndex.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Seek Using Index Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      // Integer and ScaledInteger fields of several widths, packed into 8, 16, 32 & 64 bit
+      // registers, which must also end cleanly at each chunk boundary
+      header.pointFields.returnIndexField = true;
+      header.pointFields.returnMaximum = 3;
+
+      header.pointFields.rowIndexField = true;
+      header.pointFields.rowIndexMaximum = cNumPoints - 1;
+
+      header.pointFields.intensityField = true;
+      header.pointFields.intensityNodeType = e57::NumericalNodeType::ScaledInteger;
+      header.pointFields.intensityScale = 0.25;
+      header.intensityLimits.intensityMinimum = 0.0;
+      header.intensityLimits.intensityMaximum = 1000.0;
+
+      header.pointFields.timeStampField = true;
+      header.pointFields.timeNodeType = e57::NumericalNodeType::Integer;
+      header.pointFields.timeMinimum = 0.0;
+      header.pointFields.timeMaximum = 1099511627776.0; // 2^40
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( -i );
+         pointsData.cartesianZ[i] = 0.5;
+         pointsData.returnIndex[i] = static_cast<int8_t>( i % 4 );
+         pointsData.rowIndex[i] = static_cast<int32_t>( i );
+         pointsData.intensity[i] = static_cast<double>( i % 4001 ) * 0.25;
+         pointsData.timeStamp[i] = static_cast<double>( i * 5000000 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::ImageFile imf( "./SeekUsingIndex.e57", "r" );
+
+   e57::StructureNode scan( e57::VectorNode( imf.root().get( "/data3D" ) ).get( 0 ) );
+   e57::CompressedVectorNode points( scan.get( "points" ) );
+
+   constexpr size_t cBufferSize = 1000;
+   std::vector<double> x( cBufferSize );
+   std::vector<double> y( cBufferSize );
+   std::vector<int8_t> returnIndex( cBufferSize );
+   std::vector<int32_t> rowIndex( cBufferSize );
+   std::vector<double> intensity( cBufferSize );
+   std::vector<int64_t> timeStamp( cBufferSize );
+
+   std::vector<e57::SourceDestBuffer> buffers;
+   buffers.emplace_back( imf, "cartesianX", x.data(), cBufferSize, true );
+   buffers.emplace_back( imf, "cartesianY", y.data(), cBufferSize, true );
+   buffers.emplace_back( imf, "returnIndex", returnIndex.data(), cBufferSize, true );
+   buffers.emplace_back( imf, "rowIndex", rowIndex.data(), cBufferSize, true );
+   buffers.emplace_back( imf, "intensity", intensity.data(), cBufferSize, true, true );
+   buffers.emplace_back( imf, "timeStamp", timeStamp.data(), cBufferSize, true );
+
+   e57::CompressedVectorReader reader = points.reader( buffers );
+
+   for ( int64_t recordNumber : { 123456, 0, 199999, 77, 100000, 150001 } )
+   {
+      reader.seek( recordNumber );
+
+      const auto cExpectedCount =
+         static_cast<unsigned>( std::min<int64_t>( cBufferSize, cNumPoints - recordNumber ) );
+      ASSERT_EQ( reader.read(), cExpectedCount );
+
+      for ( unsigned i = 0; i < cExpectedCount; ++i )
+      {
+         const int64_t cRecord = recordNumber + i;
+
+         ASSERT_EQ( x[i], static_cast<double>( cRecord ) );
+         ASSERT_EQ( y[i], static_cast<double>( -cRecord ) );
+         ASSERT_EQ( returnIndex[i], cRecord % 4 );
+         ASSERT_EQ( rowIndex[i], cRecord );
+         ASSERT_EQ( intensity[i], static_cast<double>( cRecord % 4001 ) * 0.25 );
+         ASSERT_EQ( timeStamp[i], cRecord * 5000000 );
+      }
+   }
+
+   reader.seek( cNumPoints );
+   EXPECT_EQ( reader.read(), 0U );
+
+   reader.close();
+   imf.close();
+}
+
+TEST( SimpleWriter, FitIntegerRangesToData )
+{
+   constexpr int64_t cNumPoints = 10000;
+
+   auto writeFile = []( const std::string &fileName, bool fitRanges ) {
+      e57::WriterOptions options;
+      options.guid = "Fit Integer Ranges File GUID";
+      options.fitIntegerRangesToData = fitRanges;
+
+      e57::Writer writer( fileName, options );
+
+      e57::Data3D header;
+      header.guid = "Fit Integer Ranges Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+      header.pointFields.pointRangeScale = 0.001;
+      header.pointFields.pointRangeMinimum = -10000.0;
+      header.pointFields.pointRangeMaximum = 10000.0;
+      header.pointFields.intensityField = true;
+      header.pointFields.intensityNodeType = e57::NumericalNodeType::Integer;
+      header.intensityLimits.intensityMinimum = 0.0;
+      header.intensityLimits.intensityMaximum = 65535.0;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i ) * 0.01;
+         pointsData.cartesianY[i] = 1.0;
+         pointsData.cartesianZ[i] = -static_cast<double>( i % 100 ) * 0.001;
+         pointsData.intensity[i] = static_cast<double>( 100 + ( i % 16 ) );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   };
+
+   E57_ASSERT_NO_THROW( writeFile( "./FitIntegerRangesDeclared.e57", false ) );
+   E57_ASSERT_NO_THROW( writeFile( "./FitIntegerRangesFitted.e57", true ) );
+
+   e57::ImageFile declaredImf( "./FitIntegerRangesDeclared.e57", "r" );
+   e57::ImageFile fittedImf( "./FitIntegerRangesFitted.e57", "r" );
+
+   auto pointsNode = []( const e57::ImageFile &imf ) {
+      e57::StructureNode scan( e57::VectorNode( imf.root().get( "/data3D" ) ).get( 0 ) );
+      return e57::CompressedVectorNode( scan.get( "points" ) );
+   };
+
+   e57::CompressedVectorNode declaredPoints = pointsNode( declaredImf );
+   e57::CompressedVectorNode fittedPoints = pointsNode( fittedImf );
+
+   // Tighter ranges need fewer bits per record
+   e57::StructureNode declaredProto( declaredPoints.prototype() );
+   e57::StructureNode fittedProto( fittedPoints.prototype() );
+
+   e57::ScaledIntegerNode fittedY( fittedProto.get( "cartesianY" ) );
+   EXPECT_EQ( fittedY.minimum(), fittedY.maximum() );
+
+   e57::IntegerNode declaredIntensity( declaredProto.get( "intensity" ) );
+   e57::IntegerNode fittedIntensity( fittedProto.get( "intensity" ) );
+   EXPECT_EQ( declaredIntensity.maximum(), 65535 );
+   EXPECT_EQ( fittedIntensity.minimum(), 100 );
+   EXPECT_EQ( fittedIntensity.maximum(), 115 );
+
+   // The values read back are the same
+   std::vector<double> x( cNumPoints );
+   std::vector<double> y( cNumPoints );
+   std::vector<double> intensity( cNumPoints );
+
+   std::vector<e57::SourceDestBuffer> buffers;
+   buffers.emplace_back( fittedImf, "cartesianX", x.data(), cNumPoints, true, true );
+   buffers.emplace_back( fittedImf, "cartesianY", y.data(), cNumPoints, true, true );
+   buffers.emplace_back( fittedImf, "intensity", intensity.data(), cNumPoints, true );
+
+   e57::CompressedVectorReader reader = fittedPoints.reader( buffers );
+   ASSERT_EQ( reader.read(), static_cast<unsigned>( cNumPoints ) );
+   reader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_NEAR( x[i], static_cast<double>( i ) * 0.01, 0.0005 );
+      ASSERT_NEAR( y[i], 1.0, 0.0005 );
+      ASSERT_EQ( intensity[i], static_cast<double>( 100 + ( i % 16 ) ) );
+   }
+
+   declaredImf.close();
+   fittedImf.close();
+}
+
+TEST( SimpleWriter, WriteConstantFieldsAsConstant )
+{
+   constexpr int64_t cNumPoints = 1000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Constant Fields File GUID";
+      options.writeConstantFieldsAsConstant = true;
+
+      e57::Writer writer( "./WriteConstantFieldsAsConstant.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Constant Fields Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+      header.pointFields.pointRangeScale = 0.001;
+      header.pointFields.returnIndexField = true;
+      header.pointFields.returnCountField = true;
+      header.pointFields.returnMaximum = 7;
+      header.pointFields.rowIndexField = true;
+      header.pointFields.rowIndexMaximum = 5000;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = 0.0;
+         pointsData.cartesianZ[i] = 2.5;
+         pointsData.returnIndex[i] = 0;
+         pointsData.returnCount[i] = 1;
+         pointsData.rowIndex[i] = static_cast<int32_t>( i );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::ImageFile imf( "./WriteConstantFieldsAsConstant.e57", "r" );
+
+   e57::StructureNode scan( e57::VectorNode( imf.root().get( "/data3D" ) ).get( 0 ) );
+   e57::CompressedVectorNode points( scan.get( "points" ) );
+   e57::StructureNode proto( points.prototype() );
+
+   e57::IntegerNode returnIndex( proto.get( "returnIndex" ) );
+   EXPECT_EQ( returnIndex.minimum(), 0 );
+   EXPECT_EQ( returnIndex.maximum(), 0 );
+
+   e57::IntegerNode returnCount( proto.get( "returnCount" ) );
+   EXPECT_EQ( returnCount.minimum(), 1 );
+   EXPECT_EQ( returnCount.maximum(), 1 );
+
+   // ScaledInteger fields get the raw value, written from scaled values
+   e57::ScaledIntegerNode cartesianZ( proto.get( "cartesianZ" ) );
+   EXPECT_EQ( cartesianZ.minimum(), 2500 );
+   EXPECT_EQ( cartesianZ.maximum(), 2500 );
+   EXPECT_EQ( cartesianZ.scale(), 0.001 );
+
+   // Fields with more than one value keep the declared range
+   e57::IntegerNode rowIndex( proto.get( "rowIndex" ) );
+   EXPECT_EQ( rowIndex.minimum(), 0 );
+   EXPECT_EQ( rowIndex.maximum(), 5000 );
+
+   std::vector<int32_t> returnCounts( cNumPoints );
+   std::vector<int32_t> rowIndices( cNumPoints );
+   std::vector<double> zs( cNumPoints );
+
+   std::vector<e57::SourceDestBuffer> buffers;
+   buffers.emplace_back( imf, "returnCount", returnCounts.data(), cNumPoints, true );
+   buffers.emplace_back( imf, "rowIndex", rowIndices.data(), cNumPoints, true );
+   buffers.emplace_back( imf, "cartesianZ", zs.data(), cNumPoints, true, true );
+
+   e57::CompressedVectorReader reader = points.reader( buffers );
+   ASSERT_EQ( reader.read(), static_cast<unsigned>( cNumPoints ) );
+   reader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( returnCounts[i], 1 );
+      ASSERT_EQ( rowIndices[i], static_cast<int32_t>( i ) );
+      ASSERT_DOUBLE_EQ( zs[i], 2.5 );
+   }
+
+   imf.close();
+}
+
+TEST( SimpleWriter, DataPacketStatistics )
+{
+   constexpr int64_t cNumPoints = 500000;
+
+   e57::WriterOptions options;
+   options.guid = "Data Packet Statistics File GUID";
+
+   e57::Writer writer( "./DataPacketStatistics.e57", options );
+
+   e57::Data3D header;
+   header.guid = "Data Packet Statistics Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Integer;
+   header.intensityLimits.intensityMinimum = 0.0;
+   header.intensityLimits.intensityMaximum = 4095.0;
+
+   e57::Data3DPointsFloat pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const auto cValue = static_cast<float>( i );
+
+      pointsData.cartesianX[i] = cValue;
+      pointsData.cartesianY[i] = -cValue;
+      pointsData.cartesianZ[i] = cValue * 0.5f;
+      pointsData.intensity[i] = static_cast<float>( i % 4096 );
+   }
+
+   const int64_t scanIndex = writer.NewData3D( header );
+
+   e57::CompressedVectorWriter dataWriter =
+      writer.SetUpData3DPointsData( scanIndex, cNumPoints, pointsData );
+
+   dataWriter.write( cNumPoints );
+   dataWriter.close();
+
+   const e57::CompressedVectorWriterStatistics stats = dataWriter.statistics();
+
+   EXPECT_EQ( stats.recordCount, static_cast<uint64_t>( cNumPoints ) );
+   EXPECT_GE( stats.indexPacketCount, 1U );
+
+   // 13.5 bytes per record, which is just over 103 full packets
+   EXPECT_GE( stats.dataPacketBytes, static_cast<uint64_t>( cNumPoints ) * 27 / 2 );
+   EXPECT_GE( stats.dataPacketCount, 103U );
+
+   // Only the last packet is allowed to be much less than full
+   EXPECT_LE( stats.dataPacketCount, 105U );
+   EXPECT_GT( stats.averageDataPacketFill, 0.98 );
+   EXPECT_LE( stats.averageDataPacketFill, 1.0 );
+
+   writer.Close();
+}
+
+TEST( SimpleWriter, StreamData3DInChunks )
+{
+   constexpr size_t cChunkCapacity = 1000;
+   constexpr size_t cChunkSizes[] = { 1000, 1, 517, 0, 999, 1000, 250 };
+
+   e57::WriterOptions options;
+   options.guid = "Stream Data3D File GUID";
+
+   e57::Writer writer( "./StreamData3DInChunks.e57", options );
+
+   e57::Data3D header;
+   header.guid = "Stream Data3D Scan Header GUID";
+   header.pointCount = cChunkCapacity; // only used to allocate the buffers
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Float;
+
+   e57::Data3DPointsFloat pointsData( header );
+
+   e57::Data3DStreamWriter stream = writer.NewData3DStream( header );
+
+   uint64_t pointCount = 0;
+
+   for ( const size_t cChunkSize : cChunkSizes )
+   {
+      for ( size_t i = 0; i < cChunkSize; ++i )
+      {
+         const auto cValue = static_cast<float>( pointCount + i );
+
+         pointsData.cartesianX[i] = cValue;
+         pointsData.cartesianY[i] = -cValue;
+         pointsData.cartesianZ[i] = 1.5f;
+         pointsData.intensity[i] = static_cast<double>( ( pointCount + i ) % 100 ) / 100.0;
+      }
+
+      stream.Append( pointsData, cChunkSize );
+
+      pointCount += cChunkSize;
+   }
+
+   EXPECT_EQ( stream.PointCount(), pointCount );
+
+   const int64_t scanIndex = stream.Close();
+
+   EXPECT_FALSE( stream.IsOpen() );
+   EXPECT_THROW( stream.Append( pointsData, 1 ), e57::E57Exception );
+
+   const e57::Data3D &streamHeader = stream.Header();
+   const auto cLastValue = static_cast<double>( pointCount - 1 );
+
+   EXPECT_EQ( streamHeader.pointCount, pointCount );
+   EXPECT_EQ( streamHeader.cartesianBounds.xMinimum, 0.0 );
+   EXPECT_EQ( streamHeader.cartesianBounds.xMaximum, cLastValue );
+   EXPECT_EQ( streamHeader.cartesianBounds.yMinimum, -cLastValue );
+   EXPECT_EQ( streamHeader.cartesianBounds.yMaximum, 0.0 );
+   EXPECT_EQ( streamHeader.cartesianBounds.zMinimum, 1.5 );
+   EXPECT_EQ( streamHeader.cartesianBounds.zMaximum, 1.5 );
+   EXPECT_EQ( streamHeader.intensityLimits.intensityMinimum, 0.0 );
+   EXPECT_FLOAT_EQ( streamHeader.intensityLimits.intensityMaximum, 0.99 );
+
+   // Read the points back while the file is still open
+   const e57::StructureNode scan( writer.GetRawData3D().get( scanIndex ) );
+   e57::CompressedVectorNode points( scan.get( "points" ) );
+
+   EXPECT_TRUE( scan.isDefined( "cartesianBounds" ) );
+   EXPECT_TRUE( scan.isDefined( "intensityLimits" ) );
+   EXPECT_EQ( points.childCount(), static_cast<int64_t>( pointCount ) );
+
+   std::vector<float> x( cChunkCapacity );
+   std::vector<e57::SourceDestBuffer> readBuffers;
+   readBuffers.emplace_back( writer.GetRawIMF(), "cartesianX", x.data(), cChunkCapacity, true );
+
+   e57::CompressedVectorReader reader = points.reader( readBuffers );
+
+   uint64_t readCount = 0;
+   unsigned count = 0;
+
+   while ( ( count = reader.read() ) > 0 )
+   {
+      for ( unsigned i = 0; i < count; ++i )
+      {
+         ASSERT_EQ( x[i], static_cast<float>( readCount + i ) );
+      }
+
+      readCount += count;
+   }
+
+   reader.close();
+
+   EXPECT_EQ( readCount, pointCount );
+
+   // A ScaledInteger field can't be streamed without its range
+   e57::Data3D scaledHeader = header;
+   scaledHeader.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+
+   EXPECT_THROW( writer.NewData3DStream( scaledHeader ), e57::E57Exception );
+
+   writer.Close();
+}
+
+TEST( SimpleWriter, BoundsComputedWhileWriting )
+{
+   constexpr int64_t cNumPoints = 10000;
+   constexpr int64_t cInvalidPoint = 1234;
+
+   e57::WriterOptions options;
+   options.guid = "Bounds Computed File GUID";
+
+   e57::Writer writer( "./BoundsComputedWhileWriting.e57", options );
+
+   e57::Data3D header;
+   header.guid = "Bounds Computed Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.pointRangeScale = 0.001;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Double;
+   header.pointFields.rowIndexField = true;
+   header.pointFields.rowIndexMaximum = cNumPoints;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const auto cValue = static_cast<double>( i ) / 100.0;
+
+      pointsData.cartesianX[i] = cValue;
+      pointsData.cartesianY[i] = -cValue;
+      pointsData.cartesianZ[i] = 2.0;
+      pointsData.cartesianInvalidState[i] = 0;
+      pointsData.intensity[i] = static_cast<double>( i % 10 );
+      pointsData.rowIndex[i] = static_cast<int32_t>( i / 2 );
+   }
+
+   // This point's coordinates are meaningless, so they aren't part of the bounds
+   pointsData.cartesianZ[cInvalidPoint] = -500.0;
+   pointsData.cartesianInvalidState[cInvalidPoint] = 2;
+
+   const int64_t scanIndex = writer.WriteData3DData( header, pointsData );
+
+   const auto cLastValue = static_cast<double>( cNumPoints - 1 ) / 100.0;
+
+   EXPECT_NEAR( header.cartesianBounds.xMinimum, 0.0, 0.001 );
+   EXPECT_NEAR( header.cartesianBounds.xMaximum, cLastValue, 0.001 );
+   EXPECT_NEAR( header.cartesianBounds.yMinimum, -cLastValue, 0.001 );
+   EXPECT_NEAR( header.cartesianBounds.yMaximum, 0.0, 0.001 );
+   EXPECT_EQ( header.cartesianBounds.zMinimum, 2.0 );
+   EXPECT_EQ( header.cartesianBounds.zMaximum, 2.0 );
+
+   EXPECT_EQ( header.intensityLimits.intensityMinimum, 0.0 );
+   EXPECT_EQ( header.intensityLimits.intensityMaximum, 9.0 );
+
+   EXPECT_EQ( header.indexBounds.rowMinimum, 0 );
+   EXPECT_EQ( header.indexBounds.rowMaximum, ( cNumPoints - 1 ) / 2 );
+
+   const e57::StructureNode scan( writer.GetRawData3D().get( scanIndex ) );
+
+   EXPECT_TRUE( scan.isDefined( "cartesianBounds" ) );
+   EXPECT_TRUE( scan.isDefined( "intensityLimits" ) );
+   EXPECT_TRUE( scan.isDefined( "indexBounds" ) );
+
+   const e57::FloatNode zMinimum( scan.get( "cartesianBounds/zMinimum" ) );
+
+   EXPECT_EQ( zMinimum.value(), 2.0 );
+
+   writer.Close();
+}
+
+TEST( SimpleWriter, BoundsLeaveOutInvalidStates )
+{
+   constexpr int64_t cNumPoints = 10000;
+
+   e57::WriterOptions options;
+   options.guid = "Bounds Invalid States File GUID";
+
+   e57::Writer writer( "./BoundsLeaveOutInvalidStates.e57", options );
+
+   e57::Data3D header;
+   header.guid = "Bounds Invalid States Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+   header.pointFields.sphericalRangeField = true;
+   header.pointFields.sphericalAzimuthField = true;
+   header.pointFields.sphericalElevationField = true;
+   header.pointFields.sphericalInvalidStateField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::Double;
+   header.pointFields.angleNodeType = e57::NumericalNodeType::Double;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const auto cValue = static_cast<double>( i % 100 ) / 100.0; // [0, 0.99]
+
+      pointsData.cartesianX[i] = cValue;
+      pointsData.cartesianY[i] = cValue;
+      pointsData.cartesianZ[i] = cValue;
+      pointsData.cartesianInvalidState[i] = 0;
+      pointsData.sphericalRange[i] = 1.0 + cValue;
+      pointsData.sphericalAzimuth[i] = cValue;
+      pointsData.sphericalElevation[i] = cValue;
+      pointsData.sphericalInvalidState[i] = 0;
+   }
+
+   // Direction only: left out of the cartesian bounds
+   pointsData.cartesianX[5000] = 100.0;
+   pointsData.cartesianInvalidState[5000] = 1;
+
+   // Meaningless: left out of the cartesian bounds
+   pointsData.cartesianY[7000] = -100.0;
+   pointsData.cartesianInvalidState[7000] = 2;
+
+   // Direction only: left out of the range bounds, but not the angle bounds
+   pointsData.sphericalRange[6000] = 500.0;
+   pointsData.sphericalElevation[6000] = 1.5;
+   pointsData.sphericalInvalidState[6000] = 1;
+
+   // Meaningless: left out of all the spherical bounds
+   pointsData.sphericalRange[8000] = 0.01;
+   pointsData.sphericalAzimuth[8000] = -3.0;
+   pointsData.sphericalElevation[8000] = -1.5;
+   pointsData.sphericalInvalidState[8000] = 2;
+
+   writer.WriteData3DData( header, pointsData );
+
+   EXPECT_EQ( header.cartesianBounds.xMinimum, 0.0 );
+   EXPECT_EQ( header.cartesianBounds.xMaximum, 0.99 );
+   EXPECT_EQ( header.cartesianBounds.yMinimum, 0.0 );
+   EXPECT_EQ( header.cartesianBounds.yMaximum, 0.99 );
+   EXPECT_EQ( header.cartesianBounds.zMinimum, 0.0 );
+   EXPECT_EQ( header.cartesianBounds.zMaximum, 0.99 );
+
+   EXPECT_EQ( header.sphericalBounds.rangeMinimum, 1.0 );
+   EXPECT_EQ( header.sphericalBounds.rangeMaximum, 1.99 );
+   EXPECT_EQ( header.sphericalBounds.azimuthStart, 0.0 );
+   EXPECT_EQ( header.sphericalBounds.azimuthEnd, 0.99 );
+   EXPECT_EQ( header.sphericalBounds.elevationMinimum, 0.0 );
+   EXPECT_EQ( header.sphericalBounds.elevationMaximum, 1.5 );
+
+   writer.Close();
+}
+
+TEST( SimpleWriter, StagedScansWrittenConcurrently )
+{
+   constexpr size_t cNumScans = 6;
+   constexpr int64_t cNumPoints = 50000;
+
+   // Write the scans. If staged, each scan's points are written on a thread of its own, and the
+   // scan is closed there too if inCloseOnThreads. Otherwise they are written one at a time.
+   auto writeScans = [=]( const std::string &inFileName, bool inStaged, bool inCloseOnThreads ) {
+      e57::WriterOptions options;
+      options.guid = "Staged Scans File GUID";
+      options.stageData3DSections = inStaged;
+
+      e57::Writer writer( inFileName, options );
+
+      std::vector<std::unique_ptr<e57::Data3DPointsFloat>> pointsData;
+      std::vector<e57::CompressedVectorWriter> dataWriters;
+
+      for ( size_t scan = 0; scan < cNumScans; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Staged Scan Header GUID " + std::to_string( scan );
+         header.pointCount = cNumPoints;
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         pointsData.emplace_back( new e57::Data3DPointsFloat( header ) );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.back()->cartesianX[i] = static_cast<float>( i );
+            pointsData.back()->cartesianY[i] = static_cast<float>( scan );
+            pointsData.back()->cartesianZ[i] = static_cast<float>( i % 100 );
+         }
+
+         const int64_t scanIndex = writer.NewData3D( header );
+
+         dataWriters.push_back(
+            writer.SetUpData3DPointsData( scanIndex, cNumPoints, *pointsData.back() ) );
+
+         if ( !inStaged )
+         {
+            dataWriters.back().write( cNumPoints );
+            dataWriters.back().close();
+         }
+      }
+
+      if ( inStaged )
+      {
+         std::vector<std::thread> threads;
+         std::vector<int> failed( cNumScans, 0 );
+
+         for ( size_t scan = 0; scan < cNumScans; ++scan )
+         {
+            threads.emplace_back( [&, scan] {
+               try
+               {
+                  dataWriters[scan].write( cNumPoints );
+
+                  if ( inCloseOnThreads )
+                  {
+                     dataWriters[scan].close();
+                  }
+               }
+               catch ( ... )
+               {
+                  failed[scan] = 1;
+               }
+            } );
+         }
+
+         for ( auto &thread : threads )
+         {
+            thread.join();
+         }
+
+         for ( size_t scan = 0; scan < cNumScans; ++scan )
+         {
+            EXPECT_EQ( failed[scan], 0 ) << "scan " << scan;
+
+            dataWriters[scan].close();
+         }
+      }
+
+      // Read the points back while the file is still open
+      for ( size_t scan = 0; scan < cNumScans; ++scan )
+      {
+         const e57::StructureNode scanNode( writer.GetRawData3D().get( scan ) );
+         e57::CompressedVectorNode points( scanNode.get( "points" ) );
+
+         ASSERT_EQ( points.childCount(), cNumPoints );
+
+         std::vector<float> x( cNumPoints );
+         std::vector<float> y( cNumPoints );
+         std::vector<e57::SourceDestBuffer> readBuffers;
+         readBuffers.emplace_back( writer.GetRawIMF(), "cartesianX", x.data(), cNumPoints, true );
+         readBuffers.emplace_back( writer.GetRawIMF(), "cartesianY", y.data(), cNumPoints, true );
+
+         e57::CompressedVectorReader reader = points.reader( readBuffers );
+
+         ASSERT_EQ( reader.read(), static_cast<unsigned>( cNumPoints ) );
+
+         reader.close();
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            ASSERT_EQ( x[i], static_cast<float>( i ) );
+            ASSERT_EQ( y[i], static_cast<float>( scan ) );
+         }
+      }
+
+      writer.Close();
+   };
+
+   E57_ASSERT_NO_THROW( writeScans( "./StagedScansOneAtATime.e57", false, false ) );
+   E57_ASSERT_NO_THROW( writeScans( "./StagedScansInOrder.e57", true, false ) );
+   E57_ASSERT_NO_THROW( writeScans( "./StagedScansOnThreads.e57", true, true ) );
+
+   // Closing the staged scans in order lays the file out the same as writing them one at a time
+   std::ifstream file1( "./StagedScansOneAtATime.e57", std::ios::binary );
+   std::ifstream file2( "./StagedScansInOrder.e57", std::ios::binary );
+
+   const std::string contents1{ std::istreambuf_iterator<char>( file1 ),
+                                std::istreambuf_iterator<char>() };
+   const std::string contents2{ std::istreambuf_iterator<char>( file2 ),
+                                std::istreambuf_iterator<char>() };
+
+   ASSERT_FALSE( contents1.empty() );
+   EXPECT_TRUE( contents1 == contents2 );
+}
+
+TEST( SimpleWriter, ImagesWrittenWhileStagedScansClose )
+{
+   constexpr size_t cNumScans = 4;
+   constexpr int64_t cNumPoints = 50000;
+   constexpr int cNumImages = 40;
+   constexpr size_t cImageSize = 10001; // not a multiple of 4, or of the page size
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Staged Scans With Images File GUID";
+      options.stageData3DSections = true;
+
+      e57::Writer writer( "./ImagesWrittenWhileStagedScansClose.e57", options );
+
+      std::vector<std::unique_ptr<e57::Data3DPointsFloat>> pointsData;
+      std::vector<e57::CompressedVectorWriter> dataWriters;
+
+      for ( size_t scan = 0; scan < cNumScans; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Staged Scan With Images Header GUID " + std::to_string( scan );
+         header.pointCount = cNumPoints;
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         pointsData.emplace_back( new e57::Data3DPointsFloat( header ) );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.back()->cartesianX[i] = static_cast<float>( i );
+            pointsData.back()->cartesianY[i] = static_cast<float>( scan );
+            pointsData.back()->cartesianZ[i] = 0.5f;
+         }
+
+         const int64_t scanIndex = writer.NewData3D( header );
+
+         dataWriters.push_back(
+            writer.SetUpData3DPointsData( scanIndex, cNumPoints, *pointsData.back() ) );
+      }
+
+      // Each scan is written and closed (which places its section in the file) on a thread of its
+      // own, while this thread adds images (whose blobs are placed in the file too)
+      std::vector<std::thread> threads;
+      std::vector<int> failed( cNumScans, 0 );
+
+      for ( size_t scan = 0; scan < cNumScans; ++scan )
+      {
+         threads.emplace_back( [&, scan] {
+            try
+            {
+               dataWriters[scan].write( cNumPoints );
+               dataWriters[scan].close();
+            }
+            catch ( ... )
+            {
+               failed[scan] = 1;
+            }
+         } );
+      }
+
+      for ( int i = 0; i < cNumImages; ++i )
+      {
+         std::vector<uint8_t> png( cImageSize, static_cast<uint8_t>( i + 1 ) );
+
+         e57::Image2D imageHeader;
+         imageHeader.guid = "Staged Scans Image GUID " + std::to_string( i );
+         imageHeader.pinholeRepresentation.imageWidth = 4;
+         imageHeader.pinholeRepresentation.imageHeight = 4;
+         imageHeader.pinholeRepresentation.pngImageSize = cImageSize;
+
+         E57_ASSERT_NO_THROW( writer.WriteImage2DData(
+            imageHeader, e57::ImagePNG, e57::ProjectionPinhole, 0, png.data(), cImageSize ) );
+      }
+
+      for ( auto &thread : threads )
+      {
+         thread.join();
+      }
+
+      for ( size_t scan = 0; scan < cNumScans; ++scan )
+      {
+         EXPECT_EQ( failed[scan], 0 ) << "scan " << scan;
+      }
+
+      writer.Close();
+   }
+
+   e57::Reader reader( "./ImagesWrittenWhileStagedScansClose.e57", e57::ReaderOptions() );
+
+   ASSERT_EQ( reader.GetData3DCount(), static_cast<int64_t>( cNumScans ) );
+   ASSERT_EQ( reader.GetImage2DCount(), cNumImages );
+
+   for ( size_t scan = 0; scan < cNumScans; ++scan )
+   {
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( static_cast<int64_t>( scan ), header ) );
+
+      e57::Data3DPointsFloat pointsData( header );
+      e57::CompressedVectorReader dataReader =
+         reader.SetUpData3DPointsData( static_cast<int64_t>( scan ), cNumPoints, pointsData );
+
+      ASSERT_EQ( dataReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      dataReader.close();
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( pointsData.cartesianX[i], static_cast<float>( i ) );
+         ASSERT_EQ( pointsData.cartesianY[i], static_cast<float>( scan ) );
+      }
+   }
+
+   for ( int i = 0; i < cNumImages; ++i )
+   {
+      std::vector<uint8_t> png( cImageSize );
+
+      ASSERT_EQ( reader.ReadImage2DData( i, e57::ProjectionPinhole, e57::ImagePNG, png.data(), 0,
+                                         cImageSize ),
+                 static_cast<int64_t>( cImageSize ) );
+
+      EXPECT_EQ( png, std::vector<uint8_t>( cImageSize, static_cast<uint8_t>( i + 1 ) ) )
+         << "image " << i;
+   }
+}
+
+TEST( SimpleWriter, WriteToMemory )
+{
+   // Write the same scan to a file and to memory - the bytes must be identical.
+   auto writeCube = []( e57::Writer &ioWriter ) {
+      Random::seed( 42 );
+
+      constexpr uint16_t cNumPointsPerFace = 1280;
+      constexpr uint32_t cNumPoints = cNumPointsPerFace * cNumCubeFaces;
+
+      e57::Data3D header;
+      header.guid = "Write To Memory Scan Header GUID";
+      header.pointCount = cNumPoints;
+
+      setUsingColouredCartesianPoints( header );
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      int64_t i = 0;
+      auto writePointLambda = [&]( uint8_t inFace, const Point &inPoint ) {
+         fillColouredCartesianPoint( pointsData, i, inFace, inPoint );
+         ++i;
+      };
+
+      generateCubePoints( 1.0, cNumPointsPerFace, writePointLambda );
+
+      ioWriter.WriteData3DData( header, pointsData );
+      ioWriter.Close();
+   };
+
+   e57::WriterOptions options;
+   options.guid = "Write To Memory File GUID";
+
+   auto sink = std::make_shared<e57::MemoryImageFileSink>();
+
+   E57_ASSERT_NO_THROW( {
+      e57::Writer writer( "./WriteToMemory.e57", options );
+      writeCube( writer );
+   } );
+
+   E57_ASSERT_NO_THROW( {
+      e57::Writer writer( sink, options );
+      writeCube( writer );
+   } );
+
+   std::ifstream file( "./WriteToMemory.e57", std::ios::binary );
+
+   const std::string contents{ std::istreambuf_iterator<char>( file ),
+                               std::istreambuf_iterator<char>() };
+
+   ASSERT_FALSE( contents.empty() );
+   ASSERT_EQ( sink->length(), contents.size() );
+   EXPECT_TRUE( std::equal( contents.begin(), contents.end(), sink->data().begin() ) );
+
+   // A sink can only be written to once
+   EXPECT_THROW( e57::Writer writer( sink, options ), e57::E57Exception );
+
+   // Read the file back from memory
+   const std::vector<char> data = sink->takeData();
+
+   EXPECT_EQ( sink->length(), 0u );
+
+   e57::ImageFile imf( data.data(), data.size() );
+   const e57::VectorNode data3D( imf.root().get( "data3D" ) );
+
+   EXPECT_EQ( data3D.childCount(), 1 );
+
+   imf.close();
+
+   // Pages read from memory are still checksummed
+   std::vector<char> corrupted = data;
+   corrupted[corrupted.size() - 100] ^= 1;
+
+   EXPECT_THROW( e57::ImageFile( corrupted.data(), corrupted.size() ), e57::E57Exception );
+}
@@ -65,3 +65,33 @@ TEST( StringFunctions, FloatToStrLocale )
 
    std::locale::global( std::locale::classic() );
 }
+
+// The C locale's decimal point is used by printf(), so make sure it's replaced.
+TEST( StringFunctions, FloatToCharsCLocale )
+{
+   if ( std::setlocale( LC_NUMERIC, "de_DE.UTF-8" ) == nullptr )
+   {
+      GTEST_SKIP() << "de_DE.UTF-8 locale not available";
+   }
+
+   char buffer[e57::cFloatingPointCharsMax];
+   const size_t length = e57::floatingPointToChars<float>( buffer, -2.5e-07f, 7 );
+
+   std::setlocale( LC_NUMERIC, "C" );
+
+   ASSERT_EQ( std::string( buffer, length ), "-2.5e-07" );
+}
+
+TEST( StringFunctions, IntegerToChars )
+{
+   char buffer[e57::cIntegerCharsMax];
+
+   size_t length = e57::integerToChars( buffer, INT64_MIN );
+   ASSERT_EQ( std::string( buffer, length ), "-9223372036854775808" );
+
+   length = e57::integerToChars( buffer, UINT64_MAX );
+   ASSERT_EQ( std::string( buffer, length ), "18446744073709551615" );
+
+   length = e57::integerToChars( buffer, int64_t( 0 ) );
+   ASSERT_EQ( std::string( buffer, length ), "0" );
+}
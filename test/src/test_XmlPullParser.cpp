@@ -0,0 +1,303 @@
+// libE57Format testing Copyright © 2026 Andy Maloney <asmaloney@gmail.com>
+// SPDX-License-Identifier: BSL-1.0
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "E57XmlPullParser.h"
+
+namespace
+{
+   // Parse @a xml from a buffer of exactly its size, and describe its events: start tags with
+   // their namespace URIs & attributes, text in quotes, and end tags.
+   std::string parseEvents( const std::string &xml )
+   {
+      const std::vector<char> buffer( xml.begin(), xml.end() );
+
+      e57::E57XmlPullParser parser( buffer.data(), buffer.size() );
+
+      std::string events;
+
+      for ( ;; )
+      {
+         switch ( parser.next() )
+         {
+            case e57::E57XmlPullParser::StartElement:
+            {
+               events += "<" + parser.qName();
+
+               if ( !parser.uri().empty() )
+               {
+                  events += "{" + parser.uri() + "}";
+               }
+
+               const e57::E57XmlAttributes &attributes = parser.attributes();
+
+               for ( size_t i = 0; i < attributes.count(); ++i )
+               {
+                  events += " " + attributes.qName( i ) + "=" + attributes.value( i );
+               }
+
+               events += ">";
+               break;
+            }
+
+            case e57::E57XmlPullParser::EndElement:
+               events += "</" + parser.qName() + ">";
+               break;
+
+            case e57::E57XmlPullParser::Characters:
+               events += "'" + std::string( parser.text(), parser.textLength() ) + "'";
+               break;
+
+            case e57::E57XmlPullParser::EndDocument:
+               return events;
+         }
+      }
+   }
+
+   bool rejected( const std::string &xml )
+   {
+      try
+      {
+         parseEvents( xml );
+      }
+      catch ( e57::E57Exception &err )
+      {
+         return err.errorCode() == e57::ErrorXMLParser;
+      }
+
+      return false;
+   }
+}
+
+TEST( XmlPullParser, Elements )
+{
+   EXPECT_EQ( parseEvents( "<a x='1' y = \"2\"><b/>text<c></c ></a>" ),
+              "<a x=1 y=2><b></b>'text'<c></c></a>" );
+
+   EXPECT_TRUE( rejected( "<a></b>" ) );
+   EXPECT_TRUE( rejected( "<a x=1/>" ) );
+   EXPECT_TRUE( rejected( "<a x='1'y='2'/>" ) );
+   EXPECT_TRUE( rejected( "<a x='<'/>" ) );
+   EXPECT_TRUE( rejected( "<1a/>" ) );
+   EXPECT_TRUE( rejected( "</a>" ) );
+}
+
+TEST( XmlPullParser, References )
+{
+   EXPECT_EQ( parseEvents( "<a x='&lt;&amp;&#65;&#x42;'>&quot;&apos;&gt;&#x20AC;&#128512;</a>" ),
+              "<a x=<&AB>'\"'>\xE2\x82\xAC\xF0\x9F\x98\x80'</a>" );
+
+   // Line ends are read as "\n", and whitespace in attribute values as spaces
+   EXPECT_EQ( parseEvents( "<a x='1\t2\r\n3'>1\r\n2\r3</a>" ), "<a x=1 2 3>'1\n2\n3'</a>" );
+
+   // There's no DTD, so only the predefined entities exist
+   EXPECT_TRUE( rejected( "<a>&nbsp;</a>" ) );
+   EXPECT_TRUE( rejected( "<a x='&foo;'/>" ) );
+   EXPECT_TRUE( rejected( "<a>&amp</a>" ) );
+   EXPECT_TRUE( rejected( "<a>&#;</a>" ) );
+   EXPECT_TRUE( rejected( "<a>&#x;</a>" ) );
+   EXPECT_TRUE( rejected( "<a>&#0;</a>" ) );
+   EXPECT_TRUE( rejected( "<a>&#xD800;</a>" ) );
+   EXPECT_TRUE( rejected( "<a>&#x110000;</a>" ) );
+   EXPECT_TRUE( rejected( "<a>&#12a;</a>" ) );
+}
+
+TEST( XmlPullParser, CDATA )
+{
+   EXPECT_EQ( parseEvents( "<a>x<![CDATA[<b>&amp;\r\n]]]]>y</a>" ), "<a>'x''<b>&amp;\n]]''y'</a>" );
+   EXPECT_EQ( parseEvents( "<a><![CDATA[]]></a>" ), "<a>''</a>" );
+
+   EXPECT_TRUE( rejected( "<a><![CDATA[x]]</a>" ) );
+   EXPECT_TRUE( rejected( "<![CDATA[x]]><a/>" ) );
+   EXPECT_TRUE( rejected( "<a/><![CDATA[x]]>" ) );
+}
+
+TEST( XmlPullParser, Doctype )
+{
+   // An external DTD isn't read, so it is skipped
+   EXPECT_EQ( parseEvents( "<?xml version='1.0'?><!DOCTYPE a SYSTEM 'a>.dtd'><a/>" ), "<a></a>" );
+
+   // Declarations in the document could define entities, which we don't support
+   EXPECT_TRUE( rejected( "<!DOCTYPE a [<!ENTITY x 'y'>]><a>&x;</a>" ) );
+   EXPECT_TRUE( rejected( "<!DOCTYPE a [<!ENTITY x 'y'>]><a/>" ) );
+
+   EXPECT_TRUE( rejected( "<a/><!DOCTYPE a>" ) );
+   EXPECT_TRUE( rejected( "<a><!DOCTYPE a></a>" ) );
+   EXPECT_TRUE( rejected( "<!DOCTYPE a" ) );
+}
+
+TEST( XmlPullParser, Encoding )
+{
+   EXPECT_EQ(
+      parseEvents( "<?xml version='1.0' encoding='utf-8'?><a x='\xC3\xA9'>\xE2\x82\xAC</a>" ),
+      "<a x=\xC3\xA9>'\xE2\x82\xAC'</a>" );
+
+   EXPECT_TRUE( rejected( "<?xml version='1.0' encoding='ISO-8859-1'?><a/>" ) );
+
+   // Only ASCII letters are case folded when comparing the declaration's names
+   EXPECT_TRUE( rejected( "<?xml version='1.0' encoding='utf-\xC3\xA9'?><a/>" ) );
+   EXPECT_EQ( parseEvents( "<?\xC3\x89xml?><a/>" ), "<a></a>" );
+   EXPECT_TRUE( rejected( "<?XmL version='1.0'?><a/>" ) );
+
+   EXPECT_TRUE( rejected( "<a>\xC3</a>" ) );             // truncated sequence
+   EXPECT_TRUE( rejected( "<a>\x80</a>" ) );             // continuation byte on its own
+   EXPECT_TRUE( rejected( "<a>\xC0\xAF</a>" ) );         // overlong
+   EXPECT_TRUE( rejected( "<a>\xED\xA0\x80</a>" ) );     // surrogate
+   EXPECT_TRUE( rejected( "<a>\xF4\x90\x80\x80</a>" ) ); // beyond U+10FFFF
+   EXPECT_TRUE( rejected( "<a>\xEF\xBF\xBE</a>" ) );     // U+FFFE
+   EXPECT_TRUE( rejected( "<a>\xFF</a>" ) );
+   EXPECT_TRUE( rejected( "<a x='\xC3'/>" ) );
+   EXPECT_TRUE( rejected( std::string( "<a>\0</a>", 8 ) ) );
+   EXPECT_TRUE( rejected( "<a>\x01</a>" ) );
+}
+
+TEST( XmlPullParser, ByteOrderMark )
+{
+   EXPECT_EQ( parseEvents( "\xEF\xBB\xBF<?xml version='1.0' encoding='UTF-8'?><a/>" ), "<a></a>" );
+   EXPECT_EQ( parseEvents( "\xEF\xBB\xBF<a/>" ), "<a></a>" );
+
+   // Anywhere else it's a character (U+FEFF)
+   EXPECT_EQ( parseEvents( "<a>\xEF\xBB\xBF</a>" ), "<a>'\xEF\xBB\xBF'</a>" );
+   EXPECT_TRUE( rejected( "\xEF\xBB\xBF\xEF\xBB\xBF<a/>" ) );
+
+   // The XML declaration has to come first
+   EXPECT_TRUE( rejected( " <?xml version='1.0'?><a/>" ) );
+   EXPECT_TRUE( rejected( "<a><?xml version='1.0'?></a>" ) );
+}
+
+TEST( XmlPullParser, Attributes )
+{
+   const std::string xml = "<a x='1' y='2'/>";
+
+   const std::vector<char> buffer( xml.begin(), xml.end() );
+
+   e57::E57XmlPullParser parser( buffer.data(), buffer.size() );
+   ASSERT_EQ( parser.next(), e57::E57XmlPullParser::StartElement );
+
+   const e57::E57XmlAttributes &attributes = parser.attributes();
+   ASSERT_EQ( attributes.count(), 2u );
+
+   size_t index = 0;
+   EXPECT_TRUE( attributes.find( "y", index ) );
+   EXPECT_EQ( index, 1u );
+   EXPECT_FALSE( attributes.find( "z", index ) );
+
+   EXPECT_TRUE( rejected( "<a x='1' x='2'/>" ) );
+   EXPECT_TRUE( rejected( "<a p:x='1' xmlns:p='u' p:x='2'/>" ) );
+
+   // Different prefixes for the same namespace
+   EXPECT_TRUE( rejected( "<a xmlns:p='u' xmlns:q='u' p:x='1' q:x='2'/>" ) );
+   EXPECT_EQ( parseEvents( "<a xmlns:p='u' xmlns:q='v' p:x='1' q:x='2' x='3'/>" ),
+              "<a xmlns:p=u xmlns:q=v p:x=1 q:x=2 x=3></a>" );
+}
+
+TEST( XmlPullParser, Namespaces )
+{
+   const std::string xml = "<e57Root xmlns='http://www.astm.org/COMMIT/E57/2010-e57-v1.0' "
+                           "xmlns:nor='http://www.libe57.org/E57_NOR_surface_normals.txt'>"
+                           "<nor:normalX type='Float'/><child xmlns=''/></e57Root>";
+
+   EXPECT_EQ( parseEvents( xml ),
+              "<e57Root{http://www.astm.org/COMMIT/E57/2010-e57-v1.0}"
+              " xmlns=http://www.astm.org/COMMIT/E57/2010-e57-v1.0"
+              " xmlns:nor=http://www.libe57.org/E57_NOR_surface_normals.txt>"
+              "<nor:normalX{http://www.libe57.org/E57_NOR_surface_normals.txt} type=Float>"
+              "</nor:normalX><child xmlns=></child></e57Root>" );
+
+   const std::vector<char> buffer( xml.begin(), xml.end() );
+
+   e57::E57XmlPullParser parser( buffer.data(), buffer.size() );
+   ASSERT_EQ( parser.next(), e57::E57XmlPullParser::StartElement );
+   ASSERT_EQ( parser.next(), e57::E57XmlPullParser::StartElement );
+
+   EXPECT_EQ( parser.localName(), "normalX" );
+   EXPECT_EQ( parser.qName(), "nor:normalX" );
+   ASSERT_EQ( parser.namespaces().size(), 2u );
+   EXPECT_EQ( parser.namespaces()[1].first, "nor" );
+
+   // Unprefixed attributes aren't in any namespace, and the xml prefix is predefined
+   const e57::E57XmlAttributes &attributes = parser.attributes();
+   EXPECT_EQ( attributes.uri( 0 ), "" );
+   EXPECT_EQ( parseEvents( "<a xml:lang='en'/>" ), "<a xml:lang=en></a>" );
+
+   // Declarations are only in scope in their element
+   EXPECT_EQ( parseEvents( "<a><b xmlns:p='u'><p:c/></b></a>" ),
+              "<a><b xmlns:p=u><p:c{u}></p:c></b></a>" );
+   EXPECT_TRUE( rejected( "<a><b xmlns:p='u'/><p:c/></a>" ) );
+
+   EXPECT_TRUE( rejected( "<p:a/>" ) );
+   EXPECT_TRUE( rejected( "<a p:x='1'/>" ) );
+   EXPECT_TRUE( rejected( "<a xmlns:p=''/>" ) );
+   EXPECT_TRUE( rejected( "<:a/>" ) );
+   EXPECT_TRUE( rejected( "<a:/>" ) );
+   EXPECT_TRUE( rejected( "<a:b:c xmlns:a='u'/>" ) );
+}
+
+TEST( XmlPullParser, OutsideTheRoot )
+{
+   EXPECT_EQ( parseEvents( "<!-- c --> <?pi x?>\n<a/> <!-- c --><?pi?>\r\n" ), "<a></a>" );
+
+   EXPECT_TRUE( rejected( "" ) );
+   EXPECT_TRUE( rejected( "  <!-- c -->" ) );
+   EXPECT_TRUE( rejected( "text<a/>" ) );
+   EXPECT_TRUE( rejected( "<a/>text" ) );
+   EXPECT_TRUE( rejected( "<a/><b/>" ) );
+   EXPECT_TRUE( rejected( "<a/></a>" ) );
+   EXPECT_TRUE( rejected( "<a/>&amp;" ) );
+}
+
+TEST( XmlPullParser, Truncated )
+{
+   const std::string xml = "\xEF\xBB\xBF<?xml version='1.0' encoding='UTF-8'?>\n"
+                           "<!DOCTYPE a SYSTEM 'a.dtd'><!-- c -->"
+                           "<a xmlns='u' xmlns:p='v' p:x='&lt;1&#x20AC;'>"
+                           "<b>\xC3\xA9&amp;<![CDATA[<c>]]></b><p:d/><?pi?></a>";
+
+   ASSERT_NO_THROW( parseEvents( xml ) );
+
+   // Every part of the document from its start, up to the end of the root element, is rejected
+   for ( size_t length = 0; length < xml.length(); ++length )
+   {
+      EXPECT_TRUE( rejected( xml.substr( 0, length ) ) ) << "length=" << length;
+   }
+}
+
+TEST( XmlPullParser, SkippedContent )
+{
+   const std::string xml = "<a xmlns:p='u'><p:b x='>'/><c><!-- </c> --><d/></c>text</a>";
+
+   const std::vector<char> buffer( xml.begin(), xml.end() );
+
+   e57::E57XmlPullParser parser( buffer.data(), buffer.size() );
+   ASSERT_EQ( parser.next(), e57::E57XmlPullParser::StartElement );
+
+   const e57::E57XmlNamespaces namespaces = parser.namespaces();
+
+   const char *contentBegin = nullptr;
+   const char *contentEnd = nullptr;
+   parser.skipContent( contentBegin, contentEnd );
+
+   EXPECT_EQ( std::string( contentBegin, contentEnd ),
+              "<p:b x='>'/><c><!-- </c> --><d/></c>text" );
+   EXPECT_EQ( parser.next(), e57::E57XmlPullParser::EndElement );
+   EXPECT_EQ( parser.next(), e57::E57XmlPullParser::EndDocument );
+
+   // Parse the content later, with the namespaces in scope where it was
+   e57::E57XmlPullParser contentParser( buffer.data(), contentBegin, contentEnd, namespaces );
+
+   std::string events;
+
+   for ( auto event = contentParser.next(); event != e57::E57XmlPullParser::EndDocument;
+         event = contentParser.next() )
+   {
+      if ( event == e57::E57XmlPullParser::StartElement )
+      {
+         events += "<" + contentParser.localName() + "{" + contentParser.uri() + "}>";
+      }
+   }
+
+   EXPECT_EQ( events, "<b{u}><c{}><d{}>" );
+}